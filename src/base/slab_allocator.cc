@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "base/slab_allocator.h"
+
+#include <tbb/mutex.h>
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <cassert>
+#include <new>
+
+#include "base/task.h"
+
+using std::string;
+
+//
+// Registry of active allocators, used to display statistics via introspect.
+//
+// Function local statics are used to make sure that the registry is usable
+// even if an allocator gets created during static initialization.
+//
+static tbb::mutex &AllocatorListMutex() {
+    static tbb::mutex mutex;
+    return mutex;
+}
+
+static SlabAllocator::AllocatorList &AllocatorListInstance() {
+    static SlabAllocator::AllocatorList allocator_list;
+    return allocator_list;
+}
+
+SlabAllocator::SlabAllocator(const string &name) : name_(name) {
+    fallback_allocs_ = 0;
+    tbb::mutex::scoped_lock lock(AllocatorListMutex());
+    AllocatorListInstance().push_back(this);
+}
+
+//
+// Only slabs with free objects are on the lists. The slabs of objects that
+// are still allocated when the allocator is destroyed are not reclaimed.
+//
+SlabAllocator::~SlabAllocator() {
+    tbb::mutex::scoped_lock lock(AllocatorListMutex());
+    AllocatorList &allocator_list = AllocatorListInstance();
+    allocator_list.erase(
+        std::remove(allocator_list.begin(), allocator_list.end(), this),
+        allocator_list.end());
+    lock.release();
+
+    for (int idx = 0; idx <= kPartitionCount; ++idx) {
+        Partition *partition = &partitions_[idx];
+        for (size_t index = 0; index < kSizeClassCount; ++index) {
+            SizeClass *size_class = &partition->size_classes[index];
+            Slab *lists[] = { size_class->partial, size_class->empty };
+            for (size_t list = 0; list < 2; ++list) {
+                Slab *slab = lists[list];
+                while (slab) {
+                    Slab *next = slab->next;
+                    free(slab);
+                    slab = next;
+                }
+            }
+        }
+    }
+}
+
+void SlabAllocator::GetAllocatorList(AllocatorList *allocator_list) {
+    tbb::mutex::scoped_lock lock(AllocatorListMutex());
+    *allocator_list = AllocatorListInstance();
+}
+
+//
+// Pick the partition for the calling thread.
+//
+// Partition kPartitionCount is shared by all code that does not run in the
+// context of a Task or runs in a Task with a wildcard instance.
+//
+int SlabAllocator::PartitionIndex() const {
+    Task *task = Task::Running();
+    if (!task || task->GetTaskInstance() < 0)
+        return kPartitionCount;
+    return task->GetTaskInstance() % kPartitionCount;
+}
+
+void SlabAllocator::LinkSlab(Slab **list, Slab *slab) {
+    slab->prev = NULL;
+    slab->next = *list;
+    if (*list)
+        (*list)->prev = slab;
+    *list = slab;
+}
+
+void SlabAllocator::UnlinkSlab(Slab **list, Slab *slab) {
+    if (slab->prev) {
+        slab->prev->next = slab->next;
+    } else {
+        *list = slab->next;
+    }
+    if (slab->next)
+        slab->next->prev = slab->prev;
+    slab->prev = slab->next = NULL;
+}
+
+//
+// Carve a new slab into objects of the given size class and put it on the
+// empty list of the size class.
+//
+// Caller must hold the partition mutex.
+//
+void SlabAllocator::RefillSizeClass(int partition_index, size_t index) {
+    void *memory;
+    if (posix_memalign(&memory, kSlabSize, kSlabSize) != 0)
+        throw std::bad_alloc();
+
+    size_t object_size = IndexToSize(index);
+    Slab *slab = static_cast<Slab *>(memory);
+    slab->free_list = NULL;
+    slab->capacity = (kSlabSize - kSlabHeaderSize) / object_size;
+    slab->free_count = slab->capacity;
+    slab->partition = partition_index;
+    slab->index = index;
+    char *objects = static_cast<char *>(memory) + kSlabHeaderSize;
+    for (size_t count = slab->capacity; count > 0; --count) {
+        FreeObject *object =
+            reinterpret_cast<FreeObject *>(objects + (count - 1) * object_size);
+        object->next = slab->free_list;
+        slab->free_list = object;
+    }
+
+    SizeClass *size_class =
+        &partitions_[partition_index].size_classes[index];
+    LinkSlab(&size_class->empty, slab);
+    size_class->empty_slabs++;
+    size_class->free_count += slab->capacity;
+    size_class->slabs++;
+}
+
+//
+// Partially used slabs are preferred over empty ones, so that the empty ones
+// stay empty and can be released.
+//
+void *SlabAllocator::Allocate(size_t size) {
+    if (size > kMaxObjectSize) {
+        fallback_allocs_++;
+        return ::operator new(size);
+    }
+
+    size_t index = SizeToIndex(size);
+    int partition_index = PartitionIndex();
+    Partition *partition = &partitions_[partition_index];
+    tbb::spin_mutex::scoped_lock lock(partition->mutex);
+    SizeClass *size_class = &partition->size_classes[index];
+    Slab *slab = size_class->partial;
+    if (!slab) {
+        if (!size_class->empty)
+            RefillSizeClass(partition_index, index);
+        slab = size_class->empty;
+        UnlinkSlab(&size_class->empty, slab);
+        size_class->empty_slabs--;
+        LinkSlab(&size_class->partial, slab);
+    }
+
+    FreeObject *object = slab->free_list;
+    slab->free_list = object->next;
+    if (--slab->free_count == 0)
+        UnlinkSlab(&size_class->partial, slab);
+    size_class->free_count--;
+    size_class->allocs++;
+    return object;
+}
+
+//
+// The object goes back to its own slab, in the partition that the slab
+// belongs to, whichever partition it is freed from.
+//
+void SlabAllocator::Free(void *ptr, size_t size) {
+    if (!ptr)
+        return;
+    if (size > kMaxObjectSize) {
+        ::operator delete(ptr);
+        return;
+    }
+
+    Slab *slab = ObjectToSlab(ptr);
+    assert(slab->index == SizeToIndex(size));
+    Partition *partition = &partitions_[slab->partition];
+    tbb::spin_mutex::scoped_lock lock(partition->mutex);
+    SizeClass *size_class = &partition->size_classes[slab->index];
+    FreeObject *object = static_cast<FreeObject *>(ptr);
+    object->next = slab->free_list;
+    slab->free_list = object;
+    size_class->free_count++;
+    size_class->frees++;
+    if (++slab->free_count == 1)
+        LinkSlab(&size_class->partial, slab);
+    if (slab->free_count < slab->capacity)
+        return;
+
+    UnlinkSlab(&size_class->partial, slab);
+    if (size_class->empty_slabs < kMaxEmptySlabs) {
+        LinkSlab(&size_class->empty, slab);
+        size_class->empty_slabs++;
+        return;
+    }
+    size_class->free_count -= slab->capacity;
+    size_class->slabs--;
+    size_class->slabs_released++;
+    free(slab);
+}
+
+//
+// Fill statistics for all size classes that are in use, aggregated across
+// all partitions.
+//
+void SlabAllocator::GetStats(StatsList *stats_list) const {
+    Stats stats[kSizeClassCount];
+    for (int idx = 0; idx <= kPartitionCount; ++idx) {
+        const Partition *partition = &partitions_[idx];
+        tbb::spin_mutex::scoped_lock lock(partition->mutex);
+        for (size_t index = 0; index < kSizeClassCount; ++index) {
+            const SizeClass *size_class = &partition->size_classes[index];
+            stats[index].slabs += size_class->slabs;
+            stats[index].allocs += size_class->allocs;
+            stats[index].frees += size_class->frees;
+            stats[index].free_objects += size_class->free_count;
+            stats[index].slabs_released += size_class->slabs_released;
+        }
+    }
+
+    for (size_t index = 0; index < kSizeClassCount; ++index) {
+        if (!stats[index].allocs)
+            continue;
+        stats[index].object_size = IndexToSize(index);
+        stats_list->push_back(stats[index]);
+    }
+}
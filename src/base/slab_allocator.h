@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef SRC_BASE_SLAB_ALLOCATOR_H_
+#define SRC_BASE_SLAB_ALLOCATOR_H_
+
+#include <stdint.h>
+#include <tbb/atomic.h>
+#include <tbb/spin_mutex.h>
+
+#include <string>
+#include <vector>
+
+#include "base/util.h"
+
+//
+// Size-class slab allocator for small, frequently allocated objects such as
+// routes and paths.
+//
+// Objects are carved out of fixed size slabs and recycled through free lists
+// that are maintained per size class. The free lists are split into a number
+// of partitions so that tasks running concurrently on different instances
+// (e.g. db::DBTable partitions) don't contend on the same lock. A partition
+// is picked based on the instance of the currently running Task. Code that
+// is not running in the context of a Task uses a shared partition.
+//
+// Slabs are aligned to kSlabSize, so the slab of an object is found from its
+// address. Each slab keeps its own free list and belongs to the partition it
+// was carved for. An object that is freed from another partition goes back
+// to its own slab, so memory doesn't migrate between partitions.
+//
+// A slab whose objects have all been freed is returned to the system, except
+// for kMaxEmptySlabs per size class and partition that are kept to absorb
+// churn. Partially used slabs are preferred for allocation so that empty
+// slabs become available for release.
+//
+// Requests larger than kMaxObjectSize are passed through to the global heap.
+//
+// The sized Free method needs to be called with the same size that was used
+// to allocate the object. This is naturally the case for class specific sized
+// operator delete as long as the class has a virtual destructor.
+//
+class SlabAllocator {
+public:
+    static const size_t kSizeClassShift = 4;
+    static const size_t kSizeClassCount = 32;
+    static const size_t kMaxObjectSize = kSizeClassCount << kSizeClassShift;
+    static const size_t kSlabSize = 64 * 1024;
+    static const int kPartitionCount = 32;
+    static const size_t kMaxEmptySlabs = 1;
+
+    struct Stats {
+        Stats()
+            : object_size(0), slabs(0), allocs(0), frees(0), free_objects(0),
+              slabs_released(0) {
+        }
+        size_t object_size;
+        uint64_t slabs;
+        uint64_t allocs;
+        uint64_t frees;
+        uint64_t free_objects;
+        uint64_t slabs_released;
+    };
+    typedef std::vector<Stats> StatsList;
+
+    explicit SlabAllocator(const std::string &name);
+    ~SlabAllocator();
+
+    void *Allocate(size_t size);
+    void Free(void *ptr, size_t size);
+
+    const std::string &name() const { return name_; }
+    void GetStats(StatsList *stats_list) const;
+    uint64_t fallback_allocs() const { return fallback_allocs_; }
+
+    // Number of objects of the given size that fit in a slab.
+    static size_t ObjectsPerSlab(size_t size) {
+        size_t object_size = IndexToSize(SizeToIndex(size));
+        return (kSlabSize - kSlabHeaderSize) / object_size;
+    }
+
+    // Get the list of all SlabAllocators that are currently active.
+    typedef std::vector<const SlabAllocator *> AllocatorList;
+    static void GetAllocatorList(AllocatorList *allocator_list);
+
+private:
+    friend class SlabAllocatorTest;
+
+    struct FreeObject {
+        FreeObject *next;
+    };
+
+    // Header at the start of each slab. Slabs that have some objects in use
+    // and some free are on the partial list of their size class, and slabs
+    // with all objects free on the empty list. Full slabs are on neither.
+    struct Slab {
+        Slab *prev;
+        Slab *next;
+        FreeObject *free_list;
+        uint32_t free_count;
+        uint32_t capacity;
+        uint32_t partition;
+        uint32_t index;
+    };
+    static const size_t kSlabHeaderSize =
+        (sizeof(Slab) + (1 << kSizeClassShift) - 1) &
+        ~((1 << kSizeClassShift) - 1);
+
+    struct SizeClass {
+        SizeClass()
+            : partial(NULL), empty(NULL), empty_slabs(0), free_count(0),
+              slabs(0), allocs(0), frees(0), slabs_released(0) {
+        }
+        Slab *partial;
+        Slab *empty;
+        size_t empty_slabs;
+        uint64_t free_count;
+        uint64_t slabs;
+        uint64_t allocs;
+        uint64_t frees;
+        uint64_t slabs_released;
+    };
+
+    struct Partition {
+        mutable tbb::spin_mutex mutex;
+        SizeClass size_classes[kSizeClassCount];
+    };
+
+    static size_t SizeToIndex(size_t size) {
+        return size ? (size - 1) >> kSizeClassShift : 0;
+    }
+    static size_t IndexToSize(size_t index) {
+        return (index + 1) << kSizeClassShift;
+    }
+
+    static Slab *ObjectToSlab(void *ptr) {
+        return reinterpret_cast<Slab *>(
+            reinterpret_cast<uintptr_t>(ptr) & ~(kSlabSize - 1));
+    }
+    static void LinkSlab(Slab **list, Slab *slab);
+    static void UnlinkSlab(Slab **list, Slab *slab);
+
+    int PartitionIndex() const;
+    void RefillSizeClass(int partition_index, size_t index);
+
+    std::string name_;
+    Partition partitions_[kPartitionCount + 1];
+    tbb::atomic<uint64_t> fallback_allocs_;
+
+    DISALLOW_COPY_AND_ASSIGN(SlabAllocator);
+};
+
+#endif  // SRC_BASE_SLAB_ALLOCATOR_H_
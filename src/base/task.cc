@@ -187,6 +187,7 @@ public:
     void PolicySet();
     void TaskStarted() {run_count_++;};
     void IncrementTotalRunTime(int64_t rtime) { total_run_time_ += rtime; }
+    uint64_t total_run_time() const { return total_run_time_; }
     TaskStats *GetTaskGroupStats();
     TaskStats *GetTaskStats();
     TaskStats *GetTaskStats(int task_instance);
@@ -779,6 +780,20 @@ TaskStats *TaskScheduler::GetTaskStats(int task_id, int instance_id) {
     return group->GetTaskStats(instance_id);
 }
 
+//
+// Return the total time in usecs that tasks in the group have run for. This
+// is accumulated only when run time tracking is enabled.
+//
+uint64_t TaskScheduler::GetTaskGroupRunTime(int task_id) {
+    if (task_id < 0 || task_id >= static_cast<int>(task_group_db_.size()))
+        return 0;
+    TaskGroup *group = QueryTaskGroup(task_id);
+    if (group == NULL)
+        return 0;
+
+    return group->total_run_time();
+}
+
 #ifndef _WIN32
 //
 // Platfrom-dependent subroutine in Linux and FreeBSD implementations,
@@ -175,6 +175,7 @@ public:
     TaskStats *GetTaskGroupStats(int task_id);
     TaskStats *GetTaskStats(int task_id);
     TaskStats *GetTaskStats(int task_id, int instance_id);
+    uint64_t GetTaskGroupRunTime(int task_id);
     void ClearTaskGroupStats(int task_id);
     void ClearTaskStats(int task_id);
     void ClearTaskStats(int task_id, int instance_id);
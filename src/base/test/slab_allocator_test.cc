@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "base/slab_allocator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <set>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/task.h"
+#include "base/test/task_test_util.h"
+#include "testing/gunit.h"
+
+using std::cout;
+using std::endl;
+using std::set;
+using std::vector;
+
+//
+// Runs a function in the context of a given task instance, which selects the
+// allocator partition.
+//
+class AllocatorTask : public Task {
+public:
+    typedef boost::function<void(void)> Function;
+
+    AllocatorTask(int instance, Function func)
+        : Task(TaskScheduler::GetInstance()->GetTaskId("slab::test"),
+               instance),
+          func_(func) {
+    }
+    virtual bool Run() {
+        func_();
+        return true;
+    }
+    std::string Description() const { return "AllocatorTask"; }
+
+    static void Execute(int instance, Function func) {
+        TaskScheduler::GetInstance()->Enqueue(
+            new AllocatorTask(instance, func));
+        task_util::WaitForIdle();
+    }
+
+private:
+    Function func_;
+};
+
+class SlabAllocatorTest : public ::testing::Test {
+protected:
+    SlabAllocatorTest() : allocator_("SlabAllocatorTest") {
+    }
+
+    const SlabAllocator::Stats *FindStats(size_t object_size) {
+        stats_list_.clear();
+        allocator_.GetStats(&stats_list_);
+        for (SlabAllocator::StatsList::const_iterator it =
+             stats_list_.begin(); it != stats_list_.end(); ++it) {
+            if (it->object_size == object_size)
+                return &(*it);
+        }
+        return NULL;
+    }
+
+    size_t SlabObjectCount(size_t object_size) {
+        return SlabAllocator::ObjectsPerSlab(object_size);
+    }
+
+    void Allocate(size_t size, void **ptr) {
+        *ptr = allocator_.Allocate(size);
+    }
+
+    void Free(size_t size, void *ptr) {
+        allocator_.Free(ptr, size);
+    }
+
+    // Resident set size in kbytes.
+    static size_t RssKbytes() {
+        long pages = 0, resident = 0;
+        FILE *file = fopen("/proc/self/statm", "r");
+        if (!file)
+            return 0;
+        if (fscanf(file, "%ld %ld", &pages, &resident) != 2)
+            resident = 0;
+        fclose(file);
+        return resident * (sysconf(_SC_PAGESIZE) / 1024);
+    }
+
+    SlabAllocator allocator_;
+    SlabAllocator::StatsList stats_list_;
+};
+
+//
+// Sizes are rounded up to the size class granularity.
+//
+TEST_F(SlabAllocatorTest, SizeClass) {
+    void *ptr1 = allocator_.Allocate(1);
+    void *ptr2 = allocator_.Allocate(16);
+    void *ptr3 = allocator_.Allocate(17);
+    void *ptr4 = allocator_.Allocate(SlabAllocator::kMaxObjectSize);
+
+    const SlabAllocator::Stats *stats = FindStats(16);
+    ASSERT_TRUE(stats != NULL);
+    EXPECT_EQ(1, stats->slabs);
+    EXPECT_EQ(2, stats->allocs);
+    EXPECT_EQ(SlabObjectCount(16) - 2, stats->free_objects);
+
+    stats = FindStats(32);
+    ASSERT_TRUE(stats != NULL);
+    EXPECT_EQ(1, stats->allocs);
+
+    stats = FindStats(SlabAllocator::kMaxObjectSize);
+    ASSERT_TRUE(stats != NULL);
+    EXPECT_EQ(1, stats->allocs);
+    EXPECT_EQ(0, allocator_.fallback_allocs());
+
+    allocator_.Free(ptr1, 1);
+    allocator_.Free(ptr2, 16);
+    allocator_.Free(ptr3, 17);
+    allocator_.Free(ptr4, SlabAllocator::kMaxObjectSize);
+
+    stats = FindStats(16);
+    ASSERT_TRUE(stats != NULL);
+    EXPECT_EQ(2, stats->frees);
+    EXPECT_EQ(SlabObjectCount(16), stats->free_objects);
+}
+
+//
+// Objects larger than kMaxObjectSize come from the global heap.
+//
+TEST_F(SlabAllocatorTest, Fallback) {
+    void *ptr = allocator_.Allocate(SlabAllocator::kMaxObjectSize + 1);
+    EXPECT_TRUE(ptr != NULL);
+    EXPECT_EQ(1, allocator_.fallback_allocs());
+    allocator_.GetStats(&stats_list_);
+    EXPECT_TRUE(stats_list_.empty());
+    allocator_.Free(ptr, SlabAllocator::kMaxObjectSize + 1);
+}
+
+//
+// Freed objects get recycled before a new slab is carved.
+//
+TEST_F(SlabAllocatorTest, Recycle) {
+    void *ptr1 = allocator_.Allocate(64);
+    allocator_.Free(ptr1, 64);
+    void *ptr2 = allocator_.Allocate(64);
+    EXPECT_EQ(ptr1, ptr2);
+    allocator_.Free(ptr2, 64);
+
+    const SlabAllocator::Stats *stats = FindStats(64);
+    ASSERT_TRUE(stats != NULL);
+    EXPECT_EQ(1, stats->slabs);
+    EXPECT_EQ(2, stats->allocs);
+    EXPECT_EQ(2, stats->frees);
+}
+
+//
+// Allocate more than a slab worth of objects and make sure that all of them
+// are distinct and properly aligned.
+//
+TEST_F(SlabAllocatorTest, MultipleSlabs) {
+    size_t count = SlabObjectCount(48) * 2 + 1;
+    set<void *> ptr_set;
+    for (size_t idx = 0; idx < count; ++idx) {
+        void *ptr = allocator_.Allocate(40);
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(ptr) % sizeof(void *));
+        EXPECT_TRUE(ptr_set.insert(ptr).second);
+    }
+
+    const SlabAllocator::Stats *stats = FindStats(48);
+    ASSERT_TRUE(stats != NULL);
+    EXPECT_EQ(3, stats->slabs);
+    EXPECT_EQ(count, stats->allocs);
+
+    for (set<void *>::iterator it = ptr_set.begin();
+         it != ptr_set.end(); ++it) {
+        allocator_.Free(*it, 40);
+    }
+    stats = FindStats(48);
+    ASSERT_TRUE(stats != NULL);
+    EXPECT_EQ(count, stats->frees);
+
+    // Only kMaxEmptySlabs of the empty slabs are kept.
+    EXPECT_EQ(SlabAllocator::kMaxEmptySlabs, stats->slabs);
+    EXPECT_EQ(3 - SlabAllocator::kMaxEmptySlabs, stats->slabs_released);
+    EXPECT_EQ(SlabObjectCount(48) * SlabAllocator::kMaxEmptySlabs,
+              stats->free_objects);
+}
+
+//
+// Objects are allocated from partially used slabs before empty ones, so
+// that a slab that was emptied isn't filled again.
+//
+TEST_F(SlabAllocatorTest, PartialFirst) {
+    size_t count = SlabObjectCount(64);
+    vector<void *> ptrs;
+    for (size_t idx = 0; idx < count * 2; ++idx) {
+        ptrs.push_back(allocator_.Allocate(64));
+    }
+
+    // Empty the first slab and free one object of the second.
+    for (size_t idx = 0; idx <= count; ++idx) {
+        allocator_.Free(ptrs[idx], 64);
+    }
+    const SlabAllocator::Stats *stats = FindStats(64);
+    ASSERT_TRUE(stats != NULL);
+    EXPECT_EQ(2, stats->slabs);
+
+    // The object comes from the second slab.
+    void *ptr = allocator_.Allocate(64);
+    EXPECT_EQ(ptrs[count], ptr);
+    ptrs[count] = ptr;
+    for (size_t idx = count; idx < count * 2; ++idx) {
+        allocator_.Free(ptrs[idx], 64);
+    }
+    stats = FindStats(64);
+    ASSERT_TRUE(stats != NULL);
+    EXPECT_EQ(SlabAllocator::kMaxEmptySlabs, stats->slabs);
+}
+
+//
+// An object that is freed from another partition goes back to the slab and
+// the partition it was allocated from.
+//
+TEST_F(SlabAllocatorTest, CrossPartition) {
+    void *ptr1 = NULL, *ptr2 = NULL;
+    AllocatorTask::Execute(1,
+        boost::bind(&SlabAllocatorTest::Allocate, this, 64, &ptr1));
+    AllocatorTask::Execute(2,
+        boost::bind(&SlabAllocatorTest::Free, this, 64, ptr1));
+    AllocatorTask::Execute(1,
+        boost::bind(&SlabAllocatorTest::Allocate, this, 64, &ptr2));
+    EXPECT_EQ(ptr1, ptr2);
+
+    const SlabAllocator::Stats *stats = FindStats(64);
+    ASSERT_TRUE(stats != NULL);
+    EXPECT_EQ(1, stats->slabs);
+    AllocatorTask::Execute(2,
+        boost::bind(&SlabAllocatorTest::Free, this, 64, ptr2));
+}
+
+//
+// Memory is given back to the system after churn. The number of objects can
+// be changed with the environment variable SLAB_ALLOCATOR_TEST_OBJECTS, e.g.
+// to 1000000 for the equivalent of 1M paths.
+//
+TEST_F(SlabAllocatorTest, Churn) {
+    char *str = getenv("SLAB_ALLOCATOR_TEST_OBJECTS");
+    size_t count = str ? strtoul(str, NULL, 0) : 100000;
+    const size_t kObjectSize = 128;
+
+    size_t start_rss = RssKbytes();
+    vector<void *> ptrs;
+    ptrs.reserve(count);
+    for (size_t idx = 0; idx < count; ++idx) {
+        ptrs.push_back(allocator_.Allocate(kObjectSize));
+    }
+    size_t alloc_rss = RssKbytes();
+
+    // Free every other object first, which doesn't empty any slab.
+    for (size_t idx = 0; idx < count; idx += 2) {
+        allocator_.Free(ptrs[idx], kObjectSize);
+    }
+    size_t half_rss = RssKbytes();
+    for (size_t idx = 1; idx < count; idx += 2) {
+        allocator_.Free(ptrs[idx], kObjectSize);
+    }
+    size_t free_rss = RssKbytes();
+
+    const SlabAllocator::Stats *stats = FindStats(kObjectSize);
+    ASSERT_TRUE(stats != NULL);
+    EXPECT_EQ(SlabAllocator::kMaxEmptySlabs, stats->slabs);
+
+    cout << "Objects: " << count << " of " << kObjectSize << " bytes, "
+         << stats->slabs_released << " slabs released" << endl;
+    cout << "RSS: start " << start_rss << " KB, allocated " << alloc_rss
+         << " KB, half freed " << half_rss << " KB, freed " << free_rss
+         << " KB" << endl;
+}
+
+//
+// Allocators register and unregister themselves.
+//
+TEST_F(SlabAllocatorTest, AllocatorList) {
+    SlabAllocator::AllocatorList allocator_list;
+    SlabAllocator::GetAllocatorList(&allocator_list);
+    EXPECT_TRUE(std::find(allocator_list.begin(), allocator_list.end(),
+        &allocator_) != allocator_list.end());
+
+    SlabAllocator *allocator = new SlabAllocator("Temporary");
+    SlabAllocator::GetAllocatorList(&allocator_list);
+    EXPECT_TRUE(std::find(allocator_list.begin(), allocator_list.end(),
+        allocator) != allocator_list.end());
+    delete allocator;
+    SlabAllocator::GetAllocatorList(&allocator_list);
+    EXPECT_TRUE(std::find(allocator_list.begin(), allocator_list.end(),
+        allocator) == allocator_list.end());
+}
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    bool success = RUN_ALL_TESTS();
+    TaskScheduler::GetInstance()->Terminate();
+    return success;
+}
@@ -33,9 +33,20 @@ using std::set;
 // Holds a table reference to ensure that table with active walk or listener
 // is not deleted
 //
+// ConditionMatch objects that provide a match prefix are kept in an index
+// that's organized as a map of prefix length to a map of subnet address to
+// the ConditionMatch objects for that prefix.  Only the objects for prefixes
+// that overlap a route are matched against it.  ConditionMatch objects that
+// don't provide a match prefix are kept in the unindexed list and matched
+// against all routes.
+//
 class ConditionMatchTableState {
 public:
     typedef set<ConditionMatchPtr> MatchList;
+    typedef map<IpAddress, MatchList> PrefixMatchMap;
+    typedef map<int, PrefixMatchMap> PrefixIndex;
+    typedef pair<IpAddress, int> MatchPrefix;
+    typedef map<ConditionMatch *, MatchPrefix> MatchPrefixMap;
     typedef map<ConditionMatchPtr,
             BgpConditionListener::RequestDoneCb> WalkList;
     ConditionMatchTableState(BgpTable *table, DBTableBase::ListenerId id);
@@ -52,8 +63,59 @@ public:
         return &match_object_list_;
     }
 
+    MatchList *unindexed_match_objects() {
+        return &unindexed_match_object_list_;
+    }
+
+    PrefixIndex *prefix_index() {
+        return &prefix_index_;
+    }
+
     void AddMatchObject(ConditionMatch *obj) {
-        match_object_list_.insert(ConditionMatchPtr(obj));
+        if (!match_object_list_.insert(ConditionMatchPtr(obj)).second)
+            return;
+
+        IpAddress address;
+        int prefixlen;
+        if (obj->GetMatchPrefix(table_, &address, &prefixlen)) {
+            MatchPrefix prefix(SubnetAddress(address, prefixlen), prefixlen);
+            prefix_index_[prefixlen][prefix.first].insert(
+                ConditionMatchPtr(obj));
+            match_prefix_map_.insert(make_pair(obj, prefix));
+        } else {
+            unindexed_match_object_list_.insert(ConditionMatchPtr(obj));
+        }
+    }
+
+    void DeleteMatchObject(ConditionMatch *obj) {
+        if (!match_object_list_.erase(ConditionMatchPtr(obj)))
+            return;
+
+        MatchPrefixMap::iterator prefix_it = match_prefix_map_.find(obj);
+        if (prefix_it == match_prefix_map_.end()) {
+            unindexed_match_object_list_.erase(ConditionMatchPtr(obj));
+            return;
+        }
+
+        const MatchPrefix &prefix = prefix_it->second;
+        PrefixIndex::iterator it = prefix_index_.find(prefix.second);
+        assert(it != prefix_index_.end());
+        PrefixMatchMap::iterator loc = it->second.find(prefix.first);
+        assert(loc != it->second.end());
+        loc->second.erase(ConditionMatchPtr(obj));
+        if (loc->second.empty())
+            it->second.erase(loc);
+        if (it->second.empty())
+            prefix_index_.erase(it);
+        match_prefix_map_.erase(prefix_it);
+    }
+
+    static IpAddress SubnetAddress(const IpAddress &address, int prefixlen) {
+        if (address.is_v4()) {
+            return Address::GetIp4SubnetAddress(address.to_v4(), prefixlen);
+        } else {
+            return Address::GetIp6SubnetAddress(address.to_v6(), prefixlen);
+        }
     }
 
     void StoreDoneCb(ConditionMatch *obj,
@@ -99,6 +161,9 @@ private:
     DBTable::DBTableWalkRef walk_ref_;
     WalkList walk_list_;
     MatchList match_object_list_;
+    MatchList unindexed_match_object_list_;
+    PrefixIndex prefix_index_;
+    MatchPrefixMap match_prefix_map_;
     LifetimeRef<ConditionMatchTableState> table_delete_ref_;
     DISALLOW_COPY_AND_ASSIGN(ConditionMatchTableState);
 };
@@ -156,7 +221,6 @@ void BgpConditionListener::AddMatchCondition(BgpTable *table,
     TableWalk(ts, obj, cb);
 }
 
-
 //
 // RemoveMatchCondition:
 // API to Remove ConditionMatch object from a table
@@ -307,6 +371,21 @@ void BgpConditionListener::TableWalk(ConditionMatchTableState *ts,
     ts->table()->WalkTable(ts->walk_ref());
 }
 
+//
+// Invoke Match for all ConditionMatch objects in the given list.
+//
+static void MatchObjects(BgpServer *server, BgpTable *table, BgpRoute *route,
+    bool del_rt, const ConditionMatchTableState::MatchList &list) {
+    for (ConditionMatchTableState::MatchList::const_iterator match_obj_it =
+         list.begin(); match_obj_it != list.end(); ++match_obj_it) {
+        bool deleted = false;
+        if ((*match_obj_it)->deleted() || del_rt) {
+            deleted = true;
+        }
+        (*match_obj_it)->Match(server, table, route, deleted);
+    }
+}
+
 // Table listener
 bool BgpConditionListener::BgpRouteNotify(BgpServer *server,
                                           DBTablePartBase *root,
@@ -323,14 +402,41 @@ bool BgpConditionListener::BgpRouteNotify(BgpServer *server,
     DBTableBase::ListenerId id = ts->GetListenerId();
     assert(id != DBTableBase::kInvalidId);
 
-    for (ConditionMatchTableState::MatchList::iterator match_obj_it =
-         ts->match_objects()->begin();
-        match_obj_it != ts->match_objects()->end(); match_obj_it++) {
-        bool deleted = false;
-        if ((*match_obj_it)->deleted() || del_rt) {
-            deleted = true;
+    // Match all unindexed ConditionMatch objects.
+    MatchObjects(server, bgptable, rt, del_rt, *ts->unindexed_match_objects());
+
+    // Bail if there are no indexed ConditionMatch objects.
+    ConditionMatchTableState::PrefixIndex *prefix_index = ts->prefix_index();
+    IpAddress address;
+    int prefixlen;
+    if (prefix_index->empty() || !rt->GetIpPrefix(&address, &prefixlen))
+        return true;
+
+    // Go through the prefix lengths in the index and match the objects for
+    // prefixes that overlap the route.  For prefix lengths that are shorter
+    // than or equal to the route's, there's at most one prefix that covers
+    // the route.  For longer prefix lengths, all prefixes that are covered
+    // by the route form a contiguous range in the ordered map.
+    IpAddress subnet =
+        ConditionMatchTableState::SubnetAddress(address, prefixlen);
+    for (ConditionMatchTableState::PrefixIndex::iterator it =
+         prefix_index->begin(); it != prefix_index->end(); ++it) {
+        ConditionMatchTableState::PrefixMatchMap *prefix_map = &it->second;
+        if (it->first <= prefixlen) {
+            ConditionMatchTableState::PrefixMatchMap::iterator match_it =
+                prefix_map->find(ConditionMatchTableState::SubnetAddress(
+                    address, it->first));
+            if (match_it != prefix_map->end())
+                MatchObjects(server, bgptable, rt, del_rt, match_it->second);
+        } else {
+            for (ConditionMatchTableState::PrefixMatchMap::iterator match_it =
+                 prefix_map->lower_bound(subnet);
+                 match_it != prefix_map->end() &&
+                 ConditionMatchTableState::SubnetAddress(
+                     match_it->first, prefixlen) == subnet; ++match_it) {
+                MatchObjects(server, bgptable, rt, del_rt, match_it->second);
+            }
         }
-        (*match_obj_it)->Match(server, bgptable, rt, deleted);
     }
     return true;
 }
@@ -368,7 +474,7 @@ void BgpConditionListener::UnregisterMatchCondition(BgpTable *bgptable,
 
     // Wait for Walk completion of deleted ConditionMatch object
     if (obj->deleted() && obj->walk_done()) {
-        ts->match_objects()->erase(obj);
+        ts->DeleteMatchObject(obj);
         purge_list_.insert(ts);
     }
     purge_trigger_->Set();
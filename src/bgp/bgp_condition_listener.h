@@ -14,6 +14,7 @@
 #include <string>
 
 #include "base/util.h"
+#include "net/address.h"
 
 class BgpRoute;
 class BgpServer;
@@ -47,6 +48,18 @@ public:
                        BgpRoute *route, bool deleted) = 0;
     virtual std::string ToString() const = 0;
 
+    // Get the prefix that routes in the given table must overlap with (i.e.
+    // be equal to, more specific than or less specific than) in order to be
+    // matched. BgpConditionListener uses this to index the ConditionMatch and
+    // skips calling Match for routes that don't overlap the prefix.
+    // Returning false means that Match is called for all routes in the table.
+    // The prefix is obtained when the ConditionMatch is added to the table so
+    // it must not change while the ConditionMatch is registered.
+    virtual bool GetMatchPrefix(const BgpTable *table, IpAddress *address,
+                                int *prefixlen) const {
+        return false;
+    }
+
     bool deleted() const { return deleted_; }
 
     void IncrementNumMatchstate() {
@@ -63,6 +76,12 @@ public:
         return num_matchstate_;
     }
 
+protected:
+    static int HostPrefixLength(const IpAddress &address) {
+        return address.is_v4() ?
+            Address::kMaxV4PrefixLen : Address::kMaxV6PrefixLen;
+    }
+
 private:
     friend class BgpConditionListener;
     friend void intrusive_ptr_add_ref(ConditionMatch *match);
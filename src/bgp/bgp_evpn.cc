@@ -137,7 +137,8 @@ bool EvpnMcastNode::UpdateAttributes(EvpnRoute *route) {
 EvpnLocalMcastNode::EvpnLocalMcastNode(EvpnManagerPartition *partition,
     EvpnRoute *route)
     : EvpnMcastNode(partition, route, EvpnMcastNode::LocalNode),
-      inclusive_mcast_route_(NULL) {
+      inclusive_mcast_route_(NULL),
+      olist_version_(0) {
     AddInclusiveMulticastRoute();
     DBTablePartition *tbl_partition = partition_->GetTablePartition();
     tbl_partition->Notify(route_);
@@ -223,7 +224,8 @@ void EvpnLocalMcastNode::TriggerUpdate() {
 // fills in the target RibPeerSet in the UpdateInfo.
 //
 // The main functionality here is to build a per-IPeer BgpOList from the list
-// of EvpnRemoteMcastNodes.
+// of EvpnRemoteMcastNodes. This is done by removing our own address from the
+// appropriate olist that's shared by all EvpnLocalMcastNodes in the partition.
 //
 UpdateInfo *EvpnLocalMcastNode::GetUpdateInfo() {
     CHECK_CONCURRENCY("db::DBTable");
@@ -232,20 +234,39 @@ UpdateInfo *EvpnLocalMcastNode::GetUpdateInfo() {
     if (assisted_replication_leaf_)
         return NULL;
 
-    // Go through list of EvpnRemoteMcastNodes and build the BgpOList.
+    // Rebuild the olists only if the remote EvpnMcastNodes or our attributes
+    // have changed since the last time.
+    if (olist_version_ != partition_->remote_version() ||
+        olist_base_attr_ != attr_) {
+        olist_attr_ = BuildOListAttr();
+        olist_version_ = partition_->remote_version();
+        olist_base_attr_ = attr_;
+    }
+
+    // Bail if both BgpOLists are empty.
+    if (!olist_attr_)
+        return NULL;
+
+    UpdateInfo *uinfo = new UpdateInfo;
+    uinfo->roattr =
+        RibOutAttr(partition_->table(), route_, olist_attr_.get(), 0, false,
+            true);
+    return uinfo;
+}
+
+//
+// Build the BgpAttr with the BgpOList and leaf BgpOList for this node.
+// Return NULL if both BgpOLists are empty.
+//
+BgpAttrPtr EvpnLocalMcastNode::BuildOListAttr() {
+    // Filter our own address from the shared BgpOList.
+    const BgpOListSpec &shared_olist_spec = edge_replication_not_supported_ ?
+        partition_->GetIrOList() : partition_->GetRegularOList();
     BgpOListSpec olist_spec(BgpAttribute::OList);
-    BOOST_FOREACH(EvpnMcastNode *node, partition_->remote_mcast_node_list()) {
-        if (node->address() == address_)
+    olist_spec.elements.reserve(shared_olist_spec.elements.size());
+    BOOST_FOREACH(const BgpOListElem &elem, shared_olist_spec.elements) {
+        if (elem.address == address_)
             continue;
-        if (node->assisted_replication_leaf())
-            continue;
-        if (!edge_replication_not_supported_ &&
-            !node->edge_replication_not_supported())
-            continue;
-
-        const ExtCommunity *extcomm = node->attr()->ext_community();
-        BgpOListElem elem(node->address(), node->label(),
-            extcomm ? extcomm->GetTunnelEncap() : vector<string>());
         olist_spec.elements.push_back(elem);
     }
 
@@ -267,15 +288,10 @@ UpdateInfo *EvpnLocalMcastNode::GetUpdateInfo() {
     if (olist_spec.elements.empty() && leaf_olist_spec.elements.empty())
         return NULL;
 
-    // Add BgpOList and leaf BgpOList to RibOutAttr for broadcast MAC route.
+    // Add BgpOList and leaf BgpOList to the attributes of broadcast MAC route.
     BgpAttrDB *attr_db = partition_->server()->attr_db();
     BgpAttrPtr attr = attr_db->ReplaceOListAndLocate(attr_.get(), &olist_spec);
-    attr = attr_db->ReplaceLeafOListAndLocate(attr.get(), &leaf_olist_spec);
-
-    UpdateInfo *uinfo = new UpdateInfo;
-    uinfo->roattr =
-        RibOutAttr(partition_->table(), route_, attr.get(), 0, false, true);
-    return uinfo;
+    return attr_db->ReplaceLeafOListAndLocate(attr.get(), &leaf_olist_spec);
 }
 
 //
@@ -303,7 +319,13 @@ void EvpnRemoteMcastNode::TriggerUpdate() {
 //
 EvpnManagerPartition::EvpnManagerPartition(EvpnManager *evpn_manager,
     size_t part_id)
-    : evpn_manager_(evpn_manager), part_id_(part_id) {
+    : evpn_manager_(evpn_manager),
+      part_id_(part_id),
+      remote_version_(1),
+      regular_olist_version_(0),
+      ir_olist_version_(0),
+      regular_olist_(BgpAttribute::OList),
+      ir_olist_(BgpAttribute::OList) {
 }
 
 //
@@ -354,6 +376,53 @@ void EvpnManagerPartition::NotifyIrClientNodeRoutes(
     }
 }
 
+//
+// Build a BgpOList from the given list of EvpnMcastNodes. Leaf nodes are
+// never included. Nodes that support edge replication are included only if
+// exclude_edge_replication_supported is false.
+//
+void EvpnManagerPartition::BuildOList(const EvpnMcastNodeList &node_list,
+    bool exclude_edge_replication_supported, BgpOListSpec *olist_spec) {
+    olist_spec->elements.clear();
+    BOOST_FOREACH(EvpnMcastNode *node, node_list) {
+        if (node->assisted_replication_leaf())
+            continue;
+        if (exclude_edge_replication_supported &&
+            !node->edge_replication_not_supported())
+            continue;
+
+        const ExtCommunity *extcomm = node->attr()->ext_community();
+        BgpOListElem elem(node->address(), node->label(),
+            extcomm ? extcomm->GetTunnelEncap() : vector<string>());
+        olist_spec->elements.push_back(elem);
+    }
+}
+
+//
+// Get the BgpOList for EvpnLocalMcastNodes that support edge replication.
+// Rebuild it if the remote EvpnMcastNodes changed since it was last built.
+//
+const BgpOListSpec &EvpnManagerPartition::GetRegularOList() {
+    if (regular_olist_version_ != remote_version_) {
+        BuildOList(regular_node_list_, true, &regular_olist_);
+        regular_olist_version_ = remote_version_;
+    }
+    return regular_olist_;
+}
+
+//
+// Get the BgpOList for EvpnLocalMcastNodes that don't support edge
+// replication. Rebuild it if the remote EvpnMcastNodes changed since it was
+// last built.
+//
+const BgpOListSpec &EvpnManagerPartition::GetIrOList() {
+    if (ir_olist_version_ != remote_version_) {
+        BuildOList(remote_mcast_node_list_, false, &ir_olist_);
+        ir_olist_version_ = remote_version_;
+    }
+    return ir_olist_;
+}
+
 //
 // Add an EvpnMcastNode to the EvpnManagerPartition.
 //
@@ -366,6 +435,7 @@ void EvpnManagerPartition::AddMcastNode(EvpnMcastNode *node) {
             ir_client_node_list_.insert(node);
         NotifyNodeRoute(node);
     } else {
+        remote_version_++;
         remote_mcast_node_list_.insert(node);
         if (node->assisted_replication_leaf()) {
             leaf_node_list_.insert(node);
@@ -388,6 +458,7 @@ void EvpnManagerPartition::DeleteMcastNode(EvpnMcastNode *node) {
         replicator_node_list_.erase(node);
         ir_client_node_list_.erase(node);
     } else {
+        remote_version_++;
         remote_mcast_node_list_.erase(node);
         if (leaf_node_list_.erase(node) > 0) {
             NotifyReplicatorNodeRoutes();
@@ -417,6 +488,7 @@ void EvpnManagerPartition::UpdateMcastNode(EvpnMcastNode *node) {
             ir_client_node_list_.insert(node);
         NotifyNodeRoute(node);
     } else {
+        remote_version_++;
         bool was_leaf = leaf_node_list_.erase(node) > 0;
         if (node->assisted_replication_leaf())
             leaf_node_list_.insert(node);
@@ -99,6 +99,11 @@ private:
 // broadcast MAC route is advertised as the label for ingress replication
 // in the PmsiTunnel attribute.
 //
+// The BgpAttr with the olists that was built the last time is cached along
+// with the version of the partition's remote EvpnMcastNode set that it was
+// built from. This avoids rebuilding the olists if the broadcast MAC route
+// gets notified but none of the inputs have changed.
+//
 class EvpnLocalMcastNode : public EvpnMcastNode {
 public:
     EvpnLocalMcastNode(EvpnManagerPartition *partition, EvpnRoute *route);
@@ -109,10 +114,15 @@ public:
     EvpnRoute *inclusive_mcast_route() { return inclusive_mcast_route_; }
 
 private:
+    BgpAttrPtr BuildOListAttr();
+
     void AddInclusiveMulticastRoute();
     void DeleteInclusiveMulticastRoute();
 
     EvpnRoute *inclusive_mcast_route_;
+    uint64_t olist_version_;
+    BgpAttrPtr olist_base_attr_;
+    BgpAttrPtr olist_attr_;
 
     DISALLOW_COPY_AND_ASSIGN(EvpnLocalMcastNode);
 };
@@ -142,6 +152,20 @@ private:
 // track of local and remote EvpnMcastNodes that belong to the partition. The
 // partition is determined on the ethernet tag in the EvpnRoute.
 //
+// The partition also maintains the ingress replication olists that are common
+// to all EvpnLocalMcastNodes. The regular olist contains the remote nodes that
+// don't support edge replication and is used for vRouters that do support it.
+// The ingress replication olist contains all remote nodes that are not leafs
+// and is used for vRouters that don't support edge replication (test mode).
+//
+// Both olists are rebuilt lazily from the remote node set when it's version
+// changes. The version is bumped whenever a remote EvpnMcastNode is added,
+// deleted or updated. An EvpnLocalMcastNode then only needs to filter out
+// it's own address from the shared olist instead of going through all the
+// remote nodes. This keeps the cost of building the olist for a vRouter
+// proportional to the number of nodes in the olist rather than the number of
+// vRouters in the EVPN instance.
+//
 class EvpnManagerPartition {
 public:
     typedef std::set<EvpnMcastNode *> EvpnMcastNodeList;
@@ -170,11 +194,23 @@ public:
     BgpServer *server();
     const EvpnTable *table() const;
 
+    uint64_t remote_version() const { return remote_version_; }
+    const BgpOListSpec &GetRegularOList();
+    const BgpOListSpec &GetIrOList();
+
 private:
     friend class BgpEvpnManagerTest;
 
+    void BuildOList(const EvpnMcastNodeList &node_list,
+        bool exclude_edge_replication_supported, BgpOListSpec *olist_spec);
+
     EvpnManager *evpn_manager_;
     size_t part_id_;
+    uint64_t remote_version_;
+    uint64_t regular_olist_version_;
+    uint64_t ir_olist_version_;
+    BgpOListSpec regular_olist_;
+    BgpOListSpec ir_olist_;
     EvpnMcastNodeList local_mcast_node_list_;
     EvpnMcastNodeList remote_mcast_node_list_;
     EvpnMcastNodeList replicator_node_list_;
@@ -358,6 +358,9 @@ void BgpMembershipManager::FillPeerMembershipInfo(const IPeer *peer,
     if (sg) {
         resp->set_send_state(
             sg->PeerInSync(nc_peer) ? "in sync" : "not in sync");
+        ShowSendShardStats send_shard_stats;
+        if (sg->FillSendShardInfo(nc_peer, &send_shard_stats))
+            resp->set_send_shard_stats(send_shard_stats);
     } else {
         resp->set_send_state("not advertising");
     }
@@ -1000,7 +1003,9 @@ BgpMembershipManager::Walker::Walker(BgpMembershipManager *manager)
       postpone_walk_(false),
       walk_started_(false),
       walk_completed_(false),
+      path_list_walk_(false),
       rs_(NULL) {
+    path_list_walk_pending_ = 0;
 }
 
 //
@@ -1012,12 +1017,68 @@ BgpMembershipManager::Walker::~Walker() {
     assert(!postpone_walk_);
     assert(!rs_);
     assert(walk_ref_ == NULL);
+    assert(!path_list_walk_);
     assert(peer_rib_list_.empty());
     assert(peer_list_.empty());
     assert(ribout_state_map_.empty());
     assert(ribout_state_list_.empty());
 }
 
+//
+// Task to walk the per peer path lists in a given partition of a BgpTable.
+//
+// A single pass handles all the IPeers in the PeerList of the Walker. Paths
+// for the IPeers are visited one IPeer at a time and the Task yields after
+// visiting the configured number of paths. A marker entry is used to keep
+// track of the position in the list of the current IPeer.
+//
+class BgpMembershipManager::Walker::PathListWalkTask : public Task {
+public:
+    PathListWalkTask(Walker *walker, BgpTable *table, int part_id)
+        : Task(TaskScheduler::GetInstance()->GetTaskId("db::DBTable"),
+               part_id),
+          walker_(walker),
+          table_(table),
+          tpart_(table->GetTablePartition(part_id)),
+          peer_it_(walker->peer_list_.begin()) {
+    }
+
+    virtual bool Run() {
+        CHECK_CONCURRENCY("db::DBTable");
+
+        int count = 0;
+        int max_count = table_->GetWalkIterationToYield();
+        for (; peer_it_ != walker_->peer_list_.end(); ++peer_it_) {
+            if (!table_->WalkPeerPaths(tpart_, *peer_it_, &marker_,
+                &count, max_count,
+                boost::bind(&PathListWalkTask::PathCallback, this,
+                    _1, _2, _3))) {
+                return false;
+            }
+        }
+        walker_->PathListWalkDone();
+        return true;
+    }
+
+    std::string Description() const {
+        return "BgpMembershipManager::Walker::PathListWalkTask";
+    }
+
+private:
+    bool PathCallback(DBTablePartBase *tpart, BgpRoute *route,
+                      BgpPath *path) {
+        return path->GetPeer()->MembershipPathCallback(tpart, route, path);
+    }
+
+    Walker *walker_;
+    BgpTable *table_;
+    DBTablePartBase *tpart_;
+    PeerList::const_iterator peer_it_;
+    BgpPeerPathEntry marker_;
+
+    DISALLOW_COPY_AND_ASSIGN(PathListWalkTask);
+};
+
 //
 // Add the given RibState to the RibStateList if it's not already present.
 // Trigger processing of the RibStateList if a walk is not already in progress.
@@ -1111,6 +1172,40 @@ bool BgpMembershipManager::Walker::WalkCallback(DBTablePartBase *tpart,
 void BgpMembershipManager::Walker::WalkDoneCallback(DBTableBase *table_base) {
     CHECK_CONCURRENCY("db::Walker");
     assert(rs_->table() == table_base);
+
+    walk_completed_ = true;
+    trigger_->Set();
+}
+
+//
+// Start walks of the per peer path lists in all partitions of the BgpTable
+// for the current RibState.
+//
+// The table walk counters are updated so that the path list walk looks like
+// a regular table walk to observers.
+//
+void BgpMembershipManager::Walker::PathListWalkStart() {
+    CHECK_CONCURRENCY("bgp::PeerMembership");
+
+    BgpTable *table = rs_->table();
+    table->incr_walk_request_count();
+    path_list_walk_pending_ = table->PartitionCount();
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    for (int part_id = 0; part_id < table->PartitionCount(); ++part_id) {
+        scheduler->Enqueue(new PathListWalkTask(this, table, part_id));
+    }
+}
+
+//
+// Handle completion of the path list walk for a partition.
+// Note that the walk has completed when the last partition is done and
+// trigger processing from the bgp::PeerMembership task.
+//
+void BgpMembershipManager::Walker::PathListWalkDone() {
+    CHECK_CONCURRENCY("db::DBTable");
+    if (path_list_walk_pending_.fetch_and_decrement() != 1)
+        return;
+    rs_->table()->incr_walk_complete_count();
     walk_completed_ = true;
     trigger_->Set();
 }
@@ -1119,10 +1214,17 @@ void BgpMembershipManager::Walker::WalkDoneCallback(DBTableBase *table_base) {
 // Start a walk for the BgpTable corresponding to the next RibState in the
 // RibStateList.
 //
+// If the BgpTable maintains per peer path lists and there are no RibOuts
+// that need join/leave processing, RibIn processing is done by walking the
+// path lists of the IPeers in the PeerList, which only visits the paths
+// added by them. Otherwise a single table walk does both the RibOut and the
+// RibIn processing, since it visits every route anyway.
+//
 void BgpMembershipManager::Walker::WalkStart() {
     CHECK_CONCURRENCY("bgp::PeerMembership");
 
     assert(walk_ref_ == NULL);
+    assert(!path_list_walk_);
     assert(!rs_);
     assert(peer_rib_list_.empty());
     assert(peer_list_.empty());
@@ -1182,11 +1284,19 @@ void BgpMembershipManager::Walker::WalkStart() {
 
     // Start the walk.
     rs_->increment_walk_count();
+    walk_started_ = true;
     BgpTable *table = rs_->table();
+    path_list_walk_ = table->peer_path_index() && !peer_list_.empty() &&
+        ribout_state_list_.empty();
+    if (path_list_walk_) {
+        if (!postpone_walk_)
+            PathListWalkStart();
+        return;
+    }
+
     walk_ref_ = table->AllocWalker(
         boost::bind(&BgpMembershipManager::Walker::WalkCallback, this, _1, _2),
         boost::bind(&BgpMembershipManager::Walker::WalkDoneCallback, this, _2));
-    walk_started_ = true;
     if (!postpone_walk_)
         table->WalkTable(walk_ref_);
 }
@@ -1201,7 +1311,7 @@ void BgpMembershipManager::Walker::WalkStart() {
 void BgpMembershipManager::Walker::WalkFinish() {
     CHECK_CONCURRENCY("bgp::PeerMembership");
 
-    assert(walk_ref_ != NULL);
+    assert(walk_ref_ != NULL || path_list_walk_);
     assert(rs_);
     assert(!peer_rib_list_.empty());
     assert(!peer_list_.empty() || !ribout_state_map_.empty());
@@ -1238,7 +1348,9 @@ void BgpMembershipManager::Walker::WalkFinish() {
         manager_->EnqueueEvent(event);
     }
 
-    table->ReleaseWalker(walk_ref_);
+    if (walk_ref_ != NULL)
+        table->ReleaseWalker(walk_ref_);
+    path_list_walk_ = false;
     rs_ = NULL;
     peer_rib_list_.clear();
     peer_list_.clear();
@@ -1287,6 +1399,7 @@ void BgpMembershipManager::Walker::SetQueueDisable(bool value) {
 void BgpMembershipManager::Walker::PostponeWalk() {
     assert(!walk_started_);
     assert(walk_ref_ == NULL);
+    assert(!path_list_walk_);
     postpone_walk_ = true;
 }
 
@@ -1297,8 +1410,12 @@ void BgpMembershipManager::Walker::PostponeWalk() {
 void BgpMembershipManager::Walker::ResumeWalk() {
     assert(walk_started_);
     assert(!walk_completed_);
-    assert(walk_ref_ != NULL);
+    assert(walk_ref_ != NULL || path_list_walk_);
     postpone_walk_ = false;
-    BgpTable *table = rs_->table();
-    table->WalkTable(walk_ref_);
+    if (path_list_walk_) {
+        PathListWalkStart();
+    } else {
+        BgpTable *table = rs_->table();
+        table->WalkTable(walk_ref_);
+    }
 }
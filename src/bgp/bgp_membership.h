@@ -445,6 +445,8 @@ public:
 private:
     friend class BgpMembershipTest;
 
+    class PathListWalkTask;
+
     class RibOutState {
     public:
         explicit RibOutState(RibOut *ribout) : ribout_(ribout) { }
@@ -477,6 +479,8 @@ private:
     RibOutState *LocateRibOutState(RibOut *ribout);
     bool WalkCallback(DBTablePartBase *tpart, DBEntryBase *db_entry);
     void WalkDoneCallback(DBTableBase *table);
+    void PathListWalkStart();
+    void PathListWalkDone();
     void WalkStart();
     void WalkFinish();
     bool WalkTrigger();
@@ -498,6 +502,8 @@ private:
     bool postpone_walk_;
     bool walk_started_;
     bool walk_completed_;
+    bool path_list_walk_;
+    tbb::atomic<int> path_list_walk_pending_;
     DBTable::DBTableWalkRef walk_ref_;
     RibState *rs_;
     PeerRibList peer_rib_list_;
@@ -4,6 +4,7 @@
 
 #include "bgp/bgp_message_builder.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "bgp/bgp_log.h"
@@ -14,7 +15,11 @@
 
 using std::auto_ptr;
 
-BgpMessage::BgpMessage(const BgpTable *table) : table_(table), datalen_(0) {
+BgpMessage::BgpMessage(const BgpTable *table, size_t max_size)
+    : table_(table),
+      data_(new uint8_t[max_size]),
+      datasize_(max_size),
+      datalen_(0) {
 }
 
 BgpMessage::~BgpMessage() {
@@ -134,7 +139,7 @@ bool BgpMessage::StartReach(const RibOut *ribout, const RibOutAttr *roattr,
     nlri->nlri.push_back(prefix);
 
     int result =
-        BgpProto::Encode(&update, data_, sizeof(data_), &encode_offsets_);
+        BgpProto::Encode(&update, data_.get(), datasize_, &encode_offsets_);
     if (result <= 0) {
         BGP_LOG_STR(BgpMessage, SandeshLevel::SYS_WARN, BGP_LOG_FLAG_ALL,
             "Error encoding reach message for route " << route->ToString() <<
@@ -160,7 +165,7 @@ bool BgpMessage::StartUnreach(const BgpRoute *route) {
     nlri->nlri.push_back(prefix);
 
     int result =
-        BgpProto::Encode(&update, data_, sizeof(data_), &encode_offsets_);
+        BgpProto::Encode(&update, data_.get(), datasize_, &encode_offsets_);
     if (result <= 0) {
         BGP_LOG_STR(BgpMessage, SandeshLevel::SYS_WARN, BGP_LOG_FLAG_ALL,
             "Error encoding unreach message for route " << route->ToString() <<
@@ -195,8 +200,8 @@ bool BgpMessage::UpdateLength(const char *tag, int size, int delta) {
 }
 
 bool BgpMessage::AddRoute(const BgpRoute *route, const RibOutAttr *roattr) {
-    uint8_t *data = data_ + datalen_;
-    size_t size = sizeof(data_) - datalen_;
+    uint8_t *data = data_.get() + datalen_;
+    size_t size = datasize_ - datalen_;
 
     BgpMpNlri nlri;
     nlri.afi = route->Afi();
@@ -239,17 +244,33 @@ bool BgpMessage::AddRoute(const BgpRoute *route, const RibOutAttr *roattr) {
     return true;
 }
 
+//
+// Replace the buffer with one that's just large enough for the message, so
+// that messages queued in the peers' TcpSessions don't each hold on to the
+// maximum message size.
+//
 void BgpMessage::Finish() {
+    if (datalen_ == datasize_)
+        return;
+    boost::shared_array<uint8_t> data(new uint8_t[datalen_]);
+    std::copy(data_.get(), data_.get() + datalen_, data.get());
+    data_ = data;
+    datasize_ = datalen_;
 }
 
 const uint8_t *BgpMessage::GetData(IPeerUpdate *ipeer_update, size_t *lenp) {
     *lenp = datalen_;
+    return data_.get();
+}
+
+boost::shared_array<uint8_t> BgpMessage::GetSharedData() const {
     return data_;
 }
 
 Message *BgpMessageBuilder::Create(const RibOut *ribout, bool cache_routes,
         const RibOutAttr *roattr, const BgpRoute *route) const {
-    auto_ptr<BgpMessage> msg(new BgpMessage(ribout->table()));
+    auto_ptr<BgpMessage> msg(
+        new BgpMessage(ribout->table(), ribout->max_message_size()));
     if (msg->Start(ribout, roattr, route)) {
         return msg.release();
     } else {
@@ -5,20 +5,35 @@
 #ifndef SRC_BGP_BGP_MESSAGE_BUILDER_H_
 #define SRC_BGP_BGP_MESSAGE_BUILDER_H_
 
+#include <boost/shared_array.hpp>
+
 #include "bgp/bgp_proto.h"
 #include "bgp/message_builder.h"
 
 class RibOut;
 
+//
+// The buffer for the message is sized based on the maximum message size for
+// the RibOut, which is larger than BgpProto::kMaxMessageSize if the peers in
+// the RibOut have negotiated the BGP Extended Message capability.
+//
+// The encoded message is the same for all peers, so the buffer is reference
+// counted and handed to the peers as is. Finish trims it to the size of the
+// message, since the peers may hold on to it while their sockets are blocked.
+// That's one allocation and copy per message, regardless of the number of
+// peers.
+//
 class BgpMessage : public Message {
 public:
-    explicit BgpMessage(const BgpTable *table = NULL);
+    explicit BgpMessage(const BgpTable *table = NULL,
+        size_t max_size = BgpProto::kMaxMessageSize);
     virtual ~BgpMessage();
     bool Start(const RibOut *ribout, const RibOutAttr *roattr,
                const BgpRoute *route);
     virtual bool AddRoute(const BgpRoute *route, const RibOutAttr *roattr);
     virtual void Finish();
     virtual const uint8_t *GetData(IPeerUpdate *ipeer_update, size_t *lenp);
+    virtual boost::shared_array<uint8_t> GetSharedData() const;
 
 private:
     bool StartReach(const RibOut *ribout, const RibOutAttr *roattr,
@@ -28,7 +43,8 @@ private:
 
     const BgpTable *table_;
     EncodeOffsets encode_offsets_;
-    uint8_t data_[BgpProto::kMaxMessageSize];
+    boost::shared_array<uint8_t> data_;
+    size_t datasize_;
     size_t datalen_;
 
     DISALLOW_COPY_AND_ASSIGN(BgpMessage);
@@ -58,7 +58,8 @@ McastForwarder::McastForwarder(McastSGEntry *sg_entry, ErmVpnRoute *route)
       label_(0),
       address_(0),
       rd_(route->GetPrefix().route_distinguisher()),
-      router_id_(route->GetPrefix().router_id()) {
+      router_id_(route->GetPrefix().router_id()),
+      tree_index_(-1) {
     const BgpPath *path = route->BestPath();
     const BgpAttr *attr = path->GetAttr();
 
@@ -360,6 +361,7 @@ McastSGEntry::McastSGEntry(McastManagerPartition *partition,
       group_(group),
       source_(source),
       forest_node_(NULL),
+      forest_node_label_(0),
       local_tree_route_(NULL),
       tree_result_route_(NULL),
       on_work_queue_(false) {
@@ -367,6 +369,9 @@ McastSGEntry::McastSGEntry(McastManagerPartition *partition,
          level < McastTreeManager::LevelCount; ++level) {
         ForwarderSet *forwarders = new ForwarderSet;
         forwarder_sets_.push_back(forwarders);
+        pending_sets_.push_back(new ForwarderSet);
+        changed_sets_.push_back(new ForwarderSet);
+        tree_nodes_.push_back(McastForwarderList());
         update_needed_.push_back(false);
     }
 }
@@ -375,6 +380,8 @@ McastSGEntry::McastSGEntry(McastManagerPartition *partition,
 // Destructor for McastSGEntry.
 //
 McastSGEntry::~McastSGEntry() {
+    STLDeleteValues(&changed_sets_);
+    STLDeleteValues(&pending_sets_);
     STLDeleteValues(&forwarder_sets_);
 }
 
@@ -392,6 +399,7 @@ std::string McastSGEntry::ToString() const {
 void McastSGEntry::AddForwarder(McastForwarder *forwarder) {
     uint8_t level = forwarder->level();
     forwarder_sets_[level]->insert(forwarder);
+    pending_sets_[level]->insert(forwarder);
     update_needed_[level] = true;
     partition_->EnqueueSGEntry(this);
 }
@@ -400,11 +408,31 @@ void McastSGEntry::AddForwarder(McastForwarder *forwarder) {
 // Handle change for the given McastForwarder under this McastSGEntry. Trigger
 // update of the distribution tree.
 //
+// The McastForwarder keeps it's position in the distribution tree. It and all
+// it's neighbors are added to the changed set since the address, encap and/or
+// label in their olists need to be updated. A new label is allocated if the
+// label block changed. The McastForwarder is moved to the pending set if the
+// label can't be allocated. It stays in the changed set in that case, since
+// it's olist is now empty and the agent needs to be told.
+//
 // Note that this method only handles the change = the caller determines that
 // there has been a change.
 //
 void McastSGEntry::ChangeForwarder(McastForwarder *forwarder) {
     uint8_t level = forwarder->level();
+    if (forwarder->tree_index() >= 0) {
+        ForwarderSet *changed = changed_sets_[level];
+        changed->insert(forwarder);
+        changed->insert(forwarder->tree_links().begin(),
+            forwarder->tree_links().end());
+        if (!forwarder->label())
+            forwarder->AllocateLabel();
+        if (!forwarder->label()) {
+            RemoveTreeNode(level, forwarder);
+            changed->insert(forwarder);
+            pending_sets_[level]->insert(forwarder);
+        }
+    }
     update_needed_[level] = true;
     partition_->EnqueueSGEntry(this);
 }
@@ -413,10 +441,17 @@ void McastSGEntry::ChangeForwarder(McastForwarder *forwarder) {
 // Delete the given McastForwarder from this McastSGEntry and trigger update
 // of the distribution tree.
 //
+// The McastForwarder is removed from the distribution tree right away since
+// it's about to be destroyed.
+//
 void McastSGEntry::DeleteForwarder(McastForwarder *forwarder) {
     if (forwarder == forest_node_)
         forest_node_ = NULL;
     uint8_t level = forwarder->level();
+    if (forwarder->tree_index() >= 0)
+        RemoveTreeNode(level, forwarder);
+    pending_sets_[level]->erase(forwarder);
+    changed_sets_[level]->erase(forwarder);
     forwarder_sets_[level]->erase(forwarder);
     update_needed_[level] = true;
     partition_->EnqueueSGEntry(this);
@@ -449,26 +484,14 @@ const RouteDistinguisher &McastSGEntry::GetSourceRd() const {
 // relative order of nodes in the tree.
 //
 void McastSGEntry::AddLocalTreeRoute() {
-    assert(!forest_node_);
     assert(!local_tree_route_);
 
-    // Select last usable leaf in the distribution tree as the forest node.
-    // A leaf is considered usable if it has a valid label i.e. it has not
-    // run out of labels.
-    uint8_t level = McastTreeManager::LevelNative;
-    ForwarderSet *forwarders = forwarder_sets_[level];
-    for (ForwarderSet::reverse_iterator rit = forwarders->rbegin();
-         rit != forwarders->rend(); ++rit) {
-        McastForwarder *forwarder = *rit;
-        if (forwarder->label()) {
-            forest_node_ = forwarder;
-            break;
-        }
-    }
-
     // Bail if we couldn't designate a forest node.
+    forest_node_ = SelectForestNode();
     if (!forest_node_)
         return;
+    forest_node_address_ = forest_node_->address();
+    forest_node_label_ = forest_node_->label();
 
     // Construct the prefix and route key.
     BgpServer *server = partition_->server();
@@ -525,7 +548,6 @@ void McastSGEntry::DeleteLocalTreeRoute() {
     if (!local_tree_route_)
         return;
 
-    forest_node_ = NULL;
     DBTablePartition *tbl_partition =
         static_cast<DBTablePartition *>(partition_->GetTablePartition());
     local_tree_route_->RemovePath(BgpPath::Local);
@@ -555,21 +577,71 @@ void McastSGEntry::UpdateLocalTreeRoute() {
     AddLocalTreeRoute();
 }
 
+//
+// Select the forest node for the distribution tree of Native McastForwarders.
+//
+// The current forest node is kept as long as it's still a leaf in the tree,
+// so that the LocalTreeRoute doesn't change as McastForwarders join and leave.
+// The last leaf is picked otherwise. A leaf has a single native link, so the
+// kDegree - 1 global edges advertised for it keep it's olist within kDegree.
+// All McastForwarders in the tree have a valid label.
+//
+McastForwarder *McastSGEntry::SelectForestNode() const {
+    const McastForwarderList &tree = tree_nodes_[McastTreeManager::LevelNative];
+    if (forest_node_ && forest_node_->tree_index() >= 0) {
+        int first_child_idx =
+            forest_node_->tree_index() * McastTreeManager::kDegree + 1;
+        if (first_child_idx >= static_cast<int>(tree.size()))
+            return forest_node_;
+    }
+    return tree.empty() ? NULL : tree.back();
+}
+
 //
 // Update relevant [Local|Global]TreeRoutes for the McastSGEntry.
 //
+// Only the McastForwarders in the changed set need to be looked at since the
+// olists and forwarding edges for all other McastForwarders are unchanged.
+// Note that DBListeners will not get invoked until after this routine is done.
+//
+// The LocalTreeRoute is updated only if the forest node left the tree or if
+// its address or label changed. Both the previous and the new forest node are
+// notified so that the global edges in their olists get updated.
+//
 void McastSGEntry::UpdateRoutes(uint8_t level) {
+    DBTablePartBase *tbl_partition = partition_->GetTablePartition();
+    ForwarderSet *changed = changed_sets_[level];
+    for (ForwarderSet::iterator it = changed->begin();
+         it != changed->end(); ++it) {
+        McastForwarder *forwarder = *it;
+        tbl_partition->Notify(forwarder->route());
+        if (level == McastTreeManager::LevelLocal) {
+            forwarder->DeleteGlobalTreeRoute();
+            forwarder->AddGlobalTreeRoute();
+        }
+    }
+
     if (level == McastTreeManager::LevelNative) {
-        DeleteLocalTreeRoute();
-        AddLocalTreeRoute();
-    } else {
-        ForwarderSet *forwarders = forwarder_sets_[level];
-        for (ForwarderSet::iterator it = forwarders->begin();
-             it != forwarders->end(); ++it) {
-            (*it)->DeleteGlobalTreeRoute();
-            (*it)->AddGlobalTreeRoute();
+        McastForwarder *forest_node = SelectForestNode();
+        bool update_needed = (forest_node != forest_node_);
+        if (!forest_node) {
+            update_needed |= (local_tree_route_ != NULL);
+        } else {
+            update_needed |= (local_tree_route_ == NULL);
+            update_needed |= (forest_node->address() != forest_node_address_);
+            update_needed |= (forest_node->label() != forest_node_label_);
+        }
+        if (update_needed) {
+            McastForwarder *prev_forest_node = forest_node_;
+            DeleteLocalTreeRoute();
+            AddLocalTreeRoute();
+            if (prev_forest_node && prev_forest_node != forest_node_)
+                tbl_partition->Notify(prev_forest_node->route());
+            NotifyForestNode();
         }
     }
+
+    changed->clear();
 }
 
 //
@@ -592,75 +664,146 @@ bool McastSGEntry::IsTreeBuilder(uint8_t level) const {
 }
 
 //
+// Get the degree of the k-ary distribution tree for the given level.
 //
-// Update specified distribution tree for the McastSGEntry.  We traverse all
-// McastForwarders in sorted order and arrange them in breadth first fashion
-// in a k-ary tree.  Building the tree in this manner guarantees that we get
-// the same tree for a given set of forwarders, independent of the order in
-// in which they joined. This predictability is deemed to be more important
-// than other criteria such as minimizing disruption of traffic, minimizing
-// the cost/weight of the tree etc.
-//
-void McastSGEntry::UpdateTree(uint8_t level) {
-    CHECK_CONCURRENCY("db::DBTable");
-
-    if (!update_needed_[level])
-        return;
-    update_needed_[level] = false;
-
-    int degree;
+int McastSGEntry::GetDegree(uint8_t level) const {
     if (level == McastTreeManager::LevelNative) {
-        degree = McastTreeManager::kDegree;
+        return McastTreeManager::kDegree;
     } else {
-        degree = McastTreeManager::kDegree - 1;
+        return McastTreeManager::kDegree - 1;
     }
+}
 
-    // First get rid of the previous distribution tree and enqueue all the
-    // associated ErmVpnRoutes for notification. Note that DBListeners will
-    // not get invoked until after this routine is done.
-    ForwarderSet *forwarders = forwarder_sets_[level];
-    for (ForwarderSet::iterator it = forwarders->begin();
-         it != forwarders->end(); ++it) {
-       (*it)->FlushLinks();
-       (*it)->ReleaseLabel();
-       partition_->GetTablePartition()->Notify((*it)->route());
+//
+// Link the McastForwarder at the given index in the distribution tree to the
+// McastForwarders at the parent and child positions, if any. We also add the
+// reverse links. All McastForwarders involved are added to the changed set.
+//
+void McastSGEntry::LinkTreeNode(uint8_t level, int idx) {
+    McastForwarderList &tree = tree_nodes_[level];
+    ForwarderSet *changed = changed_sets_[level];
+    int degree = GetDegree(level);
+    McastForwarder *forwarder = tree[idx];
+    changed->insert(forwarder);
+
+    if (idx != 0) {
+        McastForwarder *parent_forwarder = tree[(idx - 1) / degree];
+        forwarder->AddLink(parent_forwarder);
+        parent_forwarder->AddLink(forwarder);
+        changed->insert(parent_forwarder);
     }
 
-    // Bail if we're not the tree builder.
-    if (!IsTreeBuilder(level)) {
-        UpdateRoutes(level);
-        return;
+    int size = tree.size();
+    for (int child_idx = idx * degree + 1;
+         child_idx <= idx * degree + degree && child_idx < size; ++child_idx) {
+        McastForwarder *child_forwarder = tree[child_idx];
+        forwarder->AddLink(child_forwarder);
+        child_forwarder->AddLink(forwarder);
+        changed->insert(child_forwarder);
     }
+}
+
+//
+// Insert the given McastForwarder as the last leaf of the distribution tree.
+// Only the McastForwarder and it's parent get relinked.
+//
+void McastSGEntry::InsertTreeNode(uint8_t level, McastForwarder *forwarder) {
+    assert(forwarder->tree_index() < 0);
+    McastForwarderList &tree = tree_nodes_[level];
+    forwarder->set_tree_index(tree.size());
+    tree.push_back(forwarder);
+    LinkTreeNode(level, forwarder->tree_index());
+}
+
+//
+// Remove the given McastForwarder from the distribution tree and release it's
+// label. The last leaf in the tree is moved into the vacated position so that
+// the tree stays balanced. Only the neighbors of the removed McastForwarder,
+// the last leaf and it's parent get relinked.
+//
+void McastSGEntry::RemoveTreeNode(uint8_t level, McastForwarder *forwarder) {
+    McastForwarderList &tree = tree_nodes_[level];
+    ForwarderSet *changed = changed_sets_[level];
+    int idx = forwarder->tree_index();
+    assert(idx >= 0 && tree[idx] == forwarder);
+
+    changed->insert(forwarder->tree_links().begin(),
+        forwarder->tree_links().end());
+    forwarder->FlushLinks();
+    forwarder->ReleaseLabel();
+    forwarder->set_tree_index(-1);
+    changed->erase(forwarder);
 
-    // Create a vector of pointers to the McastForwarders in sorted order.
-    // We do this because std::set doesn't support random access iterators.
-    // Skip if we can't allocate a label for the McastForwarder.
-    McastForwarderList vec;
-    vec.reserve(forwarders->size());
-    for (ForwarderSet::iterator it = forwarders->begin();
-         it != forwarders->end(); ++it) {
+    McastForwarder *last_forwarder = tree.back();
+    tree.pop_back();
+    if (last_forwarder == forwarder)
+        return;
+
+    // Move the last leaf into the vacated position.
+    changed->insert(last_forwarder->tree_links().begin(),
+        last_forwarder->tree_links().end());
+    last_forwarder->FlushLinks();
+    tree[idx] = last_forwarder;
+    last_forwarder->set_tree_index(idx);
+    LinkTreeNode(level, idx);
+}
+
+//
+// Get rid of the distribution tree for the given level.  All McastForwarders
+// in the tree are moved to the pending set so that they get added back if we
+// become the tree builder again.
+//
+void McastSGEntry::FlushTree(uint8_t level) {
+    McastForwarderList &tree = tree_nodes_[level];
+    ForwarderSet *changed = changed_sets_[level];
+    for (McastForwarderList::iterator it = tree.begin();
+         it != tree.end(); ++it) {
         McastForwarder *forwarder = *it;
-        forwarder->AllocateLabel();
-        if (!forwarder->label())
-            continue;
-        vec.push_back(forwarder);
+        forwarder->FlushLinks();
+        forwarder->ReleaseLabel();
+        forwarder->set_tree_index(-1);
+        changed->insert(forwarder);
+        pending_sets_[level]->insert(forwarder);
     }
+    tree.clear();
+}
 
-    // Go through each McastForwarder in the vector and link it to it's parent
-    // McastForwarder in the k-ary tree. We also add a link from the parent to
-    // the entry in question.
-    for (McastForwarderList::iterator it = vec.begin(); it != vec.end(); ++it) {
-        int idx = it - vec.begin();
-        if (idx == 0)
-            continue;
-
-        int parent_idx = (idx - 1) / degree;
-        McastForwarderList::iterator parent_it = vec.begin() + parent_idx;
-        assert(parent_it != vec.end());
-        McastForwarder *forwarder = *it;
-        McastForwarder *parent_forwarder = *parent_it;
-        forwarder->AddLink(parent_forwarder);
-        parent_forwarder->AddLink(forwarder);
+//
+// Update specified distribution tree for the McastSGEntry.
+//
+// McastForwarders that joined or changed since the last update are added as
+// leaves in sorted order.  McastForwarders that left have already been taken
+// out of the tree. Labels for McastForwarders that were not relinked remain
+// unchanged and their ErmVpnRoutes are not notified. Hence a join or a leave
+// results in updates to a bounded number of McastForwarders, independent of
+// the size of the tree. The trade-off is that the shape of the tree depends
+// on the order in which McastForwarders joined and left.
+//
+// A McastForwarder for which we can't allocate a label is left on the pending
+// set and is retried on the next update.
+//
+void McastSGEntry::UpdateTree(uint8_t level) {
+    CHECK_CONCURRENCY("db::DBTable");
+
+    if (!update_needed_[level])
+        return;
+    update_needed_[level] = false;
+
+    if (!IsTreeBuilder(level)) {
+        FlushTree(level);
+    } else {
+        ForwarderSet *pending = pending_sets_[level];
+        for (ForwarderSet::iterator it = pending->begin();
+             it != pending->end(); ) {
+            McastForwarder *forwarder = *it;
+            forwarder->AllocateLabel();
+            if (!forwarder->label()) {
+                ++it;
+                continue;
+            }
+            pending->erase(it++);
+            InsertTreeNode(level, forwarder);
+        }
     }
 
     // Update [Local|Global]TreeRoutes.
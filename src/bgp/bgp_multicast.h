@@ -72,6 +72,10 @@ typedef std::vector<McastForwarder *> McastForwarderList;
 // distribution tree. Thus the label can be stored in the McastForwarder itself
 // and does not need to be part of the link information.
 //
+// The tree_index_ is the position of the McastForwarder in the McastSGEntry's
+// array representation of the distribution tree at it's NodeLevel. It's -1 if
+// the McastForwarder is not currently part of the distribution tree.
+//
 // If this control-node is elected as the tree builder for the (G,S), a global
 // distribution tree of all Local McastForwarders is built.  Relevant edges of
 // this global distribution tree are advertised to each control-node by adding
@@ -110,6 +114,10 @@ public:
     Ip4Address router_id() const { return router_id_; }
 
     bool empty() { return tree_links_.empty(); }
+    const McastForwarderList &tree_links() const { return tree_links_; }
+
+    int tree_index() const { return tree_index_; }
+    void set_tree_index(int tree_index) { tree_index_ = tree_index; }
 
 private:
     friend class BgpMulticastTest;
@@ -129,6 +137,7 @@ private:
     Ip4Address router_id_;
     std::vector<std::string> encap_;
     McastForwarderList tree_links_;
+    int tree_index_;
 
     DISALLOW_COPY_AND_ASSIGN(McastForwarder);
 };
@@ -177,11 +186,31 @@ struct McastForwarderCompare {
 // are advertising their local subtree's candidate edges via a LocalTreeRoute.
 // The sets are keyed by the RD and RouterId of the McastForwarders.
 //
-// A local distribution tree of all Native McastForwarders is built and the
-// last leaf in the tree is designated as the forest node.  The forest_node_
-// is used to keep track of this McastForwarder.  A LocalTreeRoute is added to
-// the ErmVpnTable and the forest node's candidate edges are advertised using
-// the EdgeDiscovery attribute. The local_tree_route_ keeps track of the route.
+// The distribution tree for each NodeLevel is kept in a vector of pointers to
+// McastForwarders that is laid out like a k-ary heap i.e. the parent of the
+// node at index idx is at index (idx - 1) / degree. The tree is maintained
+// incrementally. A new McastForwarder is appended as a leaf and is linked to
+// it's parent. When a McastForwarder is removed, the last node in the vector
+// is moved into the vacated position and relinked to the parent and children
+// of that position. This keeps the tree balanced and degree-limited without
+// relinking or relabeling any other McastForwarders.
+//
+// McastForwarders that are not yet part of the tree are kept in the pending
+// set for their NodeLevel. This includes McastForwarders for which a label
+// could not be allocated and all McastForwarders at the Local level if this
+// control-node is not the tree builder.  McastForwarders whose links changed
+// as a result of an insert or remove are kept in the changed set for their
+// NodeLevel. Only the ErmVpnRoutes and GlobalTreeRoutes for these need to be
+// updated when the McastSGEntry is processed from the WorkQueue.
+//
+// A local distribution tree of all Native McastForwarders is built and one of
+// the McastForwarders in the tree is designated as the forest node. The last
+// leaf is picked initially and the forest node then stays the same until it
+// leaves the tree or gets children of it's own. The forest_node_ is used to
+// keep track of this McastForwarder, along with the address and label that
+// were advertised for it.  A LocalTreeRoute is added to the ErmVpnTable and
+// the forest node's candidate edges are advertised using the EdgeDiscovery
+// attribute. The local_tree_route_ keeps track of the route.
 //
 // If this control-node is elected to be the tree builder for this (G,S), a
 // global distribution tree of all Local McastForwarders is built.  Relevant
@@ -241,15 +270,26 @@ private:
     typedef std::set<McastForwarder *, McastForwarderCompare> ForwarderSet;
 
     bool IsTreeBuilder(uint8_t level) const;
+    int GetDegree(uint8_t level) const;
+    void LinkTreeNode(uint8_t level, int idx);
+    void InsertTreeNode(uint8_t level, McastForwarder *forwarder);
+    void RemoveTreeNode(uint8_t level, McastForwarder *forwarder);
+    void FlushTree(uint8_t level);
     void UpdateTree(uint8_t level);
     void UpdateRoutes(uint8_t level);
+    McastForwarder *SelectForestNode() const;
 
     McastManagerPartition *partition_;
     Ip4Address group_, source_;
     McastForwarder *forest_node_;
+    Ip4Address forest_node_address_;
+    uint32_t forest_node_label_;
     ErmVpnRoute *local_tree_route_;
     ErmVpnRoute *tree_result_route_;
     std::vector<ForwarderSet *> forwarder_sets_;
+    std::vector<ForwarderSet *> pending_sets_;
+    std::vector<ForwarderSet *> changed_sets_;
+    std::vector<McastForwarderList> tree_nodes_;
     std::vector<bool> update_needed_;
     bool on_work_queue_;
 
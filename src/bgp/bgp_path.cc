@@ -6,6 +6,7 @@
 
 #include <boost/foreach.hpp>
 
+#include "base/slab_allocator.h"
 #include "bgp/bgp_route.h"
 #include "bgp/bgp_peer.h"
 #include "net/community_type.h"
@@ -13,6 +14,31 @@
 using std::string;
 using std::vector;
 
+//
+// The allocator is intentionally never destroyed so that paths can be freed
+// safely during process exit.
+//
+static SlabAllocator *BgpPathAllocator() {
+    static SlabAllocator *allocator = new SlabAllocator("BgpPath");
+    return allocator;
+}
+
+void *BgpPath::operator new(size_t size) {
+    return BgpPathAllocator()->Allocate(size);
+}
+
+void BgpPath::operator delete(void *ptr, size_t size) {
+    BgpPathAllocator()->Free(ptr, size);
+}
+
+void *BgpPeerPathEntry::operator new(size_t size) {
+    return BgpPathAllocator()->Allocate(size);
+}
+
+void BgpPeerPathEntry::operator delete(void *ptr, size_t size) {
+    BgpPathAllocator()->Free(ptr, size);
+}
+
 string BgpPath::PathIdString(uint32_t path_id) {
     Ip4Address addr(path_id);
     return addr.to_string();
@@ -21,25 +47,27 @@ string BgpPath::PathIdString(uint32_t path_id) {
 BgpPath::BgpPath(const IPeer *peer, uint32_t path_id, PathSource src,
                  const BgpAttrPtr ptr, uint32_t flags, uint32_t label)
     : peer_(peer), path_id_(path_id), source_(src), attr_(ptr),
-      original_attr_(ptr), flags_(flags), label_(label) {
+      original_attr_(ptr), flags_(flags), label_(label),
+      peer_path_entry_(NULL) {
 }
 
 BgpPath::BgpPath(const IPeer *peer, PathSource src, const BgpAttrPtr ptr,
         uint32_t flags, uint32_t label)
     : peer_(peer), path_id_(0), source_(src), attr_(ptr), original_attr_(ptr),
-      flags_(flags), label_(label) {
+      flags_(flags), label_(label), peer_path_entry_(NULL) {
 }
 
 BgpPath::BgpPath(uint32_t path_id, PathSource src, const BgpAttrPtr ptr,
         uint32_t flags, uint32_t label)
     : peer_(NULL), path_id_(path_id), source_(src), attr_(ptr),
-      original_attr_(ptr), flags_(flags), label_(label) {
+      original_attr_(ptr), flags_(flags), label_(label),
+      peer_path_entry_(NULL) {
 }
 
 BgpPath::BgpPath(PathSource src, const BgpAttrPtr ptr,
         uint32_t flags, uint32_t label)
     : peer_(NULL), path_id_(0), source_(src), attr_(ptr), original_attr_(ptr),
-      flags_(flags), label_(label) {
+      flags_(flags), label_(label), peer_path_entry_(NULL) {
 }
 
 // True is better
@@ -5,6 +5,8 @@
 #ifndef SRC_BGP_BGP_PATH_H_
 #define SRC_BGP_BGP_PATH_H_
 
+#include <boost/intrusive/list.hpp>
+
 #include <string>
 #include <vector>
 
@@ -12,10 +14,33 @@
 #include "route/path.h"
 #include "bgp/bgp_attr.h"
 
+class BgpPath;
 class BgpTable;
 class BgpRoute;
 class IPeer;
 
+//
+// Linkage of a BgpPath in the BgpTable's list of paths added by its IPeer in
+// the table partition of the BgpRoute. Entries are only allocated for paths
+// that are on such a list, so that other paths and paths in tables without
+// the per peer path index don't pay for the linkage.
+//
+// An entry without a BgpRoute is used as a marker during walks.
+//
+struct BgpPeerPathEntry {
+    BgpPeerPathEntry() : route(NULL), path(NULL) { }
+    BgpPeerPathEntry(BgpRoute *route, BgpPath *path)
+        : route(route), path(path) {
+    }
+
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+
+    boost::intrusive::list_member_hook<> node;
+    BgpRoute *route;
+    BgpPath *path;
+};
+
 class BgpPath : public Path {
 public:
     enum PathFlag {
@@ -57,6 +82,11 @@ public:
     virtual ~BgpPath() {
     }
 
+    // Paths are carved out of a slab allocator to reduce heap contention
+    // between db::DBTable partitions.
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+
     RouteDistinguisher GetSourceRouteDistinguisher() const;
 
     bool IsVrfOriginated() const {
@@ -129,6 +159,8 @@ public:
     bool PathSameNeighborAs(const BgpPath &rhs) const;
 
 private:
+    friend class BgpTable;
+
     const IPeer *peer_;
     const uint32_t path_id_;
     const PathSource source_;
@@ -139,6 +171,10 @@ private:
     BgpAttrPtr original_attr_;
     uint32_t flags_;
     uint32_t label_;
+
+    // Entry in the BgpTable's list of paths added by peer_. Only primary,
+    // unresolved paths from a peer are on such a list.
+    BgpPeerPathEntry *peer_path_entry_;
 };
 
 class BgpSecondaryPath : public BgpPath {
@@ -20,6 +20,7 @@
 #include "bgp/bgp_session.h"
 #include "bgp/bgp_session_manager.h"
 #include "bgp/bgp_peer_types.h"
+#include "bgp/bgp_update_capture.h"
 #include "bgp/ermvpn/ermvpn_table.h"
 #include "bgp/evpn/evpn_table.h"
 #include "bgp/inet/inet_table.h"
@@ -385,18 +386,21 @@ BgpPeerFamilyAttributes::BgpPeerFamilyAttributes(
 }
 
 RibExportPolicy BgpPeer::BuildRibExportPolicy(Address::Family family) const {
+    RibExportPolicy policy;
     BgpPeerFamilyAttributes *family_attributes =
         family_attributes_list_[family];
     if (!family_attributes ||
         family_attributes->gateway_address.is_unspecified()) {
-        return RibExportPolicy(peer_type_, RibExportPolicy::BGP, peer_as_,
+        policy = RibExportPolicy(peer_type_, RibExportPolicy::BGP, peer_as_,
             as_override_, peer_close_->IsCloseLongLivedGraceful(), -1, 0);
     } else {
         IpAddress nexthop = family_attributes->gateway_address;
-        return RibExportPolicy(peer_type_, RibExportPolicy::BGP, peer_as_,
+        policy = RibExportPolicy(peer_type_, RibExportPolicy::BGP, peer_as_,
             as_override_, peer_close_->IsCloseLongLivedGraceful(), nexthop,
             -1, 0);
     }
+    policy.max_message_size = GetMaxMessageSize();
+    return policy;
 }
 
 void BgpPeer::ReceiveEndOfRIB(Address::Family family, size_t msgsize) {
@@ -563,6 +567,8 @@ BgpPeer::BgpPeer(BgpServer *server, RoutingInstance *instance,
                    TaskScheduler::GetInstance()->GetTaskId("bgp::StateMachine"),
                    GetTaskInstance()),
           buffer_len_(0),
+          copy_buffer_size_(0),
+          copy_buffer_len_(0),
           session_(NULL),
           keepalive_timer_(TimerManager::CreateTimer(*server->ioservice(),
                      "BGP keepalive timer",
@@ -597,6 +603,7 @@ BgpPeer::BgpPeer(BgpServer *server, RoutingInstance *instance,
           last_flap_(0),
           inuse_authkey_type_(AuthenticationData::NIL) {
     membership_req_pending_ = 0;
+    extended_message_negotiated_ = false;
     BGP_LOG_PEER(Event, this, SandeshLevel::SYS_INFO, BGP_LOG_FLAG_ALL,
         BGP_PEER_DIR_NA, "Created");
 
@@ -1330,6 +1337,14 @@ void BgpPeer::SendOpen(TcpSession *session) {
     AddGRCapabilities(opt_param);
     AddLLGRCapabilities(opt_param);
 
+    // Indicate support for BGP Extended Message (RFC 8654) if enabled.
+    if (server_->extended_message_enable()) {
+        BgpProto::OpenMessage::Capability *ext_msg_cap =
+            new BgpProto::OpenMessage::Capability(
+                BgpProto::OpenMessage::Capability::ExtendedMessage, NULL, 0);
+        opt_param->capabilities.push_back(ext_msg_cap);
+    }
+
     if (opt_param->capabilities.size()) {
         openmsg.opt_params.push_back(opt_param);
     } else {
@@ -1376,18 +1391,55 @@ static bool SkipUpdateSend() {
 }
 
 //
-// Accumulate the message in the update buffer.
-// Flush the existing buffer if the message can't fit.
-// Note that FlushUpdate resets buffer_len_ to 0.
+// Copy the message to the end of the copy buffer and accumulate a reference
+// to it. This is only used for messages that are not in a reference counted
+// buffer already.
+//
+// A new copy buffer is allocated only when the message doesn't fit in the
+// current one. Data that has been copied is never modified, so the buffer
+// can be shared with the TcpSession, even after it has been flushed.
 //
 bool BgpPeer::SendUpdate(const uint8_t *msg, size_t msgsize) {
+    if (copy_buffer_len_ + msgsize > copy_buffer_size_) {
+        copy_buffer_size_ = kBufferSize;
+        if (msgsize > copy_buffer_size_)
+            copy_buffer_size_ = msgsize;
+        copy_buffer_.reset(new uint8_t[copy_buffer_size_]);
+        copy_buffer_len_ = 0;
+    }
+    copy(msg, msg + msgsize, copy_buffer_.get() + copy_buffer_len_);
+    TcpSession::SharedBuffer buffer(copy_buffer_, copy_buffer_len_, msgsize);
+    copy_buffer_len_ += msgsize;
+    return AppendUpdate(buffer);
+}
+
+//
+// Accumulate a reference to the builder's buffer for the message. The
+// message itself is never copied.
+//
+bool BgpPeer::SendSharedUpdate(const boost::shared_array<uint8_t> &msg,
+                               size_t msgsize) {
+    return AppendUpdate(TcpSession::SharedBuffer(msg, msgsize));
+}
+
+//
+// Accumulate the buffer in the list of update buffers.
+// Flush the existing buffers if the message can't fit in kBufferSize bytes
+// or if there are too many buffers already.
+// Note that FlushUpdate resets buffer_len_ to 0.
+//
+// The buffers get sent with a single gather write and are retained by the
+// TcpSession if the socket blocks.
+//
+bool BgpPeer::AppendUpdate(const TcpSession::SharedBuffer &buffer) {
     bool send_ready = true;
-    if (buffer_len_ + msgsize > kBufferSize) {
+    if (buffer_len_ + buffer.size() > kBufferSize ||
+        update_buffers_.size() >= kMaxUpdateBuffers) {
         send_ready = FlushUpdate();
         assert(buffer_len_ == 0);
     }
-    copy(msg, msg + msgsize, buffer_ + buffer_len_);
-    buffer_len_ += msgsize;
+    update_buffers_.push_back(buffer);
+    buffer_len_ += buffer.size();
     inc_tx_update();
     return send_ready;
 }
@@ -1395,18 +1447,20 @@ bool BgpPeer::SendUpdate(const uint8_t *msg, size_t msgsize) {
 bool BgpPeer::FlushUpdate() {
     tbb::spin_mutex::scoped_lock lock(spin_mutex_);
 
-    // Bail if the update buffer is empty.
-    if (buffer_len_ == 0)
+    // Bail if there are no update buffers.
+    if (update_buffers_.empty())
         return true;
 
     // Bail if there's no session for the peer anymore.
     if (!session_) {
+        update_buffers_.clear();
         buffer_len_ = 0;
         return true;
     }
 
     if (!SkipUpdateSend()) {
-        send_ready_ = session_->Send(buffer_, buffer_len_, NULL);
+        send_ready_ = session_->Send(update_buffers_, NULL);
+        update_buffers_.clear();
         buffer_len_ = 0;
         if (send_ready_) {
             StartKeepaliveTimerUnlocked();
@@ -1690,9 +1744,15 @@ bool BgpPeer::SetCapabilities(const BgpProto::OpenMessage *msg) {
     peer_info.set_peer_id(peer_bgp_id_);
 
     vector<string> families;
+    bool extended_message = false;
     vector<BgpProto::OpenMessage::Capability *>::iterator cap_it;
     for (cap_it = capabilities_.begin(); cap_it < capabilities_.end();
          ++cap_it) {
+        if ((*cap_it)->code ==
+            BgpProto::OpenMessage::Capability::ExtendedMessage) {
+            extended_message = true;
+            continue;
+        }
         if ((*cap_it)->code != BgpProto::OpenMessage::Capability::MpExtension)
             continue;
         uint8_t *data = (*cap_it)->capability.data();
@@ -1707,6 +1767,11 @@ bool BgpPeer::SetCapabilities(const BgpProto::OpenMessage *msg) {
     }
     peer_info.set_families(families);
 
+    // The Extended Message capability has been negotiated if we advertised
+    // it and the peer advertised it as well.
+    extended_message_negotiated_ =
+        extended_message && server_->extended_message_enable();
+
     negotiated_families_.clear();
     for (int idx = Address::UNSPEC; idx < Address::NUM_FAMILIES; ++idx) {
         if (!family_attributes_list_[idx])
@@ -1731,6 +1796,7 @@ bool BgpPeer::SetCapabilities(const BgpProto::OpenMessage *msg) {
 //
 void BgpPeer::ResetCapabilities() {
     STLDeleteValues(&capabilities_);
+    extended_message_negotiated_ = false;
     BgpPeerInfoData peer_info;
     peer_info.set_name(ToUVEKey());
     vector<string> families = vector<string>();
@@ -1741,6 +1807,15 @@ void BgpPeer::ResetCapabilities() {
     BGPPeerInfoSend(peer_info);
 }
 
+//
+// Maximum size of a message that can be sent to or received from the peer.
+//
+uint32_t BgpPeer::GetMaxMessageSize() const {
+    if (extended_message_negotiated_)
+        return BgpProto::kMaxExtendedMessageSize;
+    return BgpProto::kMaxMessageSize;
+}
+
 bool BgpPeer::MpNlriAllowed(uint16_t afi, uint8_t safi) {
     vector<BgpProto::OpenMessage::Capability *>::iterator it;
     for (it = capabilities_.begin(); it < capabilities_.end(); ++it) {
@@ -2107,9 +2182,41 @@ string BgpPeer::BytesToHexString(const u_int8_t *msg, size_t size) {
     return out.str();
 }
 
+//
+// Check if the length of the message is acceptable.
+//
+// Messages larger than BgpProto::kMaxMessageSize are allowed only if the BGP
+// Extended Message capability has been negotiated. Even then, OPEN and
+// KEEPALIVE messages can't be larger than BgpProto::kMaxMessageSize.
+//
+bool BgpPeer::MsgLengthAllowed(const u_int8_t *msg, size_t size) const {
+    if (size <= static_cast<size_t>(BgpProto::kMaxMessageSize))
+        return true;
+    if (!extended_message_negotiated_)
+        return false;
+    if (size > static_cast<size_t>(BgpProto::kMaxExtendedMessageSize))
+        return false;
+    uint8_t type = msg[18];
+    return (type != BgpProto::OPEN && type != BgpProto::KEEPALIVE);
+}
+
 bool BgpPeer::ReceiveMsg(BgpSession *session, const u_int8_t *msg,
                          size_t size) {
     ParseErrorContext ec;
+    if (!MsgLengthAllowed(msg, size)) {
+        ec.error_code = BgpProto::Notification::MsgHdrErr;
+        ec.error_subcode = BgpProto::Notification::BadMsgLength;
+        ec.type_name = "BgpMsgLength";
+        ec.data = msg + 16;
+        ec.data_size = 2;
+        BGP_TRACE_PEER_PACKET(this, msg, size, SandeshLevel::SYS_WARN);
+        BGP_LOG_PEER(Message, this, SandeshLevel::SYS_WARN, BGP_LOG_FLAG_ALL,
+                     BGP_PEER_DIR_IN,
+                     "Error while parsing message at " << ec.type_name);
+        state_machine_->OnMessageError(session, &ec);
+        return false;
+    }
+
     BgpProto::BgpMessage *minfo = BgpProto::Decode(msg, size, &ec);
 
     if (minfo == NULL) {
@@ -2125,6 +2232,10 @@ bool BgpPeer::ReceiveMsg(BgpSession *session, const u_int8_t *msg,
     if (minfo->type != BgpProto::KEEPALIVE)
         BGP_TRACE_PEER_PACKET(this, msg, size, Sandesh::LoggingUtLevel());
 
+    BgpUpdateCapture *capture = server_->update_capture();
+    if (capture && minfo->type == BgpProto::UPDATE)
+        capture->Write(BgpUpdateCapture::BgpUpdate, ToString(), msg, size);
+
     state_machine_->OnMessage(session, minfo, size);
     return true;
 }
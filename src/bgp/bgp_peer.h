@@ -27,6 +27,7 @@
 #include "bgp/ipeer.h"
 #include "bgp/bgp_peer_close.h"
 #include "bgp/state_machine.h"
+#include "io/tcp_session.h"
 #include "net/address.h"
 
 class BgpNeighborConfig;
@@ -76,7 +77,10 @@ public:
     static const int kMinEndOfRibSendTimeUsecs = 10000000;  // 10 Seconds
     static const int kMaxEndOfRibSendTimeUsecs = 60000000;  // 60 Seconds
     static const int kEndOfRibSendRetryTimeMsecs = 2000;    // 2 Seconds
+    // Threshold at which accumulated updates are flushed to the session.
+    // Updates are held by reference, so it doesn't limit the message size.
     static const size_t kBufferSize = 32768;
+    static const size_t kMaxUpdateBuffers = 64;
 
     typedef std::set<Address::Family> AddressFamilyList;
     typedef AuthenticationData::KeyType KeyType;
@@ -94,6 +98,8 @@ public:
     // thread: bgp::SendTask
     // Used to send an UPDATE message on the socket.
     virtual bool SendUpdate(const uint8_t *msg, size_t msgsize);
+    virtual bool SendSharedUpdate(const boost::shared_array<uint8_t> &msg,
+                                  size_t msgsize);
     virtual bool FlushUpdate();
 
     // thread: bgp::config
@@ -182,6 +188,10 @@ public:
     }
 
     bool IsFamilyNegotiated(Address::Family family);
+    bool IsExtendedMessageNegotiated() const {
+        return extended_message_negotiated_;
+    }
+    uint32_t GetMaxMessageSize() const;
     RoutingInstance *GetRoutingInstance() { return rtinstance_; }
     RoutingInstance *GetRoutingInstance() const { return rtinstance_; }
 
@@ -364,6 +374,8 @@ private:
     bool KeepaliveTimerExpired();
 
     RibExportPolicy BuildRibExportPolicy(Address::Family family) const;
+    bool MsgLengthAllowed(const u_int8_t *msg, size_t size) const;
+    bool AppendUpdate(const TcpSession::SharedBuffer &buffer);
     void ReceiveEndOfRIB(Address::Family family, size_t msgsize);
     void StartEndOfRibTimer();
     bool EndOfRibTimerExpired();
@@ -442,8 +454,11 @@ private:
     // and the io thread should need to lock it once every few seconds at
     // most.  Hence we choose a spin_mutex.
     tbb::spin_mutex spin_mutex_;
-    uint8_t buffer_[kBufferSize];
+    TcpSession::SharedBufferList update_buffers_;
     size_t buffer_len_;
+    boost::shared_array<uint8_t> copy_buffer_;
+    size_t copy_buffer_size_;
+    size_t copy_buffer_len_;
     BgpSession *session_;
     Timer *keepalive_timer_;
     Timer *end_of_rib_timer_;
@@ -459,6 +474,7 @@ private:
     bool non_graceful_close_;
     bool vpn_tables_registered_;
     std::vector<BgpProto::OpenMessage::Capability *> capabilities_;
+    tbb::atomic<bool> extended_message_negotiated_;
     uint16_t hold_time_;
     as_t local_as_;
     as_t peer_as_;
@@ -525,7 +525,7 @@ public:
                          ParseContext *context) {
         int value = get_short(data);
         if (value < BgpProto::kMinMessageSize ||
-            value > BgpProto::kMaxMessageSize) {
+            value > BgpProto::kMaxExtendedMessageSize) {
             return false;
         }
         if ((size_t) value < context->offset() + size) {
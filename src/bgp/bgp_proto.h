@@ -74,6 +74,7 @@ public:
                 OutboundRouteFiltering = 3,
                 MultipleRoutesToADestination = 4,
                 ExtendedNextHop = 5,
+                ExtendedMessage = 6,
                 GracefulRestart = 64,
                 AS4Support = 65,
                 Dynamic = 67,
@@ -97,6 +98,8 @@ public:
                     return "MultipleRoutesToADestination";
                 case ExtendedNextHop:
                     return "ExtendedNextHop";
+                case ExtendedMessage:
+                    return "ExtendedMessage";
                 case GracefulRestart:
                     return "GracefulRestart";
                 case AS4Support:
@@ -439,6 +442,11 @@ public:
     static const int kMinMessageSize = 19;
     static const int kMaxMessageSize = 4096;
 
+    // Maximum message size when the Extended Message capability (RFC 8654)
+    // has been negotiated. OPEN and KEEPALIVE messages are still limited to
+    // kMaxMessageSize.
+    static const int kMaxExtendedMessageSize = 65535;
+
     static BgpMessage *Decode(const uint8_t *data, size_t size,
                               ParseErrorContext *ec = NULL);
 
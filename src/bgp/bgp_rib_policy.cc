@@ -11,7 +11,8 @@ RibExportPolicy::RibExportPolicy()
       as_override(false),
       affinity(-1),
       llgr(false),
-      cluster_id(0) {
+      cluster_id(0),
+      max_message_size(BgpProto::kMaxMessageSize) {
 }
 
 RibExportPolicy::RibExportPolicy(BgpProto::BgpPeerType type, Encoding encoding,
@@ -22,7 +23,8 @@ RibExportPolicy::RibExportPolicy(BgpProto::BgpPeerType type, Encoding encoding,
       as_override(false),
       affinity(affinity),
       llgr(false),
-      cluster_id(cluster_id) {
+      cluster_id(cluster_id),
+      max_message_size(BgpProto::kMaxMessageSize) {
     if (encoding == XMPP)
         assert(type == BgpProto::XMPP);
     if (encoding == BGP)
@@ -38,7 +40,8 @@ RibExportPolicy::RibExportPolicy(BgpProto::BgpPeerType type, Encoding encoding,
       as_override(as_override),
       affinity(affinity),
       llgr(llgr),
-      cluster_id(cluster_id) {
+      cluster_id(cluster_id),
+      max_message_size(BgpProto::kMaxMessageSize) {
     if (encoding == XMPP)
         assert(type == BgpProto::XMPP);
     if (encoding == BGP)
@@ -55,7 +58,8 @@ RibExportPolicy::RibExportPolicy(BgpProto::BgpPeerType type, Encoding encoding,
       nexthop(nexthop),
       affinity(affinity),
       llgr(llgr),
-      cluster_id(cluster_id) {
+      cluster_id(cluster_id),
+      max_message_size(BgpProto::kMaxMessageSize) {
     assert(type == BgpProto::IBGP || type == BgpProto::EBGP);
     assert(encoding == BGP);
 }
@@ -72,5 +76,6 @@ bool RibExportPolicy::operator<(const RibExportPolicy &rhs) const {
     BOOL_KEY_COMPARE(affinity, rhs.affinity);
     BOOL_KEY_COMPARE(llgr, rhs.llgr);
     BOOL_KEY_COMPARE(cluster_id, rhs.cluster_id);
+    BOOL_KEY_COMPARE(max_message_size, rhs.max_message_size);
     return false;
 }
@@ -36,6 +36,12 @@
 // Instead, we should bring down the local pref to make the paths less
 // preferable.
 //
+// Including the maximum message size as part of the policy results in the
+// creation of a different ribout for peers that have (or have not) negotiated
+// the BGP Extended Message capability. This allows updates for peers that do
+// support it to be packed into larger messages. It defaults to the standard
+// maximum message size and is only overridden for BGP peers.
+//
 struct RibExportPolicy {
     enum Encoding {
         BGP,
@@ -62,6 +68,7 @@ struct RibExportPolicy {
     int affinity;
     bool llgr;
     uint32_t cluster_id;
+    uint32_t max_message_size;
 };
 
 #endif  // SRC_BGP_BGP_RIB_POLICY_H_
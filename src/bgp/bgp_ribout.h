@@ -291,6 +291,7 @@ public:
     as_t peer_as() const { return policy_.as_number; }
     bool as_override() const { return policy_.as_override; }
     bool llgr() const { return policy_.llgr; }
+    uint32_t max_message_size() const { return policy_.max_message_size; }
     const IpAddress &nexthop() const { return policy_.nexthop; }
     bool IsEncodingXmpp() const {
         return (policy_.encoding == RibExportPolicy::XMPP);
@@ -409,6 +409,10 @@ void RibOutUpdates::UpdateSend(int queue_id, Message *message,
         const RibPeerSet &dst, RibPeerSet *blocked) {
     CHECK_CONCURRENCY("bgp::SendTask");
 
+    // Messages that are the same for all peers are handed to the peers in
+    // a reference counted buffer so that they don't need to be copied.
+    boost::shared_array<uint8_t> shared_data = message->GetSharedData();
+
     RibOut::PeerIterator iter(ribout_, dst);
     while (iter.HasNext()) {
         int ix_current = iter.index();
@@ -425,7 +429,12 @@ void RibOutUpdates::UpdateSend(int queue_id, Message *message,
         stats_[queue_id].messages_sent_count_++;
         stats_[queue_id].reach_count_ += message->num_reach_routes();
         stats_[queue_id].unreach_count_ += message->num_unreach_routes();
-        bool more = peer->SendUpdate(data, msgsize);
+        bool more;
+        if (shared_data) {
+            more = peer->SendSharedUpdate(shared_data, msgsize);
+        } else {
+            more = peer->SendUpdate(data, msgsize);
+        }
         if (!more) {
             blocked->set(ix_current);
         }
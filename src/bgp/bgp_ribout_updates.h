@@ -76,6 +76,10 @@ public:
 
     void FillStatisticsInfo(int queue_id, ShowRibOutStatistics *sros) const;
 
+    uint64_t messages_sent_count(int queue_id) const {
+        return stats_[queue_id].messages_sent_count_;
+    }
+
     // Testing only
     void SetMessageBuilder(MessageBuilder *builder) { builder_ = builder; }
 
@@ -4,6 +4,7 @@
 
 #include "bgp/bgp_route.h"
 
+#include "base/slab_allocator.h"
 #include "bgp/bgp_peer.h"
 #include "bgp/bgp_server.h"
 #include "bgp/bgp_table.h"
@@ -22,6 +23,23 @@
 using std::string;
 using std::vector;
 
+//
+// The allocator is intentionally never destroyed so that routes can be freed
+// safely during process exit.
+//
+static SlabAllocator *BgpRouteAllocator() {
+    static SlabAllocator *allocator = new SlabAllocator("BgpRoute");
+    return allocator;
+}
+
+void *BgpRoute::operator new(size_t size) {
+    return BgpRouteAllocator()->Allocate(size);
+}
+
+void BgpRoute::operator delete(void *ptr, size_t size) {
+    BgpRouteAllocator()->Free(ptr, size);
+}
+
 BgpRoute::BgpRoute() {
 }
 
@@ -53,8 +71,11 @@ void BgpRoute::InsertPath(BgpPath *path) {
 
     Sort(&BgpTable::PathSelection, prev_front);
 
-    // Update counters.
-    if (table) table->UpdatePathCount(path, +1);
+    // Update counters and the per peer path index.
+    if (table) {
+        table->UpdatePathCount(path, +1);
+        table->InsertPeerPath(this, path);
+    }
     path->UpdatePeerRefCount(+1);
 }
 
@@ -67,9 +88,12 @@ void BgpRoute::DeletePath(BgpPath *path) {
     remove(path);
     Sort(&BgpTable::PathSelection, prev_front);
 
-    // Update counters.
+    // Update counters and the per peer path index.
     BgpTable *table = static_cast<BgpTable *>(get_table());
-    if (table) table->UpdatePathCount(path, -1);
+    if (table) {
+        table->UpdatePathCount(path, -1);
+        table->DeletePeerPath(this, path);
+    }
     path->UpdatePeerRefCount(-1);
 
     delete path;
@@ -24,6 +24,11 @@ public:
     BgpRoute();
     ~BgpRoute();
 
+    // Routes of all families are carved out of a slab allocator to reduce
+    // heap contention between db::DBTable partitions.
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+
     const BgpPath *BestPath() const;
 
     void InsertPath(BgpPath *path);
@@ -60,6 +65,12 @@ public:
 
     virtual std::string ToXmppIdString() const { return ToString(); }
 
+    // Get the address and prefix length for IP unicast routes. Returns false
+    // for other route types.
+    virtual bool GetIpPrefix(IpAddress *address, int *prefixlen) const {
+        return false;
+    }
+
     virtual void BuildProtoPrefix(BgpProtoPrefix *prefix,
                                   const BgpAttr *attr = NULL,
                                   uint32_t label = 0) const {
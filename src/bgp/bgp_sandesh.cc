@@ -8,6 +8,7 @@
 #include <boost/foreach.hpp>
 #include <sandesh/request_pipeline.h>
 
+#include "base/slab_allocator.h"
 #include "bgp/bgp_multicast.h"
 #include "bgp/bgp_peer.h"
 #include "bgp/bgp_peer_internal_types.h"
@@ -413,6 +414,11 @@ public:
         bsc->bgp_server->session_manager()->GetTxSocketStats(peer_socket_stats);
         resp->set_tx_socket_stats(peer_socket_stats);
 
+        BufferPoolStats buffer_pool_stats;
+        bsc->bgp_server->session_manager()->GetBufferPoolStats(
+            buffer_pool_stats);
+        resp->set_buffer_pool_stats(buffer_pool_stats);
+
         resp->set_context(req->context());
         resp->Response();
         return true;
@@ -433,6 +439,67 @@ void ShowBgpServerReq::HandleRequest() const {
     RequestPipeline rp(ps);
 }
 
+class ShowBgpSlabAllocatorHandler {
+public:
+    static void FillSlabAllocatorInfo(const SlabAllocator *allocator,
+        ShowSlabAllocator *ssa) {
+        ssa->set_name(allocator->name());
+        ssa->set_fallback_allocs(allocator->fallback_allocs());
+
+        SlabAllocator::StatsList stats_list;
+        allocator->GetStats(&stats_list);
+        vector<ShowSlabAllocatorSizeClass> sssc_list;
+        BOOST_FOREACH(const SlabAllocator::Stats &stats, stats_list) {
+            ShowSlabAllocatorSizeClass sssc;
+            sssc.set_object_size(stats.object_size);
+            sssc.set_slabs(stats.slabs);
+            sssc.set_allocs(stats.allocs);
+            sssc.set_frees(stats.frees);
+            sssc.set_in_use(stats.allocs - stats.frees);
+            sssc.set_free_objects(stats.free_objects);
+            sssc.set_slabs_released(stats.slabs_released);
+            sssc_list.push_back(sssc);
+        }
+        ssa->set_size_classes(sssc_list);
+    }
+
+    static bool CallbackS1(const Sandesh *sr,
+            const RequestPipeline::PipeSpec ps, int stage, int instNum,
+            RequestPipeline::InstData *data) {
+        const ShowBgpSlabAllocatorReq *req =
+            static_cast<const ShowBgpSlabAllocatorReq *>(ps.snhRequest_.get());
+
+        SlabAllocator::AllocatorList allocator_list;
+        SlabAllocator::GetAllocatorList(&allocator_list);
+        vector<ShowSlabAllocator> ssa_list;
+        BOOST_FOREACH(const SlabAllocator *allocator, allocator_list) {
+            ShowSlabAllocator ssa;
+            FillSlabAllocatorInfo(allocator, &ssa);
+            ssa_list.push_back(ssa);
+        }
+
+        ShowBgpSlabAllocatorResp *resp = new ShowBgpSlabAllocatorResp;
+        resp->set_allocators(ssa_list);
+        resp->set_context(req->context());
+        resp->Response();
+        return true;
+    }
+};
+
+void ShowBgpSlabAllocatorReq::HandleRequest() const {
+    RequestPipeline::PipeSpec ps(this);
+
+    // Request pipeline has single stage to collect slab allocator stats
+    // and respond to the request
+    RequestPipeline::StageSpec s1;
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    s1.taskId_ = scheduler->GetTaskId("bgp::ShowCommand");
+    s1.cbFn_ = ShowBgpSlabAllocatorHandler::CallbackS1;
+    s1.instances_.push_back(0);
+    ps.stages_ = list_of(s1);
+    RequestPipeline rp(ps);
+}
+
 BgpSandeshContext::BgpSandeshContext()
     : bgp_server(NULL),
       xmpp_peer_manager(NULL),
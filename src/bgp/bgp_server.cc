@@ -16,6 +16,7 @@
 #include "bgp/bgp_peer.h"
 #include "bgp/bgp_session_manager.h"
 #include "bgp/bgp_table_types.h"
+#include "bgp/bgp_update_capture.h"
 #include "bgp/peer_stats.h"
 #include "bgp/scheduling_group.h"
 #include "bgp/routing-instance/iservice_chain_mgr.h"
@@ -327,6 +328,8 @@ BgpServer::BgpServer(EventManager *evm)
       bgp_identifier_(0),
       hold_time_(0),
       gr_helper_enable_(getenv("GR_HELPER_BGP_ENABLE") != NULL),
+      peer_path_index_enable_(true),
+      extended_message_enable_(false),
       end_of_rib_timeout_(30),
       lifetime_manager_(BgpObjectFactory::Create<BgpLifetimeManager>(this,
           TaskScheduler::GetInstance()->GetTaskId("bgp::Config"))),
@@ -369,6 +372,10 @@ BgpServer::BgpServer(EventManager *evm)
     num_up_bgpaas_peer_ = 0;
     deleting_bgpaas_count_ = 0;
     message_build_error_ = 0;
+
+    const char *capture_file = getenv("BGP_UPDATE_CAPTURE_FILE");
+    if (capture_file)
+        update_capture_.reset(new BgpUpdateCapture(capture_file));
 }
 
 BgpServer::~BgpServer() {
@@ -31,6 +31,7 @@ class BgpOListDB;
 class BgpPeer;
 class BgpRouterState;
 class BgpSessionManager;
+class BgpUpdateCapture;
 class ClusterListDB;
 class CommunityDB;
 class EdgeDiscoveryDB;
@@ -248,11 +249,22 @@ public:
     void set_gr_helper_enable(bool gr_helper_enable) {
         gr_helper_enable_ = gr_helper_enable;
     }
+    bool peer_path_index_enable() const { return peer_path_index_enable_; }
+    void set_peer_path_index_enable(bool peer_path_index_enable) {
+        peer_path_index_enable_ = peer_path_index_enable;
+    }
+    bool extended_message_enable() const { return extended_message_enable_; }
+    void set_extended_message_enable(bool extended_message_enable) {
+        extended_message_enable_ = extended_message_enable;
+    }
     void set_end_of_rib_timeout(uint32_t end_of_rib_timeout) {
         end_of_rib_timeout_ = end_of_rib_timeout;
     }
     bool CollectStats(BgpRouterState *state, bool first) const;
 
+    // Capture of received updates, enabled with BGP_UPDATE_CAPTURE_FILE.
+    BgpUpdateCapture *update_capture() { return update_capture_.get(); }
+
 private:
     class ConfigUpdater;
     class DeleteActor;
@@ -282,6 +294,8 @@ private:
     boost::dynamic_bitset<> id_bmap_;      // free list.
     uint32_t hold_time_;
     bool gr_helper_enable_;
+    bool peer_path_index_enable_;
+    bool extended_message_enable_;
     uint32_t end_of_rib_timeout_;
     StaticRouteMgrList srt_manager_list_;
 
@@ -334,6 +348,8 @@ private:
     boost::scoped_ptr<BgpConfigManager> config_mgr_;
     boost::scoped_ptr<ConfigUpdater> updater_;
 
+    boost::scoped_ptr<BgpUpdateCapture> update_capture_;
+
     mutable tbb::atomic<uint64_t> message_build_error_;
 
     DISALLOW_COPY_AND_ASSIGN(BgpServer);
@@ -9,6 +9,7 @@
 
 #include <string>
 
+#include "bgp/bgp_proto.h"
 #include "io/tcp_session.h"
 
 class BgpPeer;
@@ -32,7 +33,7 @@ protected:
 
 private:
     static const int kHeaderLenSize = 18;
-    static const int kMaxMessageSize = 4096;
+    static const int kMaxMessageSize = BgpProto::kMaxExtendedMessageSize;
 
     DISALLOW_COPY_AND_ASSIGN(BgpMessageReader);
 };
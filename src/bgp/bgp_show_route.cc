@@ -7,11 +7,14 @@
 #include <boost/assign/list_of.hpp>
 #include <sandesh/request_pipeline.h>
 
+#include "bgp/bgp_path.h"
 #include "bgp/bgp_peer_internal_types.h"
 #include "bgp/bgp_route.h"
 #include "bgp/bgp_server.h"
 #include "bgp/bgp_table.h"
+#include "bgp/ipeer.h"
 #include "bgp/routing-instance/routing_instance.h"
+#include "net/community_type.h"
 
 using boost::assign::list_of;
 using std::auto_ptr;
@@ -138,27 +141,67 @@ public:
         }
     }
 
+    // Maximum number of routes examined by a partition for a single batch.
+    // This bounds the time for which the db::DBTable task is held when the
+    // filters in the request reject most of the routes in large tables.
+    static const uint32_t kUnitTestMaxWalkCount = 500;
+    static const uint32_t kMaxWalkCount = 10000;
+    static uint32_t GetMaxWalkCount(bool test_mode) {
+        if (test_mode) {
+            return kUnitTestMaxWalkCount;
+        } else {
+            return kMaxWalkCount;
+        }
+    }
+
     struct ShowRouteData : public RequestPipeline::InstData {
+        ShowRouteData() : walk_done(true) { }
         vector<ShowRouteTable> route_table_list;
+
+        // Position of the first route that was not examined, if the walk
+        // stopped because the partition examined kMaxWalkCount routes.
+        bool walk_done;
+        string next_routing_instance;
+        string next_routing_table;
+        string next_prefix;
     };
 
     ShowRouteHandler(const ShowRouteReq *req, int inst_id) :
-        req_(req), inst_id_(inst_id) {}
+        req_(req), inst_id_(inst_id), community_(0), community_error_(false) {
+        if (!req_->get_community().empty()) {
+            boost::system::error_code ec;
+            community_ =
+                CommunityType::CommunityFromString(req_->get_community(), &ec);
+            if (ec)
+                community_error_ = true;
+        }
+    }
 
-    // Search for interesting prefixes in a given table for given partition
-    void BuildShowRouteTable(BgpTable *table, vector<ShowRoute> *route_list,
-                             int count) {
+    //
+    // Search for interesting prefixes in a given table for given partition.
+    //
+    // Return the first route that was not examined if walk_count reaches
+    // max_walk_count before the walk of the table is complete, NULL if not.
+    //
+    BgpRoute *BuildShowRouteTable(BgpTable *table,
+                                  vector<ShowRoute> *route_list, int count,
+                                  uint32_t *walk_count,
+                                  uint32_t max_walk_count) {
         if (inst_id_ >= table->PartitionCount())
-            return;
+            return NULL;
         DBTablePartition *partition =
             static_cast<DBTablePartition *>(table->GetTablePartition(inst_id_));
         BgpRoute *route = NULL;
 
-        bool exact_lookup = false;
         if (!req_->get_prefix().empty() && !req_->get_longer_match()) {
-            exact_lookup = true;
             auto_ptr<DBEntry> key = table->AllocEntryStr(req_->get_prefix());
             route = static_cast<BgpRoute *>(partition->Find(key.get()));
+            if (route && MatchPaths(route)) {
+                ShowRoute show_route;
+                route->FillRouteInfo(table, &show_route);
+                route_list->push_back(show_route);
+            }
+            return NULL;
         } else if (table->name() == req_->get_start_routing_table()) {
             auto_ptr<DBEntry> key =
                 table->AllocEntryStr(req_->get_start_prefix());
@@ -167,16 +210,47 @@ public:
             route = static_cast<BgpRoute *>(partition->GetFirst());
         }
         for (int i = 0; route && (!count || i < count);
-             route = static_cast<BgpRoute *>(partition->GetNext(route)), ++i) {
+             route = static_cast<BgpRoute *>(partition->GetNext(route))) {
+            if (*walk_count >= max_walk_count)
+                return route;
+            (*walk_count)++;
             if (!MatchPrefix(req_->get_prefix(), route,
                              req_->get_longer_match()))
                 continue;
+            if (!MatchPaths(route))
+                continue;
             ShowRoute show_route;
             route->FillRouteInfo(table, &show_route);
             route_list->push_back(show_route);
-            if (exact_lookup)
-                break;
+            i++;
         }
+        return NULL;
+    }
+
+    // Check if any path of the route matches the source and the community
+    // in the request.
+    bool MatchPaths(const BgpRoute *route) const {
+        if (req_->get_source().empty() && req_->get_community().empty())
+            return true;
+        if (community_error_)
+            return false;
+        for (Route::PathList::const_iterator it =
+             route->GetPathList().begin();
+             it != route->GetPathList().end(); ++it) {
+            const BgpPath *path = static_cast<const BgpPath *>(it.operator->());
+            if (!req_->get_source().empty()) {
+                const IPeer *peer = path->GetPeer();
+                if (!peer || peer->ToString() != req_->get_source())
+                    continue;
+            }
+            if (!req_->get_community().empty()) {
+                const Community *comm = path->GetAttr()->community();
+                if (!comm || !comm->ContainsValue(community_))
+                    continue;
+            }
+            return true;
+        }
+        return false;
     }
 
     bool MatchPrefix(const string &expected_prefix, BgpRoute *route,
@@ -221,8 +295,18 @@ public:
             const RequestPipeline::PipeSpec ps, int stage, int instNum,
             RequestPipeline::InstData *data);
 
+    static bool IsNextLess(const ShowRouteData &lhs, const ShowRouteData &rhs,
+            const BgpSandeshContext *bsc);
+    static void TrimAfterNext(const ShowRouteData &next_data,
+            vector<ShowRouteTable> *route_table_list,
+            const BgpSandeshContext *bsc);
+    static string BuildNextBatch(const ShowRouteReq *req,
+            const string &next_routing_instance,
+            const string &next_routing_table, const string &next_prefix,
+            int count);
     static string SaveContextAndPopLast(const ShowRouteReq *req,
-            vector<ShowRouteTable> *route_table_list);
+            vector<ShowRouteTable> *route_table_list,
+            const ShowRouteData *next_data);
     static bool ConvertReqIterateToReq(const ShowRouteReqIterate *req_iterate,
                                        ShowRouteReq *req);
     static uint32_t GetMaxRouteCount(const ShowRouteReq *req);
@@ -230,6 +314,8 @@ public:
 private:
     const ShowRouteReq *req_;
     int inst_id_;
+    uint32_t community_;
+    bool community_error_;
 };
 
 uint32_t ShowRouteHandler::GetMaxRouteCount(const ShowRouteReq *req) {
@@ -255,6 +341,7 @@ bool ShowRouteHandler::ConvertReqIterateToReq(
 
     // Format of route_info:
     // UserRI||UserRT||UserPfx||NextRI||NextRT||NextPfx||count||longer_match
+    // optionally followed by ||UserSource||UserCommunity
     //
     // User* values were entered by the user and Next* values indicate 'where'
     // we need to start this iteration.
@@ -309,7 +396,25 @@ bool ShowRouteHandler::ConvertReqIterateToReq(
     string count_str = route_info.substr((pos6 + sep_size),
                                          pos7 - (pos6 + sep_size));
 
-    string longer_match = route_info.substr(pos7 + sep_size);
+    // The source and community filters are present only if the user
+    // specified at least one of them.
+    size_t pos8 = route_info.find(kIterSeparator, (pos7 + sep_size));
+    string longer_match;
+    string user_source;
+    string user_community;
+    if (pos8 == string::npos) {
+        longer_match = route_info.substr(pos7 + sep_size);
+    } else {
+        longer_match = route_info.substr((pos7 + sep_size),
+                                         pos8 - (pos7 + sep_size));
+        size_t pos9 = route_info.find(kIterSeparator, (pos8 + sep_size));
+        if (pos9 == string::npos) {
+            return false;
+        }
+        user_source = route_info.substr((pos8 + sep_size),
+                                        pos9 - (pos8 + sep_size));
+        user_community = route_info.substr(pos9 + sep_size);
+    }
 
     req->set_routing_instance(user_ri);
     req->set_routing_table(user_rt);
@@ -319,6 +424,8 @@ bool ShowRouteHandler::ConvertReqIterateToReq(
     req->set_start_prefix(next_prefix);
     req->set_count(atoi(count_str.c_str()));
     req->set_longer_match(StringToBool(longer_match));
+    req->set_source(user_source);
+    req->set_community(user_community);
 
     return true;
 }
@@ -330,6 +437,9 @@ bool ShowRouteHandler::CallbackS1Common(const ShowRouteReq *req, int inst_id,
     ShowRouteHandler handler(req, inst_id);
     BgpSandeshContext *bsc =
         static_cast<BgpSandeshContext *>(req->client_context());
+    uint32_t max_walk_count = ShowRouteHandler::GetMaxWalkCount(
+        bsc->test_mode());
+    uint32_t walk_count = 0;
     RoutingInstanceMgr *rim = bsc->bgp_server->routing_instance_mgr();
 
     string exact_routing_table = req->get_routing_table();
@@ -385,13 +495,23 @@ bool ShowRouteHandler::CallbackS1Common(const ShowRouteReq *req, int inst_id,
             srt.set_listeners(listeners);
 
             vector<ShowRoute> route_list;
-            handler.BuildShowRouteTable(table, &route_list,
-                                        max_count ? max_count - count : 0);
+            BgpRoute *next_route = handler.BuildShowRouteTable(table,
+                &route_list, max_count ? max_count - count : 0,
+                &walk_count, max_walk_count);
             if (route_list.size() || table->IsDeleted()) {
                 srt.set_routes(route_list);
                 mydata->route_table_list.push_back(srt);
             }
             count += route_list.size();
+
+            // Remember where to resume if we examined too many routes.
+            if (next_route) {
+                mydata->walk_done = false;
+                mydata->next_routing_instance = i->first;
+                mydata->next_routing_table = table->name();
+                mydata->next_prefix = next_route->ToString();
+                return true;
+            }
             if (count >= max_count) {
                 break;
             }
@@ -434,15 +554,83 @@ bool ShowRouteHandler::CallbackS1Iterate(const Sandesh *sr,
     return true;
 }
 
-string ShowRouteHandler::SaveContextAndPopLast(const ShowRouteReq *req,
-        vector<ShowRouteTable> *route_table_list) {
-    // If there are no output results for the input parameters, we dont need to
-    // save anything since there will be no subsequent iteration and there is
-    // nothing to pop off.
-    if (route_table_list->empty()) {
-        return string("");
+//
+// Compare the positions at which the walks in two partitions stopped.
+//
+bool ShowRouteHandler::IsNextLess(const ShowRouteData &lhs,
+        const ShowRouteData &rhs, const BgpSandeshContext *bsc) {
+    if (lhs.next_routing_instance != rhs.next_routing_instance) {
+        return lhs.next_routing_instance < rhs.next_routing_instance;
+    }
+    if (lhs.next_routing_table != rhs.next_routing_table) {
+        return lhs.next_routing_table < rhs.next_routing_table;
+    }
+    ShowRoute lhs_route;
+    lhs_route.set_prefix(lhs.next_prefix);
+    ShowRoute rhs_route;
+    rhs_route.set_prefix(rhs.next_prefix);
+    return IsLess(lhs_route, rhs_route, bsc, lhs.next_routing_table);
+}
+
+//
+// Remove all routes at or after the position at which the walk in one of the
+// partitions stopped. The routes after that position in the partition have
+// not been examined yet, so routes from other partitions that are after the
+// position get returned in the next batch to preserve ordering.
+//
+void ShowRouteHandler::TrimAfterNext(const ShowRouteData &next_data,
+        vector<ShowRouteTable> *route_table_list,
+        const BgpSandeshContext *bsc) {
+    ShowRoute next_route;
+    next_route.set_prefix(next_data.next_prefix);
+    vector<ShowRouteTable>::iterator it = route_table_list->begin();
+    while (it != route_table_list->end()) {
+        if (it->routing_instance < next_data.next_routing_instance ||
+            (it->routing_instance == next_data.next_routing_instance &&
+             it->routing_table_name < next_data.next_routing_table)) {
+            ++it;
+            continue;
+        }
+        if (it->routing_instance == next_data.next_routing_instance &&
+            it->routing_table_name == next_data.next_routing_table) {
+            vector<ShowRoute>::iterator rt_it = it->routes.begin();
+            while (rt_it != it->routes.end() &&
+                   IsLess(*rt_it, next_route, bsc, it->routing_table_name)) {
+                ++rt_it;
+            }
+            it->routes.erase(rt_it, it->routes.end());
+            if (!it->routes.empty()) {
+                ++it;
+                continue;
+            }
+        }
+        it = route_table_list->erase(it);
     }
+}
 
+string ShowRouteHandler::BuildNextBatch(const ShowRouteReq *req,
+        const string &next_routing_instance,
+        const string &next_routing_table, const string &next_prefix,
+        int count) {
+    string next_batch =
+        req->get_routing_instance() + kIterSeparator +
+        req->get_routing_table() + kIterSeparator +
+        req->get_prefix() + kIterSeparator +
+        next_routing_instance + kIterSeparator +
+        next_routing_table + kIterSeparator +
+        next_prefix + kIterSeparator +
+        integerToString(count) + kIterSeparator +
+        BoolToString(req->get_longer_match());
+    if (!req->get_source().empty() || !req->get_community().empty()) {
+        next_batch += kIterSeparator + req->get_source() + kIterSeparator +
+            req->get_community();
+    }
+    return next_batch;
+}
+
+string ShowRouteHandler::SaveContextAndPopLast(const ShowRouteReq *req,
+        vector<ShowRouteTable> *route_table_list,
+        const ShowRouteData *next_data) {
     // Get the total number of routes that we have collected in this iteration
     // after the mergesort.
     uint32_t total_count = 0;
@@ -450,8 +638,6 @@ string ShowRouteHandler::SaveContextAndPopLast(const ShowRouteReq *req,
         total_count += route_table_list->at(i).routes.size();
     }
 
-    ShowRouteTable *last_route_table =
-        &route_table_list->at(route_table_list->size() - 1);
     string next_batch;
 
     // We always attempt to read one extra entry (GetMaxRouteCount() adds 1).
@@ -460,9 +646,24 @@ string ShowRouteHandler::SaveContextAndPopLast(const ShowRouteReq *req,
     // GetMaxRouteCount
 
     // Case 2: (total_count < GetMaxRouteCount())
-    // There are no more entries matching the input criteria and we are done.
+    // If all partitions finished their walks, there are no more entries
+    // matching the input criteria and we are done. Otherwise, there's nothing
+    // to pop off and the next iteration starts at the position where the
+    // walk stopped. There may not be any output results for this iteration
+    // if the filters did not match any of the examined routes.
     if (total_count < ShowRouteHandler::GetMaxRouteCount(req)) {
-        return next_batch;
+        if (!next_data) {
+            return next_batch;
+        }
+        int new_count = 0;
+        if (req->get_count()) {
+            new_count = req->get_count() - total_count;
+            if (!new_count) {
+                return next_batch;
+            }
+        }
+        return BuildNextBatch(req, next_data->next_routing_instance,
+            next_data->next_routing_table, next_data->next_prefix, new_count);
     }
 
     // Case 3: (total_count == GetMaxRouteCount())
@@ -470,6 +671,8 @@ string ShowRouteHandler::SaveContextAndPopLast(const ShowRouteReq *req,
     // for the next round i.e. we are not done and we need to init next_batch
     // with the right values from the extra entry and we also need to pop off
     // the extra entry.
+    ShowRouteTable *last_route_table =
+        &route_table_list->at(route_table_list->size() - 1);
 
     int new_count;
     bool next_round = true;
@@ -489,15 +692,10 @@ string ShowRouteHandler::SaveContextAndPopLast(const ShowRouteReq *req,
     if (next_round) {
         ShowRoute last_route =
             last_route_table->routes.at(last_route_table->routes.size() - 1);
-        next_batch =
-            req->get_routing_instance() + kIterSeparator +
-            req->get_routing_table() + kIterSeparator +
-            req->get_prefix() + kIterSeparator +
-            last_route_table->get_routing_instance() + kIterSeparator +
-            last_route_table->get_routing_table_name() + kIterSeparator +
-            last_route.get_prefix() + kIterSeparator +
-            integerToString(new_count) + kIterSeparator +
-            BoolToString(req->get_longer_match());
+        next_batch = BuildNextBatch(req,
+            last_route_table->get_routing_instance(),
+            last_route_table->get_routing_table_name(),
+            last_route.get_prefix(), new_count);
     }
 
     // Pop off the last entry only after we have captured its values in
@@ -518,17 +716,26 @@ void ShowRouteHandler::CallbackS2Common(const ShowRouteReq *req,
     const RequestPipeline::StageData *sd = ps.GetStageData(0);
     vector<ShowRouteTable> route_table_list;
     vector<const vector<ShowRouteTable> *> table_lists;
+    const ShowRouteData *next_data = NULL;
     for (size_t i = 0; i < sd->size(); ++i) {
         const ShowRouteData &old_data =
             static_cast<const ShowRouteData &>(sd->at(i));
         if (old_data.route_table_list.size()) {
             table_lists.push_back(&old_data.route_table_list);
         }
+        if (!old_data.walk_done &&
+            (!next_data || IsNextLess(old_data, *next_data, bsc))) {
+            next_data = &old_data;
+        }
     }
     MergeSort(&route_table_list, &table_lists,
               ShowRouteHandler::GetMaxRouteCount(req), bsc, "");
+    if (next_data) {
+        TrimAfterNext(*next_data, &route_table_list, bsc);
+    }
 
-    string next_batch = SaveContextAndPopLast(req, &route_table_list);
+    string next_batch =
+        SaveContextAndPopLast(req, &route_table_list, next_data);
     resp->set_next_batch(next_batch);
 
     // Save the table in the message *after* popping the last entry above.
@@ -29,6 +29,7 @@ using std::map;
 using std::make_pair;
 using std::ostringstream;
 using std::string;
+using std::vector;
 
 class BgpTable::DeleteActor : public LifetimeActor {
   public:
@@ -62,7 +63,9 @@ BgpTable::BgpTable(DB *db, const string &name)
       rtinstance_(NULL),
       path_resolver_(NULL),
       stats_(new BgpTableStats()),
-      instance_delete_ref_(this, NULL) {
+      instance_delete_ref_(this, NULL),
+      peer_path_index_(false),
+      peer_path_lists_(PartitionCount()) {
     primary_path_count_ = 0;
     secondary_path_count_ = 0;
     infeasible_path_count_ = 0;
@@ -76,6 +79,9 @@ BgpTable::BgpTable(DB *db, const string &name)
 BgpTable::~BgpTable() {
     assert(path_resolver_ == NULL),
     instance_delete_ref_.Reset(NULL);
+    for (size_t part_id = 0; part_id < peer_path_lists_.size(); ++part_id) {
+        STLDeleteValues(&peer_path_lists_[part_id]);
+    }
 }
 
 void BgpTable::set_routing_instance(RoutingInstance *rtinstance) {
@@ -83,6 +89,8 @@ void BgpTable::set_routing_instance(RoutingInstance *rtinstance) {
     assert(rtinstance);
     deleter_.reset(new DeleteActor(this));
     instance_delete_ref_.Reset(rtinstance->deleter());
+    if (rtinstance->server())
+        peer_path_index_ = rtinstance->server()->peer_path_index_enable();
 }
 
 BgpServer *BgpTable::server() {
@@ -697,3 +705,170 @@ void BgpTable::FillRibOutStatisticsInfo(
         ribout->FillStatisticsInfo(sros_list);
     }
 }
+
+//
+// Return true if the BgpPath needs to be on the list of paths for it's IPeer.
+// This is consistent with the paths that are eligible for RibIn walks in the
+// BgpMembershipManager i.e. primary, unresolved paths added by a peer.
+//
+bool BgpTable::IsPeerPathIndexed(const BgpPath *path) {
+    if (!path->GetPeer())
+        return false;
+    if (path->IsResolved() || path->IsReplicated())
+        return false;
+    return true;
+}
+
+//
+// Add the BgpPath to the list of paths for it's IPeer in the partition of
+// the BgpRoute. New paths are added at the head of the list so that a walk
+// in progress does not visit paths that get added by the walk itself.
+//
+void BgpTable::InsertPeerPath(BgpRoute *rt, BgpPath *path) {
+    if (!peer_path_index_ || !IsPeerPathIndexed(path))
+        return;
+    DBTablePartBase *root = rt->get_table_partition();
+    if (!root)
+        return;
+
+    PeerPathListMap &peer_path_map = peer_path_lists_[root->index()];
+    PeerPathListMap::iterator loc = peer_path_map.find(path->GetPeer());
+    PeerPathList *path_list;
+    if (loc == peer_path_map.end()) {
+        path_list = new PeerPathList;
+        peer_path_map.insert(make_pair(path->GetPeer(), path_list));
+    } else {
+        path_list = loc->second;
+    }
+    path->peer_path_entry_ = new BgpPeerPathEntry(rt, path);
+    path_list->push_front(*path->peer_path_entry_);
+}
+
+//
+// Remove the BgpPath from the list of paths for it's IPeer. The list itself
+// is deleted when it becomes empty.
+//
+void BgpTable::DeletePeerPath(BgpRoute *rt, BgpPath *path) {
+    BgpPeerPathEntry *entry = path->peer_path_entry_;
+    if (!entry)
+        return;
+    DBTablePartBase *root = rt->get_table_partition();
+    assert(root);
+
+    PeerPathListMap &peer_path_map = peer_path_lists_[root->index()];
+    PeerPathListMap::iterator loc = peer_path_map.find(path->GetPeer());
+    assert(loc != peer_path_map.end());
+    PeerPathList *path_list = loc->second;
+    path_list->erase(path_list->iterator_to(*entry));
+    path->peer_path_entry_ = NULL;
+    delete entry;
+    if (path_list->empty()) {
+        delete path_list;
+        peer_path_map.erase(loc);
+    }
+}
+
+//
+// Walk the paths added by the given IPeer in the given partition and invoke
+// the callback for each of them. The callback is allowed to delete the path
+// being visited and to add new paths for the IPeer.
+//
+// All paths from the IPeer for a BgpRoute are visited together, so that the
+// BgpRoute is post-processed once, after the callback has been invoked for
+// the last of them.
+//
+// The marker is an entry that is not associated with any BgpRoute. It is
+// used to remember the position in the list if the walk needs to yield after
+// visiting max_count paths. The marker must not be on any list when walking
+// the paths for a new IPeer.
+//
+// Return true if all paths have been visited, false otherwise.
+//
+bool BgpTable::WalkPeerPaths(DBTablePartBase *root, const IPeer *peer,
+                             BgpPeerPathEntry *marker, int *count,
+                             int max_count, PeerPathWalkFn fn) {
+    assert(!marker->route);
+    PeerPathListMap &peer_path_map = peer_path_lists_[root->index()];
+    PeerPathListMap::iterator loc = peer_path_map.find(peer);
+    if (loc == peer_path_map.end()) {
+        assert(!marker->node.is_linked());
+        return true;
+    }
+
+    // Resume from the marker if it's on the list.
+    PeerPathList *path_list = loc->second;
+    PeerPathList::iterator it = path_list->begin();
+    if (marker->node.is_linked()) {
+        it = path_list->iterator_to(*marker);
+        it = path_list->erase(it);
+    }
+
+    while (it != path_list->end()) {
+        if (*count >= max_count) {
+            path_list->insert(it, *marker);
+            return false;
+        }
+
+        BgpPeerPathEntry *entry = &(*it++);
+        if (!entry->route)
+            continue;
+
+        // Gather the other paths from the IPeer for the same BgpRoute and
+        // move them behind the current one, so that they're not visited
+        // again later in the walk.
+        BgpRoute *rt = entry->route;
+        BgpPath *path = entry->path;
+        vector<BgpPath *> paths(1, path);
+        for (Route::PathList::iterator pit = rt->GetPathList().begin();
+             pit != rt->GetPathList().end(); ++pit) {
+            BgpPath *other = static_cast<BgpPath *>(pit.operator->());
+            if (other == path || other->GetPeer() != peer ||
+                !other->peer_path_entry_) {
+                continue;
+            }
+            BgpPeerPathEntry *other_entry = other->peer_path_entry_;
+            if (it != path_list->end() && &(*it) == other_entry)
+                ++it;
+            path_list->erase(path_list->iterator_to(*other_entry));
+            path_list->insert(path_list->iterator_to(*entry), *other_entry);
+            paths.push_back(other);
+        }
+
+        // Post-process the BgpRoute once, after all the paths from the
+        // IPeer have been visited.
+        bool notify = false;
+        for (vector<BgpPath *>::iterator pit = paths.begin();
+             pit != paths.end(); ++pit) {
+            (*count)++;
+            if (fn(root, rt, *pit))
+                notify = true;
+        }
+        InputCommonPostProcess(root, rt, notify);
+    }
+
+    // Get rid of the list if it's empty now that the marker has been removed.
+    if (path_list->empty()) {
+        delete path_list;
+        peer_path_map.erase(loc);
+    }
+    return true;
+}
+
+//
+// Get the number of paths added by the given IPeer across all partitions.
+//
+// The lists of other partitions are read without any synchronization, so
+// this is only meant for tests, and must be called when the scheduler is
+// quiesced (e.g. after task_util::WaitForIdle or with the scheduler stopped).
+//
+size_t BgpTable::GetPeerPathCount(const IPeer *peer) const {
+    size_t count = 0;
+    for (size_t part_id = 0; part_id < peer_path_lists_.size(); ++part_id) {
+        const PeerPathListMap &peer_path_map = peer_path_lists_[part_id];
+        PeerPathListMap::const_iterator loc = peer_path_map.find(peer);
+        if (loc == peer_path_map.end())
+            continue;
+        count += loc->second->size();
+    }
+    return count;
+}
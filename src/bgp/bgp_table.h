@@ -5,6 +5,8 @@
 #ifndef SRC_BGP_BGP_TABLE_H_
 #define SRC_BGP_BGP_TABLE_H_
 
+#include <boost/function.hpp>
+#include <boost/intrusive/list.hpp>
 #include <tbb/atomic.h>
 
 #include <map>
@@ -12,6 +14,7 @@
 #include <vector>
 
 #include "base/lifetime.h"
+#include "bgp/bgp_path.h"
 #include "bgp/bgp_rib_policy.h"
 #include "db/db_table_walker.h"
 #include "route/table.h"
@@ -36,6 +39,17 @@ class BgpTable : public RouteTable {
 public:
     typedef std::map<RibExportPolicy, RibOut *> RibOutMap;
 
+    // List of BgpPaths added by an IPeer in a given table partition.
+    typedef boost::intrusive::member_hook<
+        BgpPeerPathEntry,
+        boost::intrusive::list_member_hook<>,
+        &BgpPeerPathEntry::node
+    > PeerPathListMember;
+    typedef boost::intrusive::list<
+        BgpPeerPathEntry, PeerPathListMember> PeerPathList;
+    typedef boost::function<
+        bool(DBTablePartBase *, BgpRoute *, BgpPath *)> PeerPathWalkFn;
+
     struct RequestKey : DBRequestKey {
         virtual const IPeer *GetPeer() const = 0;
     };
@@ -160,10 +174,21 @@ public:
     void FillRibOutStatisticsInfo(
         std::vector<ShowRibOutStatistics> *sros_list) const;
 
+    void InsertPeerPath(BgpRoute *rt, BgpPath *path);
+    void DeletePeerPath(BgpRoute *rt, BgpPath *path);
+    bool WalkPeerPaths(DBTablePartBase *root, const IPeer *peer,
+                       BgpPeerPathEntry *marker, int *count, int max_count,
+                       PeerPathWalkFn fn);
+    size_t GetPeerPathCount(const IPeer *peer) const;
+    bool peer_path_index() const { return peer_path_index_; }
+
 private:
     friend class BgpTableTest;
 
     class DeleteActor;
+    typedef std::map<const IPeer *, PeerPathList *> PeerPathListMap;
+
+    static bool IsPeerPathIndexed(const BgpPath *path);
 
     void ProcessLlgrState(const RibOut *ribout, const BgpPath *path,
                           BgpAttr *attr);
@@ -181,6 +206,13 @@ private:
     tbb::atomic<uint64_t> secondary_path_count_;
     tbb::atomic<uint64_t> infeasible_path_count_;
 
+    // Per partition index of paths added by each IPeer. Each element in the
+    // vector is accessed only from the db::DBTable task for the partition.
+    // The index is enabled based on BgpServer configuration when the table
+    // is associated with it's RoutingInstance i.e. before any paths exist.
+    bool peer_path_index_;
+    std::vector<PeerPathListMap> peer_path_lists_;
+
     DISALLOW_COPY_AND_ASSIGN(BgpTable);
 };
 
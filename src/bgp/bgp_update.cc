@@ -4,6 +4,7 @@
 
 #include "bgp/bgp_update.h"
 
+#include "base/slab_allocator.h"
 #include "bgp/bgp_route.h"
 #include "bgp/bgp_table.h"
 
@@ -22,6 +23,51 @@ const UpdateInfo *UpdateInfoSList::FindUpdateInfo(
     return NULL;
 }
 
+//
+// RouteUpdates, UpdateInfos, UpdateMarkers and UpdateLists are carved out of
+// a common slab allocator since they get created and destroyed at a high rate
+// during convergence. Keeping them in the same allocator lets the objects for
+// a pending update share slabs instead of being scattered across the heap.
+// The allocator is never deleted so that the objects can be freed safely
+// during process exit.
+//
+static SlabAllocator *UpdateAllocator() {
+    static SlabAllocator *allocator = new SlabAllocator("RibOutUpdate");
+    return allocator;
+}
+
+void *UpdateMarker::operator new(size_t size) {
+    return UpdateAllocator()->Allocate(size);
+}
+
+void UpdateMarker::operator delete(void *ptr, size_t size) {
+    UpdateAllocator()->Free(ptr, size);
+}
+
+void *UpdateInfo::operator new(size_t size) {
+    return UpdateAllocator()->Allocate(size);
+}
+
+void UpdateInfo::operator delete(void *ptr, size_t size) {
+    UpdateAllocator()->Free(ptr, size);
+}
+
+void *RouteUpdate::operator new(size_t size) {
+    return UpdateAllocator()->Allocate(size);
+}
+
+void RouteUpdate::operator delete(void *ptr, size_t size) {
+    UpdateAllocator()->Free(ptr, size);
+}
+
+void *UpdateList::operator new(size_t size) {
+    return UpdateAllocator()->Allocate(size);
+}
+
+void UpdateList::operator delete(void *ptr, size_t size) {
+    UpdateAllocator()->Free(ptr, size);
+}
+
 RouteUpdate::RouteUpdate(BgpRoute *route, int queue_id)
     : UpdateEntry(UpdateEntry::UPDATE),
     route_(route),
@@ -54,6 +54,10 @@ private:
 struct UpdateMarker : public UpdateEntry {
     UpdateMarker() : UpdateEntry(MARKER) {
     }
+
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+
     RibPeerSet members;
 };
 
@@ -82,6 +86,9 @@ struct UpdateInfo {
           update(NULL) {
     }
 
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+
     void clear() {
         roattr.clear();
         target.clear();
@@ -196,6 +203,9 @@ public:
     RouteUpdate(BgpRoute *route, int queue_id);
     ~RouteUpdate();
 
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+
     void SetUpdateInfo(UpdateInfoSList &uinfo_slist);
     void BuildNegativeUpdateInfo(UpdateInfoSList &uinfo_slist) const;
     void ClearUpdateInfo();
@@ -280,6 +290,9 @@ public:
 
     UpdateList() { }
 
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+
     AdvertiseSList &History() { return history_; }
     const AdvertiseSList &History() const { return history_; }
 
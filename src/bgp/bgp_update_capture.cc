@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "bgp/bgp_update_capture.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include "base/parse_object.h"
+#include "base/time_util.h"
+#include "bgp/bgp_log.h"
+
+using std::string;
+
+BgpUpdateCapture::BgpUpdateCapture(const string &filename)
+    : filename_(filename),
+      file_(fopen(filename.c_str(), "wb")) {
+    records_ = 0;
+    write_errors_ = 0;
+    if (!file_)
+        return;
+
+    uint8_t header[kFileHeaderSize];
+    put_value(header, 4, kMagic);
+    put_value(header + 4, 2, kVersion);
+    if (fwrite(header, sizeof(header), 1, file_) != 1) {
+        fclose(file_);
+        file_ = NULL;
+    }
+}
+
+BgpUpdateCapture::~BgpUpdateCapture() {
+    if (file_)
+        fclose(file_);
+}
+
+//
+// Write a record with the given message. The timestamp is taken while
+// holding the mutex so that timestamps in the file are non-decreasing.
+//
+// A failure to write the record stops the capture, so that the file isn't
+// left with records that can't be read back after the partial one.
+//
+void BgpUpdateCapture::Write(RecordType type, const string &peer,
+                             const uint8_t *data, size_t size) {
+    uint8_t header[kRecordHeaderSize];
+    tbb::mutex::scoped_lock lock(mutex_);
+    if (!file_)
+        return;
+
+    put_value(header, 8, UTCTimestampUsec());
+    put_value(header + 8, 1, type);
+    put_value(header + 9, 2, peer.size());
+    put_value(header + 11, 4, size);
+    if (fwrite(header, sizeof(header), 1, file_) != 1 ||
+        (!peer.empty() && fwrite(peer.data(), peer.size(), 1, file_) != 1) ||
+        (size && fwrite(data, size, 1, file_) != 1)) {
+        write_errors_++;
+        BGP_LOG_STR(BgpMessage, SandeshLevel::SYS_WARN, BGP_LOG_FLAG_ALL,
+            "Stopped update capture to " << filename_ <<
+            " after failing to write record " << records_ + 1 <<
+            ": " << strerror(errno));
+        fclose(file_);
+        file_ = NULL;
+        return;
+    }
+    records_++;
+}
+
+void BgpUpdateCapture::Flush() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    if (file_)
+        fflush(file_);
+}
+
+BgpUpdateCaptureReader::BgpUpdateCaptureReader(const string &filename)
+    : file_(fopen(filename.c_str(), "rb")) {
+    if (!file_)
+        return;
+
+    uint8_t header[BgpUpdateCapture::kFileHeaderSize];
+    if (fread(header, sizeof(header), 1, file_) != 1 ||
+        get_value(header, 4) != BgpUpdateCapture::kMagic ||
+        get_value(header + 4, 2) != BgpUpdateCapture::kVersion) {
+        fclose(file_);
+        file_ = NULL;
+    }
+}
+
+BgpUpdateCaptureReader::~BgpUpdateCaptureReader() {
+    if (file_)
+        fclose(file_);
+}
+
+//
+// Read the next record. Return false at the end of the file or if the last
+// record is truncated e.g. because the process was killed while capturing.
+//
+bool BgpUpdateCaptureReader::Read(BgpUpdateCapture::Record *record) {
+    if (!file_)
+        return false;
+
+    uint8_t header[BgpUpdateCapture::kRecordHeaderSize];
+    if (fread(header, sizeof(header), 1, file_) != 1)
+        return false;
+    record->timestamp = get_value(header, 8);
+    record->type =
+        static_cast<BgpUpdateCapture::RecordType>(get_value(header + 8, 1));
+    size_t peer_size = get_value(header + 9, 2);
+    size_t data_size = get_value(header + 11, 4);
+
+    record->peer.resize(peer_size);
+    if (peer_size && fread(&record->peer[0], peer_size, 1, file_) != 1)
+        return false;
+    record->data.resize(data_size);
+    if (data_size && fread(&record->data[0], data_size, 1, file_) != 1)
+        return false;
+    return true;
+}
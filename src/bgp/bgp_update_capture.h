@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef SRC_BGP_BGP_UPDATE_CAPTURE_H_
+#define SRC_BGP_BGP_UPDATE_CAPTURE_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <tbb/atomic.h>
+#include <tbb/mutex.h>
+
+#include <string>
+#include <vector>
+
+#include "base/util.h"
+
+//
+// Capture of received BGP UPDATE messages and XMPP IQ messages. The capture
+// can be fed into a fresh BgpServer with the replay driver to reproduce and
+// benchmark convergence offline.
+//
+// The capture file starts with a header that has a magic number and version.
+// This is followed by a sequence of records, each of which has a fixed size
+// header with the receive timestamp in usecs, the record type, the length of
+// the peer name and the length of the message. The record header is followed
+// by the peer name and the raw message. All integers are in network order.
+//
+// BGP records hold a complete UPDATE message. XMPP records hold a single
+// stanza as it was received on the wire, so an update from an agent is made
+// up of a publish record followed by a collection record.
+//
+// Records from different peers can be written concurrently from different
+// tasks. They are serialized using a mutex so that the file order matches the
+// order in which the messages were captured.
+//
+class BgpUpdateCapture {
+public:
+    enum RecordType {
+        BgpUpdate = 1,
+        XmppMessage = 2
+    };
+
+    struct Record {
+        Record() : timestamp(0), type(BgpUpdate) { }
+        uint64_t timestamp;
+        RecordType type;
+        std::string peer;
+        std::vector<uint8_t> data;
+    };
+
+    static const uint32_t kMagic = 0x42555043;
+    static const uint16_t kVersion = 2;
+    static const size_t kFileHeaderSize = 6;
+    static const size_t kRecordHeaderSize = 15;
+
+    explicit BgpUpdateCapture(const std::string &filename);
+    ~BgpUpdateCapture();
+
+    bool IsOpen() const { return file_ != NULL; }
+
+    // Write a record. This closes the file if the record can't be written.
+    void Write(RecordType type, const std::string &peer,
+               const uint8_t *data, size_t size);
+    void Flush();
+
+    const std::string &filename() const { return filename_; }
+    uint64_t records() const { return records_; }
+    uint64_t write_errors() const { return write_errors_; }
+
+private:
+    tbb::mutex mutex_;
+    std::string filename_;
+    FILE *file_;
+    tbb::atomic<uint64_t> records_;
+    tbb::atomic<uint64_t> write_errors_;
+
+    DISALLOW_COPY_AND_ASSIGN(BgpUpdateCapture);
+};
+
+//
+// Reader for a file written by BgpUpdateCapture.
+//
+class BgpUpdateCaptureReader {
+public:
+    explicit BgpUpdateCaptureReader(const std::string &filename);
+    ~BgpUpdateCaptureReader();
+
+    bool IsOpen() const { return file_ != NULL; }
+    bool Read(BgpUpdateCapture::Record *record);
+
+private:
+    FILE *file_;
+
+    DISALLOW_COPY_AND_ASSIGN(BgpUpdateCaptureReader);
+};
+
+#endif  // SRC_BGP_BGP_UPDATE_CAPTURE_H_
@@ -170,9 +170,8 @@ void UpdateQueue::AddMarker(UpdateMarker *marker, RouteUpdate *rt_update) {
 
     for (size_t i = marker->members.find_first();
          i != BitSet::npos; i = marker->members.find_next(i)) {
-        MarkerMap::iterator loc = markers_.find(i);
-        assert(loc != markers_.end());
-        loc->second = marker;
+        assert(i < markers_.size() && markers_[i] != NULL);
+        markers_[i] = marker;
     }
 }
 
@@ -225,9 +224,8 @@ void UpdateQueue::MarkerSplit(UpdateMarker *marker, const RibPeerSet &msplit) {
 
     for (size_t i = msplit.find_first();
          i != BitSet::npos; i = msplit.find_next(i)) {
-        MarkerMap::iterator loc = markers_.find(i);
-        assert(loc != markers_.end());
-        loc->second = split_marker;
+        assert(i < markers_.size() && markers_[i] != NULL);
+        markers_[i] = split_marker;
     }
 }
 
@@ -247,9 +245,8 @@ void UpdateQueue::MarkerMerge(UpdateMarker *dst_marker,
     dst_marker->members.Set(bitset);
     for (size_t i = bitset.find_first();
          i != BitSet::npos; i = bitset.find_next(i)) {
-        MarkerMap::iterator loc = markers_.find(i);
-        assert(loc != markers_.end());
-        loc->second = dst_marker;
+        assert(i < markers_.size() && markers_[i] != NULL);
+        markers_[i] = dst_marker;
     }
 
     // Reset the bits in the src and get rid of it in case it's now empty.
@@ -267,15 +264,16 @@ void UpdateQueue::MarkerMerge(UpdateMarker *dst_marker,
 //
 UpdateMarker *UpdateQueue::GetMarker(int bit) {
     tbb::mutex::scoped_lock lock(mutex_);
-    MarkerMap::iterator loc = markers_.find(bit);
-    assert(loc != markers_.end());
-    return loc->second;
+    assert(static_cast<size_t>(bit) < markers_.size());
+    UpdateMarker *marker = markers_[bit];
+    assert(marker != NULL);
+    return marker;
 }
 
 //
 // Join a new peer, as represented by it's bit index, to the UpdateQueue.
-// Since it's a new peer, it starts out at the tail marker.  Also add the
-// peer's bit index and the tail marker pair to the MarkerMap.
+// Since it's a new peer, it starts out at the tail marker.  Also point the
+// peer's entry in the MarkerMap, which is grown as needed, to the tail marker.
 //
 // Return true if the tail marker is not the last entry in the queue. The
 // caller should trigger a tail dequeue for the RibOut if so to take care
@@ -287,22 +285,25 @@ bool UpdateQueue::Join(int bit) {
     tbb::mutex::scoped_lock lock(mutex_);
     UpdateMarker *marker = &tail_marker_;
     marker->members.set(bit);
-    markers_.insert(std::make_pair(bit, marker));
+    if (static_cast<size_t>(bit) >= markers_.size())
+        markers_.resize(bit + 1, NULL);
+    if (!markers_[bit])
+        markers_[bit] = marker;
     return (&tail_marker_ != &queue_.back());
 }
 
 //
 // Leave a peer, as represented by it's bit index, from the UpdateQueue.
-// Find the current marker for the peer and remove the peer's bit from the
+// Find the current marker for the peer and clear the peer's entry in the
 // MarkerMap. Reset the peer's bit in the marker and get rid of the marker
 // itself if it's now empty.
 //
 void UpdateQueue::Leave(int bit) {
     tbb::mutex::scoped_lock lock(mutex_);
-    MarkerMap::iterator loc = markers_.find(bit);
-    assert(loc != markers_.end());
-    UpdateMarker *marker = loc->second;
-    markers_.erase(loc);
+    assert(static_cast<size_t>(bit) < markers_.size());
+    UpdateMarker *marker = markers_[bit];
+    assert(marker != NULL);
+    markers_[bit] = NULL;
     marker->members.reset(bit);
     if (marker != &tail_marker_  && marker->members.empty()) {
         queue_.erase(queue_.iterator_to(*marker));
@@ -312,10 +313,11 @@ void UpdateQueue::Leave(int bit) {
 
 bool UpdateQueue::CheckInvariants() const {
     tbb::mutex::scoped_lock lock(mutex_);
-    for (MarkerMap::const_iterator iter = markers_.begin();
-         iter != markers_.end(); ++iter) {
-        UpdateMarker *marker = iter->second;
-        CHECK_INVARIANT(marker->members.test(iter->first));
+    for (size_t bit = 0; bit < markers_.size(); ++bit) {
+        UpdateMarker *marker = markers_[bit];
+        if (!marker)
+            continue;
+        CHECK_INVARIANT(marker->members.test(bit));
     }
     return true;
 }
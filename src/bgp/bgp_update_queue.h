@@ -10,6 +10,7 @@
 #include <list>
 #include <map>
 #include <set>
+#include <vector>
 
 #include "bgp/bgp_update.h"
 
@@ -125,7 +126,8 @@ public:
         boost::intrusive::compare<UpdateByAttrCmp>
     > UpdatesByAttr;
 
-    typedef std::map<int, UpdateMarker *> MarkerMap;
+    // Indexed by peer bit. Entries for peers that have not joined are NULL.
+    typedef std::vector<UpdateMarker *> MarkerMap;
 
     UpdateQueue(const RibOut *ribout, int queue_id);
     ~UpdateQueue();
@@ -18,6 +18,7 @@
 #include "bgp/bgp_membership.h"
 #include "bgp/bgp_peer_close.h"
 #include "bgp/bgp_server.h"
+#include "bgp/bgp_update_capture.h"
 #include "bgp/inet/inet_table.h"
 #include "bgp/inet6/inet6_table.h"
 #include "bgp/extended-community/load_balance.h"
@@ -29,6 +30,7 @@
 #include "bgp/scheduling_group.h"
 #include "bgp/security_group/security_group.h"
 #include "bgp/tunnel_encap/tunnel_encap.h"
+#include "bgp/xmpp_unicast_item_decoder.h"
 #include "control-node/sandesh/control_node_types.h"
 #include "net/community_type.h"
 #include "schema/xmpp_multicast_types.h"
@@ -47,12 +49,6 @@ using autogen::McastItemType;
 using autogen::McastNextHopsType;
 using autogen::McastTunnelEncapsulationListType;
 
-using autogen::ItemType;
-using autogen::NextHopListType;
-using autogen::SecurityGroupListType;
-using autogen::CommunityTagListType;
-using autogen::TunnelEncapsulationListType;
-
 using boost::regex;
 using boost::regex_search;
 using boost::smatch;
@@ -623,7 +619,8 @@ BgpXmppChannel::BgpXmppChannel(XmppChannel *channel, BgpServer *bgp_server,
             TaskScheduler::GetInstance()->GetTaskId("xmpp::StateMachine"),
             channel->GetTaskInstance(),
             boost::bind(&BgpXmppChannel::MembershipResponseHandler, this, _1)),
-      lb_mgr_(new LabelBlockManager()) {
+      lb_mgr_(new LabelBlockManager()),
+      unicast_item_decoder_(new XmppUnicastItemDecoder()) {
     if (bgp_server) {
         end_of_rib_timer_ = TimerManager::CreateTimer(*bgp_server->ioservice(),
                                 "EndOfRib timer",
@@ -633,6 +630,10 @@ BgpXmppChannel::BgpXmppChannel(XmppChannel *channel, BgpServer *bgp_server,
     }
     channel_->RegisterReceive(peer_id_,
          boost::bind(&BgpXmppChannel::ReceiveUpdate, this, _1));
+    if (bgp_server && bgp_server->update_capture()) {
+        channel_->RegisterRxMessageTraceCallback(
+            boost::bind(&BgpXmppChannel::CaptureMessage, this, _4, _5));
+    }
     BGP_LOG_PEER(Event, peer_.get(), SandeshLevel::SYS_INFO, BGP_LOG_FLAG_ALL,
         BGP_PEER_DIR_NA, "Created");
 }
@@ -654,6 +655,10 @@ BgpXmppChannel::~BgpXmppChannel() {
     BGP_LOG_PEER(Event, peer_.get(), SandeshLevel::SYS_INFO, BGP_LOG_FLAG_ALL,
         BGP_PEER_DIR_NA, "Deleted");
     channel_->UnRegisterReceive(peer_id_);
+    if (bgp_server_ && bgp_server_->update_capture()) {
+        channel_->RegisterRxMessageTraceCallback(
+            XmppChannel::RxMessageTraceCb());
+    }
 }
 
 void BgpXmppChannel::XMPPPeerInfoSend(const XmppPeerInfoData &peer_info) const {
@@ -1197,31 +1202,29 @@ bool BgpXmppChannel::ProcessMcastItem(string vrf_name,
 
 bool BgpXmppChannel::ProcessItem(string vrf_name,
     const pugi::xml_node &node, bool add_change) {
-    ItemType item;
-    item.Clear();
-
-    if (!item.XmlParse(node)) {
+    XmppUnicastItemDecoder &item = *unicast_item_decoder_;
+    if (!item.Decode(node)) {
         BGP_LOG_PEER_INSTANCE(Peer(), vrf_name,
             SandeshLevel::SYS_WARN, BGP_LOG_FLAG_ALL,
             "Invalid inet route message received");
         return false;
     }
 
-    if (item.entry.nlri.af != BgpAf::IPv4) {
+    if (item.af() != BgpAf::IPv4) {
         BGP_LOG_PEER_INSTANCE(Peer(), vrf_name,
             SandeshLevel::SYS_WARN, BGP_LOG_FLAG_ALL,
-            "Unsupported address family " << item.entry.nlri.af <<
-            " for inet route " << item.entry.nlri.address);
+            "Unsupported address family " << item.af() <<
+            " for inet route " << item.address());
         return false;
     }
 
     error_code error;
-    Ip4Prefix rt_prefix = Ip4Prefix::FromString(item.entry.nlri.address,
+    Ip4Prefix rt_prefix = Ip4Prefix::FromString(item.address(),
                                                 &error);
     if (error) {
         BGP_LOG_PEER_INSTANCE(Peer(), vrf_name,
             SandeshLevel::SYS_WARN, BGP_LOG_FLAG_ALL,
-            "Bad inet route " << item.entry.nlri.address);
+            "Bad inet route " << item.address());
         return false;
     }
 
@@ -1248,9 +1251,7 @@ bool BgpXmppChannel::ProcessItem(string vrf_name,
     if (add_change) {
         req.oper = DBRequest::DB_ENTRY_ADD_CHANGE;
         BgpAttrSpec attrs;
-        const NextHopListType &inh_list = item.entry.next_hops;
-
-        if (inh_list.next_hop.empty()) {
+        if (item.next_hop_count() == 0) {
             BGP_LOG_PEER_INSTANCE(Peer(), vrf_name,
                 SandeshLevel::SYS_WARN, BGP_LOG_FLAG_ALL,
                 "Missing next-hops for inet route " << rt_prefix.ToString());
@@ -1258,30 +1259,31 @@ bool BgpXmppChannel::ProcessItem(string vrf_name,
         }
 
         bool first_nh = true;
-        for (NextHopListType::const_iterator nit = inh_list.begin();
-             nit != inh_list.end(); ++nit, first_nh = false) {
+        for (size_t idx = 0; idx < item.next_hop_count();
+             ++idx, first_nh = false) {
+            const XmppUnicastItemDecoder::NextHop &inh = item.next_hop(idx);
             InetTable::RequestData::NextHop nexthop;
 
             IpAddress nhop_address(Ip4Address(0));
-            if (!XmppDecodeAddress(nit->af, nit->address, &nhop_address)) {
+            if (!XmppDecodeAddress(inh.af, inh.address, &nhop_address)) {
                 BGP_LOG_PEER_INSTANCE(Peer(), vrf_name,
                     SandeshLevel::SYS_WARN, BGP_LOG_FLAG_ALL,
-                    "Bad nexthop address " << nit->address <<
+                    "Bad nexthop address " << inh.address <<
                     " for inet route " << rt_prefix.ToString());
                 return false;
             }
 
             if (first_nh) {
                 nh_address = nhop_address;
-                label = nit->label;
+                label = inh.label;
             }
 
             // Process tunnel encapsulation list.
             bool no_tunnel_encap = true;
             bool no_valid_tunnel_encap = true;
-            for (TunnelEncapsulationListType::const_iterator eit =
-                 nit->tunnel_encapsulation_list.begin();
-                 eit != nit->tunnel_encapsulation_list.end(); ++eit) {
+            for (vector<const char *>::const_iterator eit =
+                 inh.tunnel_encapsulations.begin();
+                 eit != inh.tunnel_encapsulations.end(); ++eit) {
                 no_tunnel_encap = false;
                 TunnelEncap tun_encap(*eit);
                 if (tun_encap.tunnel_encap() == TunnelEncapType::UNSPEC)
@@ -1302,19 +1304,19 @@ bool BgpXmppChannel::ProcessItem(string vrf_name,
             }
             nexthop.flags_ = flags;
             nexthop.address_ = nhop_address;
-            nexthop.label_ = nit->label;
+            nexthop.label_ = inh.label;
             nexthop.source_rd_ = RouteDistinguisher(
                 nhop_address.to_v4().to_ulong(), instance_id);
             nexthops.push_back(nexthop);
         }
 
-        BgpAttrLocalPref local_pref(item.entry.local_preference);
+        BgpAttrLocalPref local_pref(item.local_preference());
         if (local_pref.local_pref != 0)
             attrs.push_back(&local_pref);
 
         // If there's no explicit med, calculate it automatically from the
         // local pref.
-        uint32_t med_value = item.entry.med;
+        uint32_t med_value = item.med();
         if (!med_value)
             med_value = GetMedFromLocalPref(local_pref.local_pref);
         BgpAttrMultiExitDisc med(med_value);
@@ -1322,8 +1324,8 @@ bool BgpXmppChannel::ProcessItem(string vrf_name,
             attrs.push_back(&med);
 
         // Process community tags
-        const CommunityTagListType &ict_list = item.entry.community_tag_list;
-        for (CommunityTagListType::const_iterator cit = ict_list.begin();
+        const vector<const char *> &ict_list = item.community_tags();
+        for (vector<const char *>::const_iterator cit = ict_list.begin();
              cit != ict_list.end(); ++cit) {
             error_code error;
             uint32_t rt_community =
@@ -1341,20 +1343,20 @@ bool BgpXmppChannel::ProcessItem(string vrf_name,
         attrs.push_back(&source_rd);
 
         // Process security group list.
-        const SecurityGroupListType &isg_list = item.entry.security_group_list;
-        for (SecurityGroupListType::const_iterator sit = isg_list.begin();
+        const vector<int> &isg_list = item.security_groups();
+        for (vector<int>::const_iterator sit = isg_list.begin();
              sit != isg_list.end(); ++sit) {
             SecurityGroup sg(bgp_server_->autonomous_system(), *sit);
             ext.communities.push_back(sg.GetExtCommunityValue());
         }
 
-        if (item.entry.sequence_number) {
-            MacMobility mm(item.entry.sequence_number);
+        if (item.sequence_number()) {
+            MacMobility mm(item.sequence_number());
             ext.communities.push_back(mm.GetExtCommunityValue());
         }
 
         // Process load-balance extended community
-        LoadBalance load_balance(item.entry.load_balance);
+        const LoadBalance &load_balance = item.load_balance();
         if (!load_balance.IsDefault())
             ext.communities.push_back(load_balance.GetExtCommunityValue());
 
@@ -1388,7 +1390,7 @@ bool BgpXmppChannel::ProcessItem(string vrf_name,
     assert(table);
     BGP_LOG_PEER_INSTANCE(Peer(), vrf_name,
         SandeshLevel::SYS_DEBUG, BGP_LOG_FLAG_TRACE,
-        "Inet route " << item.entry.nlri.address <<
+        "Inet route " << item.address() <<
         " with next-hop " << nh_address << " and label " << label <<
         " enqueued for " << (add_change ? "add/change" : "delete"));
     table->Enqueue(&req);
@@ -1397,10 +1399,8 @@ bool BgpXmppChannel::ProcessItem(string vrf_name,
 
 bool BgpXmppChannel::ProcessInet6Item(string vrf_name,
     const pugi::xml_node &node, bool add_change) {
-    ItemType item;
-    item.Clear();
-
-    if (!item.XmlParse(node)) {
+    XmppUnicastItemDecoder &item = *unicast_item_decoder_;
+    if (!item.Decode(node)) {
         error_stats().incr_inet6_rx_bad_xml_token_count();
         BGP_LOG_PEER_INSTANCE(Peer(), vrf_name,
             SandeshLevel::SYS_WARN, BGP_LOG_FLAG_ALL,
@@ -1408,32 +1408,32 @@ bool BgpXmppChannel::ProcessInet6Item(string vrf_name,
         return false;
     }
 
-    if (item.entry.nlri.af != BgpAf::IPv6) {
+    if (item.af() != BgpAf::IPv6) {
         error_stats().incr_inet6_rx_bad_afi_safi_count();
         BGP_LOG_PEER_INSTANCE(Peer(), vrf_name,
             SandeshLevel::SYS_WARN, BGP_LOG_FLAG_ALL,
-            "Unsupported address family " << item.entry.nlri.af <<
-            " for inet6 route " << item.entry.nlri.address);
+            "Unsupported address family " << item.af() <<
+            " for inet6 route " << item.address());
         return false;
     }
 
-    if (item.entry.nlri.safi != BgpAf::Unicast) {
+    if (item.safi() != BgpAf::Unicast) {
         error_stats().incr_inet6_rx_bad_afi_safi_count();
         BGP_LOG_PEER_INSTANCE(Peer(), vrf_name,
             SandeshLevel::SYS_WARN, BGP_LOG_FLAG_ALL,
-            "Unsupported subsequent address family " << item.entry.nlri.safi <<
-            " for inet6 route " << item.entry.nlri.address);
+            "Unsupported subsequent address family " << item.safi() <<
+            " for inet6 route " << item.address());
         return false;
     }
 
     error_code error;
     Inet6Prefix rt_prefix =
-        Inet6Prefix::FromString(item.entry.nlri.address, &error);
+        Inet6Prefix::FromString(item.address(), &error);
     if (error) {
         error_stats().incr_inet6_rx_bad_prefix_count();
         BGP_LOG_PEER_INSTANCE(Peer(), vrf_name,
             SandeshLevel::SYS_WARN, BGP_LOG_FLAG_ALL,
-            "Bad inet6 route " << item.entry.nlri.address);
+            "Bad inet6 route " << item.address());
         return false;
     }
 
@@ -1460,9 +1460,7 @@ bool BgpXmppChannel::ProcessInet6Item(string vrf_name,
     if (add_change) {
         req.oper = DBRequest::DB_ENTRY_ADD_CHANGE;
         BgpAttrSpec attrs;
-        const NextHopListType &inh_list = item.entry.next_hops;
-
-        if (inh_list.next_hop.empty()) {
+        if (item.next_hop_count() == 0) {
             BGP_LOG_PEER_INSTANCE(Peer(), vrf_name,
                 SandeshLevel::SYS_WARN, BGP_LOG_FLAG_ALL,
                 "Missing next-hops for inet6 route " << rt_prefix.ToString());
@@ -1470,31 +1468,32 @@ bool BgpXmppChannel::ProcessInet6Item(string vrf_name,
         }
 
         bool first_nh = true;
-        for (NextHopListType::const_iterator nit = inh_list.begin();
-             nit != inh_list.end(); ++nit, first_nh = false) {
+        for (size_t idx = 0; idx < item.next_hop_count();
+             ++idx, first_nh = false) {
+            const XmppUnicastItemDecoder::NextHop &inh = item.next_hop(idx);
             Inet6Table::RequestData::NextHop nexthop;
 
             IpAddress nhop_address(Ip4Address(0));
-            if (!XmppDecodeAddress(nit->af, nit->address, &nhop_address)) {
+            if (!XmppDecodeAddress(inh.af, inh.address, &nhop_address)) {
                 error_stats().incr_inet6_rx_bad_nexthop_count();
                 BGP_LOG_PEER_INSTANCE(Peer(), vrf_name,
                     SandeshLevel::SYS_WARN, BGP_LOG_FLAG_ALL,
-                    "Bad nexthop address " << nit->address <<
+                    "Bad nexthop address " << inh.address <<
                     " for inet6 route " << rt_prefix.ToString());
                 return false;
             }
 
             if (first_nh) {
                 nh_address = nhop_address;
-                label = nit->label;
+                label = inh.label;
             }
 
             // Process tunnel encapsulation list.
             bool no_tunnel_encap = true;
             bool no_valid_tunnel_encap = true;
-            for (TunnelEncapsulationListType::const_iterator eit =
-                 nit->tunnel_encapsulation_list.begin();
-                 eit != nit->tunnel_encapsulation_list.end(); ++eit) {
+            for (vector<const char *>::const_iterator eit =
+                 inh.tunnel_encapsulations.begin();
+                 eit != inh.tunnel_encapsulations.end(); ++eit) {
                 no_tunnel_encap = false;
                 TunnelEncap tun_encap(*eit);
                 if (tun_encap.tunnel_encap() == TunnelEncapType::UNSPEC)
@@ -1516,20 +1515,20 @@ bool BgpXmppChannel::ProcessInet6Item(string vrf_name,
 
             nexthop.flags_ = flags;
             nexthop.address_ = nhop_address;
-            nexthop.label_ = nit->label;
+            nexthop.label_ = inh.label;
             nexthop.source_rd_ = RouteDistinguisher(
                 nhop_address.to_v4().to_ulong(), instance_id);
             nexthops.push_back(nexthop);
         }
 
-        BgpAttrLocalPref local_pref(item.entry.local_preference);
+        BgpAttrLocalPref local_pref(item.local_preference());
         if (local_pref.local_pref != 0) {
             attrs.push_back(&local_pref);
         }
 
         // If there's no explicit med, calculate it automatically from the
         // local pref.
-        uint32_t med_value = item.entry.med;
+        uint32_t med_value = item.med();
         if (!med_value)
             med_value = GetMedFromLocalPref(local_pref.local_pref);
         BgpAttrMultiExitDisc med(med_value);
@@ -1537,8 +1536,8 @@ bool BgpXmppChannel::ProcessInet6Item(string vrf_name,
             attrs.push_back(&med);
 
         // Process community tags
-        const CommunityTagListType &ict_list = item.entry.community_tag_list;
-        for (CommunityTagListType::const_iterator cit = ict_list.begin();
+        const vector<const char *> &ict_list = item.community_tags();
+        for (vector<const char *>::const_iterator cit = ict_list.begin();
              cit != ict_list.end(); ++cit) {
             error_code error;
             uint32_t rt_community =
@@ -1556,20 +1555,20 @@ bool BgpXmppChannel::ProcessInet6Item(string vrf_name,
         attrs.push_back(&source_rd);
 
         // Process security group list.
-        const SecurityGroupListType &isg_list = item.entry.security_group_list;
-        for (SecurityGroupListType::const_iterator sit = isg_list.begin();
+        const vector<int> &isg_list = item.security_groups();
+        for (vector<int>::const_iterator sit = isg_list.begin();
              sit != isg_list.end(); ++sit) {
             SecurityGroup sg(bgp_server_->autonomous_system(), *sit);
             ext.communities.push_back(sg.GetExtCommunityValue());
         }
 
-        if (item.entry.sequence_number) {
-            MacMobility mm(item.entry.sequence_number);
+        if (item.sequence_number()) {
+            MacMobility mm(item.sequence_number());
             ext.communities.push_back(mm.GetExtCommunityValue());
         }
 
         // Process load-balance extended community
-        LoadBalance load_balance(item.entry.load_balance);
+        const LoadBalance &load_balance = item.load_balance();
         if (!load_balance.IsDefault())
             ext.communities.push_back(load_balance.GetExtCommunityValue());
 
@@ -1604,7 +1603,7 @@ bool BgpXmppChannel::ProcessInet6Item(string vrf_name,
     assert(table);
     BGP_LOG_PEER_INSTANCE(Peer(), vrf_name,
         SandeshLevel::SYS_DEBUG, BGP_LOG_FLAG_TRACE,
-        "Inet6 route " << item.entry.nlri.address <<
+        "Inet6 route " << item.address() <<
         " with next-hop " << nh_address << " and label " << label <<
         " enqueued for " << (add_change ? "add/change" : "delete"));
     table->Enqueue(&req);
@@ -2570,6 +2569,20 @@ void BgpXmppChannel::StartEndOfRibTimer() {
         boost::bind(&BgpXmppChannel::EndOfRibTimerErrorHandler, this, _1, _2));
 }
 
+//
+// Capture an iq stanza as it was received on the wire. This is called from
+// the io::ReaderTask before the message is decoded any further. Return false
+// so that the message is still traced as usual.
+//
+bool BgpXmppChannel::CaptureMessage(const string &msg,
+                                    const XmppStanza::XmppMessage *minfo) {
+    if (minfo->type != XmppStanza::IQ_STANZA)
+        return false;
+    bgp_server_->update_capture()->Write(BgpUpdateCapture::XmppMessage,
+        ToString(), reinterpret_cast<const uint8_t *>(msg.data()), msg.size());
+    return false;
+}
+
 void BgpXmppChannel::ReceiveUpdate(const XmppStanza::XmppMessage *msg) {
     CHECK_CONCURRENCY("xmpp::StateMachine");
 
@@ -41,6 +41,7 @@ class XmppConfigUpdater;
 class XmppConnectionEndpoint;
 class XmppPeerInfoData;
 class XmppSession;
+class XmppUnicastItemDecoder;
 
 class BgpXmppChannel {
 public:
@@ -198,6 +199,8 @@ private:
     typedef std::multimap<VrfTableName, DBRequest *> DeferQ;
 
     virtual void ReceiveUpdate(const XmppStanza::XmppMessage *msg);
+    bool CaptureMessage(const std::string &msg,
+                        const XmppStanza::XmppMessage *minfo);
 
     virtual bool GetMembershipInfo(BgpTable *table,
         int *instance_id, uint64_t *subscribed_at, RequestType *req_type);
@@ -287,6 +290,9 @@ private:
     // Label block manager for multicast labels.
     LabelBlockManagerPtr lb_mgr_;
 
+    // Decoder for inet and inet6 route items, reused for all messages.
+    boost::scoped_ptr<XmppUnicastItemDecoder> unicast_item_decoder_;
+
     DISALLOW_COPY_AND_ASSIGN(BgpXmppChannel);
 };
 
@@ -85,6 +85,11 @@ public:
 
     // Check whether 'this' is more specific than rhs.
     virtual bool IsMoreSpecific(const std::string &match) const;
+    virtual bool GetIpPrefix(IpAddress *address, int *prefixlen) const {
+        *address = prefix_.addr();
+        *prefixlen = prefix_.prefixlen();
+        return true;
+    }
     virtual uint16_t Afi() const { return BgpAf::IPv4; }
     virtual uint8_t Safi() const { return BgpAf::Unicast; }
 
@@ -94,6 +94,11 @@ public:
 
     // Check whether 'this' is more specific than rhs.
     virtual bool IsMoreSpecific(const std::string &match) const;
+    virtual bool GetIpPrefix(IpAddress *address, int *prefixlen) const {
+        *address = prefix_.addr();
+        *prefixlen = prefix_.prefixlen();
+        return true;
+    }
     virtual u_int16_t Afi() const { return BgpAf::IPv6; }
     virtual u_int8_t Safi() const { return BgpAf::Unicast; }
     virtual u_int16_t NexthopAfi() const { return BgpAf::IPv4; }
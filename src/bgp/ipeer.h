@@ -5,6 +5,8 @@
 #ifndef SRC_BGP_IPEER_H_
 #define SRC_BGP_IPEER_H_
 
+#include <boost/shared_array.hpp>
+
 #include "bgp/bgp_proto.h"
 #include "net/address.h"
 #include "tbb/atomic.h"
@@ -27,6 +29,15 @@ public:
     // Returns true if the peer can send additional messages.
     virtual bool SendUpdate(const uint8_t *msg, size_t msgsize) = 0;
 
+    // Send an update that's in a reference counted buffer. The same buffer
+    // may be sent to many peers, so it must not be modified. Peers that can
+    // hold on to the buffer instead of copying the message override this.
+    // Returns true if the peer can send additional messages.
+    virtual bool SendSharedUpdate(const boost::shared_array<uint8_t> &msg,
+                                  size_t msgsize) {
+        return SendUpdate(msg.get(), msgsize);
+    }
+
     // Flush any accumulated updates.
     // Returns true if the peer can send additional messages.
     virtual bool FlushUpdate() { return true; }
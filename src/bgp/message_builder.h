@@ -5,6 +5,8 @@
 #ifndef SRC_BGP_MESSAGE_BUILDER_H_
 #define SRC_BGP_MESSAGE_BUILDER_H_
 
+#include <boost/shared_array.hpp>
+
 #include "bgp/bgp_rib_policy.h"
 
 class BgpMessageBuilder;
@@ -24,6 +26,12 @@ public:
     virtual bool AddRoute(const BgpRoute *route, const RibOutAttr *roattr) = 0;
     virtual void Finish() = 0;
     virtual const uint8_t *GetData(IPeerUpdate *peer_update, size_t *lenp) = 0;
+    // Returns the data in a reference counted buffer if the message is the
+    // same for all peers, so that it can be sent without being copied.
+    // Returns an empty buffer otherwise.
+    virtual boost::shared_array<uint8_t> GetSharedData() const {
+        return boost::shared_array<uint8_t>();
+    }
     uint32_t num_reach_routes() const {
         return num_reach_route_;
     }
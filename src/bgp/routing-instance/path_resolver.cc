@@ -1069,6 +1069,18 @@ string ResolverNexthop::ToString() const {
     return (string("ResolverNexthop ") + address_.to_string());
 }
 
+//
+// Implement virtual method for ConditionMatch base class.
+//
+// Only routes that cover the address can match.
+//
+bool ResolverNexthop::GetMatchPrefix(const BgpTable *table,
+    IpAddress *address, int *prefixlen) const {
+    *address = address_;
+    *prefixlen = HostPrefixLength(address_);
+    return true;
+}
+
 //
 // Implement virtual method for ConditionMatch base class.
 //
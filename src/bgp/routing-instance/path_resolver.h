@@ -378,6 +378,8 @@ public:
     virtual std::string ToString() const;
     virtual bool Match(BgpServer *server, BgpTable *table, BgpRoute *route,
         bool deleted);
+    virtual bool GetMatchPrefix(const BgpTable *table, IpAddress *address,
+        int *prefixlen) const;
     void AddResolverPath(int part_id, ResolverPath *rpath);
     void RemoveResolverPath(int part_id, ResolverPath *rpath);
 
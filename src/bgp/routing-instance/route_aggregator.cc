@@ -87,6 +87,7 @@ public:
     typedef typename T::PrefixT PrefixT;
     typedef typename T::AddressT AddressT;
     typedef RouteAggregator<T> AggregateRouteMgrT;
+    typedef AggregateRouteTrieNode<T> AggregateRouteTrieNodeT;
     // List of more specific routes resulted in Aggregate route PER PARTITION
     typedef std::set<BgpRoute *> RouteList;
     typedef std::vector<RouteList> ContributingRouteList;
@@ -131,6 +132,10 @@ public:
         return nexthop_;
     }
 
+    AggregateRouteTrieNodeT *trie_node() {
+        return &trie_node_;
+    }
+
     bool IsMoreSpecific(BgpRoute *route) const {
         const RouteT *ip_route = static_cast<RouteT *>(route);
         const PrefixT &ip_prefix = ip_route->GetPrefix();
@@ -148,6 +153,14 @@ public:
     virtual bool Match(BgpServer *server, BgpTable *table,
                        BgpRoute *route, bool deleted);
 
+    // Only more specific routes of the aggregate prefix can match.
+    virtual bool GetMatchPrefix(const BgpTable *table, IpAddress *address,
+                                int *prefixlen) const {
+        *address = aggregate_route_prefix_.addr();
+        *prefixlen = aggregate_route_prefix_.prefixlen();
+        return true;
+    }
+
     void UpdateNexthop(IpAddress nexthop) {
         nexthop_ = nexthop;
         UpdateAggregateRoute();
@@ -246,6 +259,7 @@ private:
     IpAddress nexthop_;
     BgpRoute *aggregate_route_;
     ContributingRouteList contributors_;
+    AggregateRouteTrieNodeT trie_node_;
 
     DISALLOW_COPY_AND_ASSIGN(AggregateRoute);
 };
@@ -259,7 +273,8 @@ AggregateRoute<T>::AggregateRoute(RoutingInstance *rtinstance,
       aggregate_route_prefix_(aggregate_route),
       nexthop_(nexthop),
       aggregate_route_(NULL),
-      contributors_(ContributingRouteList(DB::PartitionCount())) {
+      contributors_(ContributingRouteList(DB::PartitionCount())),
+      trie_node_(aggregate_route, this) {
 }
 
 // Compare config and return whether cfg has updated
@@ -301,8 +316,8 @@ bool AggregateRoute<T>::IsOriginVnMatch(BgpRoute *route) const {
 }
 
 //
-// Calculate all aggregate prefixes to which the route can be contributing.
-// We need to calculate the longest prefix to which this route belongs.
+// Check whether this is the longest aggregate prefix to which the route can
+// be contributing.
 // E.g. routing instance is configured with 1/8, 1.1/16 and 1.1.1/24, 1.1.1.1/32
 // should match 1.1.1/24. Similarly, 1.1.1/24 should be most specific to 1.1/16
 // as so on
@@ -310,25 +325,11 @@ bool AggregateRoute<T>::IsOriginVnMatch(BgpRoute *route) const {
 template <typename T>
 bool AggregateRoute<T>::IsBestMatch(BgpRoute *route) const {
     const RouteT *ip_route = static_cast<RouteT *>(route);
-    const PrefixT &ip_prefix = ip_route->GetPrefix();
-    typename RouteAggregator<T>::AggregateRouteMap::const_iterator it;
-    std::set<PrefixT> prefix_list;
-    for (it = manager_->aggregate_route_map().begin();
-         it != manager_->aggregate_route_map().end(); ++it) {
-        if (!it->second->deleted() && ip_prefix != it->first &&
-            ip_prefix.IsMoreSpecific(it->first)) {
-            prefix_list.insert(it->first);
-        }
-    }
+    ConditionMatch *aggregate =
+        manager_->FindCoveringAggregate(ip_route->GetPrefix());
     // It should match atleast one prefix
-    assert(prefix_list.size());
-    //
-    // Longest prefix matches the aggregate prefix of current AggregateRoute
-    // return true to make this route as contributing route
-    // Longest prefix is the last prefix in the set
-    //
-    if (*(prefix_list.rbegin()) == aggregate_route_prefix_) return true;
-    return false;
+    assert(aggregate);
+    return (aggregate == this);
 }
 
 // Match function called from BgpConditionListener
@@ -703,6 +704,29 @@ void RouteAggregator<T>::UnregisterAndResolveRouteAggregate(
     unregister_list_trigger_->Set();
 }
 
+//
+// Find the longest aggregate prefix that covers the given prefix, excluding
+// the prefix itself. Aggregate prefixes that are being deleted are skipped
+// by repeating the lookup with a prefix length that's one shorter than that
+// of the deleted aggregate prefix.
+//
+template <typename T>
+ConditionMatch *RouteAggregator<T>::FindCoveringAggregate(
+    const PrefixT &prefix) const {
+    int prefixlen = prefix.prefixlen();
+    while (prefixlen > 0) {
+        AggregateRouteTrieNodeT key(PrefixT(prefix.addr(), prefixlen - 1),
+                                    NULL);
+        AggregateRouteTrieNodeT *node = aggregate_route_trie_.LPMFind(&key);
+        if (!node)
+            return NULL;
+        if (!node->aggregate()->deleted())
+            return node->aggregate();
+        prefixlen = node->prefix().prefixlen();
+    }
+    return NULL;
+}
+
 template <typename T>
 bool RouteAggregator<T>::IsAggregateRoute(const BgpRoute *route) const {
     RouteAggregatorState *state = static_cast<RouteAggregatorState *>
@@ -800,6 +824,7 @@ void RouteAggregator<T>::LocateAggregateRoutePrefix(const AggregateRouteConfig
         new AggregateRouteT(routing_instance(), this, prefix, cfg.nexthop);
     AggregateRoutePtr aggregate_route_match = AggregateRoutePtr(match);
     aggregate_route_map_.insert(make_pair(prefix, aggregate_route_match));
+    aggregate_route_trie_.Insert(match->trie_node());
 
     condition_listener_->AddMatchCondition(match->bgp_table(),
            aggregate_route_match.get(), BgpConditionListener::RequestDoneCb());
@@ -838,6 +863,7 @@ bool RouteAggregator<T>::ProcessUnregisterList() {
          it = unregister_aggregate_list_.begin();
          it != unregister_aggregate_list_.end(); ++it) {
         AggregateRouteT *aggregate = static_cast<AggregateRouteT *>(it->get());
+        aggregate_route_trie_.Remove(aggregate->trie_node());
         aggregate_route_map_.erase(aggregate->aggregate_route_prefix());
         condition_listener_->UnregisterMatchCondition(aggregate->bgp_table(),
                                                       aggregate);
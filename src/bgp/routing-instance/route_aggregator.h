@@ -12,6 +12,7 @@
 
 #include "bgp/routing-instance/iroute_aggregator.h"
 
+#include "base/patricia.h"
 #include "bgp/bgp_condition_listener.h"
 #include "bgp/bgp_config.h"
 #include "bgp/inet/inet_route.h"
@@ -22,6 +23,7 @@
 class AggregateRouteConfig;
 
 template <typename T> class AggregateRoute;
+template <typename T> class RouteAggregator;
 
 template <typename T1, typename T2, typename T3, typename T4>
 struct AggregateRouteBase {
@@ -41,6 +43,44 @@ class AggregateInet6Route : public AggregateRouteBase<
 
 typedef ConditionMatchPtr AggregateRoutePtr;
 
+//
+// Node in the patricia trie of aggregate prefixes in a RouteAggregator.
+// Each AggregateRoute embeds one of these for its prefix.
+//
+template <typename T>
+class AggregateRouteTrieNode {
+public:
+    typedef typename T::PrefixT PrefixT;
+
+    AggregateRouteTrieNode(const PrefixT &prefix, ConditionMatch *aggregate)
+        : prefix_(prefix), aggregate_(aggregate) {
+    }
+
+    const PrefixT &prefix() const { return prefix_; }
+    ConditionMatch *aggregate() const { return aggregate_; }
+
+    // Key for patricia node lookup
+    class Key {
+    public:
+        static std::size_t BitLength(const AggregateRouteTrieNode *node) {
+            return node->prefix_.prefixlen();
+        }
+        static char ByteValue(const AggregateRouteTrieNode *node,
+                              std::size_t i) {
+            return static_cast<char>(node->prefix_.addr().to_bytes()[i]);
+        }
+    };
+
+private:
+    friend class RouteAggregator<T>;
+
+    PrefixT prefix_;
+    ConditionMatch *aggregate_;
+    Patricia::Node node_;
+
+    DISALLOW_COPY_AND_ASSIGN(AggregateRouteTrieNode);
+};
+
 //
 // RouteAggregator
 // ================
@@ -65,7 +105,10 @@ typedef ConditionMatchPtr AggregateRoutePtr;
 // AggregateRoute class implements the MatchCondition for BgpConditionListener
 // and implements the Match() to detect the more specific route.
 // RouteAggregator stores the match object, AggregateRoute, in
-// aggregate_route_map_.
+// aggregate_route_map_. The aggregate prefixes are also kept in a patricia
+// trie, aggregate_route_trie_, so that the most specific aggregate prefix
+// covering a route can be found with a single longest prefix match instead
+// of going through all the aggregate prefixes in the routing instance.
 //
 // AggregateRoute class stores the contributing routes in "contributors_" list.
 // Match is executed in db::DBTable task in each partition context.
@@ -156,6 +199,8 @@ typedef ConditionMatchPtr AggregateRoutePtr;
 // Match() function of the AggregateRoute class is run in per partition
 // db::DBTable task. Hence the "contributors_" maintains the contributing routes
 // in per partition list to allow concurrent access
+// aggregate_route_trie_ is read in db::DBTable task from Match() and modified
+// only in bgp::Config task, which runs in exclusion to db::DBTable.
 //
 template <typename T>
 class RouteAggregator : public IRouteAggregator {
@@ -165,6 +210,8 @@ public:
     typedef typename T::AddressT AddressT;
     typedef AggregateRoute<T> AggregateRouteT;
 
+    typedef AggregateRouteTrieNode<T> AggregateRouteTrieNodeT;
+
     // Map of AggregateRoute prefix to the AggregateRoute match object
     typedef std::map<PrefixT, AggregateRoutePtr> AggregateRouteMap;
 
@@ -196,6 +243,8 @@ public:
     void EvaluateAggregateRoute(AggregateRoutePtr entry);
     void UnregisterAndResolveRouteAggregate(AggregateRoutePtr entry);
 
+    ConditionMatch *FindCoveringAggregate(const PrefixT &prefix) const;
+
     virtual bool IsAggregateRoute(const BgpRoute *route) const;
     virtual bool IsContributingRoute(const BgpRoute *route) const;
 
@@ -206,6 +255,9 @@ private:
     class DeleteActor;
     typedef std::set<AggregateRoutePtr> AggregateRouteProcessList;
     typedef BgpInstanceConfig::AggregateRouteList AggregateRouteConfigList;
+    typedef Patricia::Tree<AggregateRouteTrieNodeT,
+        &AggregateRouteTrieNodeT::node_,
+        typename AggregateRouteTrieNodeT::Key> AggregateRouteTrie;
 
     int CompareAggregateRoute(typename AggregateRouteMap::iterator loc,
         AggregateRouteConfigList::iterator it);
@@ -238,6 +290,7 @@ private:
     BgpConditionListener *condition_listener_;
     DBTableBase::ListenerId listener_id_;
     AggregateRouteMap  aggregate_route_map_;
+    mutable AggregateRouteTrie aggregate_route_trie_;
     boost::scoped_ptr<TaskTrigger> update_list_trigger_;
     boost::scoped_ptr<TaskTrigger> unregister_list_trigger_;
     tbb::mutex mutex_;
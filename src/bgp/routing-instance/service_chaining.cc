@@ -56,6 +56,43 @@ static int GetOriginVnIndex(const BgpTable *table, const BgpRoute *route) {
     return 0;
 }
 
+//
+// Replace the paths and flush the attribute cache.
+//
+void ServiceChainNexthop::Reset(const PathList &paths) {
+    paths_ = paths;
+    version_++;
+    attr_cache_.clear();
+}
+
+const ServiceChainNexthop::AttrList *ServiceChainNexthop::FindAttrList(
+    const BgpAttr *orig_attr, int vn_index) const {
+    if (vn_index != vn_index_)
+        return NULL;
+    AttrCache::const_iterator loc = attr_cache_.find(orig_attr);
+    if (loc == attr_cache_.end())
+        return NULL;
+    return &loc->second.second;
+}
+
+//
+// Memoize the attribute list for the given original attribute. The original
+// attribute is held in the cache so that the key can't get reused while the
+// entry is present. The cache is flushed if the vn index of the destination
+// changes or if it grows too large.
+//
+const ServiceChainNexthop::AttrList *ServiceChainNexthop::InsertAttrList(
+    const BgpAttr *orig_attr, int vn_index, const AttrList &attr_list) {
+    if (vn_index != vn_index_ || attr_cache_.size() >= kMaxAttrCacheSize) {
+        attr_cache_.clear();
+        vn_index_ = vn_index;
+    }
+    std::pair<BgpAttrPtr, AttrList> &entry = attr_cache_[orig_attr];
+    entry.first = orig_attr;
+    entry.second = attr_list;
+    return &entry.second;
+}
+
 template <typename T>
 ServiceChain<T>::ServiceChain(ServiceChainMgrT *manager, RoutingInstance *src,
     RoutingInstance *dest, RoutingInstance *connected,
@@ -65,6 +102,10 @@ ServiceChain<T>::ServiceChain(ServiceChainMgrT *manager, RoutingInstance *src,
       dest_(dest),
       connected_(connected),
       connected_route_(NULL),
+      route_updates_pending_(false),
+      aggregate_updates_done_(false),
+      has_next_aggregate_(false),
+      next_ext_route_(NULL),
       service_chain_addr_(addr),
       connected_table_unregistered_(false),
       dest_table_unregistered_(false),
@@ -251,17 +292,37 @@ bool ServiceChain<T>::Match(BgpServer *server, BgpTable *table, BgpRoute *route,
     return true;
 }
 
+//
+// Only the connected route is of interest in the connected table, so the
+// match can be restricted to routes that cover the service chain address.
+// All routes in the dest table are of interest.
+//
+template <typename T>
+bool ServiceChain<T>::GetMatchPrefix(const BgpTable *table,
+    IpAddress *address, int *prefixlen) const {
+    if (table != connected_table() || table == dest_table())
+        return false;
+    *address = IpAddress(service_chain_addr_);
+    *prefixlen = HostPrefixLength(*address);
+    return true;
+}
+
 template <typename T>
 string ServiceChain<T>::ToString() const {
     return (string("ServiceChain " ) + service_chain_addr_.to_string());
 }
 
+//
+// Update the connected route and the nexthop derived from it. Return true if
+// the nexthop changed, in which case all service chain routes need to be
+// updated.
+//
 template <typename T>
-void ServiceChain<T>::SetConnectedRoute(BgpRoute *connected) {
+bool ServiceChain<T>::SetConnectedRoute(BgpRoute *connected) {
     connected_route_ = connected;
     connected_path_ids_.clear();
     if (!connected_route_)
-        return;
+        return UpdateNexthop();
 
     for (Route::PathList::iterator it = connected->GetPathList().begin();
         it != connected->GetPathList().end(); ++it) {
@@ -279,6 +340,297 @@ void ServiceChain<T>::SetConnectedRoute(BgpRoute *connected) {
         uint32_t path_id = path->GetAttr()->nexthop().to_v4().to_ulong();
         connected_path_ids_.insert(path_id);
     }
+    return UpdateNexthop();
+}
+
+//
+// Rebuild the nexthop from the ECMP paths of the connected route.
+//
+// This does the part of the attribute manipulation that's independent of the
+// original route for each connected path. Return true if the resulting paths
+// are different from the ones in the current nexthop.
+//
+template <typename T>
+bool ServiceChain<T>::UpdateNexthop() {
+    ServiceChainNexthop::PathList paths;
+    if (connected_route_) {
+        BgpTable *bgptable = src_table();
+        BgpServer *server = dest_routing_instance()->server();
+        BgpAttrDB *attr_db = server->attr_db();
+        ExtCommunityDB *extcomm_db = server->extcomm_db();
+        BgpMembershipManager *membership_mgr = server->membership_mgr();
+
+        for (Route::PathList::iterator it =
+             connected_route_->GetPathList().begin();
+             it != connected_route_->GetPathList().end(); ++it) {
+            BgpPath *connected_path = static_cast<BgpPath *>(it.operator->());
+
+            // Infeasible paths are not considered
+            if (!connected_path->IsFeasible())
+                break;
+
+            // take snapshot of all ECMP paths
+            if (connected_route_->BestPath()->PathCompare(*connected_path,
+                                                          true))
+                break;
+
+            // Skip paths with duplicate forwarding information.  This ensures
+            // that we generate only one path with any given next hop and label
+            // when there are multiple connected paths from the original source
+            // received via different peers e.g. directly via XMPP and via BGP.
+            if (connected_route_->DuplicateForwardingPath(connected_path))
+                continue;
+
+            const BgpAttr *attr = connected_path->GetAttr();
+
+            // Strip any RouteTargets from the connected attributes.
+            ExtCommunityPtr new_ext_community =
+                extcomm_db->ReplaceRTargetAndLocate(
+                    attr->ext_community(), ExtCommunity::ExtCommunityList());
+            BgpAttrPtr new_attr = attr_db->ReplaceExtCommunityAndLocate(
+                attr, new_ext_community);
+
+            // Strip aspath. This is required when the connected route is
+            // learnt via BGP.
+            new_attr =
+                attr_db->ReplaceAsPathAndLocate(new_attr.get(), AsPathPtr());
+
+            // If the connected path is learnt via XMPP, construct RD based on
+            // the id registered with source table instead of connected table.
+            // This allows chaining of multiple in-network service instances
+            // that are on the same compute node.
+            const IPeer *peer = connected_path->GetPeer();
+            if (src_ != connected_ && peer && peer->IsXmppPeer()) {
+                int instance_id = -1;
+                bool is_registered = membership_mgr->GetRegistrationInfo(peer,
+                    bgptable, &instance_id);
+                if (!is_registered)
+                    continue;
+                RouteDistinguisher connected_rd = attr->source_rd();
+                if (connected_rd.Type() !=
+                    RouteDistinguisher::TypeIpAddressBased)
+                    continue;
+
+                RouteDistinguisher rd(connected_rd.GetAddress(), instance_id);
+                new_attr =
+                    attr_db->ReplaceSourceRdAndLocate(new_attr.get(), rd);
+            }
+
+            // Replace the source rd if the connected path is a secondary path
+            // of a primary path in the l3vpn table. Use the RD of the primary.
+            if (connected_path->IsReplicated()) {
+                const BgpSecondaryPath *spath =
+                    static_cast<const BgpSecondaryPath *>(connected_path);
+                const RoutingInstance *ri =
+                    spath->src_table()->routing_instance();
+                if (ri->IsMasterRoutingInstance()) {
+                    const VpnRouteT *vpn_route =
+                        static_cast<const VpnRouteT *>(spath->src_rt());
+                    new_attr = attr_db->ReplaceSourceRdAndLocate(new_attr.get(),
+                        vpn_route->GetPrefix().route_distinguisher());
+                }
+            }
+
+            uint32_t path_id = attr->nexthop().to_v4().to_ulong();
+            paths.push_back(ServiceChainNexthop::Path(path_id, new_attr.get(),
+                connected_path->GetFlags(), connected_path->GetLabel(),
+                LoadBalance::IsPresent(connected_path)));
+        }
+    }
+
+    if (nexthop_.Equals(paths))
+        return false;
+    nexthop_.Reset(paths);
+    return true;
+}
+
+//
+// Get the final attribute for each path in the nexthop for a service chain
+// route with the given original route. The original route is NULL for an
+// aggregate route.
+//
+template <typename T>
+const ServiceChainNexthop::AttrList *ServiceChain<T>::GetServiceChainAttrs(
+    const RouteT *orig_route) {
+    const BgpAttr *orig_attr = NULL;
+    if (orig_route && orig_route->BestPath())
+        orig_attr = orig_route->BestPath()->GetAttr();
+
+    int vn_index = dest_routing_instance()->virtual_network_index();
+    const ServiceChainNexthop::AttrList *attr_list =
+        nexthop_.FindAttrList(orig_attr, vn_index);
+    if (attr_list)
+        return attr_list;
+
+    BgpServer *server = dest_routing_instance()->server();
+    OriginVn origin_vn(server->autonomous_system(), vn_index);
+
+    SiteOfOrigin soo;
+    ExtCommunity::ExtCommunityList sgid_list;
+    LoadBalance load_balance;
+    bool load_balance_present = false;
+    const Community *orig_community = NULL;
+    const OriginVnPath *orig_ovnpath = NULL;
+    RouteDistinguisher orig_rd;
+    if (orig_attr) {
+        const ExtCommunity *ext_community = orig_attr->ext_community();
+        orig_community = orig_attr->community();
+        orig_ovnpath = orig_attr->origin_vn_path();
+        orig_rd = orig_attr->source_rd();
+        if (ext_community) {
+            BOOST_FOREACH(const ExtCommunity::ExtCommunityValue &comm,
+                          ext_community->communities()) {
+                if (ExtCommunity::is_security_group(comm))
+                    sgid_list.push_back(comm);
+                if (ExtCommunity::is_site_of_origin(comm) && soo.IsNull())
+                    soo = SiteOfOrigin(comm);
+                if (ExtCommunity::is_load_balance(comm)) {
+                    load_balance = LoadBalance(comm);
+                    load_balance_present = true;
+                }
+            }
+        }
+    }
+
+    BgpAttrDB *attr_db = server->attr_db();
+    CommunityDB *comm_db = server->comm_db();
+    CommunityPtr new_community = comm_db->AppendAndLocate(
+        orig_community, CommunityType::AcceptOwnNexthop);
+    ExtCommunityDB *extcomm_db = server->extcomm_db();
+    OriginVnPathDB *ovnpath_db = server->ovnpath_db();
+    OriginVnPathPtr new_ovnpath =
+        ovnpath_db->PrependAndLocate(orig_ovnpath, origin_vn.GetExtCommunity());
+
+    ServiceChainNexthop::AttrList new_attr_list;
+    BOOST_FOREACH(const ServiceChainNexthop::Path &path, nexthop_.paths()) {
+        const BgpAttr *attr = path.attr.get();
+
+        // Replace the SGID list with the list from the original route.
+        ExtCommunityPtr new_ext_community =
+            extcomm_db->ReplaceSGIDListAndLocate(attr->ext_community(),
+                                                 sgid_list);
+
+        // Replace SiteOfOrigin with value from original route if any.
+        if (soo.IsNull()) {
+            new_ext_community = extcomm_db->RemoveSiteOfOriginAndLocate(
+                new_ext_community.get());
+        } else {
+            new_ext_community = extcomm_db->ReplaceSiteOfOriginAndLocate(
+                new_ext_community.get(), soo.GetExtCommunity());
+        }
+
+        // Inherit load balance attribute of orig_route if connected path
+        // does not have one already.
+        if (!path.load_balance_present && load_balance_present) {
+            new_ext_community = extcomm_db->AppendAndLocate(
+                    new_ext_community.get(), load_balance.GetExtCommunity());
+        }
+
+        // Replace the OriginVn with the value from the original route
+        // or the value associated with the dest routing instance.
+        new_ext_community = extcomm_db->ReplaceOriginVnAndLocate(
+            new_ext_community.get(), origin_vn.GetExtCommunity());
+
+        // Replace extended community, community and origin vn path.
+        BgpAttrPtr new_attr = attr_db->ReplaceExtCommunityAndLocate(
+            attr, new_ext_community);
+        new_attr =
+            attr_db->ReplaceCommunityAndLocate(new_attr.get(), new_community);
+        new_attr = attr_db->ReplaceOriginVnPathAndLocate(new_attr.get(),
+            new_ovnpath);
+
+        // Skip paths with Source RD same as source RD of the connected path
+        if (!orig_rd.IsZero() && new_attr->source_rd() == orig_rd)
+            new_attr = BgpAttrPtr();
+
+        new_attr_list.push_back(new_attr);
+    }
+
+    return nexthop_.InsertAttrList(orig_attr, vn_index, new_attr_list);
+}
+
+//
+// Start a walk to update all the service chain routes after a change in the
+// nexthop. Paths with any of the old path ids are removed from the routes as
+// they are walked, unless the path id is still present in the new nexthop.
+//
+// If a walk is already in progress, it's restarted from the beginning and
+// the stale path ids accumulate.
+//
+template <typename T>
+void ServiceChain<T>::StartRouteUpdates(
+    const ConnectedPathIdList &old_path_ids) {
+    CHECK_CONCURRENCY("bgp::ServiceChain");
+    stale_path_ids_.insert(old_path_ids.begin(), old_path_ids.end());
+    route_updates_pending_ = true;
+    aggregate_updates_done_ = false;
+    has_next_aggregate_ = false;
+    next_ext_route_ = NULL;
+}
+
+//
+// Update service chain routes until the budget is exhausted. Aggregates are
+// updated before external connecting routes. The position of the walk is
+// kept as a key rather than an iterator so that the lists can be modified
+// between runs.
+//
+// Return true if the walk is complete.
+//
+template <typename T>
+bool ServiceChain<T>::ProcessRouteUpdates(size_t *budget) {
+    CHECK_CONCURRENCY("bgp::ServiceChain");
+    if (!route_updates_pending_)
+        return true;
+    if (deleted() || dest_table_unregistered() ||
+        connected_table_unregistered() || !connected_route()) {
+        CancelRouteUpdates();
+        return true;
+    }
+
+    if (!aggregate_updates_done_) {
+        typename PrefixToRouteListMap::iterator it = has_next_aggregate_ ?
+            prefix_to_routelist_map_.lower_bound(next_aggregate_) :
+            prefix_to_routelist_map_.begin();
+        for (; it != prefix_to_routelist_map_.end(); ++it) {
+            if (*budget == 0) {
+                has_next_aggregate_ = true;
+                next_aggregate_ = it->first;
+                return false;
+            }
+            if (it->second.empty())
+                continue;
+            AddServiceChainRoute(it->first, NULL, stale_path_ids_, true);
+            (*budget)--;
+        }
+        aggregate_updates_done_ = true;
+    }
+
+    typename ExtConnectRouteList::iterator it =
+        ext_connect_routes_.lower_bound(next_ext_route_);
+    for (; it != ext_connect_routes_.end(); ++it) {
+        if (*budget == 0) {
+            next_ext_route_ = *it;
+            return false;
+        }
+        RouteT *ext_route = static_cast<RouteT *>(*it);
+        AddServiceChainRoute(
+            ext_route->GetPrefix(), ext_route, stale_path_ids_, false);
+        (*budget)--;
+    }
+
+    route_updates_pending_ = false;
+    stale_path_ids_.clear();
+    return true;
+}
+
+//
+// Stop the walk. The stale path ids are retained since routes that weren't
+// walked may still have paths with them. They get cleared when the connected
+// route is deleted, since all service chain routes are removed at that point.
+//
+template <typename T>
+void ServiceChain<T>::CancelRouteUpdates() {
+    route_updates_pending_ = false;
 }
 
 template <typename T>
@@ -346,10 +698,17 @@ void ServiceChain<T>::RemoveServiceChainRoute(PrefixT prefix, bool aggregate) {
     if (!service_chain_route || service_chain_route->IsDeleted())
         return;
 
-    for (ConnectedPathIdList::const_iterator it = GetConnectedPathIds().begin();
-         it != GetConnectedPathIds().end(); ++it) {
+    // Paths with stale ids may be present if the route hasn't been updated
+    // since the last change in the nexthop.
+    ConnectedPathIdList path_ids = GetConnectedPathIds();
+    path_ids.insert(stale_path_ids_.begin(), stale_path_ids_.end());
+    for (ConnectedPathIdList::const_iterator it = path_ids.begin();
+         it != path_ids.end(); ++it) {
         uint32_t path_id = *it;
-        service_chain_route->RemovePath(BgpPath::ServiceChain, NULL, path_id);
+        if (!service_chain_route->RemovePath(
+            BgpPath::ServiceChain, NULL, path_id)) {
+            continue;
+        }
         BGP_LOG_STR(BgpMessage, SandeshLevel::SYS_DEBUG, BGP_LOG_FLAG_TRACE,
             "Removed " << (aggregate ? "Aggregate" : "ExtConnected") <<
             " ServiceChain path " << service_chain_route->ToString() <<
@@ -385,160 +744,20 @@ void ServiceChain<T>::AddServiceChainRoute(PrefixT prefix,
         service_chain_route->ClearDelete();
     }
 
-    int vn_index = dest_routing_instance()->virtual_network_index();
-    BgpServer *server = dest_routing_instance()->server();
-    OriginVn origin_vn(server->autonomous_system(), vn_index);
-
-    SiteOfOrigin soo;
-    ExtCommunity::ExtCommunityList sgid_list;
-    LoadBalance load_balance;
-    bool load_balance_present = false;
-    const Community *orig_community = NULL;
-    const OriginVnPath *orig_ovnpath = NULL;
-    RouteDistinguisher orig_rd;
-    if (orig_route) {
-        const BgpPath *orig_path = orig_route->BestPath();
-        const BgpAttr *orig_attr = NULL;
-        const ExtCommunity *ext_community = NULL;
-        if (orig_path)
-            orig_attr = orig_path->GetAttr();
-        if (orig_attr) {
-            orig_community = orig_attr->community();
-            ext_community = orig_attr->ext_community();
-            orig_ovnpath = orig_attr->origin_vn_path();
-            orig_rd = orig_attr->source_rd();
-        }
-        if (ext_community) {
-            BOOST_FOREACH(const ExtCommunity::ExtCommunityValue &comm,
-                          ext_community->communities()) {
-                if (ExtCommunity::is_security_group(comm))
-                    sgid_list.push_back(comm);
-                if (ExtCommunity::is_site_of_origin(comm) && soo.IsNull())
-                    soo = SiteOfOrigin(comm);
-                if (ExtCommunity::is_load_balance(comm)) {
-                    load_balance = LoadBalance(comm);
-                    load_balance_present = true;
-                }
-            }
-        }
-    }
-
-    BgpAttrDB *attr_db = server->attr_db();
-    CommunityDB *comm_db = server->comm_db();
-    CommunityPtr new_community = comm_db->AppendAndLocate(
-        orig_community, CommunityType::AcceptOwnNexthop);
-    ExtCommunityDB *extcomm_db = server->extcomm_db();
-    BgpMembershipManager *membership_mgr = server->membership_mgr();
-    OriginVnPathDB *ovnpath_db = server->ovnpath_db();
-    OriginVnPathPtr new_ovnpath =
-        ovnpath_db->PrependAndLocate(orig_ovnpath, origin_vn.GetExtCommunity());
+    const ServiceChainNexthop::PathList &paths = nexthop_.paths();
+    const ServiceChainNexthop::AttrList *attr_list =
+        GetServiceChainAttrs(orig_route);
+    assert(attr_list->size() == paths.size());
 
     ConnectedPathIdList new_path_ids;
-    for (Route::PathList::iterator it =
-         connected_route()->GetPathList().begin();
-         it != connected_route()->GetPathList().end(); ++it) {
-        BgpPath *connected_path = static_cast<BgpPath *>(it.operator->());
-
-        // Infeasible paths are not considered
-        if (!connected_path->IsFeasible())
-            break;
-
-        // take snapshot of all ECMP paths
-        if (connected_route()->BestPath()->PathCompare(*connected_path, true))
-            break;
-
-        // Skip paths with duplicate forwarding information.  This ensures
-        // that we generate only one path with any given next hop and label
-        // when there are multiple connected paths from the original source
-        // received via different peers e.g. directly via XMPP and via BGP.
-        if (connected_route()->DuplicateForwardingPath(connected_path))
-            continue;
-
-        const BgpAttr *attr = connected_path->GetAttr();
-
-        ExtCommunityPtr new_ext_community;
-
-        // Strip any RouteTargets from the connected attributes.
-        new_ext_community = extcomm_db->ReplaceRTargetAndLocate(
-            attr->ext_community(), ExtCommunity::ExtCommunityList());
-
-        // Replace the SGID list with the list from the original route.
-        new_ext_community = extcomm_db->ReplaceSGIDListAndLocate(
-            new_ext_community.get(), sgid_list);
-
-        // Replace SiteOfOrigin with value from original route if any.
-        if (soo.IsNull()) {
-            new_ext_community = extcomm_db->RemoveSiteOfOriginAndLocate(
-                new_ext_community.get());
-        } else {
-            new_ext_community = extcomm_db->ReplaceSiteOfOriginAndLocate(
-                new_ext_community.get(), soo.GetExtCommunity());
-        }
-
-        // Inherit load balance attribute of orig_route if connected path
-        // does not have one already.
-        if (!LoadBalance::IsPresent(connected_path) && load_balance_present) {
-            new_ext_community = extcomm_db->AppendAndLocate(
-                    new_ext_community.get(), load_balance.GetExtCommunity());
-        }
-
-        // Replace the OriginVn with the value from the original route
-        // or the value associated with the dest routing instance.
-        new_ext_community = extcomm_db->ReplaceOriginVnAndLocate(
-            new_ext_community.get(), origin_vn.GetExtCommunity());
-
-        // Replace extended community, community and origin vn path.
-        BgpAttrPtr new_attr = attr_db->ReplaceExtCommunityAndLocate(
-            attr, new_ext_community);
-        new_attr =
-            attr_db->ReplaceCommunityAndLocate(new_attr.get(), new_community);
-        new_attr = attr_db->ReplaceOriginVnPathAndLocate(new_attr.get(),
-            new_ovnpath);
-
-        // Strip aspath. This is required when the connected route is
-        // learnt via BGP.
-        new_attr = attr_db->ReplaceAsPathAndLocate(new_attr.get(), AsPathPtr());
-
-        // If the connected path is learnt via XMPP, construct RD based on
-        // the id registered with source table instead of connected table.
-        // This allows chaining of multiple in-network service instances
-        // that are on the same compute node.
-        const IPeer *peer = connected_path->GetPeer();
-        if (src_ != connected_ && peer && peer->IsXmppPeer()) {
-            int instance_id = -1;
-            bool is_registered = membership_mgr->GetRegistrationInfo(peer,
-                                                       bgptable, &instance_id);
-            if (!is_registered)
-                continue;
-            RouteDistinguisher connected_rd = attr->source_rd();
-            if (connected_rd.Type() != RouteDistinguisher::TypeIpAddressBased)
-                continue;
-
-            RouteDistinguisher rd(connected_rd.GetAddress(), instance_id);
-            new_attr = attr_db->ReplaceSourceRdAndLocate(new_attr.get(), rd);
-        }
-
-        // Replace the source rd if the connected path is a secondary path
-        // of a primary path in the l3vpn table. Use the RD of the primary.
-        if (connected_path->IsReplicated()) {
-            const BgpSecondaryPath *spath =
-                static_cast<const BgpSecondaryPath *>(connected_path);
-            const RoutingInstance *ri = spath->src_table()->routing_instance();
-            if (ri->IsMasterRoutingInstance()) {
-                const VpnRouteT *vpn_route =
-                    static_cast<const VpnRouteT *>(spath->src_rt());
-                new_attr = attr_db->ReplaceSourceRdAndLocate(new_attr.get(),
-                    vpn_route->GetPrefix().route_distinguisher());
-            }
-        }
-
-        // Skip paths with Source RD same as source RD of the connected path
-        if (!orig_rd.IsZero() && new_attr->source_rd() == orig_rd)
+    for (size_t idx = 0; idx < paths.size(); ++idx) {
+        const ServiceChainNexthop::Path &path = paths[idx];
+        const BgpAttr *new_attr = (*attr_list)[idx].get();
+        if (!new_attr)
             continue;
 
         // Check whether we already have a path with the associated path id.
-        uint32_t path_id =
-            connected_path->GetAttr()->nexthop().to_v4().to_ulong();
+        uint32_t path_id = path.path_id;
         BgpPath *existing_path =
             service_chain_route->FindPath(BgpPath::ServiceChain, NULL,
                                           path_id);
@@ -547,8 +766,8 @@ void ServiceChain<T>::AddServiceChainRoute(PrefixT prefix,
         bool path_updated = false;
         if (existing_path != NULL) {
             // Existing path can be reused.
-            if ((new_attr.get() == existing_path->GetAttr()) &&
-                (connected_path->GetLabel() == existing_path->GetLabel())) {
+            if ((new_attr == existing_path->GetAttr()) &&
+                (path.label == existing_path->GetLabel())) {
                 new_path_ids.insert(path_id);
                 continue;
             }
@@ -562,8 +781,8 @@ void ServiceChain<T>::AddServiceChainRoute(PrefixT prefix,
         }
 
         BgpPath *new_path =
-            new BgpPath(path_id, BgpPath::ServiceChain, new_attr.get(),
-                        connected_path->GetFlags(), connected_path->GetLabel());
+            new BgpPath(path_id, BgpPath::ServiceChain, new_attr,
+                        path.flags, path.label);
         if (is_stale)
             new_path->SetStale();
         if (is_llgr_stale)
@@ -587,7 +806,10 @@ void ServiceChain<T>::AddServiceChainRoute(PrefixT prefix,
         uint32_t path_id = *it;
         if (new_path_ids.find(path_id) != new_path_ids.end())
             continue;
-        service_chain_route->RemovePath(BgpPath::ServiceChain, NULL, path_id);
+        if (!service_chain_route->RemovePath(
+            BgpPath::ServiceChain, NULL, path_id)) {
+            continue;
+        }
         partition->Notify(service_chain_route);
 
         BGP_LOG_STR(BgpMessage, SandeshLevel::SYS_DEBUG, BGP_LOG_FLAG_TRACE,
@@ -725,9 +947,8 @@ bool ServiceChainMgr<T>::RequestHandler(ServiceChainRequestT *req) {
             if (info->AddMoreSpecific(aggregate_match, route) &&
                 info->IsConnectedRouteValid()) {
                 // Add the aggregate route
-                typename ServiceChainT::ConnectedPathIdList path_ids;
                 info->AddServiceChainRoute(
-                    aggregate_match, NULL, path_ids, true);
+                    aggregate_match, NULL, info->stale_path_ids(), true);
             }
             break;
         }
@@ -751,29 +972,13 @@ bool ServiceChainMgr<T>::RequestHandler(ServiceChainRequestT *req) {
                 state->reset_deleted();
             }
 
-            // Store the old path id list and populate the new one.
+            // Store the old path id list and populate the new one. The
+            // service chain routes are updated in batches only if the
+            // nexthop changed.
             typename ServiceChainT::ConnectedPathIdList path_ids =
                 info->GetConnectedPathIds();
-            info->SetConnectedRoute(route);
-
-            typename ServiceChainT::PrefixToRouteListMap *vnprefix_list =
-                info->prefix_to_route_list_map();
-            for (typename ServiceChainT::PrefixToRouteListMap::iterator it =
-                 vnprefix_list->begin(); it != vnprefix_list->end(); ++it) {
-                // Add aggregate route.. Or if the route exists
-                // sync the path and purge old paths
-                if (!it->second.empty())
-                    info->AddServiceChainRoute(it->first, NULL, path_ids, true);
-            }
-
-            for (typename ServiceChainT::ExtConnectRouteList::iterator it =
-                 info->ext_connecting_routes()->begin();
-                 it != info->ext_connecting_routes()->end(); ++it) {
-                // Add ServiceChain route for external connecting route
-                RouteT *ext_route = static_cast<RouteT *>(*it);
-                info->AddServiceChainRoute(
-                    ext_route->GetPrefix(), ext_route, path_ids, false);
-            }
+            if (info->SetConnectedRoute(route))
+                StartRouteUpdates(info, path_ids);
             break;
         }
         case ServiceChainRequestT::CONNECTED_ROUTE_DELETE: {
@@ -795,6 +1000,8 @@ bool ServiceChainMgr<T>::RequestHandler(ServiceChainRequestT *req) {
             }
             info->RemoveMatchState(route, state);
             info->SetConnectedRoute(NULL);
+            info->CancelRouteUpdates();
+            info->ClearStalePathIds();
             break;
         }
         case ServiceChainRequestT::EXT_CONNECT_ROUTE_ADD_CHG: {
@@ -805,9 +1012,8 @@ bool ServiceChainMgr<T>::RequestHandler(ServiceChainRequestT *req) {
             info->ext_connecting_routes()->insert(route);
             if (info->IsConnectedRouteValid()) {
                 RouteT *ext_route = dynamic_cast<RouteT *>(route);
-                typename ServiceChainT::ConnectedPathIdList path_ids;
-                info->AddServiceChainRoute(
-                    ext_route->GetPrefix(), ext_route, path_ids, false);
+                info->AddServiceChainRoute(ext_route->GetPrefix(), ext_route,
+                    info->stale_path_ids(), false);
             }
             break;
         }
@@ -828,27 +1034,12 @@ bool ServiceChainMgr<T>::RequestHandler(ServiceChainRequestT *req) {
             if (!info->connected_route())
                 break;
 
+            // The registration of an XMPP peer affects the source rd of
+            // connected paths learnt from it, so rebuild the nexthop.
             typename ServiceChainT::ConnectedPathIdList path_ids =
                 info->GetConnectedPathIds();
-            typename ServiceChainT::PrefixToRouteListMap *vnprefix_list =
-                info->prefix_to_route_list_map();
-            for (typename ServiceChainT::PrefixToRouteListMap::iterator it =
-                 vnprefix_list->begin(); it != vnprefix_list->end(); ++it) {
-                // Add aggregate route.. Or if the route exists
-                // sync the path and purge old paths
-                if (!it->second.empty())
-                    info->AddServiceChainRoute(
-                        it->first, NULL, path_ids, true);
-            }
-
-            for (typename ServiceChainT::ExtConnectRouteList::iterator it =
-                 info->ext_connecting_routes()->begin();
-                 it != info->ext_connecting_routes()->end(); ++it) {
-                // Add ServiceChain route for external connecting route
-                RouteT *ext_route = static_cast<RouteT *>(*it);
-                info->AddServiceChainRoute(
-                    ext_route->GetPrefix(), ext_route, path_ids, false);
-            }
+            if (info->UpdateNexthop())
+                StartRouteUpdates(info, path_ids);
             break;
         }
         case ServiceChainRequestT::STOP_CHAIN_DONE: {
@@ -914,6 +1105,10 @@ ServiceChainMgr<T>::ServiceChainMgr(BgpServer *server)
         service_chain_task_id_ = scheduler->GetTaskId("bgp::ServiceChain");
     }
 
+    update_trigger_.reset(new TaskTrigger(
+        bind(&ServiceChainMgr::ProcessRouteUpdates, this),
+        service_chain_task_id_, 0));
+
     process_queue_.reset(
         new WorkQueue<ServiceChainRequestT *>(service_chain_task_id_, 0,
                      bind(&ServiceChainMgr::RequestHandler, this, _1)));
@@ -949,6 +1144,38 @@ void ServiceChainMgr<T>::Enqueue(ServiceChainRequestT *req) {
     process_queue_->Enqueue(req);
 }
 
+//
+// Schedule a batched update of all the routes of the given service chain.
+//
+template <typename T>
+void ServiceChainMgr<T>::StartRouteUpdates(ServiceChainT *chain,
+    const typename ServiceChainT::ConnectedPathIdList &old_path_ids) {
+    CHECK_CONCURRENCY("bgp::ServiceChain");
+    if (!chain->route_updates_pending())
+        update_list_.push_back(ServiceChainPtr(chain));
+    chain->StartRouteUpdates(old_path_ids);
+    update_trigger_->Set();
+}
+
+//
+// Update service chain routes for chains in the update list, round robin,
+// till kMaxRouteUpdates routes have been updated. Return false to yield if
+// there's more work to be done.
+//
+template <typename T>
+bool ServiceChainMgr<T>::ProcessRouteUpdates() {
+    CHECK_CONCURRENCY("bgp::ServiceChain");
+    size_t budget = kMaxRouteUpdates;
+    while (!update_list_.empty() && budget > 0) {
+        ServiceChainPtr chain_ptr = update_list_.front();
+        update_list_.pop_front();
+        ServiceChainT *chain = static_cast<ServiceChainT *>(chain_ptr.get());
+        if (!chain->ProcessRouteUpdates(&budget))
+            update_list_.push_back(chain_ptr);
+    }
+    return update_list_.empty();
+}
+
 template <typename T>
 bool ServiceChainMgr<T>::IsPending(RoutingInstance *rtinstance) const {
     return pending_chains_.find(rtinstance) != pending_chains_.end();
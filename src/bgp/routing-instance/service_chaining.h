@@ -5,16 +5,20 @@
 #ifndef SRC_BGP_ROUTING_INSTANCE_SERVICE_CHAINING_H_
 #define SRC_BGP_ROUTING_INSTANCE_SERVICE_CHAINING_H_
 
+#include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 
 #include <list>
 #include <map>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/lifetime.h"
 #include "base/queue_task.h"
+#include "base/task_trigger.h"
+#include "bgp/bgp_attr.h"
 #include "bgp/bgp_condition_listener.h"
 #include "bgp/inet/inet_route.h"
 #include "bgp/inet6/inet6_route.h"
@@ -106,6 +110,74 @@ private:
     DISALLOW_COPY_AND_ASSIGN(ServiceChainRequest);
 };
 
+//
+// Forwarding information derived from the connected route of a ServiceChain.
+//
+// There's a single ServiceChainNexthop per ServiceChain and it's shared by
+// all the service chain routes i.e. aggregates and external connecting routes.
+// It has one entry for each ECMP path of the connected route, with attributes
+// that depend only on the connected path (route targets and as path stripped,
+// source rd fixed up for XMPP and replicated paths) computed once.
+//
+// The final attributes of the service chain paths also depend on attributes
+// of the original route. These are memoized per original attribute since a
+// large number of routes typically have the same one (e.g. aggregates, which
+// have no original route, or routes leaked from the same gateway). The cache
+// is flushed whenever the nexthop is rebuilt.
+//
+class ServiceChainNexthop {
+public:
+    struct Path {
+        Path(uint32_t path_id, const BgpAttr *attr, uint32_t flags,
+             uint32_t label, bool load_balance_present)
+            : path_id(path_id),
+              attr(attr),
+              flags(flags),
+              label(label),
+              load_balance_present(load_balance_present) {
+        }
+        bool operator==(const Path &rhs) const {
+            return path_id == rhs.path_id && attr == rhs.attr &&
+                flags == rhs.flags && label == rhs.label;
+        }
+
+        uint32_t path_id;
+        BgpAttrPtr attr;
+        uint32_t flags;
+        uint32_t label;
+        bool load_balance_present;
+    };
+    typedef std::vector<Path> PathList;
+
+    // Final attribute for each path, NULL if the path is to be skipped.
+    typedef std::vector<BgpAttrPtr> AttrList;
+
+    static const size_t kMaxAttrCacheSize = 4096;
+
+    ServiceChainNexthop() : version_(0), vn_index_(0) { }
+
+    void Reset(const PathList &paths);
+    bool Equals(const PathList &paths) const { return paths_ == paths; }
+    const PathList &paths() const { return paths_; }
+    uint64_t version() const { return version_; }
+
+    const AttrList *FindAttrList(const BgpAttr *orig_attr, int vn_index) const;
+    const AttrList *InsertAttrList(const BgpAttr *orig_attr, int vn_index,
+                                   const AttrList &attr_list);
+    size_t attr_cache_size() const { return attr_cache_.size(); }
+
+private:
+    typedef std::map<const BgpAttr *, std::pair<BgpAttrPtr, AttrList> >
+        AttrCache;
+
+    PathList paths_;
+    uint64_t version_;
+    int vn_index_;
+    AttrCache attr_cache_;
+
+    DISALLOW_COPY_AND_ASSIGN(ServiceChainNexthop);
+};
+
 template <typename T>
 class ServiceChain : public ConditionMatch {
 public:
@@ -139,11 +211,22 @@ public:
     bool CompareServiceChainConfig(const ServiceChainConfig &config);
     void RemoveMatchState(BgpRoute *route, ServiceChainState *state);
 
-    void SetConnectedRoute(BgpRoute *connected);
+    bool SetConnectedRoute(BgpRoute *connected);
+    bool UpdateNexthop();
     bool IsConnectedRouteValid() const;
     const ConnectedPathIdList &GetConnectedPathIds() {
         return connected_path_ids_;
     }
+    const ServiceChainNexthop *nexthop() const { return &nexthop_; }
+
+    void StartRouteUpdates(const ConnectedPathIdList &old_path_ids);
+    bool ProcessRouteUpdates(size_t *budget);
+    void CancelRouteUpdates();
+    void ClearStalePathIds() { stale_path_ids_.clear(); }
+    bool route_updates_pending() const { return route_updates_pending_; }
+    const ConnectedPathIdList &stale_path_ids() const {
+        return stale_path_ids_;
+    }
 
     BgpRoute *connected_route() const { return connected_route_; }
     RoutingInstance *src_routing_instance() const { return src_; }
@@ -171,6 +254,8 @@ public:
 
     virtual bool Match(BgpServer *server, BgpTable *table, BgpRoute *route,
         bool deleted);
+    virtual bool GetMatchPrefix(const BgpTable *table, IpAddress *address,
+        int *prefixlen) const;
     virtual std::string ToString() const;
 
     void FillServiceChainInfo(ShowServicechainInfo *info) const;
@@ -208,6 +293,18 @@ private:
     RoutingInstance *connected_;
     ConnectedPathIdList connected_path_ids_;
     BgpRoute *connected_route_;
+    ServiceChainNexthop nexthop_;
+
+    // State for a batched walk of the service chain routes to update them
+    // after a change in the nexthop. Paths with the stale path ids may still
+    // be present on routes that haven't been walked yet.
+    bool route_updates_pending_;
+    bool aggregate_updates_done_;
+    bool has_next_aggregate_;
+    PrefixT next_aggregate_;
+    BgpRoute *next_ext_route_;
+    ConnectedPathIdList stale_path_ids_;
+
     AddressT service_chain_addr_;
     PrefixToRouteListMap prefix_to_routelist_map_;
     ExtConnectRouteList ext_connect_routes_;
@@ -222,6 +319,8 @@ private:
     bool IsMoreSpecific(BgpRoute *route, PrefixT *aggregate_match) const;
     bool IsAggregate(BgpRoute *route) const;
     bool IsConnectedRoute(BgpRoute *route) const;
+    const ServiceChainNexthop::AttrList *GetServiceChainAttrs(
+        const RouteT *orig_route);
 
     DISALLOW_COPY_AND_ASSIGN(ServiceChain);
 };
@@ -250,11 +349,15 @@ public:
     virtual size_t PendingQueueSize() const { return pending_chains_.size(); }
     virtual size_t ResolvedQueueSize() const { return chain_set_.size(); }
     virtual uint32_t GetDownServiceChainCount() const;
-    virtual bool IsQueueEmpty() const { return process_queue_->IsQueueEmpty(); }
+    virtual bool IsQueueEmpty() const {
+        return process_queue_->IsQueueEmpty() && !update_trigger_->IsSet();
+    }
     virtual bool IsPending(RoutingInstance *rtinstance) const;
 
     Address::Family GetFamily() const;
     void Enqueue(ServiceChainRequestT *req);
+    void StartRouteUpdates(ServiceChainT *chain,
+        const typename ServiceChainT::ConnectedPathIdList &old_path_ids);
     virtual bool FillServiceChainInfo(RoutingInstance *rtinstance,
                                       ShowServicechainInfo *info) const;
 
@@ -266,15 +369,23 @@ private:
     // of this task. This task has exclusion with db::DBTable task.
     static int service_chain_task_id_;
 
+    // Maximum number of service chain routes updated in one run of the
+    // update trigger.
+    static const size_t kMaxRouteUpdates = 1024;
+
     // Set of service chains created in the system
     typedef std::map<RoutingInstance *, ServiceChainPtr> ServiceChainMap;
 
+    // Service chains with pending route updates, processed round robin.
+    typedef std::list<ServiceChainPtr> ServiceChainUpdateList;
+
     // At the time of processing, service chain request, all required
     // routing instance may not be created. Create a list of service chain
     // waiting for a routing instance to get created
     typedef std::set<RoutingInstance *> PendingServiceChainList;
 
     bool RequestHandler(ServiceChainRequestT *req);
+    bool ProcessRouteUpdates();
     void StopServiceChainDone(BgpTable *table, ConditionMatch *info);
     ServiceChainT *FindServiceChain(const std::string &instance) const;
     ServiceChainT *FindServiceChain(RoutingInstance *rtinstance) const;
@@ -311,10 +422,12 @@ private:
     BgpServer *server_;
     BgpConditionListener *listener_;
     boost::scoped_ptr<TaskTrigger> resolve_trigger_;
+    boost::scoped_ptr<TaskTrigger> update_trigger_;
     boost::scoped_ptr<WorkQueue<ServiceChainRequestT *> > process_queue_;
     bool aggregate_host_route_;
     ServiceChainMap chain_set_;
     PendingServiceChainList pending_chains_;
+    ServiceChainUpdateList update_list_;
 
     DISALLOW_COPY_AND_ASSIGN(ServiceChainMgr);
 };
@@ -136,6 +136,14 @@ public:
     virtual bool Match(BgpServer *server, BgpTable *table,
                        BgpRoute *route, bool deleted);
 
+    // Only routes that cover the nexthop can match.
+    virtual bool GetMatchPrefix(const BgpTable *table, IpAddress *address,
+                                int *prefixlen) const {
+        *address = nexthop_;
+        *prefixlen = HostPrefixLength(nexthop_);
+        return true;
+    }
+
     virtual string ToString() const {
         return (string("StaticRoute ") + nexthop_.to_string());
     }
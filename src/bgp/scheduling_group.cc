@@ -10,8 +10,10 @@
 #include <string>
 
 #include "base/task_annotations.h"
+#include "base/time_util.h"
 #include "bgp/bgp_factory.h"
 #include "bgp/bgp_log.h"
+#include "bgp/bgp_peer_types.h"
 #include "bgp/bgp_ribout.h"
 #include "bgp/bgp_ribout_updates.h"
 
@@ -37,6 +39,36 @@ struct SchedulingGroup::PeerRibState {
     uint8_t qactive;
 };
 
+//
+// This struct represents a SendShard in a SchedulingGroup. It has it's own
+// WorkQueue of WorkPeer entries and related Worker state.  Both are protected
+// by the mutex in the SchedulingGroup.
+//
+// The statistics are updated by the Worker for the SendShard and are used to
+// report the send throughput for the SendShard.
+//
+struct SchedulingGroup::SendShard {
+    explicit SendShard(size_t index)
+        : index(index), running(false), worker_task(NULL) {
+        work_count = 0;
+        peer_dequeue_count = 0;
+        messages_sent_count = 0;
+        blocked_count = 0;
+        run_time_usec = 0;
+    }
+
+    size_t index;
+    WorkQueue work_queue;
+    bool running;
+    Worker *worker_task;
+
+    tbb::atomic<uint64_t> work_count;
+    tbb::atomic<uint64_t> peer_dequeue_count;
+    tbb::atomic<uint64_t> messages_sent_count;
+    tbb::atomic<uint64_t> blocked_count;
+    tbb::atomic<uint64_t> run_time_usec;
+};
+
 //
 // This nested class represents IPeerUpdate related state that's specific to
 // the SchedulingGroup.
@@ -59,6 +91,11 @@ struct SchedulingGroup::PeerRibState {
 // A (RibOut, QueueId) pair is considered to be active if the PeerState isn't
 // send_ready and there's RouteUpdates for the pair.
 //
+// The PeerRibState for a RibOut is only modified while holding the mutex for
+// the corresponding RibState.  The counts of active RibOuts and the in_sync
+// state are atomic since they can be updated by the Worker for the group and
+// the Worker for the SendShard of the peer at the same time.
+//
 class SchedulingGroup::PeerState {
 public:
     typedef map<size_t, PeerRibState> Map;
@@ -138,7 +175,8 @@ public:
     explicit PeerState(IPeerUpdate *peer)
         : key_(peer), index_(-1),
         qactive_cnt_(RibOutUpdates::QCOUNT),
-        in_sync_(true), rib_iterator_(BitSet::npos) {
+        rib_iterator_(BitSet::npos) {
+        in_sync_ = true;
         send_ready_ = true;
         for (int i = 0; i < RibOutUpdates::QCOUNT; i++) {
             qactive_cnt_[i] = 0;
@@ -248,8 +286,8 @@ private:
     size_t index_;          // assigned from PeerStateMap in the group
     Map rib_set_;           // list of RibOuts advertised by the peer.
     BitSet rib_bitset_;     // bitset of RibOuts advertised by the peer
-    vector<int> qactive_cnt_;
-    bool in_sync_;          // whether the peer may dequeue tail markers.
+    vector<tbb::atomic<int> > qactive_cnt_;
+    tbb::atomic<bool> in_sync_;  // whether the peer may dequeue tail markers.
     tbb::atomic<bool> send_ready_;    // whether the peer may send updates.
     size_t rib_iterator_;   // index of last processed rib.
 
@@ -268,6 +306,12 @@ private:
 // the functionality to walk through all the PeerState entries for the
 // ribout.
 //
+// The mutex serializes dequeues for the RibOut when the SchedulingGroup has
+// SendShards.  It's also held when updating the in_sync state for the RibOut
+// and the PeerRibState of any peer for the RibOut.  It's not used when the
+// SchedulingGroup isn't sharded, since all dequeues then run in the Worker
+// for the SchedulingGroup.
+//
 class SchedulingGroup::RibState {
 public:
     class iterator : public boost::iterator_facade<
@@ -327,11 +371,14 @@ public:
 
     const GroupPeerSet &peer_set() const { return peer_set_; }
 
+    tbb::mutex &mutex() { return mutex_; }
+
 private:
     RibOut *key_;
     size_t index_;
     GroupPeerSet peer_set_;
     vector<bool> in_sync_;
+    tbb::mutex mutex_;
 
     DISALLOW_COPY_AND_ASSIGN(RibState);
 };
@@ -398,23 +445,30 @@ RibOut &SchedulingGroup::PeerState::circular_iterator::dereference() const {
     return *indexmap_.At(index_)->ribout();
 }
 
+//
+// The Worker processes the WorkQueue for the SchedulingGroup if the shard is
+// NULL and the WorkQueue for the SendShard otherwise.
+//
 class SchedulingGroup::Worker : public Task {
 public:
-    explicit Worker(SchedulingGroup *group)
-        : Task(send_task_id_), group_(group) {
+    explicit Worker(SchedulingGroup *group, SendShard *shard = NULL)
+        : Task(send_task_id_), group_(group), shard_(shard) {
     }
 
     virtual bool Run() {
         CHECK_CONCURRENCY("bgp::SendTask");
 
+        uint64_t start_time = shard_ ? UTCTimestampUsec() : 0;
         while (true) {
-            auto_ptr<WorkBase> wentry = group_->WorkDequeue();
+            auto_ptr<WorkBase> wentry = group_->WorkDequeue(shard_);
             if (wentry.get() == NULL) {
                 break;
             }
             if (!wentry->valid) {
                 continue;
             }
+            if (shard_)
+                shard_->work_count++;
             switch (wentry->type) {
             case WorkBase::WRibOut: {
                 WorkRibOut *workrib = static_cast<WorkRibOut *>(wentry.get());
@@ -429,12 +483,15 @@ public:
             }
         }
 
+        if (shard_)
+            shard_->run_time_usec += UTCTimestampUsec() - start_time;
         return true;
     }
     string Description() const { return "SchedulingGroup::Worker"; }
 
 private:
     SchedulingGroup *group_;
+    SendShard *shard_;
 };
 
 SchedulingGroup::SchedulingGroup()
@@ -450,10 +507,93 @@ SchedulingGroup::SchedulingGroup()
 }
 
 SchedulingGroup::~SchedulingGroup() {
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
     if (worker_task_) {
-        TaskScheduler *scheduler = TaskScheduler::GetInstance();
         scheduler->Cancel(worker_task_);
     }
+    for (SendShardList::iterator it = shards_.begin();
+         it != shards_.end(); ++it) {
+        SendShard *shard = *it;
+        if (shard->worker_task)
+            scheduler->Cancel(shard->worker_task);
+    }
+    STLDeleteValues(&shards_);
+}
+
+//
+// Set the number of SendShards for the SchedulingGroup.  A count of 1 or less
+// means that the SchedulingGroup is not sharded.
+//
+void SchedulingGroup::set_shard_count(size_t count) {
+    assert(empty());
+    assert(shards_.empty());
+    if (count <= 1)
+        return;
+    for (size_t idx = 0; idx < count; ++idx) {
+        shards_.push_back(new SendShard(idx));
+    }
+}
+
+//
+// Return the SendShard for the given PeerState, NULL if the SchedulingGroup
+// is not sharded.
+//
+SchedulingGroup::SendShard *SchedulingGroup::PeerShard(
+    const PeerState *ps) const {
+    if (shards_.empty())
+        return NULL;
+    return shards_[ps->index() % shards_.size()];
+}
+
+//
+// Return the number of entries in the WorkQueue for the given SendShard.
+//
+size_t SchedulingGroup::ShardWorkQueueSize(size_t index) const {
+    return shards_[index]->work_queue.size();
+}
+
+//
+// Get the SendShard index for an IPeerUpdate.
+//
+size_t SchedulingGroup::GetPeerShard(IPeerUpdate *peer) const {
+    PeerState *ps = peer_state_imap_.Find(peer);
+    if (ps == NULL)
+        return BitSet::npos;
+    SendShard *shard = PeerShard(ps);
+    return shard ? shard->index : 0;
+}
+
+//
+// Fill introspect information for the SendShard of the given IPeerUpdate.
+// Return false if the SchedulingGroup is not sharded.
+//
+bool SchedulingGroup::FillSendShardInfo(IPeerUpdate *peer,
+    ShowSendShardStats *info) const {
+    CHECK_CONCURRENCY("bgp::PeerMembership", "bgp::ShowCommand");
+
+    PeerState *ps = peer_state_imap_.Find(peer);
+    if (ps == NULL)
+        return false;
+    SendShard *shard = PeerShard(ps);
+    if (shard == NULL)
+        return false;
+
+    uint32_t peer_count = 0;
+    for (size_t i = 0; i < peer_state_imap_.size(); i++) {
+        PeerState *other_ps = peer_state_imap_.At(i);
+        if (other_ps != NULL && PeerShard(other_ps) == shard)
+            peer_count++;
+    }
+
+    info->set_shard(shard->index);
+    info->set_shard_count(shards_.size());
+    info->set_peers(peer_count);
+    info->set_work_items(shard->work_count);
+    info->set_peer_dequeues(shard->peer_dequeue_count);
+    info->set_messages_sent(shard->messages_sent_count);
+    info->set_blocked(shard->blocked_count);
+    info->set_run_time_usec(shard->run_time_usec);
+    return true;
 }
 
 void SchedulingGroup::clear() {
@@ -651,10 +791,49 @@ void SchedulingGroup::Merge(SchedulingGroup *rhs) {
     // Finally transfer the work queue from the old SchedulingGroup to this
     // one and clear the old SchedulingGroup. It's the caller responsibility
     // to delete the old SchedulingGroup.
+    //
+    // WorkPeer entries in the SendShards of the old SchedulingGroup need to
+    // be redistributed since the IPeers have new indexes in this one.
     work_queue_.transfer(work_queue_.end(), rhs->work_queue_);
+    for (SendShardList::iterator it = rhs->shards_.begin();
+         it != rhs->shards_.end(); ++it) {
+        ShardWorkPeerMove(rhs, &(*it)->work_queue);
+    }
     rhs->clear();
 }
 
+//
+// Move WorkPeer entries from the given WorkQueue, which belongs to a SendShard
+// in the source SchedulingGroup, to the SendShard in this SchedulingGroup for
+// the corresponding IPeerUpdate.  Entries for IPeers that are not in this
+// SchedulingGroup are left alone.
+//
+// Start the Worker for any SendShards that received new entries.
+//
+void SchedulingGroup::ShardWorkPeerMove(SchedulingGroup *src_sg,
+    WorkQueue *queue) {
+    CHECK_CONCURRENCY("bgp::PeerMembership");
+
+    tbb::mutex::scoped_lock lock(mutex_);
+    for (WorkQueue::iterator iter = queue->begin(); iter != queue->end(); ) {
+        WorkPeer *work = static_cast<WorkPeer *>(iter.operator->());
+        WorkQueue::iterator loc = iter;
+        ++iter;
+        assert(work->type == WorkBase::WPeer);
+        PeerState *ps = peer_state_imap_.Find(work->peer);
+        if (ps == NULL)
+            continue;
+        SendShard *shard = PeerShard(ps);
+        if (shard == NULL) {
+            work_queue_.transfer(work_queue_.end(), loc, *queue);
+            MaybeStartWorker();
+        } else if (&shard->work_queue != queue) {
+            shard->work_queue.transfer(shard->work_queue.end(), loc, *queue);
+            MaybeStartShardWorker(shard);
+        }
+    }
+}
+
 //
 // Split all RibOuts in the list specified as rg2 from this SchedulingGroup
 // into the SchedulingGroup specified as rhs. Naturally, all the IPeers that
@@ -735,6 +914,12 @@ void SchedulingGroup::Split(SchedulingGroup *rhs, const RibOutList &rg1,
             rhs->work_queue_.transfer(rhs->work_queue_.end(), loc, work_queue_);
         }
     }
+
+    // Move WorkPeer entries in the SendShards for the IPeers being moved.
+    for (SendShardList::iterator it = shards_.begin();
+         it != shards_.end(); ++it) {
+        rhs->ShardWorkPeerMove(this, &(*it)->work_queue);
+    }
 }
 
 //
@@ -834,16 +1019,38 @@ void SchedulingGroup::MaybeStartWorker() {
 }
 
 //
-// Dequeue the first WorkBase item from the work queue and return an
-// auto_ptr to it.  Clear out Worker related state if the work queue
-// is empty.
+// Create a Worker for the SendShard if warranted and enqueue it to the
+// TaskScheduler.
+// Assumes that the caller holds the SchedulingGroup mutex.
 //
-auto_ptr<SchedulingGroup::WorkBase> SchedulingGroup::WorkDequeue() {
+void SchedulingGroup::MaybeStartShardWorker(SendShard *shard) {
+    if (!shard->running && !disabled_ && !shard->work_queue.empty()) {
+        shard->worker_task = new Worker(this, shard);
+        TaskScheduler *scheduler = TaskScheduler::GetInstance();
+        scheduler->Enqueue(shard->worker_task);
+        shard->running = true;
+    }
+}
+
+//
+// Dequeue the first WorkBase item from the work queue for the SendShard, or
+// for the SchedulingGroup if the SendShard is NULL, and return an auto_ptr
+// to it.  Clear out Worker related state if the work queue is empty.
+//
+auto_ptr<SchedulingGroup::WorkBase> SchedulingGroup::WorkDequeue(
+    SendShard *shard) {
     CHECK_CONCURRENCY("bgp::SendTask");
 
     tbb::mutex::scoped_lock lock(mutex_);
     auto_ptr<WorkBase> wentry;
-    if (work_queue_.empty()) {
+    if (shard) {
+        if (shard->work_queue.empty()) {
+            shard->worker_task = NULL;
+            shard->running = false;
+        } else {
+            wentry.reset(shard->work_queue.pop_front().release());
+        }
+    } else if (work_queue_.empty()) {
         worker_task_ = NULL;
         running_ = false;
     } else {
@@ -873,16 +1080,30 @@ void SchedulingGroup::set_disabled(bool disabled) {
     tbb::mutex::scoped_lock lock(mutex_);
     disabled_ = disabled;
     MaybeStartWorker();
+    for (SendShardList::iterator it = shards_.begin();
+         it != shards_.end(); ++it) {
+        MaybeStartShardWorker(*it);
+    }
 }
 
 //
-// Enqueue a WorkPeer to the work queue.
+// Enqueue a WorkPeer to the work queue for the SendShard of the IPeerUpdate,
+// or to the work queue for the SchedulingGroup if it's not sharded.
 //
 void SchedulingGroup::WorkPeerEnqueue(IPeerUpdate *peer) {
     CHECK_CONCURRENCY("bgp::SendReadyTask");
 
     WorkBase *wentry = new WorkPeer(peer);
-    WorkEnqueue(wentry);
+    PeerState *ps = peer_state_imap_.Find(peer);
+    SendShard *shard = ps ? PeerShard(ps) : NULL;
+    if (shard == NULL) {
+        WorkEnqueue(wentry);
+        return;
+    }
+
+    tbb::mutex::scoped_lock lock(mutex_);
+    shard->work_queue.push_back(wentry);
+    MaybeStartShardWorker(shard);
 }
 
 //
@@ -903,6 +1124,18 @@ void SchedulingGroup::PeerInvalidate(IPeerUpdate *peer) {
             continue;
         wpeer->valid = false;
     }
+
+    // The PeerState is already gone, so look at all SendShards.
+    for (SendShardList::iterator it = shards_.begin();
+         it != shards_.end(); ++it) {
+        WorkQueue *queue = &(*it)->work_queue;
+        for (WorkQueue::iterator iter = queue->begin();
+             iter != queue->end(); ++iter) {
+            WorkPeer *wpeer = static_cast<WorkPeer *>(iter.operator->());
+            if (wpeer->peer == peer)
+                wpeer->valid = false;
+        }
+    }
 }
 
 //
@@ -961,7 +1194,10 @@ void SchedulingGroup::BuildSyncUnsyncBitSet(const RibOut *ribout, RibState *rs,
 // that we need to use bit indices that are specific to the RibOut, not the
 // ones from the SchedulingGroup.
 //
-void SchedulingGroup::BuildSendReadyBitSet(RibOut *ribout, RibPeerSet *mready) {
+// Only IPeers in the given SendShard are considered.
+//
+void SchedulingGroup::BuildSendReadyBitSet(RibOut *ribout,
+    const SendShard *shard, RibPeerSet *mready) {
     CHECK_CONCURRENCY("bgp::SendTask");
 
     RibState *rs = rib_state_imap_.Find(ribout);
@@ -969,7 +1205,7 @@ void SchedulingGroup::BuildSendReadyBitSet(RibOut *ribout, RibPeerSet *mready) {
     for (RibState::iterator iter = rs->begin(peer_state_imap_);
          iter != rs->end(peer_state_imap_); ++iter) {
         const PeerState *ps = iter.operator->();
-        if (ps->send_ready()) {
+        if (ps->send_ready() && PeerShard(ps) == shard) {
             int rix = ribout->GetPeerIndex(ps->peer());
             mready->set(rix);
         }
@@ -1054,6 +1290,9 @@ bool SchedulingGroup::IsQueueActive(RibOut *ribout, int queue_id,
 // Mark all the RibStates for the given peer and queue id as being in sync
 // and trigger a tail dequeue.
 //
+// Assumes that the caller holds the mutex for all the RibStates if the
+// SchedulingGroup has SendShards.
+//
 void SchedulingGroup::SetQueueSync(PeerState *ps, int queue_id) {
     CHECK_CONCURRENCY("bgp::SendTask");
 
@@ -1077,6 +1316,9 @@ void SchedulingGroup::UpdateRibOut(RibOut *ribout, int queue_id) {
 
     RibOutUpdates *updates = ribout->updates();
     RibState *rs = rib_state_imap_.Find(ribout);
+    tbb::mutex::scoped_lock lock;
+    if (!shards_.empty())
+        lock.acquire(rs->mutex());
     RibPeerSet msync, munsync;
 
     // Convert group in-sync list to rib specific bitset.
@@ -1115,29 +1357,48 @@ bool SchedulingGroup::UpdatePeerQueue(IPeerUpdate *peer, PeerState *ps,
         int queue_id) {
     CHECK_CONCURRENCY("bgp::SendTask");
 
+    SendShard *shard = PeerShard(ps);
     for (PeerState::circular_iterator iter =
             ps->circular_begin(rib_state_imap_);
          iter != ps->circular_end(rib_state_imap_); ++iter) {
+        RibState *rs = iter.rib_state();
+        tbb::mutex::scoped_lock lock;
+        if (shard)
+            lock.acquire(rs->mutex());
+
         // Skip if this queue is not active in the PeerRibState.
         if (!BitIsSet(iter.peer_rib_state().qactive, queue_id))
             continue;
 
+        // The peer may have been blocked by a tail dequeue in the Worker for
+        // the SchedulingGroup if we are running in the Worker for a shard.
+        if (!ps->send_ready()) {
+            ps->SetIteratorStart(iter.index());
+            return false;
+        }
+
         RibOut *ribout = iter.operator->();
 
         // Build the send ready bitset. This includes all send ready peers
-        // for the ribout so that we can potentially merge other peers as
-        // we move forward in processing the update queue.
+        // in the shard for the ribout so that we can potentially merge other
+        // peers as we move forward in processing the update queue.
         RibPeerSet send_ready;
-        BuildSendReadyBitSet(ribout, &send_ready);
+        BuildSendReadyBitSet(ribout, shard, &send_ready);
 
         // Drain the queue till we can do no more.
         RibOutUpdates *updates = ribout->updates();
         RibPeerSet blocked;
+        uint64_t messages_sent = updates->messages_sent_count(queue_id);
         bool done = updates->PeerDequeue(queue_id, peer, send_ready, &blocked);
         assert(send_ready.Contains(blocked));
+        if (shard) {
+            shard->peer_dequeue_count++;
+            shard->messages_sent_count +=
+                updates->messages_sent_count(queue_id) - messages_sent;
+            shard->blocked_count += blocked.count();
+        }
 
         // Process blocked mask.
-        RibState *rs = iter.rib_state();
         SetSendBlocked(ribout, rs, queue_id, blocked);
 
         // If the peer is still send_ready, mark the queue as inactive for
@@ -1172,35 +1433,81 @@ void SchedulingGroup::UpdatePeer(IPeerUpdate *peer) {
         return;
     }
 
-    // Go through all queues and drain them if there's anything on them.
-    for (int queue_id = RibOutUpdates::QCOUNT - 1; queue_id >= 0; --queue_id) {
-        if (ps->QueueCount(queue_id) == 0) {
-            continue;
+    // Keep going till the peer gets blocked or we manage to mark it as being
+    // in sync.  A tail dequeue in the Worker for the SchedulingGroup may make
+    // a queue active again before we get a chance to do the latter if we are
+    // running in the Worker for a shard.
+    do {
+        // Go through all queues and drain them if there's anything on them.
+        for (int queue_id = RibOutUpdates::QCOUNT - 1; queue_id >= 0;
+             --queue_id) {
+            if (ps->QueueCount(queue_id) == 0) {
+                continue;
+            }
+            if (!UpdatePeerQueue(peer, ps, queue_id)) {
+                assert(!ps->send_ready());
+                return;
+            }
         }
-        if (!UpdatePeerQueue(peer, ps, queue_id)) {
-            assert(!ps->send_ready());
+
+        // Checking the return value of UpdatePeerQueue above is not
+        // sufficient as that only tells us that *some* peer(s) got merged
+        // with the tail marker.  Need to make sure that the IPeerUpdate that
+        // we are processing is still send ready.
+        if (!ps->send_ready()) {
             return;
         }
+    } while (!UpdatePeerSync(ps));
+}
+
+//
+// Mark the peer as being in sync across all tables if all it's queues are
+// still inactive. Return false if that's not the case.
+//
+// If the SchedulingGroup has SendShards, the mutex for all the RibStates for
+// the peer is held, in increasing order of index to avoid deadlocks, so that
+// a concurrent tail dequeue cannot make any of the queues active while we're
+// doing this.
+//
+bool SchedulingGroup::UpdatePeerSync(PeerState *ps) {
+    CHECK_CONCURRENCY("bgp::SendTask");
+
+    RibStateList rs_list;
+    for (PeerState::iterator iter = ps->begin(rib_state_imap_);
+         !shards_.empty() && iter != ps->end(rib_state_imap_); ++iter) {
+        RibState *rs = iter.rib_state();
+        rs->mutex().lock();
+        rs_list.push_back(rs);
     }
 
-    // Checking the return value of UpdatePeerQueue above is not sufficient as
-    // that only tells us that *some* peer(s) got merged with the tail marker.
-    // Need to make sure that the IPeerUpdate that we are processing is still
-    // send ready.
-    if (!ps->send_ready()) {
-        return;
+    bool in_sync = ps->send_ready();
+    for (int queue_id = RibOutUpdates::QCOUNT - 1; queue_id >= 0; --queue_id) {
+        if (ps->QueueCount(queue_id) != 0)
+            in_sync = false;
     }
 
-    // Mark the peer as being in sync across all tables.
-    ps->SetSync();
+    if (in_sync) {
+        // Mark the peer as being in sync across all tables.
+        ps->SetSync();
 
-    // Mark all RibStates for the peer as being in sync. This triggers a tail
-    // dequeue for the corresponding (RibOut, QueueId) if necessary. This in
-    // turn ensures that we do not get stuck in the case where all peers get
-    // blocked and then get back in sync.
-    for (int queue_id = RibOutUpdates::QCOUNT - 1; queue_id >= 0; --queue_id) {
-        SetQueueSync(ps, queue_id);
+        // Mark all RibStates for the peer as being in sync. This triggers a
+        // tail dequeue for the corresponding (RibOut, QueueId) if necessary.
+        // This in turn ensures that we do not get stuck in the case where all
+        // peers get blocked and then get back in sync.
+        for (int queue_id = RibOutUpdates::QCOUNT - 1; queue_id >= 0;
+             --queue_id) {
+            SetQueueSync(ps, queue_id);
+        }
+    }
+
+    for (RibStateList::reverse_iterator it = rs_list.rbegin();
+         it != rs_list.rend(); ++it) {
+        (*it)->mutex().unlock();
     }
+
+    // If the peer is no longer send ready, it will be processed again when
+    // it becomes send ready.
+    return in_sync || !ps->send_ready();
 }
 
 //
@@ -1280,6 +1587,7 @@ struct WorkQueueDelete<IPeerUpdate *> {
 // Constructor for SchedulingGroupManager. Initialize send ready WorkQueue.
 //
 SchedulingGroupManager::SchedulingGroupManager() :
+    send_shard_count_(1),
     send_ready_queue_(
             TaskScheduler::GetInstance()->GetTaskId("bgp::SendReadyTask"), 0,
             boost::bind(&SchedulingGroupManager::SendReadyCallback, this, _1)) {
@@ -1290,6 +1598,24 @@ SchedulingGroupManager::~SchedulingGroupManager() {
 }
 
 
+//
+// Set the number of SendShards for new SchedulingGroups.
+//
+void SchedulingGroupManager::set_send_shard_count(size_t count) {
+    assert(groups_.empty());
+    send_shard_count_ = count ? count : 1;
+}
+
+//
+// Create a new SchedulingGroup and add it to the GroupList.
+//
+SchedulingGroup *SchedulingGroupManager::CreateGroup() {
+    SchedulingGroup *sg = BgpObjectFactory::Create<SchedulingGroup>();
+    sg->set_shard_count(send_shard_count_);
+    groups_.push_back(sg);
+    return sg;
+}
+
 //
 // Return the SchedulingGroup for the specified IPeerUpdate.
 //
@@ -1325,8 +1651,7 @@ void SchedulingGroupManager::Join(RibOut *ribout, IPeerUpdate *peer) {
     if (i1 == peer_map_.end()) {
         if (i2 == ribout_map_.end()) {
             // Create new empty group
-            sg = BgpObjectFactory::Create<SchedulingGroup>();
-            groups_.push_back(sg);
+            sg = CreateGroup();
             ribout_map_.insert(make_pair(ribout, sg));
         } else {
             // Add peer to existing group
@@ -1493,8 +1818,7 @@ void SchedulingGroupManager::Split(
         SchedulingGroup *sg, const RibOutList &rg1, const RibOutList &rg2) {
     CHECK_CONCURRENCY("bgp::PeerMembership");
 
-    SchedulingGroup *sg2 = BgpObjectFactory::Create<SchedulingGroup>();
-    groups_.push_back(sg2);
+    SchedulingGroup *sg2 = CreateGroup();
 
     // Note that calling the Split method results in the creation of all
     // necessary PeerState and RibOutState in sg2. Hence, there's no typo
@@ -19,6 +19,7 @@
 class IPeerUpdate;
 class RibOut;
 class RibPeerSet;
+class ShowSendShardStats;
 
 class GroupPeerSet : public BitSet {
 };
@@ -55,6 +56,23 @@ class GroupPeerSet : public BitSet {
 // WorkRibOut entry after adding a RouteUpdate to an empty UpdateQueue, and
 // the IPeer class which create a WorkPeer entry when it becomes unblocked.
 //
+// A SchedulingGroup can optionally be divided into a number of SendShards.
+// This is useful when a large number of IPeers advertise the same set of
+// RibOuts e.g. vRouter agents that all subscribe to the same few instances,
+// since all of them would otherwise end up being serviced by a single thread.
+// Each IPeerUpdate is assigned to a SendShard based on it's index in the
+// PeerStateMap.  WorkRibOut entries are still processed by the Worker for the
+// SchedulingGroup, so the tail dequeue and the encoding of update messages
+// for in-sync peers is shared by all the shards. WorkPeer entries are queued
+// to the SendShard for the IPeerUpdate and processed by a Worker for the
+// SendShard, so peer dequeues for IPeers in different SendShards can run in
+// parallel.
+//
+// When a SchedulingGroup has SendShards, dequeues for a given RibOut are
+// serialized using a mutex in the corresponding RibState.  A peer dequeue
+// only merges and sends to IPeers in the same SendShard, which ensures that
+// a given IPeerUpdate is only written from one thread at a time.
+//
 class SchedulingGroup {
 public:
     static const uint32_t kSplitThreshold = 8192;
@@ -106,6 +124,12 @@ public:
     void DecrementMemberCount();
     void IncrementMemberCount();
 
+    // Must be called before any members are added to the group.
+    void set_shard_count(size_t count);
+    size_t shard_count() const { return shards_.size(); }
+    size_t GetPeerShard(IPeerUpdate *peer) const;
+    bool FillSendShardInfo(IPeerUpdate *peer, ShowSendShardStats *info) const;
+
     bool CheckInvariants() const;
 
     void clear();
@@ -154,19 +178,27 @@ private:
     class PeerIterator;
     class Worker;
     struct PeerRibState;
+    struct SendShard;
 
     typedef boost::ptr_list<WorkBase> WorkQueue;
     typedef IndexMap<IPeerUpdate *, PeerState, GroupPeerSet> PeerStateMap;
     typedef IndexMap<RibOut *, RibState> RibStateMap;
+    typedef std::vector<SendShard *> SendShardList;
 
     void MaybeStartWorker();
-    std::auto_ptr<WorkBase> WorkDequeue();
+    void MaybeStartShardWorker(SendShard *shard);
+    std::auto_ptr<WorkBase> WorkDequeue(SendShard *shard);
     void WorkEnqueue(WorkBase *wentry);
     void WorkPeerEnqueue(IPeerUpdate *peer);
     void WorkRibOutEnqueue(RibOut *ribout, int queue_id);
 
     void UpdateRibOut(RibOut *ribout, int queue_id);
     void UpdatePeer(IPeerUpdate *peer);
+    bool UpdatePeerSync(PeerState *ps);
+
+    SendShard *PeerShard(const PeerState *ps) const;
+    size_t ShardWorkQueueSize(size_t index) const;
+    void ShardWorkPeerMove(SchedulingGroup *src_sg, WorkQueue *queue);
 
     // Notification that a peer is send ready.
     void SendReady(IPeerUpdate *peer);
@@ -177,7 +209,8 @@ private:
 
     void BuildSyncUnsyncBitSet(const RibOut *ribout, RibState *rs,
                                RibPeerSet *msync, RibPeerSet *munsync);
-    void BuildSendReadyBitSet(RibOut *ribout, RibPeerSet *mready);
+    void BuildSendReadyBitSet(RibOut *ribout, const SendShard *shard,
+                              RibPeerSet *mready);
 
     void SetQueueActive(const RibOut *ribout, RibState *rs, int queue_id,
                         const RibPeerSet &munsync);
@@ -202,6 +235,7 @@ private:
 
     PeerStateMap peer_state_imap_;
     RibStateMap rib_state_imap_;
+    SendShardList shards_;
 
     static int send_task_id_;
 
@@ -245,6 +279,12 @@ public:
     // Number of SchedulingGroups.
     int size() const { return groups_.size(); }
 
+    // Number of SendShards for new SchedulingGroups. A value of 1 means that
+    // SchedulingGroups are not sharded.  Can only be changed when there are
+    // no SchedulingGroups.
+    size_t send_shard_count() const { return send_shard_count_; }
+    void set_send_shard_count(size_t count);
+
     // For unit testing.
     void DisableGroups();
     void EnableGroups();
@@ -266,9 +306,12 @@ private:
 
     void Move(SchedulingGroup *group, SchedulingGroup *dst);
 
+    SchedulingGroup *CreateGroup();
+
     GroupList groups_;
     PeerMap peer_map_;
     RibOutMap ribout_map_;
+    size_t send_shard_count_;
 
     // Deferred send ready processing.
     WorkQueue<IPeerUpdate *> send_ready_queue_;
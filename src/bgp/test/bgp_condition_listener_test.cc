@@ -58,13 +58,25 @@ class TestConditionMatch : public ConditionMatch {
 public:
     typedef map<PrefixT, BgpRoute *> MatchList;
     TestConditionMatch(Address::Family family, const PrefixT &prefix,
-                       bool hold_db_state)
-        : family_(family), prefix_(prefix), hold_db_state_(hold_db_state) {
+                       bool hold_db_state, bool use_match_prefix = false)
+        : family_(family), prefix_(prefix), hold_db_state_(hold_db_state),
+          use_match_prefix_(use_match_prefix) {
+        match_calls_ = 0;
+    }
+
+    bool GetMatchPrefix(const BgpTable *table, IpAddress *address,
+                        int *prefixlen) const {
+        if (!use_match_prefix_)
+            return false;
+        *address = prefix_.addr();
+        *prefixlen = prefix_.prefixlen();
+        return true;
     }
 
     bool Match(BgpServer *server, BgpTable *table,
                BgpRoute *route, bool deleted) {
         RouteT *ip_route = dynamic_cast<RouteT *>(route);
+        match_calls_++;
 
         BgpConditionListener *listener = server->condition_listener(family_);
         TestMatchState *state = static_cast<TestMatchState *>(
@@ -121,6 +133,8 @@ public:
         return it->second;
     }
 
+    int match_calls() const { return match_calls_; }
+
     void remove_matched_route(const PrefixT &prefix) {
         tbb::mutex::scoped_lock lock(mutex_);
         typename MatchList::iterator it = match_list_.find(prefix);;
@@ -134,6 +148,8 @@ private:
     MatchList match_list_;
     PrefixT prefix_;
     bool hold_db_state_;
+    bool use_match_prefix_;
+    tbb::atomic<int> match_calls_;
 };
 
 //
@@ -332,10 +348,12 @@ protected:
     }
 
     void AddMatchCondition(string name, string match,
-                           bool hold_db_state = false) {
+                           bool hold_db_state = false,
+                           bool use_match_prefix = false) {
         ConcurrencyScope scope("bgp::Config");
         PrefixT prefix = PrefixT::FromString(match);
-        match_.reset(new ConditionMatchT(family_, prefix, hold_db_state));
+        match_.reset(new ConditionMatchT(family_, prefix, hold_db_state,
+                                         use_match_prefix));
         RoutingInstance *rti =
             bgp_server_->routing_instance_mgr()->GetRoutingInstance(name);
         BgpTable *table = rti->GetTable(family_);
@@ -611,6 +629,64 @@ TYPED_TEST(BgpConditionListenerTest, ChangeNotify) {
     task_util::WaitForIdle();
 }
 
+//
+// ConditionMatch with a match prefix is invoked only for routes that overlap
+// the prefix.
+//
+TYPED_TEST(BgpConditionListenerTest, MatchPrefix) {
+    typedef typename TypeParam::ConditionMatchT ConditionMatchT;
+
+    this->AddRoutingInstance("blue");
+    task_util::WaitForIdle();
+
+    // Add the match condition on table with existing routes
+    this->AddRoute("blue", this->BuildHostAddress("192.168.1.2"));
+    this->AddRoute("blue", this->BuildHostAddress("192.168.2.2"));
+    this->AddRoute("blue", this->BuildPrefix("192.168.0.0", 16));
+    this->AddRoute("blue", this->BuildPrefix("10.1.0.0", 16));
+
+    this->AddMatchCondition("blue", this->BuildPrefix("192.168.1.0", 24),
+                            false, true);
+    task_util::WaitForIdle();
+
+    // Match is invoked for 192.168.1.2 and 192.168.0.0/16 during the walk.
+    ConditionMatchT *match = static_cast<ConditionMatchT *>(this->match_.get());
+    TASK_UTIL_EXPECT_EQ(1, match->matched_routes_size());
+    TASK_UTIL_EXPECT_EQ(2, match->match_calls());
+
+    // Non-overlapping routes don't invoke Match.
+    this->AddRoute("blue", this->BuildHostAddress("192.168.3.3"));
+    this->AddRoute("blue", this->BuildPrefix("192.168.2.0", 24));
+    this->AddRoute("blue", this->BuildPrefix("10.1.1.0", 24));
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(2, match->match_calls());
+
+    // Overlapping routes do.
+    this->AddRoute("blue", this->BuildHostAddress("192.168.1.3"));
+    this->AddRoute("blue", this->BuildPrefix("192.168.1.0", 24));
+    this->AddRoute("blue", this->BuildPrefix("192.168.0.0", 20));
+    TASK_UTIL_EXPECT_EQ(2, match->matched_routes_size());
+    TASK_UTIL_EXPECT_EQ(5, match->match_calls());
+
+    this->DeleteRoute("blue", this->BuildHostAddress("192.168.1.3"));
+    TASK_UTIL_EXPECT_EQ(1, match->matched_routes_size());
+    TASK_UTIL_EXPECT_EQ(6, match->match_calls());
+
+    this->RemoveMatchCondition("blue");
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_TRUE(match->matched_routes_empty());
+
+    this->DeleteRoute("blue", this->BuildHostAddress("192.168.1.2"));
+    this->DeleteRoute("blue", this->BuildHostAddress("192.168.2.2"));
+    this->DeleteRoute("blue", this->BuildHostAddress("192.168.3.3"));
+    this->DeleteRoute("blue", this->BuildPrefix("192.168.0.0", 16));
+    this->DeleteRoute("blue", this->BuildPrefix("192.168.0.0", 20));
+    this->DeleteRoute("blue", this->BuildPrefix("192.168.1.0", 24));
+    this->DeleteRoute("blue", this->BuildPrefix("192.168.2.0", 24));
+    this->DeleteRoute("blue", this->BuildPrefix("10.1.0.0", 16));
+    this->DeleteRoute("blue", this->BuildPrefix("10.1.1.0", 24));
+}
+
 class TestEnvironment : public ::testing::Environment {
     virtual ~TestEnvironment() { }
 };
@@ -2,9 +2,14 @@
  * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
  */
 
+#include <stdlib.h>
+
+#include <algorithm>
+
 #include <boost/foreach.hpp>
 
 #include "base/task_annotations.h"
+#include "base/time_util.h"
 #include "bgp/bgp_factory.h"
 #include "bgp/bgp_evpn.h"
 #include "bgp/bgp_ribout_updates.h"
@@ -342,6 +347,17 @@ protected:
         }
     }
 
+    void CreateScaleXmppPeers(int count) {
+        for (int idx = 1; idx <= count; ++idx) {
+            Ip4Address address(Ip4Address::from_string("10.2.0.0").to_ulong() +
+                idx);
+            PeerMock *peer = new PeerMock(
+                xmpp_peers_.size() + 1, address, true, 10000 + idx);
+            xmpp_peers_.push_back(peer);
+            RibOutRegister(blue_ribout_.get(), peer);
+        }
+    }
+
     void ChangeXmppPeersLabelCommon(bool odd, bool even) {
         BOOST_FOREACH(PeerMock *peer, xmpp_peers_) {
             if ((odd && peer->index() % 2 != 0) ||
@@ -386,7 +402,7 @@ protected:
     }
 
     void AddXmppPeerBroadcastMacRoute(PeerMock *peer, string nexthop_str = "",
-        uint32_t label = 0) {
+        uint32_t label = 0, bool wait_for_idle = true) {
         EXPECT_TRUE(peer->IsXmppPeer());
         RouteDistinguisher rd(peer->address().to_ulong(), kVrfId);
         EvpnPrefix prefix(rd, tag_, MacAddress::BroadcastMac(), IpAddress());
@@ -427,7 +443,8 @@ protected:
             new EvpnTable::RequestData(attr, 0, label ? label : peer->label()));
         addReq.oper = DBRequest::DB_ENTRY_ADD_CHANGE;
         blue_->Enqueue(&addReq);
-        task_util::WaitForIdle();
+        if (wait_for_idle)
+            task_util::WaitForIdle();
     }
 
     void AddXmppPeersBroadcastMacRouteCommon(bool odd, bool even) {
@@ -451,7 +468,8 @@ protected:
         AddXmppPeersBroadcastMacRouteCommon(true, true);
     }
 
-    void DelXmppPeerBroadcastMacRoute(PeerMock *peer) {
+    void DelXmppPeerBroadcastMacRoute(PeerMock *peer,
+        bool wait_for_idle = true) {
         EXPECT_TRUE(peer->IsXmppPeer());
         RouteDistinguisher rd(peer->address().to_ulong(), kVrfId);
         EvpnPrefix prefix(rd, tag_, MacAddress::BroadcastMac(), IpAddress());
@@ -460,7 +478,8 @@ protected:
         delReq.key.reset(new EvpnTable::RequestKey(prefix, peer));
         delReq.oper = DBRequest::DB_ENTRY_DELETE;
         blue_->Enqueue(&delReq);
-        task_util::WaitForIdle();
+        if (wait_for_idle)
+            task_util::WaitForIdle();
     }
 
     void DelAllXmppPeersBroadcastMacRoute() {
@@ -3814,6 +3833,52 @@ TEST_P(BgpEvpnManagerTest, UnicastAndMulticast6) {
     VerifyAllXmppPeersNoUpdateInfo();
 }
 
+// Benchmark for ingress replication olists with a large number of XMPP
+// peers in a single EVPN instance.
+// Add Inclusive Multicast route from all BGP peers.
+// Add Broadcast MAC routes from all XMPP peers without waiting in between.
+// Verify UpdateInfo for Broadcast MAC routes from all XMPP peers.
+// Delete Broadcast MAC routes from all XMPP peers.
+// The number of XMPP peers can be changed with the environment variable
+// BGP_EVPN_MANAGER_TEST_XMPP_PEERS, e.g. to 2000 for a meaningful benchmark.
+TEST_P(BgpEvpnManagerTest, ScaleXmppPeers) {
+    char *str = getenv("BGP_EVPN_MANAGER_TEST_XMPP_PEERS");
+    size_t xmpp_peer_count = str ? strtoul(str, NULL, 0) : 64;
+    xmpp_peer_count = std::max(xmpp_peer_count, xmpp_peers_.size());
+    CreateScaleXmppPeers(xmpp_peer_count - xmpp_peers_.size());
+    AddAllBgpPeersInclusiveMulticastRoute();
+
+    uint64_t start_time = UTCTimestampUsec();
+    BOOST_FOREACH(PeerMock *peer, xmpp_peers_) {
+        AddXmppPeerBroadcastMacRoute(peer, "", 0, false);
+    }
+    task_util::WaitForIdle();
+    uint64_t add_time = UTCTimestampUsec() - start_time;
+    TASK_UTIL_EXPECT_EQ(xmpp_peer_count, GetPartitionLocalSize(tag_));
+    TASK_UTIL_EXPECT_EQ(bgp_peers_.size() + xmpp_peer_count,
+        GetPartitionRemoteSize(tag_));
+
+    start_time = UTCTimestampUsec();
+    VerifyAllXmppPeersAllUpdateInfo();
+    uint64_t verify_time = UTCTimestampUsec() - start_time;
+
+    start_time = UTCTimestampUsec();
+    BOOST_FOREACH(PeerMock *peer, xmpp_peers_) {
+        DelXmppPeerBroadcastMacRoute(peer, false);
+    }
+    task_util::WaitForIdle();
+    uint64_t del_time = UTCTimestampUsec() - start_time;
+    TASK_UTIL_EXPECT_EQ(0, GetPartitionLocalSize(tag_));
+
+    cout << "XMPP peers: " << xmpp_peer_count
+         << " add: " << add_time / 1000 << " msec"
+         << " update info: " << verify_time / 1000 << " msec"
+         << " delete: " << del_time / 1000 << " msec" << endl;
+
+    DelAllBgpPeersInclusiveMulticastRoute();
+    TASK_UTIL_EXPECT_EQ(0, GetPartitionRemoteSize(tag_));
+}
+
 INSTANTIATE_TEST_CASE_P(Default, BgpEvpnManagerTest, ::testing::Values(0, 4094));
 
 class TestEnvironment : public ::testing::Environment {
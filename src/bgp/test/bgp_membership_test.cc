@@ -209,6 +209,39 @@ protected:
         table->Enqueue(&request);
     }
 
+    void AddMultiPathRoute(BgpTestPeer *peer, BgpTable *table,
+        const string &prefix_str, const vector<string> &nexthops) {
+        boost::system::error_code ec;
+        Ip4Prefix prefix = Ip4Prefix::FromString(prefix_str, &ec);
+        EXPECT_FALSE(ec);
+        DBRequest request;
+        request.oper = DBRequest::DB_ENTRY_ADD_CHANGE;
+        request.key.reset(new InetTable::RequestKey(prefix, peer));
+
+        BgpAttrSpec attr_spec;
+        BgpAttrOrigin origin_spec(BgpAttrOrigin::INCOMPLETE);
+        attr_spec.push_back(&origin_spec);
+
+        BgpAttrLocalPref local_pref(100);
+        attr_spec.push_back(&local_pref);
+
+        IpAddress nh_addr = IpAddress::from_string(nexthops[0], ec);
+        EXPECT_FALSE(ec);
+        BgpAttrNextHop nh_spec(nh_addr);
+        attr_spec.push_back(&nh_spec);
+
+        BgpAttrPtr attr = server_->attr_db()->Locate(attr_spec);
+        InetTable::RequestData::NextHops nexthop_list;
+        for (size_t idx = 0; idx < nexthops.size(); ++idx) {
+            IpAddress address = IpAddress::from_string(nexthops[idx], ec);
+            EXPECT_FALSE(ec);
+            nexthop_list.push_back(
+                InetTable::RequestData::NextHop(0, address, 0));
+        }
+        request.data.reset(new InetTable::RequestData(attr, nexthop_list));
+        table->Enqueue(&request);
+    }
+
     void DeleteRoute(BgpTestPeer *peer, BgpTable *table,
         const string &prefix_str) {
         boost::system::error_code ec;
@@ -944,6 +977,242 @@ TEST_F(BgpMembershipTest, MultiplePeersWalkRibIn) {
     TASK_UTIL_EXPECT_EQ(0, mgr_->GetMembershipCount());
 }
 
+//
+// Verify that a RibIn walk only visits the paths added by the walked peers.
+// The walk is done using the per peer path lists in the table and should not
+// be affected by the number of paths added by other peers.
+//
+TEST_F(BgpMembershipTest, WalkRibInPeerPathList) {
+    static const int kRouteCount = 8;
+    static const int kOtherRouteCount = 512;
+
+    // Register all peers.
+    Register(peers_[0], blue_tbl_);
+    Register(peers_[1], blue_tbl_);
+    task_util::WaitForIdle();
+
+    TASK_UTIL_EXPECT_TRUE(IsWalkerQueueEmpty());
+    TASK_UTIL_EXPECT_EQ(2, mgr_->GetMembershipCount());
+    uint64_t blue_walk_count = blue_tbl_->walk_complete_count();
+
+    // Add a few paths from one peer and lots of paths from the other peer.
+    for (int idx = 0; idx < kRouteCount; idx++) {
+        AddRoute(peers_[0], blue_tbl_, BuildPrefix(idx), "192.168.1.0");
+    }
+    for (int idx = 0; idx < kOtherRouteCount; idx++) {
+        AddRoute(peers_[1], blue_tbl_, BuildPrefix(idx), "192.168.1.1");
+    }
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(kOtherRouteCount, blue_tbl_->Size());
+    TASK_UTIL_EXPECT_EQ(kRouteCount, blue_tbl_->GetPeerPathCount(peers_[0]));
+    TASK_UTIL_EXPECT_EQ(kOtherRouteCount,
+        blue_tbl_->GetPeerPathCount(peers_[1]));
+
+    // Walk the blue table for the peer with a few paths.
+    WalkRibIn(peers_[0], blue_tbl_);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_TRUE(IsWalkerQueueEmpty());
+    TASK_UTIL_EXPECT_EQ(blue_walk_count + 1, blue_tbl_->walk_request_count());
+    TASK_UTIL_EXPECT_EQ(blue_walk_count + 1, blue_tbl_->walk_complete_count());
+    TASK_UTIL_EXPECT_EQ(kRouteCount, peers_[0]->path_cb_count());
+    TASK_UTIL_EXPECT_EQ(0, peers_[1]->path_cb_count());
+
+    // Walk the blue table for both peers.
+    WalkRibIn(peers_[0], blue_tbl_);
+    WalkRibIn(peers_[1], blue_tbl_);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_TRUE(IsWalkerQueueEmpty());
+    TASK_UTIL_EXPECT_EQ(2 * kRouteCount, peers_[0]->path_cb_count());
+    TASK_UTIL_EXPECT_EQ(kOtherRouteCount, peers_[1]->path_cb_count());
+
+    // Delete paths from all peers.
+    for (int idx = 0; idx < kRouteCount; idx++) {
+        DeleteRoute(peers_[0], blue_tbl_, BuildPrefix(idx));
+    }
+    for (int idx = 0; idx < kOtherRouteCount; idx++) {
+        DeleteRoute(peers_[1], blue_tbl_, BuildPrefix(idx));
+    }
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(0, blue_tbl_->Size());
+    TASK_UTIL_EXPECT_EQ(0, blue_tbl_->GetPeerPathCount(peers_[0]));
+    TASK_UTIL_EXPECT_EQ(0, blue_tbl_->GetPeerPathCount(peers_[1]));
+
+    // Unregister all peers.
+    Unregister(peers_[0], blue_tbl_);
+    Unregister(peers_[1], blue_tbl_);
+    task_util::WaitForIdle();
+
+    TASK_UTIL_EXPECT_TRUE(IsWalkerQueueEmpty());
+    TASK_UTIL_EXPECT_EQ(0, mgr_->GetMembershipCount());
+}
+
+//
+// Verify that a RibIn walk visits each path once when a peer has multiple
+// paths for the same route. All the paths from the peer for a route are
+// visited together and the route is post-processed once.
+//
+TEST_F(BgpMembershipTest, WalkRibInPeerPathListMultiPath) {
+    static const int kRouteCount = 8;
+    vector<string> nexthops;
+    nexthops.push_back("192.168.1.0");
+    nexthops.push_back("192.168.1.1");
+    nexthops.push_back("192.168.1.2");
+
+    // Register.
+    Register(peers_[0], blue_tbl_);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(1, mgr_->GetMembershipCount());
+
+    // Add multiple paths for each route.
+    for (int idx = 0; idx < kRouteCount; idx++) {
+        AddMultiPathRoute(peers_[0], blue_tbl_, BuildPrefix(idx), nexthops);
+    }
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(kRouteCount, blue_tbl_->Size());
+    TASK_UTIL_EXPECT_EQ(kRouteCount * nexthops.size(),
+        blue_tbl_->GetPeerPathCount(peers_[0]));
+
+    // Walk the blue table for the peer.
+    WalkRibIn(peers_[0], blue_tbl_);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_TRUE(IsWalkerQueueEmpty());
+    TASK_UTIL_EXPECT_EQ(kRouteCount * nexthops.size(),
+        peers_[0]->path_cb_count());
+
+    // Walk again, the paths are still on the list.
+    WalkRibIn(peers_[0], blue_tbl_);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(2 * kRouteCount * nexthops.size(),
+        peers_[0]->path_cb_count());
+    TASK_UTIL_EXPECT_EQ(kRouteCount * nexthops.size(),
+        blue_tbl_->GetPeerPathCount(peers_[0]));
+
+    // Delete the routes.
+    for (int idx = 0; idx < kRouteCount; idx++) {
+        DeleteRoute(peers_[0], blue_tbl_, BuildPrefix(idx));
+    }
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(0, blue_tbl_->Size());
+    TASK_UTIL_EXPECT_EQ(0, blue_tbl_->GetPeerPathCount(peers_[0]));
+
+    // Unregister.
+    Unregister(peers_[0], blue_tbl_);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_TRUE(IsWalkerQueueEmpty());
+    TASK_UTIL_EXPECT_EQ(0, mgr_->GetMembershipCount());
+}
+
+//
+// Verify RibIn walk and unregister when the per peer path index is disabled.
+// RibIn processing falls back to a walk of the entire table.
+//
+TEST_F(BgpMembershipTest, WalkRibInNoPeerPathIndex) {
+    static const int kRouteCount = 8;
+
+    // Create green routing instance without the per peer path index.
+    server_->set_peer_path_index_enable(false);
+    BgpTable *green_tbl = NULL;
+    {
+        ConcurrencyScope scope("bgp::Config");
+        BgpInstanceConfig green_config("green");
+        RoutingInstance *rtinstance =
+            server_->routing_instance_mgr()->CreateRoutingInstance(
+                &green_config);
+        green_tbl = rtinstance->GetTable(Address::INET);
+    }
+    server_->set_peer_path_index_enable(true);
+    task_util::WaitForIdle();
+    EXPECT_FALSE(green_tbl->peer_path_index());
+    EXPECT_TRUE(blue_tbl_->peer_path_index());
+
+    // Register.
+    Register(peers_[0], green_tbl);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(1, mgr_->GetMembershipCount());
+    uint64_t green_walk_count = green_tbl->walk_complete_count();
+
+    // Add paths from peer.
+    for (int idx = 0; idx < kRouteCount; idx++) {
+        AddRoute(peers_[0], green_tbl, BuildPrefix(idx), "192.168.1.0");
+    }
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(kRouteCount, green_tbl->Size());
+    TASK_UTIL_EXPECT_EQ(0, green_tbl->GetPeerPathCount(peers_[0]));
+
+    // Walk the green table.
+    WalkRibIn(peers_[0], green_tbl);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(green_walk_count + 1, green_tbl->walk_complete_count());
+    TASK_UTIL_EXPECT_EQ(kRouteCount, peers_[0]->path_cb_count());
+
+    // Unregister.
+    Unregister(peers_[0], green_tbl);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(0, mgr_->GetMembershipCount());
+    TASK_UTIL_EXPECT_EQ(green_walk_count + 2, green_tbl->walk_complete_count());
+    TASK_UTIL_EXPECT_EQ(2 * kRouteCount, peers_[0]->path_cb_count());
+
+    // Delete paths from peer.
+    for (int idx = 0; idx < kRouteCount; idx++) {
+        DeleteRoute(peers_[0], green_tbl, BuildPrefix(idx));
+    }
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(0, green_tbl->Size());
+}
+
+//
+// Verify that unregister of RibIn and RibOut visits the paths added by the
+// peer exactly once and uses a single table walk. The per peer path lists
+// are not walked since the table walk for RibOut processing visits all the
+// routes anyway.
+//
+TEST_F(BgpMembershipTest, UnregisterPeerPathList) {
+    static const int kRouteCount = 8;
+    static const int kOtherRouteCount = 64;
+
+    // Register all peers.
+    Register(peers_[0], blue_tbl_);
+    Register(peers_[1], blue_tbl_);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(2, mgr_->GetMembershipCount());
+    uint64_t blue_walk_count = blue_tbl_->walk_complete_count();
+
+    // Add paths from both peers.
+    for (int idx = 0; idx < kRouteCount; idx++) {
+        AddRoute(peers_[0], blue_tbl_, BuildPrefix(idx), "192.168.1.0");
+    }
+    for (int idx = 0; idx < kOtherRouteCount; idx++) {
+        AddRoute(peers_[1], blue_tbl_, BuildPrefix(idx), "192.168.1.1");
+    }
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(kOtherRouteCount, blue_tbl_->Size());
+
+    // Unregister the peer with a few paths.
+    Unregister(peers_[0], blue_tbl_);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_TRUE(IsWalkerQueueEmpty());
+    TASK_UTIL_EXPECT_EQ(1, mgr_->GetMembershipCount());
+    TASK_UTIL_EXPECT_EQ(blue_walk_count + 1, blue_tbl_->walk_request_count());
+    TASK_UTIL_EXPECT_EQ(blue_walk_count + 1, blue_tbl_->walk_complete_count());
+    TASK_UTIL_EXPECT_EQ(kRouteCount, peers_[0]->path_cb_count());
+    TASK_UTIL_EXPECT_EQ(0, peers_[1]->path_cb_count());
+
+    // Delete paths from all peers.
+    for (int idx = 0; idx < kRouteCount; idx++) {
+        DeleteRoute(peers_[0], blue_tbl_, BuildPrefix(idx));
+    }
+    for (int idx = 0; idx < kOtherRouteCount; idx++) {
+        DeleteRoute(peers_[1], blue_tbl_, BuildPrefix(idx));
+    }
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(0, blue_tbl_->Size());
+
+    // Unregister remaining peer.
+    Unregister(peers_[1], blue_tbl_);
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(0, mgr_->GetMembershipCount());
+}
+
 //
 // Verify WalkRibIn functionality for multiple peers.
 // Walk requests from multiple peers and register from other peer is combined
@@ -2,6 +2,12 @@
  * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
  */
 
+#include <boost/scoped_ptr.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
 #include "base/task_annotations.h"
 #include "base/test/task_test_util.h"
 
@@ -182,6 +188,80 @@ TEST_F(BgpMsgBuilderTest, Build) {
     delete result;
 }
 
+//
+// Routes with the same attributes are packed into messages that don't exceed
+// the maximum message size of the RibOut. A RibOut for peers that negotiated
+// the Extended Message capability needs fewer messages for the same routes.
+//
+TEST_F(BgpMsgBuilderTest, MaxMessageSize) {
+    static const int kRouteCount = 8192;
+    BgpAttrSpec attr_spec;
+    BgpAttrNextHop nexthop(0x0a010101);
+    attr_spec.push_back(&nexthop);
+    BgpAttrOrigin origin(BgpAttrOrigin::INCOMPLETE);
+    attr_spec.push_back(&origin);
+    RibOutAttr rib_out_attr;
+    rib_out_attr.set_attr(NULL, server_.attr_db()->Locate(attr_spec));
+
+    vector<InetVpnRoute *> routes;
+    for (int idx = 0; idx < kRouteCount; ++idx) {
+        ostringstream repr;
+        repr << "12345:2:10." << idx / 256 << "." << idx % 256 << ".0/24";
+        InetVpnRoute *route =
+            new InetVpnRoute(InetVpnPrefix::FromString(repr.str()));
+        route->InsertPath(new BgpPath(
+            peer_, BgpPath::BGP_XMPP, rib_out_attr.attr(), 0, 0));
+        routes.push_back(route);
+    }
+
+    size_t max_sizes[] = { 4096, 65535 };
+    size_t message_counts[2];
+    for (int size_idx = 0; size_idx < 2; ++size_idx) {
+        RibExportPolicy policy;
+        policy.max_message_size = max_sizes[size_idx];
+        RibOut ribout(NULL, NULL, policy);
+        BgpMessageBuilder builder;
+
+        size_t message_count = 0, route_count = 0, max_length = 0;
+        vector<InetVpnRoute *>::iterator it = routes.begin();
+        while (it != routes.end()) {
+            boost::scoped_ptr<Message> message(
+                builder.Create(&ribout, false, &rib_out_attr, *it));
+            ASSERT_TRUE(message.get() != NULL);
+            for (++it; it != routes.end(); ++it) {
+                if (!message->AddRoute(*it, &rib_out_attr))
+                    break;
+            }
+            message->Finish();
+
+            size_t length;
+            const uint8_t *data = message->GetData(NULL, &length);
+            EXPECT_LE(length, max_sizes[size_idx]);
+            EXPECT_EQ(data, message->GetSharedData().get());
+            max_length = std::max(max_length, length);
+            boost::scoped_ptr<const BgpProto::Update> update(
+                static_cast<const BgpProto::Update *>(
+                    BgpProto::Decode(data, length)));
+            ASSERT_TRUE(update.get() != NULL);
+            const BgpMpNlri *nlri = static_cast<const BgpMpNlri *>(
+                update->path_attributes.back());
+            EXPECT_EQ(message->num_reach_routes(), nlri->nlri.size());
+            route_count += nlri->nlri.size();
+            message_count++;
+        }
+        EXPECT_EQ(static_cast<size_t>(kRouteCount), route_count);
+        EXPECT_GT(max_length, max_sizes[size_idx] - 32);
+        message_counts[size_idx] = message_count;
+    }
+    EXPECT_GT(message_counts[0], message_counts[1] * 8);
+
+    for (vector<InetVpnRoute *>::iterator it = routes.begin();
+         it != routes.end(); ++it) {
+        (*it)->RemovePath(peer_);
+        delete *it;
+    }
+}
+
 void BgpMsgBuilderTest::TestSkipNotificationReceive(int code,
                                                     int subcode) const {
     if (code < BgpProto::Notification::MsgHdrErr ||
@@ -4,6 +4,8 @@
 
 #include "bgp/bgp_multicast.h"
 
+#include <algorithm>
+
 #include "base/task_annotations.h"
 #include "bgp/bgp_update.h"
 #include "bgp/ermvpn/ermvpn_table.h"
@@ -20,16 +22,17 @@ public:
           address_str_(address_str),
           label_block_(new LabelBlock(1000, 1500 -1)) {
         boost::system::error_code ec;
-        BgpAttrSpec attr_spec;
         address_ = Ip4Address::from_string(address_str.c_str(), ec);
-        BgpAttrNextHop nexthop(address_.to_ulong());
-        attr_spec.push_back(&nexthop);
-        BgpAttrLabelBlock label_block(label_block_);
-        attr_spec.push_back(&label_block);
-        attr = server_->attr_db()->Locate(attr_spec);
+        LocateAttr();
     }
     virtual ~XmppPeerMock() { }
 
+    // Routes added after this use the given label block.
+    void set_label_block(LabelBlockPtr label_block) {
+        label_block_ = label_block;
+        LocateAttr();
+    }
+
     void AddRoute(ErmVpnTable *table, string group_str, string source_str) {
         boost::system::error_code ec;
         RouteDistinguisher rd(address_.to_ulong(), 65535);
@@ -90,6 +93,15 @@ public:
     virtual bool CanUseMembershipManager() const { return true; }
 
 private:
+    void LocateAttr() {
+        BgpAttrSpec attr_spec;
+        BgpAttrNextHop nexthop(address_.to_ulong());
+        attr_spec.push_back(&nexthop);
+        BgpAttrLabelBlock label_block(label_block_);
+        attr_spec.push_back(&label_block);
+        attr = server_->attr_db()->Locate(attr_spec);
+    }
+
     BgpServer *server_;
     string address_str_;
     Ip4Address address_;
@@ -327,6 +339,115 @@ protected:
         VerifyForwarderCount(tm, group_str, "0.0.0.0", count);
     }
 
+    typedef std::map<McastForwarder *, uint32_t> ForwarderLabelMap;
+
+    McastSGEntry *FindSGEntry(McastTreeManager *tm, string group_str) {
+        boost::system::error_code ec;
+        Ip4Address group = Ip4Address::from_string(group_str.c_str(), ec);
+        Ip4Address source = Ip4Address::from_string("0.0.0.0", ec);
+        for (McastTreeManager::PartitionList::iterator it =
+             tm->partitions_.begin(); it != tm->partitions_.end(); ++it) {
+            McastSGEntry *sg_entry = (*it)->FindSGEntry(group, source);
+            if (sg_entry)
+                return sg_entry;
+        }
+        return NULL;
+    }
+
+    void GetForwarderLabels(McastTreeManager *tm, string group_str,
+            ForwarderLabelMap *labels) {
+        ConcurrencyScope scope("db::DBTable");
+
+        McastSGEntry *sg_entry = FindSGEntry(tm, group_str);
+        ASSERT_TRUE(sg_entry != NULL);
+        McastSGEntry::ForwarderSet *forwarders =
+            sg_entry->forwarder_sets_[McastTreeManager::LevelNative];
+        labels->clear();
+        for (McastSGEntry::ForwarderSet::iterator it = forwarders->begin();
+             it != forwarders->end(); ++it) {
+            labels->insert(std::make_pair(*it, (*it)->label()));
+        }
+    }
+
+    void VerifyForwarderLabels(McastTreeManager *tm, string group_str,
+            const ForwarderLabelMap &labels, size_t count) {
+        ConcurrencyScope scope("db::DBTable");
+
+        McastSGEntry *sg_entry = FindSGEntry(tm, group_str);
+        ASSERT_TRUE(sg_entry != NULL);
+        McastSGEntry::ForwarderSet *forwarders =
+            sg_entry->forwarder_sets_[McastTreeManager::LevelNative];
+        size_t matched = 0;
+        for (McastSGEntry::ForwarderSet::iterator it = forwarders->begin();
+             it != forwarders->end(); ++it) {
+            ForwarderLabelMap::const_iterator loc = labels.find(*it);
+            if (loc == labels.end())
+                continue;
+            EXPECT_EQ(loc->second, (*it)->label());
+            matched++;
+        }
+        EXPECT_EQ(count, matched);
+    }
+
+    // Get the index of the peer whose forwarder is the forest node.
+    int GetForestNodePeerIndex(McastTreeManager *tm, string group_str) {
+        ConcurrencyScope scope("db::DBTable");
+
+        McastSGEntry *sg_entry = FindSGEntry(tm, group_str);
+        if (!sg_entry || !sg_entry->forest_node_)
+            return -1;
+        const IPeer *peer =
+            sg_entry->forest_node_->route()->BestPath()->GetPeer();
+        for (int idx = 0; idx < kPeerCount; idx++) {
+            if (peers_[idx] == peer)
+                return idx;
+        }
+        return -1;
+    }
+
+    // Get the forwarder for the route added by the peer with the given index.
+    McastForwarder *FindForwarder(McastTreeManager *tm, string group_str,
+            int peer_idx) {
+        ConcurrencyScope scope("db::DBTable");
+
+        McastSGEntry *sg_entry = FindSGEntry(tm, group_str);
+        if (!sg_entry)
+            return NULL;
+        McastSGEntry::ForwarderSet *forwarders =
+            sg_entry->forwarder_sets_[McastTreeManager::LevelNative];
+        for (McastSGEntry::ForwarderSet::iterator it = forwarders->begin();
+             it != forwarders->end(); ++it) {
+            if ((*it)->route()->BestPath()->GetPeer() == peers_[peer_idx])
+                return *it;
+        }
+        return NULL;
+    }
+
+    // Get the number of BgpOListElems advertised for the forest node.
+    size_t GetForestNodeOListSize(McastTreeManager *tm, string group_str) {
+        ConcurrencyScope scope("db::DBTable");
+
+        McastSGEntry *sg_entry = FindSGEntry(tm, group_str);
+        if (!sg_entry || !sg_entry->forest_node_)
+            return 0;
+        scoped_ptr<UpdateInfo> uinfo(
+            sg_entry->forest_node_->GetUpdateInfo(tm->table_));
+        if (!uinfo)
+            return 0;
+        return uinfo->roattr.attr()->olist()->elements().size();
+    }
+
+    // DB listener that counts notifications for the forwarder's route and
+    // records whether the forwarder had an olist at the last one.
+    void ForwarderNotify(DBTablePartBase *tpart, DBEntryBase *entry,
+            McastForwarder *forwarder, int *count, bool *has_olist) {
+        if (entry != forwarder->route())
+            return;
+        (*count)++;
+        scoped_ptr<UpdateInfo> uinfo(forwarder->GetUpdateInfo(red_table_));
+        *has_olist = (uinfo.get() != NULL);
+    }
+
     size_t VerifyTreeUpdateCount(McastTreeManager *tm) {
         size_t total = 0;
         for (int idx = 0; idx < ErmVpnTable::kPartitionCount; idx++) {
@@ -500,6 +621,188 @@ TEST_F(BgpMulticastTest, SingleGroupRepeatedDelAdd) {
     VerifyForwarderCount(red_tm_, "192.168.1.255", 0);
 }
 
+//
+// Join and leave of a single forwarder should not change the labels of any
+// of the other forwarders in the distribution tree.
+//
+TEST_F(BgpMulticastTest, SingleGroupIncrementalJoinLeave) {
+    ForwarderLabelMap labels;
+
+    for (int idx = 0; idx < kPeerCount - 1; idx++) {
+        peers_[idx]->AddRoute(red_table_, "192.168.1.255");
+    }
+    task_util::WaitForIdle();
+    VerifyRouteCount(red_table_, kPeerCount);
+    VerifySGCount(red_tm_, 1);
+    VerifyForwarderCount(red_tm_, "192.168.1.255", kPeerCount - 1);
+    GetForwarderLabels(red_tm_, "192.168.1.255", &labels);
+
+    peers_[kPeerCount - 1]->AddRoute(red_table_, "192.168.1.255");
+    task_util::WaitForIdle();
+    VerifyRouteCount(red_table_, kPeerCount + 1);
+    VerifyForwarderCount(red_tm_, "192.168.1.255", kPeerCount);
+    VerifyForwarderLabels(red_tm_, "192.168.1.255", labels, kPeerCount - 1);
+    GetForwarderLabels(red_tm_, "192.168.1.255", &labels);
+
+    peers_[kPeerCount / 2]->DelRoute(red_table_, "192.168.1.255");
+    task_util::WaitForIdle();
+    VerifyRouteCount(red_table_, kPeerCount);
+    VerifyForwarderCount(red_tm_, "192.168.1.255", kPeerCount - 1);
+    VerifyForwarderLabels(red_tm_, "192.168.1.255", labels, kPeerCount - 1);
+
+    for (int idx = 0; idx < kPeerCount; idx++) {
+        if (idx == kPeerCount / 2)
+            continue;
+        peers_[idx]->DelRoute(red_table_, "192.168.1.255");
+    }
+    task_util::WaitForIdle();
+    VerifyRouteCount(red_table_, 0);
+    VerifySGCount(red_tm_, 0);
+    VerifyForwarderCount(red_tm_, "192.168.1.255", 0);
+}
+
+//
+// The forest node should stay the same when other forwarders join and leave
+// as long as it's a leaf, and a new one should be picked when the forest node
+// itself leaves.
+//
+TEST_F(BgpMulticastTest, SingleGroupStableForestNode) {
+    for (int idx = 0; idx < kPeerCount - 2; idx++) {
+        peers_[idx]->AddRoute(red_table_, "192.168.1.255");
+    }
+    task_util::WaitForIdle();
+    VerifyRouteCount(red_table_, kPeerCount - 1);
+    int forest_idx = GetForestNodePeerIndex(red_tm_, "192.168.1.255");
+    ASSERT_GE(forest_idx, 0);
+
+    // Join of another forwarder.
+    peers_[kPeerCount - 2]->AddRoute(red_table_, "192.168.1.255");
+    peers_[kPeerCount - 1]->AddRoute(red_table_, "192.168.1.255");
+    task_util::WaitForIdle();
+    VerifyRouteCount(red_table_, kPeerCount + 1);
+    EXPECT_EQ(forest_idx, GetForestNodePeerIndex(red_tm_, "192.168.1.255"));
+
+    // Leave of a forwarder other than the forest node.
+    int leave_idx = (forest_idx == 0) ? 1 : 0;
+    peers_[leave_idx]->DelRoute(red_table_, "192.168.1.255");
+    task_util::WaitForIdle();
+    VerifyRouteCount(red_table_, kPeerCount);
+    EXPECT_EQ(forest_idx, GetForestNodePeerIndex(red_tm_, "192.168.1.255"));
+
+    // Leave of the forest node.
+    peers_[forest_idx]->DelRoute(red_table_, "192.168.1.255");
+    task_util::WaitForIdle();
+    VerifyRouteCount(red_table_, kPeerCount - 1);
+    int new_forest_idx = GetForestNodePeerIndex(red_tm_, "192.168.1.255");
+    EXPECT_GE(new_forest_idx, 0);
+    EXPECT_NE(forest_idx, new_forest_idx);
+    EXPECT_NE(leave_idx, new_forest_idx);
+
+    for (int idx = 0; idx < kPeerCount; idx++) {
+        if (idx == leave_idx || idx == forest_idx)
+            continue;
+        peers_[idx]->DelRoute(red_table_, "192.168.1.255");
+    }
+    task_util::WaitForIdle();
+    VerifyRouteCount(red_table_, 0);
+    VerifySGCount(red_tm_, 0);
+}
+
+//
+// The forest node should not get any children as forwarders join, since the
+// global edges advertised for it would make it's olist exceed kDegree.
+//
+TEST_F(BgpMulticastTest, SingleGroupForestNodeDegree) {
+    for (int idx = 0; idx < kPeerCount; idx++) {
+        peers_[idx]->AddRoute(red_table_, "192.168.1.255");
+        task_util::WaitForIdle();
+        VerifyRouteCount(red_table_, idx + 2);
+
+        ConcurrencyScope scope("db::DBTable");
+        McastSGEntry *sg_entry = FindSGEntry(red_tm_, "192.168.1.255");
+        ASSERT_TRUE(sg_entry != NULL);
+        ASSERT_TRUE(sg_entry->forest_node_ != NULL);
+        size_t links = sg_entry->forest_node_->tree_links_.size();
+        EXPECT_LE(links + McastTreeManager::kDegree - 1,
+                  static_cast<size_t>(McastTreeManager::kDegree));
+        EXPECT_LE(GetForestNodeOListSize(red_tm_, "192.168.1.255"),
+                  static_cast<size_t>(McastTreeManager::kDegree));
+    }
+
+    DelRouteAllPeers(red_table_, "192.168.1.255");
+    task_util::WaitForIdle();
+    VerifyRouteCount(red_table_, 0);
+    VerifySGCount(red_tm_, 0);
+}
+
+//
+// A forwarder that can't get a label after a change of label block leaves
+// the tree. It's route should be notified again so that the agent gets an
+// empty olist.
+//
+TEST_F(BgpMulticastTest, SingleGroupLabelExhausted) {
+    const int kPeers = 5;
+    for (int idx = 0; idx < kPeers; idx++) {
+        peers_[idx]->AddRoute(red_table_, "192.168.1.255");
+    }
+    task_util::WaitForIdle();
+    VerifyRouteCount(red_table_, kPeers + 1);
+    VerifyForwarderCount(red_tm_, "192.168.1.255", kPeers);
+
+    // Pick a forwarder that isn't the forest node, so that the forest node
+    // change doesn't notify it's route.
+    int peer_idx = GetForestNodePeerIndex(red_tm_, "192.168.1.255") == 0 ?
+        1 : 0;
+    McastForwarder *forwarder = FindForwarder(red_tm_, "192.168.1.255",
+        peer_idx);
+    ASSERT_TRUE(forwarder != NULL);
+    EXPECT_NE(0, forwarder->label());
+
+    // Switch to a label block that has no free labels.
+    LabelBlockPtr label_block(new LabelBlock(2000, 2000));
+    uint32_t label = label_block->AllocateLabel();
+    EXPECT_EQ(2000, label);
+    int count = 0;
+    bool has_olist = true;
+    DBTableBase::ListenerId id = red_table_->Register(
+        boost::bind(&BgpMulticastTest::ForwarderNotify, this, _1, _2,
+            forwarder, &count, &has_olist));
+    peers_[peer_idx]->set_label_block(label_block);
+    peers_[peer_idx]->AddRoute(red_table_, "192.168.1.255");
+    task_util::WaitForIdle();
+    red_table_->Unregister(id);
+
+    // Once for the change of the route and once for the new olist.
+    EXPECT_EQ(2, count);
+    EXPECT_FALSE(has_olist);
+    EXPECT_EQ(0, forwarder->label());
+    EXPECT_GT(0, forwarder->tree_index());
+
+    // None of the other forwarders link to it.
+    {
+        ConcurrencyScope scope("db::DBTable");
+        McastSGEntry *sg_entry = FindSGEntry(red_tm_, "192.168.1.255");
+        ASSERT_TRUE(sg_entry != NULL);
+        const McastForwarderList &tree =
+            sg_entry->tree_nodes_[McastTreeManager::LevelNative];
+        EXPECT_EQ(static_cast<size_t>(kPeers - 1), tree.size());
+        for (McastForwarderList::const_iterator it = tree.begin();
+             it != tree.end(); ++it) {
+            EXPECT_TRUE(std::find((*it)->tree_links_.begin(),
+                (*it)->tree_links_.end(), forwarder) ==
+                (*it)->tree_links_.end());
+        }
+    }
+
+    for (int idx = 0; idx < kPeers; idx++) {
+        peers_[idx]->DelRoute(red_table_, "192.168.1.255");
+    }
+    task_util::WaitForIdle();
+    VerifyRouteCount(red_table_, 0);
+    VerifySGCount(red_tm_, 0);
+    label_block->ReleaseLabel(label);
+}
+
 TEST_F(BgpMulticastTest, MultipleGroup) {
     AddRouteAllPeers(red_table_, "192.168.1.253");
     AddRouteAllPeers(red_table_, "192.168.1.254");
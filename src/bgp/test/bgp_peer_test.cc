@@ -2,13 +2,18 @@
  * Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
  */
 
+#include <string.h>
+
 #include <boost/scoped_ptr.hpp>
 
+#include <vector>
+
 #include "base/task_annotations.h"
 #include "base/test/task_test_util.h"
 #include "bgp/bgp_config.h"
 #include "bgp/bgp_log.h"
 #include "bgp/bgp_peer.h"
+#include "bgp/bgp_server.h"
 #include "bgp/bgp_session.h"
 #include "control-node/control_node.h"
 
@@ -24,13 +29,24 @@ public:
 
     virtual bool Send(const u_int8_t *data, size_t size, size_t *sent) {
         message_count_++;
+        data_.assign(data, data + size);
+        return true;
+    }
+
+    virtual bool Send(const SharedBufferList &buffers, size_t *sent) {
+        message_count_++;
+        buffers_ = buffers;
         return true;
     }
 
     uint64_t message_count() const { return message_count_; }
+    const std::vector<uint8_t> &data() const { return data_; }
+    const SharedBufferList &buffers() const { return buffers_; }
 
 private:
     uint64_t message_count_;
+    std::vector<uint8_t> data_;
+    SharedBufferList buffers_;
 };
 
 class BgpPeerMock : public BgpPeer {
@@ -90,6 +106,58 @@ protected:
         task_util::WaitForIdle();
     }
 
+    // Send an OPEN and return true if it has the Extended Message capability.
+    bool SendOpenExtendedMessage() {
+        peer_->SendOpen(session_.get());
+        const std::vector<uint8_t> &data = session_->data();
+        boost::scoped_ptr<const BgpProto::OpenMessage> msg(
+            static_cast<const BgpProto::OpenMessage *>(
+                BgpProto::Decode(&data[0], data.size())));
+        EXPECT_TRUE(msg.get() != NULL);
+        for (size_t idx = 0; msg.get() && idx < msg->opt_params.size();
+             ++idx) {
+            const BgpProto::OpenMessage::OptParam *param =
+                msg->opt_params[idx];
+            for (size_t cap_idx = 0; cap_idx < param->capabilities.size();
+                 ++cap_idx) {
+                if (param->capabilities[cap_idx]->code ==
+                    BgpProto::OpenMessage::Capability::ExtendedMessage) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Process an OPEN from the peer with or without Extended Message.
+    void ReceiveOpen(bool extended_message) {
+        BgpProto::OpenMessage open;
+        BgpProto::OpenMessage::OptParam *param =
+            new BgpProto::OpenMessage::OptParam;
+        uint8_t cap_mp[] = { 0, 1, 0, 1 };
+        param->capabilities.push_back(new BgpProto::OpenMessage::Capability(
+            BgpProto::OpenMessage::Capability::MpExtension, cap_mp, 4));
+        if (extended_message) {
+            param->capabilities.push_back(
+                new BgpProto::OpenMessage::Capability(
+                    BgpProto::OpenMessage::Capability::ExtendedMessage,
+                    NULL, 0));
+        }
+        open.opt_params.push_back(param);
+        peer_->SetCapabilities(&open);
+    }
+
+    // Check if a message of the given type and size would be accepted.
+    bool MsgLengthAllowed(BgpProto::MessageType type, size_t size) {
+        std::vector<uint8_t> msg(size, 0xff);
+        msg[18] = type;
+        return peer_->MsgLengthAllowed(&msg[0], size);
+    }
+
+    uint32_t RibOutMaxMessageSize() {
+        return peer_->BuildRibExportPolicy(Address::INET).max_message_size;
+    }
+
     BgpNeighborConfig config_;
     BgpServer server_;
     EventManager evm_;
@@ -281,6 +349,174 @@ TEST_F(BgpPeerTest, MessageBuffer8) {
     TASK_UTIL_EXPECT_EQ(0, session_->message_count());
 }
 
+//
+// SendUpdate causes call to FlushUpdate when the maximum number of update
+// buffers is reached, even though the buffer size is not exceeded.
+//
+TEST_F(BgpPeerTest, MessageBuffer9) {
+    static const size_t msgsize = 32;
+    uint8_t msg[msgsize];
+
+    for (size_t idx = 0; idx < BgpPeer::kMaxUpdateBuffers; ++idx) {
+        peer_->SendUpdate(msg, msgsize);
+    }
+    TASK_UTIL_EXPECT_EQ(BgpPeer::kMaxUpdateBuffers * msgsize,
+        peer_->buffer_len());
+    TASK_UTIL_EXPECT_EQ(0, session_->message_count());
+
+    peer_->SendUpdate(msg, msgsize);
+    TASK_UTIL_EXPECT_EQ(msgsize, peer_->buffer_len());
+    TASK_UTIL_EXPECT_EQ(1, session_->message_count());
+    TASK_UTIL_EXPECT_EQ(BgpPeer::kMaxUpdateBuffers, session_->buffers().size());
+
+    peer_->FlushUpdate();
+    TASK_UTIL_EXPECT_EQ(0, peer_->buffer_len());
+    TASK_UTIL_EXPECT_EQ(2, session_->message_count());
+    TASK_UTIL_EXPECT_EQ(1, session_->buffers().size());
+}
+
+//
+// SendSharedUpdate sends the message without copying it.
+// Message larger than the buffer size is sent as is.
+//
+TEST_F(BgpPeerTest, MessageBuffer10) {
+    static const size_t msgsize = BgpPeer::kBufferSize + 128;
+    boost::shared_array<uint8_t> msg1(new uint8_t[msgsize]);
+    boost::shared_array<uint8_t> msg2(new uint8_t[msgsize]);
+
+    peer_->SendSharedUpdate(msg1, msgsize);
+    TASK_UTIL_EXPECT_EQ(msgsize, peer_->buffer_len());
+    TASK_UTIL_EXPECT_EQ(1, peer_->get_tx_update());
+    TASK_UTIL_EXPECT_EQ(0, session_->message_count());
+
+    peer_->SendSharedUpdate(msg2, msgsize);
+    TASK_UTIL_EXPECT_EQ(msgsize, peer_->buffer_len());
+    TASK_UTIL_EXPECT_EQ(2, peer_->get_tx_update());
+    TASK_UTIL_EXPECT_EQ(1, session_->message_count());
+    TASK_UTIL_EXPECT_EQ(1, session_->buffers().size());
+    TASK_UTIL_EXPECT_TRUE(session_->buffers()[0].data() == msg1.get());
+
+    peer_->FlushUpdate();
+    TASK_UTIL_EXPECT_EQ(0, peer_->buffer_len());
+    TASK_UTIL_EXPECT_EQ(2, session_->message_count());
+    TASK_UTIL_EXPECT_EQ(1, session_->buffers().size());
+    TASK_UTIL_EXPECT_TRUE(session_->buffers()[0].data() == msg2.get());
+}
+
+//
+// Extended Message capability is not advertised unless enabled, and is not
+// negotiated if either side doesn't advertise it.
+//
+TEST_F(BgpPeerTest, ExtendedMessageNegotiation1) {
+    EXPECT_FALSE(SendOpenExtendedMessage());
+
+    ReceiveOpen(true);
+    EXPECT_FALSE(peer_->IsExtendedMessageNegotiated());
+    EXPECT_EQ(4096U, peer_->GetMaxMessageSize());
+    EXPECT_EQ(4096U, RibOutMaxMessageSize());
+    peer_->ResetCapabilities();
+
+    server_.set_extended_message_enable(true);
+    EXPECT_TRUE(SendOpenExtendedMessage());
+
+    ReceiveOpen(false);
+    EXPECT_FALSE(peer_->IsExtendedMessageNegotiated());
+    EXPECT_EQ(4096U, peer_->GetMaxMessageSize());
+    EXPECT_EQ(4096U, RibOutMaxMessageSize());
+    peer_->ResetCapabilities();
+}
+
+//
+// Extended Message capability is negotiated if both sides advertise it, and
+// is cleared when the capabilities are reset.
+//
+TEST_F(BgpPeerTest, ExtendedMessageNegotiation2) {
+    server_.set_extended_message_enable(true);
+    EXPECT_TRUE(SendOpenExtendedMessage());
+
+    ReceiveOpen(true);
+    EXPECT_TRUE(peer_->IsExtendedMessageNegotiated());
+    EXPECT_EQ(65535U, peer_->GetMaxMessageSize());
+    EXPECT_EQ(65535U, RibOutMaxMessageSize());
+
+    peer_->ResetCapabilities();
+    EXPECT_FALSE(peer_->IsExtendedMessageNegotiated());
+    EXPECT_EQ(4096U, peer_->GetMaxMessageSize());
+    EXPECT_EQ(4096U, RibOutMaxMessageSize());
+}
+
+//
+// Messages larger than 4096 bytes are not accepted if Extended Message has
+// not been negotiated.
+//
+TEST_F(BgpPeerTest, MsgLengthAllowed1) {
+    EXPECT_TRUE(MsgLengthAllowed(BgpProto::UPDATE, 4096));
+    EXPECT_TRUE(MsgLengthAllowed(BgpProto::OPEN, 4096));
+    EXPECT_TRUE(MsgLengthAllowed(BgpProto::KEEPALIVE, 4096));
+    EXPECT_FALSE(MsgLengthAllowed(BgpProto::UPDATE, 4097));
+    EXPECT_FALSE(MsgLengthAllowed(BgpProto::NOTIFICATION, 4097));
+    EXPECT_FALSE(MsgLengthAllowed(BgpProto::UPDATE, 65535));
+
+    server_.set_extended_message_enable(true);
+    ReceiveOpen(false);
+    EXPECT_TRUE(MsgLengthAllowed(BgpProto::UPDATE, 4096));
+    EXPECT_FALSE(MsgLengthAllowed(BgpProto::UPDATE, 4097));
+    peer_->ResetCapabilities();
+}
+
+//
+// Messages up to 65535 bytes are accepted if Extended Message has been
+// negotiated, except for OPEN and KEEPALIVE which are still limited to 4096
+// bytes.
+//
+TEST_F(BgpPeerTest, MsgLengthAllowed2) {
+    server_.set_extended_message_enable(true);
+    ReceiveOpen(true);
+    EXPECT_TRUE(MsgLengthAllowed(BgpProto::UPDATE, 4096));
+    EXPECT_TRUE(MsgLengthAllowed(BgpProto::UPDATE, 4097));
+    EXPECT_TRUE(MsgLengthAllowed(BgpProto::UPDATE, 65535));
+    EXPECT_TRUE(MsgLengthAllowed(BgpProto::NOTIFICATION, 65535));
+    EXPECT_FALSE(MsgLengthAllowed(BgpProto::UPDATE, 65536));
+    EXPECT_TRUE(MsgLengthAllowed(BgpProto::OPEN, 4096));
+    EXPECT_FALSE(MsgLengthAllowed(BgpProto::OPEN, 4097));
+    EXPECT_TRUE(MsgLengthAllowed(BgpProto::KEEPALIVE, 4096));
+    EXPECT_FALSE(MsgLengthAllowed(BgpProto::KEEPALIVE, 4097));
+    peer_->ResetCapabilities();
+}
+
+//
+// SendUpdate copies consecutive messages into the same buffer.
+//
+TEST_F(BgpPeerTest, MessageBuffer11) {
+    static const size_t msgsize = 128;
+    uint8_t msg1[msgsize], msg2[msgsize];
+    memset(msg1, 1, msgsize);
+    memset(msg2, 2, msgsize);
+
+    peer_->SendUpdate(msg1, msgsize);
+    peer_->SendUpdate(msg2, msgsize);
+    TASK_UTIL_EXPECT_EQ(2 * msgsize, peer_->buffer_len());
+    TASK_UTIL_EXPECT_EQ(0, session_->message_count());
+
+    peer_->FlushUpdate();
+    TASK_UTIL_EXPECT_EQ(1, session_->message_count());
+    TASK_UTIL_EXPECT_EQ(2, session_->buffers().size());
+    const uint8_t *data1 = session_->buffers()[0].data();
+    const uint8_t *data2 = session_->buffers()[1].data();
+    EXPECT_TRUE(data2 == data1 + msgsize);
+    EXPECT_EQ(0, memcmp(data1, msg1, msgsize));
+    EXPECT_EQ(0, memcmp(data2, msg2, msgsize));
+
+    // The buffer is still used after the flush, without changing the data
+    // that was flushed.
+    peer_->SendUpdate(msg1, msgsize);
+    peer_->FlushUpdate();
+    TASK_UTIL_EXPECT_EQ(2, session_->message_count());
+    TASK_UTIL_EXPECT_EQ(1, session_->buffers().size());
+    EXPECT_TRUE(session_->buffers()[0].data() == data2 + msgsize);
+    EXPECT_EQ(0, memcmp(data2, msg2, msgsize));
+}
+
 typedef std::tr1::tuple<uint64_t, uint64_t, bool> TestParams;
 
 class BgpPeerParamTest :
@@ -6,6 +6,7 @@
 #include "base/test/task_test_util.h"
 #include "control-node/control_node.h"
 #include <boost/assign/list_of.hpp>
+#include <boost/scoped_array.hpp>
 #include "net/bgp_af.h"
 #include "bgp/bgp_log.h"
 #include "bgp_message_test.h"
@@ -1005,6 +1006,52 @@ TEST_F(BgpProtoTest, UpdateScale) {
     }
 }
 
+//
+// Update with enough routes to exceed the standard maximum message size can
+// be encoded and decoded when using the extended maximum message size.
+//
+TEST_F(BgpProtoTest, UpdateExtendedMessage) {
+    BgpProto::Update update;
+    static const int kMaxRoutes = 2000;
+
+    BgpAttrOrigin *origin = new BgpAttrOrigin(BgpAttrOrigin::INCOMPLETE);
+    update.path_attributes.push_back(origin);
+
+    BgpMpNlri *mp_nlri = new BgpMpNlri(BgpAttribute::MPReachNlri);
+    mp_nlri->flags = BgpAttribute::Optional;
+    mp_nlri->afi = 1;
+    mp_nlri->safi = 128;
+    uint8_t nh[4] = {192,168,1,1};
+    mp_nlri->nexthop.resize(12);
+    copy(&nh[0], &nh[4], mp_nlri->nexthop.begin() + 8);
+    for (int i = 0; i < kMaxRoutes; i++) {
+        BgpProtoPrefix *prefix = new BgpProtoPrefix;
+        prefix->prefixlen = 12 * 8;
+        for (int j = 0; j < 12; j++)
+            prefix->prefix.push_back(rand() % 256);
+        mp_nlri->nlri.push_back(prefix);
+    }
+    update.path_attributes.push_back(mp_nlri);
+
+    uint8_t small_data[BgpProto::kMaxMessageSize];
+    int res = BgpProto::Encode(&update, small_data, sizeof(small_data));
+    EXPECT_EQ(-1, res);
+
+    boost::scoped_array<uint8_t> data(
+        new uint8_t[BgpProto::kMaxExtendedMessageSize]);
+    res = BgpProto::Encode(&update, data.get(),
+        BgpProto::kMaxExtendedMessageSize);
+    EXPECT_GT(res, 4096);
+    EXPECT_LE(res, 65535);
+
+    ParseErrorContext err;
+    boost::scoped_ptr<const BgpProto::Update> result(
+        static_cast<const BgpProto::Update *>(
+            BgpProto::Decode(data.get(), res, &err)));
+    ASSERT_TRUE(result.get() != NULL);
+    EXPECT_EQ(0, result->CompareTo(update));
+}
+
 TEST_F(BgpProtoTest, KeepaliveError) {
     uint8_t data[] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
                        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
@@ -4,6 +4,8 @@
 
 #include "bgp/test/bgp_ribout_updates_test.h"
 
+#include "base/slab_allocator.h"
+#include "base/time_util.h"
 
 using namespace std;
 
@@ -2417,6 +2419,78 @@ TEST_F(RibOutUpdatesTest, PeerDequeueSplitMerge1) {
     }
 }
 
+//
+// Return the number of bytes currently in use in the slab allocator for
+// RouteUpdates, UpdateInfos, UpdateMarkers and UpdateLists.
+//
+static uint64_t GetRibOutUpdateMemory() {
+    SlabAllocator::AllocatorList allocator_list;
+    SlabAllocator::GetAllocatorList(&allocator_list);
+    uint64_t memory = 0;
+    for (SlabAllocator::AllocatorList::const_iterator it =
+         allocator_list.begin(); it != allocator_list.end(); ++it) {
+        const SlabAllocator *allocator = *it;
+        if (allocator->name() != "RibOutUpdate")
+            continue;
+        SlabAllocator::StatsList stats_list;
+        allocator->GetStats(&stats_list);
+        for (SlabAllocator::StatsList::const_iterator iter =
+             stats_list.begin(); iter != stats_list.end(); ++iter) {
+            memory += (iter->allocs - iter->frees) * iter->object_size;
+        }
+    }
+    return memory;
+}
+
+// Benchmark for enqueue and dequeue of a large number of pending updates.
+// Routes:   Routes x=[0,16384-1] enqueued to all peers with attr A.
+// Blocking: None.
+// Result:   Routes get sent to all peers. Enqueue and dequeue rates and the
+//           memory used per pending update are reported.
+TEST_F(RibOutUpdatesTest, ScaleEnqueueDequeue) {
+    static const int kScaleRouteCount = 16384;
+
+    // Build UpdateInfo for attr A with all peers.
+    UpdateInfoSList uinfo_slist;
+    PrependUpdateInfo(uinfo_slist, attrA_, 0, kPeerCount-1);
+
+    // Create additional routes so that the total is 16K.
+    for (int idx = kRouteCount; idx < kScaleRouteCount; idx++) {
+        CreateRoute(idx);
+    }
+
+    // Build updates for all the routes.
+    uint64_t base_memory = GetRibOutUpdateMemory();
+    uint64_t start_time = UTCTimestampUsec();
+    for (int idx = 0; idx < kScaleRouteCount; idx++) {
+        UpdateInfoSList temp_uinfo_slist;
+        CloneUpdateInfo(uinfo_slist, temp_uinfo_slist);
+        BuildRouteUpdate(routes_[idx], temp_uinfo_slist);
+    }
+    uint64_t enqueue_time = UTCTimestampUsec() - start_time;
+    uint64_t pending_memory = GetRibOutUpdateMemory() - base_memory;
+    EXPECT_GT(pending_memory, 0U);
+
+    // Dequeue the updates.
+    start_time = UTCTimestampUsec();
+    UpdateRibOut();
+    uint64_t dequeue_time = UTCTimestampUsec() - start_time;
+
+    // Verify blocked state and DB State for the routes.
+    VerifyPeerBlock(0, kPeerCount-1, false);
+    VerifyPeerInSync(0, kPeerCount-1, true);
+    for (int idx = 0; idx < kScaleRouteCount; idx++) {
+        RouteState *rstate = ExpectRouteState(routes_[idx]);
+        VerifyHistory(rstate, attrA_, 0, kPeerCount-1);
+    }
+
+    cout << "Updates: " << kScaleRouteCount
+         << " enqueue: " << enqueue_time / 1000 << " msec"
+         << " dequeue: " << dequeue_time / 1000 << " msec"
+         << " memory per update: " << pending_memory / kScaleRouteCount
+         << " bytes" << endl;
+}
+
 static void SetUp() {
     bgp_log_test::init();
     ControlNode::SetDefaultSchedulingPolicy();
@@ -69,15 +69,17 @@ private:
 class SGTest : public ::testing::Test {
 protected:
 
-    SGTest()
+    explicit SGTest(size_t shard_count = 1)
         : server_(&evm_),
-        table_(&db_, "inet.0") {
+        table_(&db_, "inet.0"),
+        shard_count_(shard_count) {
         table_.Init();
     }
 
     virtual void SetUp() {
         SchedulerStop();
 
+        mgr_.set_send_shard_count(shard_count_);
         gbl_ribout_index = 0;
         CreateRibOut();
 
@@ -241,6 +243,10 @@ protected:
         VerifyOddEvenPeerInSync(idx, idx, true, true, in_sync);
     }
 
+    void VerifyPeerInSync(int start_idx, int end_idx, bool in_sync) {
+        VerifyOddEvenPeerInSync(start_idx, end_idx, true, true, in_sync);
+    }
+
     void VerifyEvenPeerInSync(int start_idx, int end_idx, bool in_sync) {
         VerifyOddEvenPeerInSync(start_idx, end_idx, true, false, in_sync);
     }
@@ -260,6 +266,7 @@ protected:
     BgpServer server_;
     DB db_;
     InetTable table_;
+    size_t shard_count_;
     SchedulingGroupManager mgr_;
     SchedulingGroup *sg_;
     std::vector<BgpTestPeer *> peers_;
@@ -1919,6 +1926,79 @@ TEST_F(SGMultiRibOutTest, PeerDequeueBlocks1b) {
     }
 }
 
+//
+// Same as SGTest, except that the SchedulingGroup has 2 SendShards.  Peers
+// are assigned to shards based on their index, so the even peers are in one
+// shard and the odd peers in the other.
+//
+class SGShardTest : public SGTest {
+protected:
+    SGShardTest() : SGTest(2) {
+    }
+};
+
+TEST_F(SGShardTest, Noop) {
+    EXPECT_EQ(2U, sg_->shard_count());
+}
+
+//
+// PeerDequeue is called when peers get unblocked.  The peers in each shard
+// are dequeued by the Worker for that shard, so PeerDequeue only merges the
+// peers in the same shard.
+// The tail dequeue triggered by the first peer to get in sync can run in
+// parallel with the peer dequeues for the other shard, so the peers that
+// are not yet in sync at that point may need another PeerDequeue.
+// All blocked peers are unblocked in this test.
+//
+TEST_F(SGShardTest, PeerDequeueBasic) {
+    RibPeerSet peerset, even_peerset, odd_peerset;
+    BuildPeerSet(peerset, 0, 0, kPeerCount-1);
+    BuildEvenPeerSet(even_peerset, 0, 0, kPeerCount-1);
+    BuildOddPeerSet(odd_peerset, 0, 0, kPeerCount-1);
+
+    // Expect call to TailDequeue and get all peers into blocked state.
+    EXPECT_CALL(*updates_[0],
+        TailDequeue(RibOutUpdates::QUPDATE, peerset,
+                    Property(&RibPeerSet::empty, true)))
+        .Times(1)
+        .WillOnce(DoAll(SetArgPointee<2>(peerset), Return(false)));
+
+    RibOutActive(ribouts_[0], RibOutUpdates::QUPDATE);
+
+    // Verify that all peers are blocked.
+    task_util::WaitForIdle();
+    VerifyPeerBlock(0, kPeerCount-1, true);
+    VerifyPeerInSync(0, kPeerCount-1, false);
+
+    // Expect PeerDequeue to be called for each peer with the peers in its
+    // shard. Return true to get the peers in sync.
+    for (int idx = 0; idx < kPeerCount; idx++) {
+        EXPECT_CALL(*updates_[0],
+            PeerDequeue(RibOutUpdates::QUPDATE, peers_[idx],
+                        idx % 2 == 0 ? even_peerset : odd_peerset,
+                        Property(&RibPeerSet::empty, true)))
+            .Times(AtLeast(1))
+            .WillRepeatedly(Return(true));
+    }
+
+    // Expect TailDequeue as a consequence of the peers getting in sync.
+    EXPECT_CALL(*updates_[0],
+        TailDequeue(RibOutUpdates::QUPDATE, _,
+                    Property(&RibPeerSet::empty, true)))
+        .Times(AtLeast(1))
+        .WillRepeatedly(Return(true));
+
+    // Unblock all peers.
+    SchedulerStop();
+    SetPeerUnblockNow(0, kPeerCount-1);
+    SchedulerStart();
+
+    // Verify that all peers are unblocked and in sync.
+    task_util::WaitForIdle();
+    VerifyPeerBlock(0, kPeerCount-1, false);
+    VerifyPeerInSync(0, kPeerCount-1, true);
+}
+
 int main(int argc, char **argv) {
     bgp_log_test::init();
     ControlNode::SetDefaultSchedulingPolicy();
@@ -11,9 +11,11 @@
 #include <map>
 #include <string>
 #include <signal.h>
+#include <sys/resource.h>
 
 #include "base/task_annotations.h"
 #include "base/test/addr_test_util.h"
+#include "base/time_util.h"
 
 #include "bgp/bgp_config_parser.h"
 #include "bgp/bgp_factory.h"
@@ -177,6 +179,7 @@ static bool d_no_verify_routes_ = false;
 static bool d_no_agent_updates_processing_ = false;
 static bool d_no_agent_messages_processing_ = false;
 static float d_events_proportion_ = 0.0;
+static string d_benchmark_output_ = "";
 
 static vector<int>  n_instances = boost::assign::list_of(d_instances_);
 static vector<int>  n_routes    = boost::assign::list_of(d_routes_);
@@ -1806,6 +1809,160 @@ void BgpStressTest::VerifyXmppRouteNextHops() {
     }
 }
 
+//
+// Tasks for which the run time is reported for each benchmark stage.
+//
+static const char *benchmark_tasks[] = {
+    "bgp::Config",
+    "bgp::PeerMembership",
+    "bgp::RTFilter",
+    "bgp::SendReadyTask",
+    "bgp::SendTask",
+    "bgp::ServiceChain",
+    "bgp::StateMachine",
+    "db::DBTable",
+    "io::ReaderTask",
+    "xmpp::StateMachine",
+};
+
+static uint64_t GetProcessCpuTime() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000ULL +
+        usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static void GetBenchmarkSnapshot(BgpStressTestStage *snapshot) {
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    snapshot->wall_time = UTCTimestampUsec();
+    snapshot->cpu_time = GetProcessCpuTime();
+    for (size_t idx = 0;
+         idx < sizeof(benchmark_tasks) / sizeof(benchmark_tasks[0]); ++idx) {
+        int task_id = scheduler->GetTaskId(benchmark_tasks[idx]);
+        snapshot->task_run_time[benchmark_tasks[idx]] =
+            scheduler->GetTaskGroupRunTime(task_id);
+    }
+}
+
+//
+// Start measuring stages of the initial setup if benchmark mode is enabled.
+//
+void BgpStressTest::BenchmarkStart() {
+    if (d_benchmark_output_.empty())
+        return;
+
+    stages_.clear();
+    TaskScheduler::GetInstance()->SetTrackRunTime(true);
+    GetBenchmarkSnapshot(&stage_start_);
+}
+
+//
+// Record the stage that just completed and start the next one.
+//
+void BgpStressTest::BenchmarkStage(const string &name) {
+    if (d_benchmark_output_.empty())
+        return;
+
+    BgpStressTestStage snapshot;
+    GetBenchmarkSnapshot(&snapshot);
+
+    BgpStressTestStage stage;
+    stage.name = name;
+    stage.wall_time = snapshot.wall_time - stage_start_.wall_time;
+    stage.cpu_time = snapshot.cpu_time - stage_start_.cpu_time;
+    for (map<string, uint64_t>::const_iterator it =
+         snapshot.task_run_time.begin();
+         it != snapshot.task_run_time.end(); ++it) {
+        stage.task_run_time[it->first] =
+            it->second - stage_start_.task_run_time[it->first];
+    }
+    stages_.push_back(stage);
+    stage_start_ = snapshot;
+}
+
+//
+// Write the benchmark results as JSON so that they can be tracked across
+// releases.
+//
+// Routes/sec is based on the time from the start of route injection till the
+// controller has all the routes. The time to converge goes on till all the
+// agents have received all the routes.
+//
+void BgpStressTest::BenchmarkReport(const string &filename) {
+    int xmpp_routes_per_prefix = 2;
+    if (!d_no_mcast_routes_)
+        xmpp_routes_per_prefix++;
+    if (!d_no_inet6_routes_)
+        xmpp_routes_per_prefix++;
+    int bgp_families = 0;
+    for (int i = 0; i < n_families_; ++i) {
+        if (families_[i] == Address::INET6VPN && d_no_inet6_routes_)
+            continue;
+        bgp_families++;
+    }
+    uint64_t routes = static_cast<uint64_t>(n_routes_) *
+        (n_instances_ * n_agents_ * xmpp_routes_per_prefix +
+         n_peers_ * bgp_families);
+
+    uint64_t ingest_time = 0;
+    uint64_t converge_time = 0;
+    bool converged = false;
+    bool injecting = false;
+    BOOST_FOREACH(const BgpStressTestStage &stage, stages_) {
+        if (stage.name == "bgp_routes")
+            injecting = true;
+        if (!injecting || converged)
+            continue;
+        converge_time += stage.wall_time;
+        if (stage.name != "agent_converge")
+            ingest_time += stage.wall_time;
+        if (stage.name == "agent_converge")
+            converged = true;
+    }
+
+    ostringstream out;
+    out << "{" << endl;
+    out << "  \"instances\": " << n_instances_ << "," << endl;
+    out << "  \"peers\": " << n_peers_ << "," << endl;
+    out << "  \"agents\": " << n_agents_ << "," << endl;
+    out << "  \"routes\": " << n_routes_ << "," << endl;
+    out << "  \"targets\": " << n_targets_ << "," << endl;
+    out << "  \"routes_injected\": " << routes << "," << endl;
+    out << "  \"routes_per_sec\": " <<
+        (ingest_time ? routes * 1000000 / ingest_time : 0) << "," << endl;
+    out << "  \"converged\": " << (converged ? "true" : "false") << ","
+        << endl;
+    out << "  \"converge_time_usecs\": " << converge_time << "," << endl;
+    out << "  \"stages\": [" << endl;
+    for (size_t idx = 0; idx < stages_.size(); ++idx) {
+        const BgpStressTestStage &stage = stages_[idx];
+        out << "    {" << endl;
+        out << "      \"name\": \"" << stage.name << "\"," << endl;
+        out << "      \"wall_time_usecs\": " << stage.wall_time << ","
+            << endl;
+        out << "      \"cpu_time_usecs\": " << stage.cpu_time << "," << endl;
+        out << "      \"task_run_time_usecs\": {";
+        for (map<string, uint64_t>::const_iterator it =
+             stage.task_run_time.begin();
+             it != stage.task_run_time.end(); ++it) {
+            out << (it == stage.task_run_time.begin() ? "" : ",") << endl;
+            out << "        \"" << it->first << "\": " << it->second;
+        }
+        out << endl << "      }" << endl;
+        out << "    }" << (idx + 1 < stages_.size() ? "," : "") << endl;
+    }
+    out << "  ]" << endl;
+    out << "}" << endl;
+
+    BGP_STRESS_TEST_LOG("Benchmark results: " << out.str());
+    if (filename == "-") {
+        cout << out.str();
+    } else {
+        ofstream file(filename.c_str());
+        file << out.str();
+    }
+}
+
 string BgpStressTest::GetAgentConfigName(int agent_id) {
     ostringstream config;
 
@@ -2301,6 +2458,7 @@ void BgpStressTest::AddAllRoutes(int ninstances, int npeers, int nagents,
     BGP_STRESS_TEST_LOG("Start subscribing all XMPP Agents");
     SubscribeAgents(ninstances, nagents);
     BGP_STRESS_TEST_LOG("End subscribing all XMPP Agents");
+    BenchmarkStage("subscribe");
 
     if (d_vms_count_) {
         BGP_STRESS_TEST_LOG("Start subscribing all agents' "
@@ -2308,11 +2466,13 @@ void BgpStressTest::AddAllRoutes(int ninstances, int npeers, int nagents,
         SubscribeAgentsConfiguration(nagents, true);
         BGP_STRESS_TEST_LOG("End subscribing all agents' "
                             "IFMAP configuration");
+        BenchmarkStage("subscribe_configuration");
     }
 
     BGP_STRESS_TEST_LOG("Start injecting BGP and/or XMPP routes");
     AddAllBgpRoutes(nroutes, ntargets);
     BGP_STRESS_TEST_LOG("End injecting BGP and/or XMPP routes");
+    BenchmarkStage("bgp_routes");
 
     if (!d_routes_send_trigger_.empty()) {
 
@@ -2325,12 +2485,14 @@ void BgpStressTest::AddAllRoutes(int ninstances, int npeers, int nagents,
 
         // Remove the trigger file.
         remove(d_routes_send_trigger_.c_str());
+        BenchmarkStage("routes_send_trigger");
     }
 
     BGP_STRESS_TEST_LOG("Start feeding all routes from all XMPP agents");
     usleep(10000);
     AddAllXmppRoutes(ninstances, nagents, nroutes);
     BGP_STRESS_TEST_LOG("End feeding all routes from all XMPP agents");
+    BenchmarkStage("xmpp_routes");
 
     if (d_no_verify_routes_) return;
 
@@ -2338,6 +2500,7 @@ void BgpStressTest::AddAllRoutes(int ninstances, int npeers, int nagents,
     BGP_STRESS_TEST_LOG("Start verifying XMPP Routes at the controller");
     VerifyControllerRoutes(ninstances, nagents, nroutes);
     BGP_STRESS_TEST_LOG("End verifying XMPP Routes at the controller");
+    BenchmarkStage("controller_converge");
 
     //
     // We get routes added by agents as well as those from bgp peers
@@ -2346,6 +2509,7 @@ void BgpStressTest::AddAllRoutes(int ninstances, int npeers, int nagents,
     VerifyAgentRoutes(nagents, ninstances, ninstances * nagents * nroutes +
                                            npeers * nroutes);
     BGP_STRESS_TEST_LOG("End verifying XMPP routes at the agents");
+    BenchmarkStage("agent_converge");
 
     BGP_STRESS_TEST_LOG("Start verifying XMPP routes nexthops at the agents");
     VerifyXmppRouteNextHops();
@@ -2536,18 +2700,28 @@ TEST_P(BgpStressTest, RandomEvents) {
     SCOPED_TRACE(__FUNCTION__);
     InitParams();
 
+    BenchmarkStart();
     AddRoutingInstances(n_instances_, n_targets_);
+    BenchmarkStage("routing_instances");
 
     boost::posix_time::ptime time_start(
                                  boost::posix_time::second_clock::local_time());
     AddBgpPeers(n_peers_);
+    BenchmarkStage("bgp_peers");
     BringUpXmppAgents(n_agents_);
+    BenchmarkStage("xmpp_agents");
     AddAllRoutes(n_instances_, n_peers_, n_agents_, n_routes_, n_targets_);
     boost::posix_time::ptime time_end(
                                  boost::posix_time::second_clock::local_time());
     BGP_STRESS_TEST_LOG("Time taken for initial setup: " <<
         boost::posix_time::time_duration(time_end - time_start));
 
+    // In benchmark mode, only the initial setup is measured.
+    if (!d_benchmark_output_.empty()) {
+        BenchmarkReport(d_benchmark_output_);
+        return;
+    }
+
     ShowAllRoutes();
     ShowNeighborStatistics();
     Pause("Pause after initial setup is complete");
@@ -2745,6 +2919,8 @@ static void process_command_line_args(int argc, const char **argv) {
     "Scaling\n"
     "=======\n"
     "Tweak nagents, npeers, nroutes, ninstances, ntargets as desired\n\n"
+    "Use --benchmark-output to get the time and cpu used by each stage of\n"
+    "the initial setup, routes/sec and the time to converge as JSON\n\n"
     "Use --no-agents-updates-processing option\n"
     "Tune following environment variables: e.g.\n"
     "TCP_SESSION_SOCKET_BUFFER_SIZE=65536 CONCURRENCY_CHECK_DISABLE=TRUE BGP_KEEPALIVE_SECONDS=30000 XMPP_KEEPALIVE_SECONDS=30000 CONTRAIL_UT_TEST_TIMEOUT=3000 WAIT_FOR_IDLE=320 TASK_UTIL_WAIT_TIME=10000 TASK_UTIL_RETRY_COUNT=250000 BGP_STRESS_TEST_SUITE=1 NO_HEAPCHECK=TRUE LOG_DISABLE=TRUE\n"
@@ -2752,6 +2928,9 @@ static void process_command_line_args(int argc, const char **argv) {
     );
     desc.add_options()
         ("help", "produce help message")
+        ("benchmark-output", value<string>(),
+             "Measure the initial setup and write results as JSON to the "
+             "given file (- for stdout), skipping the random events")
         ("db-walker-wait-usecs", value<int>()->default_value(d_db_walker_wait_),
             "set usecs delay in walker cb")
         ("close-from-control-node", bool_switch(&d_close_from_control_node_),
@@ -3034,6 +3213,10 @@ static void process_command_line_args(int argc, const char **argv) {
         BgpStressTestEvent::ReadEventsFromFile(d_feed_events_file_);
     }
 
+    if (vm.count("benchmark-output")) {
+        d_benchmark_output_ = vm["benchmark-output"].as<string>();
+    }
+
     if (vm.count("routes-send-trigger")) {
         d_routes_send_trigger_ = vm["routes-send-trigger"].as<string>();
     }
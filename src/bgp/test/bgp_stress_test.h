@@ -4,6 +4,10 @@
 #ifndef __BGP__BGP_STRESS_TEST_H__
 #define __BGP__BGP_STRESS_TEST_H__
 
+#include <map>
+#include <string>
+#include <vector>
+
 #include "control-node/test/network_agent_mock.h"
 #include "bgp/bgp_xmpp_channel.h"
 #include "bgp/bgp_sandesh.h"
@@ -277,6 +281,19 @@ private:
 
 typedef std::tr1::tuple<int, int, int, int, int, bool, bool> TestParams;
 
+//
+// Measurements for one stage of the initial setup in benchmark mode. Times
+// are in usecs. The cpu time is for the whole process and the task run time
+// is broken down by task name.
+//
+struct BgpStressTestStage {
+    BgpStressTestStage() : wall_time(0), cpu_time(0) { }
+    std::string name;
+    uint64_t wall_time;
+    uint64_t cpu_time;
+    std::map<std::string, uint64_t> task_run_time;
+};
+
 class BgpStressTest : public ::testing::TestWithParam<TestParams> {
 protected:
     BgpStressTest() : thread_(&evm_) { }
@@ -359,6 +376,10 @@ protected:
     size_t GetAllAgentRouteCount(int nagents, int ninstances);
     void VerifyXmppRouteNextHops();
 
+    void BenchmarkStart();
+    void BenchmarkStage(const std::string &name);
+    void BenchmarkReport(const std::string &filename);
+
     void InitParams();
 
     void SubscribeRoutingInstance(int agent_id, int instance_id,
@@ -448,6 +469,8 @@ protected:
     int socket_buffer_size_;
     bool sandesh_response_validation_complete_;
     boost::scoped_ptr<BgpSandeshContext> sandesh_context_;
+    std::vector<BgpStressTestStage> stages_;
+    BgpStressTestStage stage_start_;
 
     DB *config_db_;
     DBGraph *config_graph_;
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "bgp/bgp_update_capture.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "base/logging.h"
+#include "testing/gunit.h"
+
+using std::string;
+
+class BgpUpdateCaptureTest : public ::testing::Test {
+protected:
+    BgpUpdateCaptureTest() {
+        char filename[] = "/tmp/bgp_update_capture_XXXXXX";
+        int fd = mkstemp(filename);
+        if (fd >= 0)
+            close(fd);
+        filename_ = filename;
+    }
+
+    virtual void TearDown() {
+        unlink(filename_.c_str());
+    }
+
+    void TruncateFile(long size) {
+        EXPECT_EQ(0, truncate(filename_.c_str(), size));
+    }
+
+    long FileSize() {
+        FILE *file = fopen(filename_.c_str(), "rb");
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fclose(file);
+        return size;
+    }
+
+    string filename_;
+};
+
+//
+// Records are read back in the order in which they were written, with the
+// same type, peer and data.
+//
+TEST_F(BgpUpdateCaptureTest, WriteRead) {
+    const uint8_t bgp_data[] = { 0xff, 0xff, 0xff, 0xff, 0x00, 0x17, 0x02 };
+    const string xmpp_data("<iq type=\"set\"/>");
+    {
+        BgpUpdateCapture capture(filename_);
+        EXPECT_TRUE(capture.IsOpen());
+        capture.Write(BgpUpdateCapture::BgpUpdate, "10.1.1.1:1",
+            bgp_data, sizeof(bgp_data));
+        capture.Write(BgpUpdateCapture::XmppMessage, "agent-1",
+            reinterpret_cast<const uint8_t *>(xmpp_data.data()),
+            xmpp_data.size());
+        capture.Write(BgpUpdateCapture::BgpUpdate, "", NULL, 0);
+        EXPECT_EQ(3U, capture.records());
+    }
+
+    BgpUpdateCaptureReader reader(filename_);
+    EXPECT_TRUE(reader.IsOpen());
+    BgpUpdateCapture::Record record1, record2, record3, record4;
+
+    EXPECT_TRUE(reader.Read(&record1));
+    EXPECT_EQ(BgpUpdateCapture::BgpUpdate, record1.type);
+    EXPECT_EQ("10.1.1.1:1", record1.peer);
+    EXPECT_EQ(sizeof(bgp_data), record1.data.size());
+    EXPECT_EQ(0, memcmp(bgp_data, &record1.data[0], sizeof(bgp_data)));
+
+    EXPECT_TRUE(reader.Read(&record2));
+    EXPECT_EQ(BgpUpdateCapture::XmppMessage, record2.type);
+    EXPECT_EQ("agent-1", record2.peer);
+    EXPECT_EQ(xmpp_data, string(record2.data.begin(), record2.data.end()));
+    EXPECT_LE(record1.timestamp, record2.timestamp);
+
+    EXPECT_TRUE(reader.Read(&record3));
+    EXPECT_EQ("", record3.peer);
+    EXPECT_TRUE(record3.data.empty());
+    EXPECT_LE(record2.timestamp, record3.timestamp);
+
+    EXPECT_FALSE(reader.Read(&record4));
+}
+
+//
+// A truncated last record is ignored.
+//
+TEST_F(BgpUpdateCaptureTest, TruncatedRecord) {
+    const uint8_t data[] = { 0x01, 0x02, 0x03, 0x04 };
+    {
+        BgpUpdateCapture capture(filename_);
+        capture.Write(BgpUpdateCapture::BgpUpdate, "peer", data, sizeof(data));
+        capture.Write(BgpUpdateCapture::BgpUpdate, "peer", data, sizeof(data));
+    }
+    TruncateFile(FileSize() - 1);
+
+    BgpUpdateCaptureReader reader(filename_);
+    BgpUpdateCapture::Record record;
+    EXPECT_TRUE(reader.Read(&record));
+    EXPECT_FALSE(reader.Read(&record));
+}
+
+//
+// A record that can't be written is counted and stops the capture. The
+// writes to /dev/full succeed till the stdio buffer has to be flushed.
+//
+TEST_F(BgpUpdateCaptureTest, WriteError) {
+    const uint8_t data[8192] = { 0 };
+    BgpUpdateCapture capture("/dev/full");
+    EXPECT_TRUE(capture.IsOpen());
+    capture.Write(BgpUpdateCapture::BgpUpdate, "peer", data, sizeof(data));
+    capture.Write(BgpUpdateCapture::BgpUpdate, "peer", data, sizeof(data));
+    EXPECT_FALSE(capture.IsOpen());
+    EXPECT_EQ(1U, capture.write_errors());
+    EXPECT_GT(2U, capture.records());
+
+    capture.Write(BgpUpdateCapture::BgpUpdate, "peer", data, sizeof(data));
+    EXPECT_EQ(1U, capture.write_errors());
+}
+
+//
+// A file without the capture header is rejected.
+//
+TEST_F(BgpUpdateCaptureTest, BadHeader) {
+    FILE *file = fopen(filename_.c_str(), "wb");
+    fputs("not a capture file", file);
+    fclose(file);
+
+    BgpUpdateCaptureReader reader(filename_);
+    EXPECT_FALSE(reader.IsOpen());
+    BgpUpdateCapture::Record record;
+    EXPECT_FALSE(reader.Read(&record));
+}
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,607 @@
+/*
+ * Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
+ */
+
+//
+// Replay driver for files written by BgpUpdateCapture.
+//
+// The BGP UPDATEs and XMPP IQ messages in the capture are fed into a fresh
+// BgpServer without any network sessions. BGP peers and XMPP channels are
+// created on the fly, keyed by the peer name in the capture. A configuration
+// file in the BgpConfigParser format can be provided to create the routing
+// instances that the XMPP peers subscribe to.
+//
+// All records are processed in capture order from a single queue. Each one
+// is processed in the task in which the message would have been processed in
+// a live control node, i.e. bgp::StateMachine for BGP updates and
+// xmpp::StateMachine for XMPP messages. Peers and channels are created in
+// the tasks that create them in a live control node as well. This makes the
+// final state of the server deterministic, so the results from different
+// builds can be compared.
+//
+// The driver reports the time to converge, i.e. the time from the start of
+// the replay till the scheduler becomes idle after the last message has been
+// processed, along with the peak RSS and the peak depths of the replay and
+// DB request queues.
+//
+
+#include <sys/resource.h>
+
+#include <boost/program_options.hpp>
+#include <boost/ptr_container/ptr_map.hpp>
+#include <tbb/mutex.h>
+
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include "base/task.h"
+#include "base/task_annotations.h"
+#include "base/test/task_test_util.h"
+#include "base/time_util.h"
+#include "bgp/bgp_config.h"
+#include "bgp/bgp_log.h"
+#include "bgp/bgp_peer.h"
+#include "bgp/bgp_proto.h"
+#include "bgp/bgp_update_capture.h"
+#include "bgp/bgp_xmpp_channel.h"
+#include "bgp/routing-instance/peer_manager.h"
+#include "bgp/routing-instance/routing_instance.h"
+#include "bgp/test/bgp_server_test_util.h"
+#include "control-node/control_node.h"
+#include "db/db_partition.h"
+#include "io/test/event_manager_test.h"
+#include "xmpp/xmpp_channel.h"
+#include "xmpp/xmpp_connection.h"
+#include "xmpp/xmpp_proto.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+
+namespace po = boost::program_options;
+
+//
+// XmppChannel without a connection. Messages are fed directly into the
+// BgpXmppChannel by the replay driver and anything sent to the agent is
+// discarded. A publish iq is held in the channel till the collection iq
+// that completes it is replayed, like XmppConnection does.
+//
+class ReplayXmppChannel : public XmppChannel {
+public:
+    explicit ReplayXmppChannel(const string &name) : name_(name) { }
+    virtual ~ReplayXmppChannel() { }
+
+    virtual void Close() { }
+    virtual void CloseComplete() { }
+    virtual bool IsCloseInProgress() const { return false; }
+    virtual bool Send(const uint8_t *, size_t, xmps::PeerId, SendReadyCb) {
+        return true;
+    }
+    virtual int GetTaskInstance() const { return 0; }
+    virtual void RegisterReceive(xmps::PeerId, ReceiveCb) { }
+    virtual void UnRegisterReceive(xmps::PeerId) { }
+    virtual void UnRegisterWriteReady(xmps::PeerId) { }
+    virtual std::string ToString() const { return name_; }
+    virtual std::string StateName() const { return "Established"; }
+    virtual xmps::PeerState GetPeerState() const { return xmps::READY; }
+    virtual std::string FromString() const { return name_; }
+    virtual const XmppConnection *connection() const { return NULL; }
+    virtual std::string LastStateName() const { return ""; }
+    virtual std::string LastStateChangeAt() const { return ""; }
+    virtual std::string LastEvent() const { return ""; }
+    virtual uint32_t rx_open() const { return 0; }
+    virtual uint32_t rx_close() const { return 0; }
+    virtual uint32_t rx_update() const { return 0; }
+    virtual uint32_t rx_keepalive() const { return 0; }
+    virtual uint32_t tx_open() const { return 0; }
+    virtual uint32_t tx_close() const { return 0; }
+    virtual uint32_t tx_update() const { return 0; }
+    virtual uint32_t tx_keepalive() const { return 0; }
+    virtual uint32_t FlapCount() const { return 0; }
+    virtual std::string LastFlap() const { return ""; }
+    virtual std::string AuthType() const { return ""; }
+    virtual std::string PeerAddress() const { return name_; }
+    virtual void RegisterRxMessageTraceCallback(RxMessageTraceCb cb) { }
+    virtual void RegisterTxMessageTraceCallback(TxMessageTraceCb cb) { }
+
+    std::auto_ptr<XmppStanza::XmppMessage> &last_msg() { return last_msg_; }
+
+private:
+    string name_;
+    std::auto_ptr<XmppStanza::XmppMessage> last_msg_;
+};
+
+class BgpUpdateReplay {
+public:
+    BgpUpdateReplay(BgpServerTest *server, bool original_speed)
+        : server_(server),
+          xmpp_mgr_(new BgpXmppChannelManager(NULL, server)),
+          original_speed_(original_speed),
+          bgp_task_id_(
+              TaskScheduler::GetInstance()->GetTaskId("bgp::StateMachine")),
+          xmpp_task_id_(
+              TaskScheduler::GetInstance()->GetTaskId("xmpp::StateMachine")),
+          running_(false),
+          bgp_records_(0),
+          xmpp_records_(0),
+          peak_queue_(0),
+          peak_db_queue_(0),
+          converge_time_(0) {
+        errors_ = 0;
+    }
+
+    ~BgpUpdateReplay() {
+        task_util::TaskFire(
+            boost::bind(&BgpUpdateReplay::CloseXmppChannels, this),
+            "xmpp::StateMachine");
+        task_util::WaitForIdle();
+        xmpp_mgr_.reset();
+        task_util::WaitForIdle();
+        for (ChannelMap::iterator it = channels_.begin();
+             it != channels_.end(); ++it) {
+            delete it->second;
+        }
+    }
+
+    bool Run(const string &filename);
+    void Report(std::ostream &os) const;
+
+private:
+    class ReplayTask;
+
+    struct ReplayEntry {
+        ReplayEntry()
+            : task_id(-1), task_instance(0), peer(NULL), xmpp_channel(NULL),
+              channel(NULL) {
+        }
+        int task_id;
+        int task_instance;
+        BgpPeer *peer;
+        ReplayXmppChannel *xmpp_channel;
+        BgpXmppChannel *channel;
+        BgpUpdateCapture::Record record;
+    };
+
+    typedef std::deque<ReplayEntry *> ReplayQueue;
+    typedef std::map<string, BgpPeer *> PeerMap;
+    typedef std::map<string, ReplayXmppChannel *> ChannelMap;
+    typedef boost::ptr_map<string, BgpNeighborConfig> NeighborConfigMap;
+
+    // Number of entries processed by a ReplayTask before it yields.
+    static const int kMaxIterations = 64;
+
+    BgpPeer *LocateBgpPeer(const string &name);
+    void CreateBgpPeer(const string &name);
+    void OpenBgpPeer(BgpPeer *peer);
+    ReplayXmppChannel *LocateXmppChannel(const string &name);
+    void CreateXmppChannel(ReplayXmppChannel *channel);
+    void CloseXmppChannels();
+    void Enqueue(ReplayEntry *entry);
+    void StartTask(const ReplayEntry *entry);
+    void ProcessQueue(int task_id, int task_instance);
+    void ProcessBgpEntry(ReplayEntry *entry);
+    void ProcessXmppEntry(ReplayEntry *entry);
+    bool IsQueueEmpty();
+    void SampleQueues();
+    void WaitForConvergence();
+
+    BgpServerTest *server_;
+    boost::scoped_ptr<BgpXmppChannelManager> xmpp_mgr_;
+    bool original_speed_;
+    int bgp_task_id_;
+    int xmpp_task_id_;
+    tbb::mutex mutex_;
+    ReplayQueue queue_;
+    bool running_;
+    PeerMap peers_;
+    NeighborConfigMap neighbor_configs_;
+    ChannelMap channels_;
+    uint64_t bgp_records_;
+    uint64_t xmpp_records_;
+    tbb::atomic<uint64_t> errors_;
+    size_t peak_queue_;
+    long peak_db_queue_;
+    uint64_t converge_time_;
+};
+
+//
+// Process the entries at the head of the replay queue that run in the task
+// of this ReplayTask. The queue is handed over to a new ReplayTask when the
+// entry at the head runs in a different task, so only one ReplayTask exists
+// at any time and entries are processed in capture order.
+//
+class BgpUpdateReplay::ReplayTask : public Task {
+public:
+    ReplayTask(BgpUpdateReplay *replay, int task_id, int task_instance)
+        : Task(task_id, task_instance), replay_(replay) {
+    }
+
+    virtual bool Run() {
+        replay_->ProcessQueue(GetTaskId(), GetTaskInstance());
+        return true;
+    }
+    virtual std::string Description() const {
+        return "BgpUpdateReplay::ReplayTask";
+    }
+
+private:
+    BgpUpdateReplay *replay_;
+};
+
+//
+// Find or create a BgpPeer in the master instance for the given name. The
+// peer is created in the bgp::Config task and its capabilities are set in
+// the bgp::StateMachine task, as for a live session.
+//
+BgpPeer *BgpUpdateReplay::LocateBgpPeer(const string &name) {
+    PeerMap::iterator loc = peers_.find(name);
+    if (loc != peers_.end())
+        return loc->second;
+
+    task_util::TaskFire(
+        boost::bind(&BgpUpdateReplay::CreateBgpPeer, this, name),
+        "bgp::Config");
+    BgpPeer *peer = peers_[name];
+    assert(peer);
+    task_util::TaskFire(
+        boost::bind(&BgpUpdateReplay::OpenBgpPeer, this, peer),
+        "bgp::StateMachine", peer->GetTaskInstance());
+    return peer;
+}
+
+void BgpUpdateReplay::CreateBgpPeer(const string &name) {
+    CHECK_CONCURRENCY("bgp::Config");
+    BgpNeighborConfig *config = new BgpNeighborConfig;
+    string key(name);
+    neighbor_configs_.insert(key, config);
+    config->set_name(name);
+    config->set_instance_name(BgpConfigManager::kMasterInstance);
+    config->set_local_as(server_->autonomous_system());
+    config->set_peer_as(server_->autonomous_system());
+    config->set_local_identifier(server_->bgp_identifier());
+    boost::system::error_code ec;
+    IpAddress address = IpAddress::from_string(name.substr(0, name.find(':')),
+        ec);
+    if (!ec)
+        config->set_peer_address(address);
+
+    const char *families[] = {
+        "inet", "inet-vpn", "inet6", "inet6-vpn", "e-vpn", "erm-vpn",
+        "route-target"
+    };
+    BgpNeighborConfig::FamilyAttributesList family_attributes_list;
+    for (size_t idx = 0; idx < sizeof(families) / sizeof(families[0]);
+         ++idx) {
+        family_attributes_list.push_back(
+            BgpFamilyAttributesConfig(families[idx]));
+    }
+    config->set_family_attributes_list(family_attributes_list);
+
+    RoutingInstance *master = server_->routing_instance_mgr()->
+        GetDefaultRoutingInstance();
+    peers_[name] = master->peer_manager()->PeerLocate(server_, config);
+}
+
+//
+// All address families are negotiated since the capture doesn't have the
+// OPEN message from the original session.
+//
+void BgpUpdateReplay::OpenBgpPeer(BgpPeer *peer) {
+    CHECK_CONCURRENCY("bgp::StateMachine");
+    BgpProto::OpenMessage open;
+    BgpProto::OpenMessage::OptParam *opt = new BgpProto::OpenMessage::OptParam;
+    const uint16_t afi_safi[][2] = {
+        { BgpAf::IPv4, BgpAf::Unicast },
+        { BgpAf::IPv4, BgpAf::Vpn },
+        { BgpAf::IPv6, BgpAf::Unicast },
+        { BgpAf::IPv6, BgpAf::Vpn },
+        { BgpAf::L2Vpn, BgpAf::EVpn },
+        { BgpAf::IPv4, BgpAf::ErmVpn },
+        { BgpAf::IPv4, BgpAf::RTarget }
+    };
+    for (size_t idx = 0; idx < sizeof(afi_safi) / sizeof(afi_safi[0]);
+         ++idx) {
+        uint8_t capc[] = {
+            0, static_cast<uint8_t>(afi_safi[idx][0]), 0,
+            static_cast<uint8_t>(afi_safi[idx][1])
+        };
+        opt->capabilities.push_back(new BgpProto::OpenMessage::Capability(
+            BgpProto::OpenMessage::Capability::MpExtension, capc, 4));
+    }
+    open.opt_params.push_back(opt);
+    peer->SetCapabilities(&open);
+}
+
+//
+// Find or create the channel for the given agent name. The BgpXmppChannel is
+// created in the xmpp::StateMachine task, as for a live connection.
+//
+ReplayXmppChannel *BgpUpdateReplay::LocateXmppChannel(const string &name) {
+    ChannelMap::iterator loc = channels_.find(name);
+    if (loc != channels_.end())
+        return loc->second;
+
+    ReplayXmppChannel *channel = new ReplayXmppChannel(name);
+    channels_.insert(make_pair(name, channel));
+    task_util::TaskFire(
+        boost::bind(&BgpUpdateReplay::CreateXmppChannel, this, channel),
+        "xmpp::StateMachine");
+    assert(xmpp_mgr_->FindChannel(channel));
+    return channel;
+}
+
+void BgpUpdateReplay::CreateXmppChannel(ReplayXmppChannel *channel) {
+    CHECK_CONCURRENCY("xmpp::StateMachine");
+    xmpp_mgr_->XmppHandleChannelEvent(channel, xmps::READY);
+}
+
+void BgpUpdateReplay::CloseXmppChannels() {
+    CHECK_CONCURRENCY("xmpp::StateMachine");
+    for (ChannelMap::iterator it = channels_.begin();
+         it != channels_.end(); ++it) {
+        xmpp_mgr_->XmppHandleChannelEvent(it->second, xmps::NOT_READY);
+    }
+}
+
+void BgpUpdateReplay::Enqueue(ReplayEntry *entry) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    queue_.push_back(entry);
+    peak_queue_ = std::max(peak_queue_, queue_.size());
+    if (!running_) {
+        running_ = true;
+        StartTask(entry);
+    }
+}
+
+void BgpUpdateReplay::StartTask(const ReplayEntry *entry) {
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    scheduler->Enqueue(
+        new ReplayTask(this, entry->task_id, entry->task_instance));
+}
+
+void BgpUpdateReplay::ProcessQueue(int task_id, int task_instance) {
+    for (int count = 0; ; ++count) {
+        ReplayEntry *entry;
+        {
+            tbb::mutex::scoped_lock lock(mutex_);
+            if (queue_.empty()) {
+                running_ = false;
+                return;
+            }
+            entry = queue_.front();
+            if (entry->task_id != task_id ||
+                entry->task_instance != task_instance ||
+                count == kMaxIterations) {
+                StartTask(entry);
+                return;
+            }
+            queue_.pop_front();
+        }
+        if (task_id == bgp_task_id_) {
+            ProcessBgpEntry(entry);
+        } else {
+            ProcessXmppEntry(entry);
+        }
+        delete entry;
+    }
+}
+
+void BgpUpdateReplay::ProcessBgpEntry(ReplayEntry *entry) {
+    CHECK_CONCURRENCY("bgp::StateMachine");
+    const BgpUpdateCapture::Record &record = entry->record;
+    ParseErrorContext ec;
+    std::auto_ptr<BgpProto::BgpMessage> msg(
+        BgpProto::Decode(&record.data[0], record.data.size(), &ec));
+    if (msg.get() && msg->type == BgpProto::UPDATE) {
+        entry->peer->ProcessUpdate(
+            static_cast<BgpProto::Update *>(msg.get()), record.data.size());
+    } else {
+        errors_++;
+    }
+}
+
+//
+// Decode the stanza and merge it with the publish that precedes it, if it's
+// a collection, the same way as XmppConnection does for received stanzas.
+//
+void BgpUpdateReplay::ProcessXmppEntry(ReplayEntry *entry) {
+    CHECK_CONCURRENCY("xmpp::StateMachine");
+    const BgpUpdateCapture::Record &record = entry->record;
+    string doc(record.data.begin(), record.data.end());
+    std::auto_ptr<XmppStanza::XmppMessage> msg(XmppProto::Decode(doc));
+    if (!msg.get()) {
+        errors_++;
+        return;
+    }
+
+    std::auto_ptr<XmppStanza::XmppMessage> &last_msg =
+        entry->xmpp_channel->last_msg();
+    if (msg->type == XmppStanza::IQ_STANZA) {
+        const XmppStanza::XmppMessageIq *iq =
+            static_cast<const XmppStanza::XmppMessageIq *>(msg.get());
+        if (iq->action.compare("publish") == 0) {
+            last_msg.reset(msg.release());
+            return;
+        }
+        if (iq->action.compare("collection") == 0) {
+            if (!last_msg.get() || !XmppConnection::MergeCollection(
+                    static_cast<XmppStanza::XmppMessageIq *>(last_msg.get()),
+                    iq)) {
+                last_msg.reset();
+                errors_++;
+                return;
+            }
+            msg.reset(last_msg.release());
+        }
+    }
+    entry->channel->ReceiveUpdate(msg.get());
+}
+
+bool BgpUpdateReplay::IsQueueEmpty() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    return queue_.empty();
+}
+
+void BgpUpdateReplay::SampleQueues() {
+    long db_queue = 0;
+    DB *db = server_->database();
+    for (int idx = 0; idx < DB::PartitionCount(); ++idx) {
+        db_queue += db->GetPartition(idx)->request_queue_len();
+    }
+    peak_db_queue_ = std::max(peak_db_queue_, db_queue);
+}
+
+void BgpUpdateReplay::WaitForConvergence() {
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    while (!IsQueueEmpty() || !scheduler->IsEmpty()) {
+        SampleQueues();
+        usleep(1000);
+    }
+}
+
+//
+// Replay all records in the capture file. In original speed mode, each record
+// is enqueued at the same offset from the start of the replay as it had from
+// the first record in the capture. Otherwise records are enqueued as fast as
+// they can be read.
+//
+bool BgpUpdateReplay::Run(const string &filename) {
+    BgpUpdateCaptureReader reader(filename);
+    if (!reader.IsOpen()) {
+        cerr << "Cannot read capture file " << filename << endl;
+        return false;
+    }
+
+    uint64_t start_time = UTCTimestampUsec();
+    uint64_t first_timestamp = 0;
+    while (true) {
+        ReplayEntry *entry = new ReplayEntry;
+        if (!reader.Read(&entry->record)) {
+            delete entry;
+            break;
+        }
+
+        const BgpUpdateCapture::Record &record = entry->record;
+        if (!first_timestamp)
+            first_timestamp = record.timestamp;
+        if (original_speed_) {
+            uint64_t offset = record.timestamp - first_timestamp;
+            while (UTCTimestampUsec() - start_time < offset) {
+                SampleQueues();
+                usleep(100);
+            }
+        }
+
+        if (record.type == BgpUpdateCapture::BgpUpdate) {
+            entry->peer = LocateBgpPeer(record.peer);
+            entry->task_id = bgp_task_id_;
+            entry->task_instance = entry->peer->GetTaskInstance();
+            bgp_records_++;
+            Enqueue(entry);
+        } else if (record.type == BgpUpdateCapture::XmppMessage) {
+            entry->xmpp_channel = LocateXmppChannel(record.peer);
+            entry->channel = xmpp_mgr_->FindChannel(entry->xmpp_channel);
+            entry->task_id = xmpp_task_id_;
+            entry->task_instance = entry->xmpp_channel->GetTaskInstance();
+            xmpp_records_++;
+            Enqueue(entry);
+        } else {
+            errors_++;
+            delete entry;
+        }
+        SampleQueues();
+    }
+
+    WaitForConvergence();
+    converge_time_ = UTCTimestampUsec() - start_time;
+    return true;
+}
+
+void BgpUpdateReplay::Report(std::ostream &os) const {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    os << "BGP peers: " << peers_.size()
+       << " updates: " << bgp_records_ << endl;
+    os << "XMPP agents: " << channels_.size()
+       << " messages: " << xmpp_records_ << endl;
+    os << "Errors: " << errors_ << endl;
+    os << "Time to converge: " << converge_time_ / 1000 << " msec" << endl;
+    os << "Peak RSS: " << usage.ru_maxrss << " KB" << endl;
+    os << "Peak queue depth: replay " << peak_queue_
+       << " db " << peak_db_queue_ << endl;
+}
+
+static string FileRead(const string &filename) {
+    std::ifstream file(filename.c_str());
+    std::ostringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+int main(int argc, char **argv) {
+    string capture_file;
+    string config_file;
+    string localname;
+
+    po::options_description desc("Options");
+    desc.add_options()
+        ("help", "Print help message")
+        ("capture-file", po::value<string>(&capture_file),
+             "Capture file written by the control node")
+        ("config-file", po::value<string>(&config_file),
+             "Configuration file in BgpConfigParser format")
+        ("localname", po::value<string>(&localname)->default_value("A"),
+             "Name of the local bgp-router in the configuration")
+        ("original-speed", "Replay at the speed at which updates were "
+             "captured instead of as fast as possible");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+    if (vm.count("help") || capture_file.empty()) {
+        cout << desc << endl;
+        return vm.count("help") ? 0 : 1;
+    }
+
+    bgp_log_test::init();
+    ControlNode::SetDefaultSchedulingPolicy();
+    BgpServerTest::GlobalSetUp();
+
+    EventManager evm;
+    ServerThread thread(&evm);
+    BgpServerTest server(&evm, localname);
+    thread.Start();
+
+    if (!config_file.empty()) {
+        server.Configure(FileRead(config_file));
+    } else {
+        BgpInstanceConfig master_config(BgpConfigManager::kMasterInstance);
+        task_util::TaskFire(boost::bind(
+            &RoutingInstanceMgr::CreateRoutingInstance,
+            server.routing_instance_mgr(), &master_config),
+            "bgp::Config");
+    }
+    task_util::WaitForIdle();
+
+    bool success;
+    {
+        BgpUpdateReplay replay(&server, vm.count("original-speed") != 0);
+        success = replay.Run(capture_file);
+        if (success)
+            replay.Report(cout);
+    }
+
+    server.Shutdown();
+    task_util::WaitForIdle();
+    evm.Shutdown();
+    thread.Join();
+    TaskScheduler::GetInstance()->Terminate();
+    return success ? 0 : 1;
+}
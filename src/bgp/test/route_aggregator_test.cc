@@ -371,6 +371,20 @@ protected:
         return rti->route_aggregator(fmly)->GetUpdateAggregateListSize();
     }
 
+    string FindCoveringAggregate(const string &instance,
+                                 const string &prefix) {
+        RoutingInstance *rti =
+            bgp_server_->routing_instance_mgr()->GetRoutingInstance(instance);
+        RouteAggregatorInet *aggregator = static_cast<RouteAggregatorInet *>(
+            rti->route_aggregator(Address::INET));
+        boost::system::error_code error;
+        Ip4Prefix ip_prefix = Ip4Prefix::FromString(prefix, &error);
+        EXPECT_FALSE(error);
+        ConditionMatch *aggregate =
+            aggregator->FindCoveringAggregate(ip_prefix);
+        return aggregate ? aggregate->ToString() : "";
+    }
+
     vector<string> GetCommunityListFromRoute(const BgpPath *path) {
         const Community *comm = path->GetAttr()->community();
         if (comm == NULL) return vector<string>();
@@ -1701,6 +1715,66 @@ TEST_F(RouteAggregatorTest, ConfigUpdate_RemoveOverlappingPrefixes) {
     task_util::WaitForIdle();
 }
 
+//
+// Verify that the longest covering aggregate prefix is found for routes with
+// overlapping aggregate prefixes and that the lookup skips the prefix itself.
+// Remove the longest aggregate prefix and verify that the contributing route
+// moves to the next longest one.
+//
+TEST_F(RouteAggregatorTest, OverlappingPrefixes_CoveringAggregate) {
+    string content =
+        FileRead("controller/src/bgp/testdata/route_aggregate_3c.xml");
+    EXPECT_TRUE(parser_.Parse(content));
+    task_util::WaitForIdle();
+
+    EXPECT_EQ("AggregateRoute 2.2.2.0/24",
+              FindCoveringAggregate("test", "2.2.2.2/32"));
+    EXPECT_EQ("AggregateRoute 2.2.0.0/16",
+              FindCoveringAggregate("test", "2.2.1.1/32"));
+    EXPECT_EQ("AggregateRoute 2.0.0.0/8",
+              FindCoveringAggregate("test", "2.1.1.1/32"));
+    EXPECT_EQ("AggregateRoute 2.2.0.0/16",
+              FindCoveringAggregate("test", "2.2.2.0/24"));
+    EXPECT_EQ("AggregateRoute 2.0.0.0/8",
+              FindCoveringAggregate("test", "2.2.0.0/16"));
+    EXPECT_EQ("", FindCoveringAggregate("test", "2.0.0.0/8"));
+    EXPECT_EQ("", FindCoveringAggregate("test", "3.3.3.3/32"));
+
+    boost::system::error_code ec;
+    peers_.push_back(
+        new BgpPeerMock(Ip4Address::from_string("192.168.0.1", ec)));
+
+    AddRoute<InetDefinition>(peers_[0], "test.inet.0", "2.2.2.1/32", 100);
+    AddRoute<InetDefinition>(peers_[0], "test.inet.0", "2.2.2.2/32", 100);
+    task_util::WaitForIdle();
+
+    VERIFY_EQ(5, RouteCount("test.inet.0"));
+    TASK_UTIL_EXPECT_TRUE(IsContributingRoute<InetDefinition>("test",
+                                      "test.inet.0", "2.2.2.2/32"));
+    TASK_UTIL_EXPECT_TRUE(IsAggregateRoute<InetDefinition>("test",
+                                      "test.inet.0", "2.2.2.0/24"));
+
+    ifmap_test_util::IFMapMsgUnlink(&config_db_, "routing-instance", "test",
+        "route-aggregate", "vn_subnet_1", "routing-instance-route-aggregate");
+    task_util::WaitForIdle();
+
+    TASK_UTIL_EXPECT_EQ(GetUnregResolveListSize("test", Address::INET), 0);
+    EXPECT_EQ("AggregateRoute 2.2.0.0/16",
+              FindCoveringAggregate("test", "2.2.2.2/32"));
+
+    VERIFY_EQ(4, RouteCount("test.inet.0"));
+    BgpRoute *rt = RouteLookup<InetDefinition>("test.inet.0", "2.2.2.0/24");
+    ASSERT_TRUE(rt == NULL);
+    TASK_UTIL_EXPECT_TRUE(IsContributingRoute<InetDefinition>("test",
+                                      "test.inet.0", "2.2.2.2/32"));
+    TASK_UTIL_EXPECT_TRUE(IsAggregateRoute<InetDefinition>("test",
+                                      "test.inet.0", "2.2.0.0/16"));
+
+    DeleteRoute<InetDefinition>(peers_[0], "test.inet.0", "2.2.2.1/32");
+    DeleteRoute<InetDefinition>(peers_[0], "test.inet.0", "2.2.2.2/32");
+    task_util::WaitForIdle();
+}
+
 //
 // With multiple route aggregate config object linked to the routing instance,
 // update the config to remove longer prefix
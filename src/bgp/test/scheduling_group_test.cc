@@ -93,6 +93,16 @@ protected:
         return sg->work_queue_.size();
     }
 
+    size_t GetShardWorkQueueSize(SchedulingGroup *sg, size_t shard) {
+        ConcurrencyScope scope("bgp::PeerMembership");
+        return sg->ShardWorkQueueSize(shard);
+    }
+
+    size_t GetPeerShard(SchedulingGroup *sg, IPeerUpdate *peer) {
+        ConcurrencyScope scope("bgp::PeerMembership");
+        return sg->GetPeerShard(peer);
+    }
+
     void SetQueueActive(SchedulingGroup *sg, RibOut *ribout, int queue_id,
         IPeerUpdate *peer) {
         ConcurrencyScope scope("bgp::SendTask");
@@ -845,6 +855,96 @@ TEST_F(SchedulingGroupManagerTest, WorkPeerInvalidate) {
     EXPECT_EQ(0, sgman_.size());
 }
 
+TEST_F(SchedulingGroupManagerTest, ShardWorkPeer) {
+    sgman_.set_send_shard_count(2);
+
+    // Create 4 test peers and 1 ribout.
+    boost::scoped_ptr<RibOut> ribout(new RibOut(inetvpn_table_, &sgman_,
+        RibExportPolicy(BgpProto::IBGP, RibExportPolicy::BGP, 0, 0)));
+    vector<BgpTestPeer *> peers;
+    for (int idx = 0; idx < 4; ++idx) {
+        peers.push_back(new BgpTestPeer());
+        Join(ribout.get(), peers[idx]);
+    }
+    EXPECT_EQ(1, sgman_.size());
+
+    // Peers are distributed across the shards.
+    SchedulingGroup *sg = ribout->GetSchedulingGroup();
+    EXPECT_EQ(2, sg->shard_count());
+    for (int idx = 0; idx < 4; ++idx) {
+        EXPECT_EQ(idx % 2, GetPeerShard(sg, peers[idx]));
+    }
+
+    // WorkPeer entries go to the shard work queues and WorkRibOut entries
+    // go to the work queue for the group.
+    for (int idx = 0; idx < 4; ++idx) {
+        WorkPeerEnqueue(sg, peers[idx]);
+    }
+    WorkRibOutEnqueue(sg, ribout.get());
+    EXPECT_EQ(1, GetWorkQueueSize(sg));
+    EXPECT_EQ(2, GetShardWorkQueueSize(sg, 0));
+    EXPECT_EQ(2, GetShardWorkQueueSize(sg, 1));
+
+    for (int idx = 0; idx < 4; ++idx) {
+        Leave(ribout.get(), peers[idx]);
+    }
+    EXPECT_EQ(0, sgman_.size());
+    STLDeleteValues(&peers);
+}
+
+TEST_F(SchedulingGroupManagerTest, ShardWorkPeerSplitMerge) {
+    sgman_.set_send_shard_count(2);
+
+    boost::scoped_ptr<RibOut> rp1(new RibOut(inetvpn_table_, &sgman_,
+        RibExportPolicy(BgpProto::IBGP, RibExportPolicy::BGP, 1, 0)));
+    boost::scoped_ptr<RibOut> rp2(new RibOut(inetvpn_table_, &sgman_,
+        RibExportPolicy(BgpProto::IBGP, RibExportPolicy::BGP, 2, 0)));
+    boost::scoped_ptr<BgpTestPeer> p1(new BgpTestPeer());
+    boost::scoped_ptr<BgpTestPeer> p2(new BgpTestPeer());
+
+    Join(rp1.get(), p1.get());
+    Join(rp1.get(), p2.get());
+    Join(rp2.get(), p2.get());
+    EXPECT_EQ(1, sgman_.size());
+
+    SchedulingGroup *sg = rp1->GetSchedulingGroup();
+    EXPECT_EQ(0, GetPeerShard(sg, p1.get()));
+    EXPECT_EQ(1, GetPeerShard(sg, p2.get()));
+    WorkPeerEnqueue(sg, p1.get());
+    WorkPeerEnqueue(sg, p2.get());
+    EXPECT_EQ(1, GetShardWorkQueueSize(sg, 0));
+    EXPECT_EQ(1, GetShardWorkQueueSize(sg, 1));
+
+    // The WorkPeer entry for p2 moves to the shard for it's new index in
+    // the new group.
+    Leave(rp1.get(), p2.get());
+    EXPECT_EQ(2, sgman_.size());
+    sg = rp1->GetSchedulingGroup();
+    EXPECT_EQ(2, sg->shard_count());
+    EXPECT_EQ(1, GetShardWorkQueueSize(sg, 0));
+    EXPECT_EQ(0, GetShardWorkQueueSize(sg, 1));
+    sg = rp2->GetSchedulingGroup();
+    EXPECT_EQ(2, sg->shard_count());
+    EXPECT_EQ(0, GetPeerShard(sg, p2.get()));
+    EXPECT_EQ(1, GetShardWorkQueueSize(sg, 0));
+    EXPECT_EQ(0, GetShardWorkQueueSize(sg, 1));
+
+    // Merge the groups again. The WorkPeer entries move to the shards for
+    // the new peer indices in the merged group.
+    Join(rp1.get(), p2.get());
+    EXPECT_EQ(1, sgman_.size());
+    sg = rp1->GetSchedulingGroup();
+    EXPECT_NE(GetPeerShard(sg, p1.get()), GetPeerShard(sg, p2.get()));
+    EXPECT_EQ(1, GetShardWorkQueueSize(sg, 0));
+    EXPECT_EQ(1, GetShardWorkQueueSize(sg, 1));
+    EXPECT_EQ(0, GetWorkQueueSize(sg));
+
+    Leave(rp1.get(), p1.get());
+    Leave(rp1.get(), p2.get());
+    Leave(rp2.get(), p2.get());
+    EXPECT_EQ(0, sgman_.size());
+}
+
 // Parameterize number of entries in the work queue and the order in which
 // the entries are added.
 
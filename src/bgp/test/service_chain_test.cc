@@ -13,6 +13,7 @@
 
 #include "base/task_annotations.h"
 #include "base/test/task_test_util.h"
+#include "base/time_util.h"
 #include "bgp/bgp_config_ifmap.h"
 #include "bgp/bgp_config_parser.h"
 #include "bgp/bgp_factory.h"
@@ -49,6 +50,7 @@ using pugi::xml_document;
 using pugi::xml_node;
 using pugi::xml_parse_result;
 using std::auto_ptr;
+using std::cout;
 using std::endl;
 using std::ifstream;
 using std::istreambuf_iterator;
@@ -1867,6 +1869,88 @@ TYPED_TEST(ServiceChainTest, UpdateNexthop) {
     this->DeleteConnectedRoute(NULL, this->BuildPrefix("1.1.2.3", 32));
 }
 
+//
+// Benchmark for updating a large number of external connecting routes when
+// the nexthop of the connected route changes. All the service chain routes
+// share the same nexthop, so a change to it is processed in batches with the
+// attributes computed only once.
+//
+// The number of routes defaults to a value that keeps the test fast but is
+// large enough to need multiple batches. Set SERVICE_CHAIN_TEST_SCALE_ROUTES
+// to e.g. 100000 for benchmarking. The times are only printed if it's set.
+//
+TYPED_TEST(ServiceChainTest, ScaleUpdateNexthop) {
+    int route_count = 2048;
+    char *env = getenv("SERVICE_CHAIN_TEST_SCALE_ROUTES");
+    if (env)
+        route_count = strtoul(env, NULL, 0);
+
+    vector<string> instance_names = list_of("blue")("blue-i1")("red-i2")("red");
+    multimap<string, string> connections =
+        map_list_of("blue", "blue-i1") ("red-i2", "red");
+    this->NetworkConfig(instance_names, connections);
+    this->VerifyNetworkConfig(instance_names);
+
+    this->SetServiceChainInformation("blue-i1",
+        "controller/src/bgp/testdata/service_chain_1.xml");
+
+    // Add Ext connect routes.
+    vector<string> prefixes;
+    for (int idx = 0; idx < route_count; ++idx) {
+        Ip4Address addr(Ip4Address::from_string("10.0.0.0").to_ulong() +
+                        (idx << 8));
+        prefixes.push_back(this->BuildPrefix(addr.to_string(), 24));
+        this->AddRoute(NULL, "red", prefixes.back(), 100);
+    }
+    task_util::WaitForIdle();
+    int blue_count = this->RouteCount("blue");
+
+    // Add Connected and verify that all ExtConnect routes get added.
+    uint64_t start = UTCTimestampUsec();
+    this->AddConnectedRoute(NULL, this->BuildPrefix("1.1.2.3", 32), 100,
+                            this->BuildNextHopAddress("2.3.4.5"));
+    task_util::WaitForIdle();
+    uint64_t add_time = UTCTimestampUsec() - start;
+    TASK_UTIL_EXPECT_EQ(blue_count + route_count, this->RouteCount("blue"));
+    this->VerifyRouteAttributes("blue", prefixes.front(),
+                                this->BuildNextHopAddress("2.3.4.5"), "red");
+    this->VerifyRouteAttributes("blue", prefixes.back(),
+                                this->BuildNextHopAddress("2.3.4.5"), "red");
+
+    // Update Connected and verify that all ExtConnect routes get updated.
+    start = UTCTimestampUsec();
+    this->AddConnectedRoute(NULL, this->BuildPrefix("1.1.2.3", 32), 100,
+                            this->BuildNextHopAddress("3.4.5.6"));
+    task_util::WaitForIdle();
+    uint64_t update_time = UTCTimestampUsec() - start;
+    TASK_UTIL_EXPECT_EQ(blue_count + route_count, this->RouteCount("blue"));
+    this->VerifyRouteAttributes("blue", prefixes.front(),
+                                this->BuildNextHopAddress("3.4.5.6"), "red");
+    this->VerifyRouteAttributes("blue", prefixes[route_count / 2],
+                                this->BuildNextHopAddress("3.4.5.6"), "red");
+    this->VerifyRouteAttributes("blue", prefixes.back(),
+                                this->BuildNextHopAddress("3.4.5.6"), "red");
+
+    // Delete Connected and verify that all ExtConnect routes get deleted.
+    start = UTCTimestampUsec();
+    this->DeleteConnectedRoute(NULL, this->BuildPrefix("1.1.2.3", 32));
+    task_util::WaitForIdle();
+    uint64_t delete_time = UTCTimestampUsec() - start;
+    TASK_UTIL_EXPECT_EQ(blue_count, this->RouteCount("blue"));
+
+    if (env) {
+        cout << "Routes: " << route_count
+             << " add: " << add_time / 1000 << " msec"
+             << " update: " << update_time / 1000 << " msec"
+             << " delete: " << delete_time / 1000 << " msec" << endl;
+    }
+
+    // Delete Ext connect routes.
+    BOOST_FOREACH(const string &prefix, prefixes) {
+        this->DeleteRoute(NULL, "red", prefix);
+    }
+    task_util::WaitForIdle();
+}
 
 TYPED_TEST(ServiceChainTest, UpdateLabel) {
     vector<string> instance_names = list_of("blue")("blue-i1")("red-i2")("red");
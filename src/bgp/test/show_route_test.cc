@@ -5,9 +5,10 @@
 #include <boost/assign/list_of.hpp>
 #include <boost/foreach.hpp>
 
-
+#include <set>
 
 #include "bgp/bgp_config_parser.h"
+#include "bgp/bgp_peer_internal_types.h"
 #include "bgp/bgp_sandesh.h"
 #include "bgp/bgp_session_manager.h"
 #include "bgp/inet/inet_table.h"
@@ -154,7 +155,29 @@ protected:
     }
 
     void AddInetRoute(std::string prefix_str, BgpPeer *peer,
-                      const char *inst = NULL) {
+                      const char *inst = NULL, uint32_t community = 0) {
+        EnqueueInetRoute(prefix_str, peer, inst, community);
+        task_util::WaitForIdle();
+
+        DB *db_a = a_.get()->database();
+        InetTable *table_a = static_cast<InetTable *>(db_a->FindTable(
+                inst ? string(inst) + ".inet.0" : "inet.0"));
+        const Ip4Prefix prefix(Ip4Prefix::FromString(prefix_str));
+        const InetTable::RequestKey key(prefix, peer);
+        TASK_UTIL_ASSERT_TRUE(table_a->Find(&key) != NULL);
+    }
+
+    // Add a path for each of the prefixes and wait for all of them at once.
+    void AddInetRoutes(const vector<string> &prefixes, BgpPeer *peer,
+                       const char *inst) {
+        for (size_t i = 0; i < prefixes.size(); ++i) {
+            EnqueueInetRoute(prefixes[i], peer, inst, 0);
+        }
+        task_util::WaitForIdle();
+    }
+
+    void EnqueueInetRoute(std::string prefix_str, BgpPeer *peer,
+                          const char *inst, uint32_t community) {
         BgpAttrPtr attr_ptr;
 
         // Create a BgpAttrSpec to mimic a eBGP learnt route with Origin,
@@ -177,6 +200,12 @@ protected:
         BgpAttrLocalPref local_pref(100);
         attr_spec.push_back(&local_pref);
 
+        CommunitySpec comm_spec;
+        if (community) {
+            comm_spec.communities.push_back(community);
+            attr_spec.push_back(&comm_spec);
+        }
+
         attr_ptr = a_.get()->attr_db()->Locate(attr_spec);
 
         // Find the inet.0 table in A and B.
@@ -185,11 +214,8 @@ protected:
                 inst ? string(inst) + ".inet.0" : "inet.0"));
         assert(table_a);
 
-        // Create 3 IPv4 prefixes and the corresponding keys.
         const Ip4Prefix prefix(Ip4Prefix::FromString(prefix_str));
 
-        const InetTable::RequestKey key(prefix, peer);
-
         DBRequest req;
 
         // Add prefix
@@ -197,9 +223,6 @@ protected:
         req.key.reset(new InetTable::RequestKey(prefix, peer));
         req.data.reset(new InetTable::RequestData(attr_ptr, 0, 0));
         table_a->Enqueue(&req);
-        task_util::WaitForIdle();
-
-        TASK_UTIL_ASSERT_TRUE(table_a->Find(&key) != NULL);
     }
 
     void DeleteInetRoute(std::string prefix_str, BgpPeer *peer, size_t size,
@@ -227,6 +250,26 @@ protected:
         TASK_UTIL_EXPECT_EQ(size, table_a->Size());
     }
 
+    // Delete the paths for each of the prefixes and wait for all of them at
+    // once.
+    void DeleteInetRoutes(const vector<string> &prefixes, BgpPeer *peer,
+                          size_t size, const char *inst) {
+        DB *db_a = a_.get()->database();
+        InetTable *table_a = static_cast<InetTable *>(db_a->FindTable(
+                inst ? string(inst) + ".inet.0" : "inet.0"));
+        assert(table_a);
+
+        for (size_t i = 0; i < prefixes.size(); ++i) {
+            const Ip4Prefix prefix(Ip4Prefix::FromString(prefixes[i]));
+            DBRequest req;
+            req.oper = DBRequest::DB_ENTRY_DELETE;
+            req.key.reset(new InetTable::RequestKey(prefix, peer));
+            table_a->Enqueue(&req);
+        }
+        task_util::WaitForIdle();
+        TASK_UTIL_EXPECT_EQ(size, table_a->Size());
+    }
+
     void AddInetVpnRoute(std::string prefix_str, BgpPeer *peer) {
         BgpAttrPtr attr_ptr;
 
@@ -345,6 +388,20 @@ protected:
         validate_done_ = true;
     }
 
+    static void SaveShowRouteSandeshResponse(Sandesh *sandesh,
+        vector<string> *prefixes, string *next_batch) {
+        ShowRouteResp *resp = dynamic_cast<ShowRouteResp *>(sandesh);
+        EXPECT_NE((ShowRouteResp *)NULL, resp);
+
+        for (size_t i = 0; i < resp->get_tables().size(); i++) {
+            for (size_t j = 0; j < resp->get_tables()[i].routes.size(); j++) {
+                prefixes->push_back(resp->get_tables()[i].routes[j].prefix);
+            }
+        }
+        *next_batch = resp->get_next_batch();
+        validate_done_ = true;
+    }
+
     static void ValidateShowRouteSandeshRespSubstr(Sandesh *sandesh,
         vector<int> &result, int called_from_line, string substring) {
         ShowRouteResp *resp = dynamic_cast<ShowRouteResp *>(sandesh);
@@ -2017,6 +2074,170 @@ TEST_F(ShowRouteTest3, SimulateClickingNextBatch) {
     }
 }
 
+// Filter routes by source with enough non-matching routes that partitions
+// may have to stop their walks early. Follow next_batch till the end and
+// make sure that each matching route is returned exactly once.
+TEST_F(ShowRouteTest3, FilterSourceWalkLimit) {
+    std::string plen = "/32";
+    in_addr src;
+    int ip1 = 0x01020000;
+    int ip2 = 0x01030000;
+    for (int i = 0; i < 1000; ++i) {
+        src.s_addr = htonl(ip1 | i);
+        string ip = string(inet_ntoa(src)) + plen;
+        AddInetRoute(ip, peers_[0], "red");
+    }
+    for (int i = 0; i < 10; ++i) {
+        src.s_addr = htonl(ip2 | i);
+        string ip = string(inet_ntoa(src)) + plen;
+        AddInetRoute(ip, peers_[1], "red");
+    }
+
+    vector<string> prefixes;
+    string next_batch;
+    ShowRouteReq *show_req = new ShowRouteReq;
+    show_req->set_routing_table("red.inet.0");
+    show_req->set_source(peers_[1]->ToString());
+    Sandesh::set_response_callback(boost::bind(
+        SaveShowRouteSandeshResponse, _1, &prefixes, &next_batch));
+    validate_done_ = false;
+    show_req->HandleRequest();
+    show_req->Release();
+    TASK_UTIL_EXPECT_EQ(true, validate_done_);
+
+    int batches = 1;
+    while (!next_batch.empty()) {
+        EXPECT_NE(string::npos, next_batch.find(peers_[1]->ToString()));
+        ShowRouteReqIterate *show_req_iterate = new ShowRouteReqIterate;
+        show_req_iterate->set_route_info(next_batch);
+        validate_done_ = false;
+        show_req_iterate->HandleRequest();
+        show_req_iterate->Release();
+        TASK_UTIL_EXPECT_EQ(true, validate_done_);
+        ASSERT_LT(++batches, 1000);
+    }
+
+    set<string> prefix_set(prefixes.begin(), prefixes.end());
+    EXPECT_EQ(10, prefixes.size());
+    EXPECT_EQ(10, prefix_set.size());
+    for (int i = 0; i < 10; ++i) {
+        src.s_addr = htonl(ip2 | i);
+        string ip = string(inet_ntoa(src)) + plen;
+        EXPECT_EQ(1, prefix_set.count(ip));
+    }
+
+    for (int i = 9; i >= 0; --i) {
+        src.s_addr = htonl(ip2 | i);
+        string ip = string(inet_ntoa(src)) + plen;
+        DeleteInetRoute(ip, peers_[1], 1000 + i, "red");
+    }
+    for (int i = 999; i >= 0; --i) {
+        src.s_addr = htonl(ip1 | i);
+        string ip = string(inet_ntoa(src)) + plen;
+        DeleteInetRoute(ip, peers_[0], i, "red");
+    }
+}
+
+// Filter routes by community. None of the routes have communities.
+TEST_F(ShowRouteTest3, FilterCommunity) {
+    AddInetRoute("1.2.3.0/24", peers_[0], "red");
+
+    ShowRouteReq *show_req = new ShowRouteReq;
+    vector<int> result;
+    string next_batch = "";
+    Sandesh::set_response_callback(boost::bind(
+        ValidateShowRouteSandeshResponse, _1, result, __LINE__, next_batch));
+    show_req->set_routing_table("red.inet.0");
+    show_req->set_community("64512:100");
+    validate_done_ = false;
+    show_req->HandleRequest();
+    show_req->Release();
+    TASK_UTIL_EXPECT_EQ(true, validate_done_);
+
+    DeleteInetRoute("1.2.3.0/24", peers_[0], 0, "red");
+}
+
+// Filter routes by community. A route matches if any of its paths carries
+// the community.
+TEST_F(ShowRouteTest3, FilterCommunityMatch) {
+    uint32_t comm100 = (64512U << 16) | 100;
+    uint32_t comm200 = (64512U << 16) | 200;
+    AddInetRoute("1.2.3.0/24", peers_[0], "red", comm100);
+    AddInetRoute("1.2.4.0/24", peers_[0], "red");
+    AddInetRoute("1.2.5.0/24", peers_[0], "red", comm200);
+    AddInetRoute("1.2.5.0/24", peers_[1], "red", comm100);
+    AddInetRoute("1.2.6.0/24", peers_[1], "red", comm200);
+
+    vector<string> prefixes;
+    string next_batch;
+    ShowRouteReq *show_req = new ShowRouteReq;
+    show_req->set_routing_table("red.inet.0");
+    show_req->set_community("64512:100");
+    Sandesh::set_response_callback(boost::bind(
+        SaveShowRouteSandeshResponse, _1, &prefixes, &next_batch));
+    validate_done_ = false;
+    show_req->HandleRequest();
+    show_req->Release();
+    TASK_UTIL_EXPECT_EQ(true, validate_done_);
+
+    set<string> prefix_set(prefixes.begin(), prefixes.end());
+    EXPECT_EQ(2, prefixes.size());
+    EXPECT_EQ(1, prefix_set.count("1.2.3.0/24"));
+    EXPECT_EQ(1, prefix_set.count("1.2.5.0/24"));
+    EXPECT_EQ("", next_batch);
+
+    DeleteInetRoute("1.2.6.0/24", peers_[1], 3, "red");
+    DeleteInetRoute("1.2.5.0/24", peers_[1], 3, "red");
+    DeleteInetRoute("1.2.5.0/24", peers_[0], 2, "red");
+    DeleteInetRoute("1.2.4.0/24", peers_[0], 1, "red");
+    DeleteInetRoute("1.2.3.0/24", peers_[0], 0, "red");
+}
+
+// None of the routes match the filter and there are enough of them that at
+// least one partition has more than kUnitTestMaxWalkCount (500) routes. The
+// first batch stops that walk early and returns no routes, but has a
+// next_batch to resume from. Following next_batch eventually finishes.
+TEST_F(ShowRouteTest3, FilterWalkLimitTruncate) {
+    std::string plen = "/32";
+    in_addr src;
+    int ip1 = 0x01020000;
+    vector<string> routes;
+    for (int i = 0; i < 501 * DB::PartitionCount(); ++i) {
+        src.s_addr = htonl(ip1 + i);
+        routes.push_back(string(inet_ntoa(src)) + plen);
+    }
+    AddInetRoutes(routes, peers_[0], "red");
+
+    vector<string> prefixes;
+    string next_batch;
+    ShowRouteReq *show_req = new ShowRouteReq;
+    show_req->set_routing_table("red.inet.0");
+    show_req->set_source(peers_[1]->ToString());
+    Sandesh::set_response_callback(boost::bind(
+        SaveShowRouteSandeshResponse, _1, &prefixes, &next_batch));
+    validate_done_ = false;
+    show_req->HandleRequest();
+    show_req->Release();
+    TASK_UTIL_EXPECT_EQ(true, validate_done_);
+    EXPECT_TRUE(prefixes.empty());
+    EXPECT_NE("", next_batch);
+
+    int batches = 1;
+    while (!next_batch.empty()) {
+        ShowRouteReqIterate *show_req_iterate = new ShowRouteReqIterate;
+        show_req_iterate->set_route_info(next_batch);
+        validate_done_ = false;
+        show_req_iterate->HandleRequest();
+        show_req_iterate->Release();
+        TASK_UTIL_EXPECT_EQ(true, validate_done_);
+        ASSERT_LT(++batches, 1000);
+    }
+    EXPECT_LT(1, batches);
+    EXPECT_TRUE(prefixes.empty());
+
+    DeleteInetRoutes(routes, peers_[0], 0, "red");
+}
+
 class ShowRouteVrfTest : public ShowRouteTest2 {
 };
 
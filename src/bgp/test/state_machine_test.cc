@@ -46,6 +46,10 @@ public:
         return true;
     }
 
+    virtual bool Send(const SharedBufferList &buffers, size_t *sent) {
+        return true;
+    }
+
     virtual bool Connected(Endpoint remote) {
         state_ = BgpSessionMock::ESTABLISHED;
         EventObserver obs = observer();
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "bgp/xmpp_unicast_item_decoder.h"
+
+#include <pugixml/pugixml.hpp>
+
+#include <fstream>
+#include <string>
+
+#include "base/logging.h"
+#include "base/string_util.h"
+#include "schema/xmpp_unicast_types.h"
+#include "testing/gunit.h"
+
+using pugi::xml_document;
+using pugi::xml_node;
+using std::ifstream;
+using std::istreambuf_iterator;
+using std::string;
+
+static const char *kItem =
+    "<item>"
+    "  <entry xmlns='http://ietf.org/protocol/bgpvpn'>"
+    "    <nlri><af>1</af><safi>1</safi><address>10.1.1.1/32</address></nlri>"
+    "    <next-hops>"
+    "      <next-hop>"
+    "        <af>1</af><address>192.168.1.1</address><label>10000</label>"
+    "        <tunnel-encapsulation-list>"
+    "          <tunnel-encapsulation>gre</tunnel-encapsulation>"
+    "          <tunnel-encapsulation>udp</tunnel-encapsulation>"
+    "        </tunnel-encapsulation-list>"
+    "        <virtual-network>blue</virtual-network>"
+    "      </next-hop>"
+    "      <next-hop>"
+    "        <af>1</af><address>192.168.1.2</address><label>20000</label>"
+    "      </next-hop>"
+    "    </next-hops>"
+    "    <version>1</version>"
+    "    <virtual-network>blue</virtual-network>"
+    "    <sequence-number>7</sequence-number>"
+    "    <security-group-list>"
+    "      <security-group>8000001</security-group>"
+    "      <security-group>8000002</security-group>"
+    "    </security-group-list>"
+    "    <community-tag-list>"
+    "      <community-tag>no-export</community-tag>"
+    "    </community-tag-list>"
+    "    <local-preference>200</local-preference>"
+    "    <med>300</med>"
+    "    <load-balance>"
+    "      <load-balance-decision>source-bias</load-balance-decision>"
+    "    </load-balance>"
+    "  </entry>"
+    "</item>";
+
+class XmppUnicastItemDecoderTest : public ::testing::Test {
+protected:
+    xml_node Load(const string &data) {
+        doc_.reset();
+        doc_.load_buffer(data.data(), data.size());
+        return doc_.child("item");
+    }
+
+    xml_node LoadFile(const string &filename) {
+        ifstream file(filename.c_str());
+        string content((istreambuf_iterator<char>(file)),
+                       istreambuf_iterator<char>());
+        return Load(content);
+    }
+
+    // Verify that the decoder and the autogen code agree on the item.
+    void VerifyAutogen(const xml_node &node) {
+        autogen::ItemType item;
+        item.Clear();
+        bool success = item.XmlParse(node);
+        EXPECT_EQ(success, decoder_.Decode(node));
+        if (!success)
+            return;
+
+        EXPECT_EQ(item.entry.nlri.af, decoder_.af());
+        EXPECT_EQ(item.entry.nlri.safi, decoder_.safi());
+        EXPECT_EQ(item.entry.nlri.address, decoder_.address());
+        ASSERT_EQ(item.entry.next_hops.next_hop.size(),
+                  decoder_.next_hop_count());
+        for (size_t idx = 0; idx < decoder_.next_hop_count(); ++idx) {
+            const autogen::NextHopType &nh = item.entry.next_hops.next_hop[idx];
+            const XmppUnicastItemDecoder::NextHop &dnh =
+                decoder_.next_hop(idx);
+            EXPECT_EQ(nh.af, dnh.af);
+            EXPECT_EQ(nh.address, dnh.address);
+            EXPECT_EQ(nh.label, dnh.label);
+            ASSERT_EQ(nh.tunnel_encapsulation_list.tunnel_encapsulation.size(),
+                      dnh.tunnel_encapsulations.size());
+            for (size_t eidx = 0; eidx < dnh.tunnel_encapsulations.size();
+                 ++eidx) {
+                EXPECT_EQ(
+                    nh.tunnel_encapsulation_list.tunnel_encapsulation[eidx],
+                    dnh.tunnel_encapsulations[eidx]);
+            }
+        }
+        EXPECT_EQ(item.entry.sequence_number, decoder_.sequence_number());
+        EXPECT_TRUE(item.entry.security_group_list.security_group ==
+                    decoder_.security_groups());
+        ASSERT_EQ(item.entry.community_tag_list.community_tag.size(),
+                  decoder_.community_tags().size());
+        for (size_t idx = 0; idx < decoder_.community_tags().size(); ++idx) {
+            EXPECT_EQ(item.entry.community_tag_list.community_tag[idx],
+                      decoder_.community_tags()[idx]);
+        }
+        EXPECT_EQ(item.entry.local_preference, decoder_.local_preference());
+        EXPECT_EQ(item.entry.med, decoder_.med());
+        EXPECT_TRUE(LoadBalance(item.entry.load_balance) ==
+                    decoder_.load_balance());
+    }
+
+    xml_document doc_;
+    XmppUnicastItemDecoder decoder_;
+};
+
+TEST_F(XmppUnicastItemDecoderTest, Basic) {
+    xml_node node = Load(kItem);
+    EXPECT_TRUE(decoder_.Decode(node));
+    EXPECT_EQ(1, decoder_.af());
+    EXPECT_EQ(1, decoder_.safi());
+    EXPECT_STREQ("10.1.1.1/32", decoder_.address());
+    ASSERT_EQ(2U, decoder_.next_hop_count());
+    EXPECT_STREQ("192.168.1.1", decoder_.next_hop(0).address);
+    EXPECT_EQ(10000, decoder_.next_hop(0).label);
+    ASSERT_EQ(2U, decoder_.next_hop(0).tunnel_encapsulations.size());
+    EXPECT_STREQ("gre", decoder_.next_hop(0).tunnel_encapsulations[0]);
+    EXPECT_STREQ("udp", decoder_.next_hop(0).tunnel_encapsulations[1]);
+    EXPECT_STREQ("192.168.1.2", decoder_.next_hop(1).address);
+    EXPECT_EQ(20000, decoder_.next_hop(1).label);
+    EXPECT_TRUE(decoder_.next_hop(1).tunnel_encapsulations.empty());
+    EXPECT_EQ(7, decoder_.sequence_number());
+    ASSERT_EQ(2U, decoder_.security_groups().size());
+    EXPECT_EQ(8000001, decoder_.security_groups()[0]);
+    EXPECT_EQ(8000002, decoder_.security_groups()[1]);
+    ASSERT_EQ(1U, decoder_.community_tags().size());
+    EXPECT_STREQ("no-export", decoder_.community_tags()[0]);
+    EXPECT_EQ(200, decoder_.local_preference());
+    EXPECT_EQ(300, decoder_.med());
+    EXPECT_FALSE(decoder_.load_balance().IsDefault());
+    VerifyAutogen(node);
+}
+
+//
+// Values from a previous item must not leak into the next one.
+//
+TEST_F(XmppUnicastItemDecoderTest, Reuse) {
+    EXPECT_TRUE(decoder_.Decode(Load(kItem)));
+    xml_node node = Load(
+        "<item><entry>"
+        "<nlri><af>1</af><address>10.1.1.2/32</address></nlri>"
+        "<next-hops><next-hop><address>192.168.1.3</address></next-hop>"
+        "</next-hops>"
+        "</entry></item>");
+    EXPECT_TRUE(decoder_.Decode(node));
+    EXPECT_EQ(0, decoder_.safi());
+    EXPECT_STREQ("10.1.1.2/32", decoder_.address());
+    ASSERT_EQ(1U, decoder_.next_hop_count());
+    EXPECT_STREQ("192.168.1.3", decoder_.next_hop(0).address);
+    EXPECT_EQ(0, decoder_.next_hop(0).af);
+    EXPECT_EQ(0, decoder_.next_hop(0).label);
+    EXPECT_TRUE(decoder_.next_hop(0).tunnel_encapsulations.empty());
+    EXPECT_EQ(0, decoder_.sequence_number());
+    EXPECT_TRUE(decoder_.security_groups().empty());
+    EXPECT_TRUE(decoder_.community_tags().empty());
+    EXPECT_EQ(0, decoder_.local_preference());
+    EXPECT_EQ(0, decoder_.med());
+    EXPECT_TRUE(decoder_.load_balance().IsDefault());
+    VerifyAutogen(node);
+}
+
+TEST_F(XmppUnicastItemDecoderTest, BadInteger) {
+    const char *items[] = {
+        "<item><entry><version>ZZZ</version></entry></item>",
+        "<item><entry><nlri><af>one</af></nlri></entry></item>",
+        "<item><entry><next-hops><next-hop><label>1x</label></next-hop>"
+        "</next-hops></entry></item>",
+        "<item><entry><security-group-list><security-group>sg"
+        "</security-group></security-group-list></entry></item>",
+        "<item><entry><med>-</med></entry></item>",
+    };
+    for (size_t idx = 0; idx < sizeof(items) / sizeof(items[0]); ++idx) {
+        xml_node node = Load(items[idx]);
+        EXPECT_FALSE(decoder_.Decode(node)) << items[idx];
+        VerifyAutogen(node);
+    }
+}
+
+//
+// The decoder accepts and rejects the same items in the test data as the
+// autogen code.
+//
+TEST_F(XmppUnicastItemDecoderTest, TestData) {
+    for (int idx = 1; idx <= 6; ++idx) {
+        string suffix = integerToString(idx) + ".xml";
+        VerifyAutogen(LoadFile(
+            "controller/src/bgp/testdata/bad_inet_item_" + suffix));
+        VerifyAutogen(LoadFile(
+            "controller/src/bgp/testdata/bad_inet6_item_" + suffix));
+    }
+}
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "bgp/xmpp_unicast_item_decoder.h"
+
+#include <string.h>
+
+#include <pugixml/pugixml.hpp>
+
+#include "base/autogen_util.h"
+#include "schema/xmpp_unicast_types.h"
+
+using pugi::xml_node;
+
+XmppUnicastItemDecoder::NextHop::NextHop() {
+    Clear();
+}
+
+void XmppUnicastItemDecoder::NextHop::Clear() {
+    af = 0;
+    address = "";
+    label = 0;
+    tunnel_encapsulations.clear();
+}
+
+XmppUnicastItemDecoder::XmppUnicastItemDecoder() {
+    Clear();
+}
+
+//
+// Reset all values. The vectors keep their capacity, and so do the tunnel
+// encapsulation lists of the next hops that are not in use.
+//
+void XmppUnicastItemDecoder::Clear() {
+    af_ = 0;
+    safi_ = 0;
+    address_ = "";
+    next_hop_count_ = 0;
+    sequence_number_ = 0;
+    security_groups_.clear();
+    community_tags_.clear();
+    local_preference_ = 0;
+    med_ = 0;
+    load_balance_ = LoadBalance();
+}
+
+bool XmppUnicastItemDecoder::Decode(const xml_node &item) {
+    Clear();
+    for (xml_node node = item.first_child(); node;
+         node = node.next_sibling()) {
+        if (strcmp(node.name(), "entry") == 0) {
+            if (!DecodeEntry(node))
+                return false;
+        }
+    }
+    return true;
+}
+
+bool XmppUnicastItemDecoder::DecodeEntry(const xml_node &entry) {
+    for (xml_node node = entry.first_child(); node;
+         node = node.next_sibling()) {
+        const char *name = node.name();
+        bool success = true;
+        if (strcmp(name, "nlri") == 0) {
+            success = DecodeNlri(node);
+        } else if (strcmp(name, "next-hops") == 0) {
+            success = DecodeNextHops(node);
+        } else if (strcmp(name, "version") == 0) {
+            int version;
+            success = autogen::ParseInteger(node, &version);
+        } else if (strcmp(name, "sequence-number") == 0) {
+            success = autogen::ParseInteger(node, &sequence_number_);
+        } else if (strcmp(name, "security-group-list") == 0) {
+            success = DecodeSecurityGroups(node);
+        } else if (strcmp(name, "community-tag-list") == 0) {
+            DecodeCommunityTags(node);
+        } else if (strcmp(name, "local-preference") == 0) {
+            success = autogen::ParseInteger(node, &local_preference_);
+        } else if (strcmp(name, "med") == 0) {
+            success = autogen::ParseInteger(node, &med_);
+        } else if (strcmp(name, "load-balance") == 0) {
+            success = DecodeLoadBalance(node);
+        }
+        if (!success)
+            return false;
+    }
+    return true;
+}
+
+bool XmppUnicastItemDecoder::DecodeNlri(const xml_node &nlri) {
+    for (xml_node node = nlri.first_child(); node;
+         node = node.next_sibling()) {
+        const char *name = node.name();
+        if (strcmp(name, "af") == 0) {
+            if (!autogen::ParseInteger(node, &af_))
+                return false;
+        } else if (strcmp(name, "safi") == 0) {
+            if (!autogen::ParseInteger(node, &safi_))
+                return false;
+        } else if (strcmp(name, "address") == 0) {
+            address_ = node.child_value();
+        }
+    }
+    return true;
+}
+
+bool XmppUnicastItemDecoder::DecodeNextHops(const xml_node &next_hops) {
+    for (xml_node node = next_hops.first_child(); node;
+         node = node.next_sibling()) {
+        if (strcmp(node.name(), "next-hop") != 0)
+            continue;
+        if (next_hop_count_ == next_hops_.size())
+            next_hops_.push_back(NextHop());
+        NextHop *next_hop = &next_hops_[next_hop_count_++];
+        next_hop->Clear();
+        if (!DecodeNextHop(node, next_hop))
+            return false;
+    }
+    return true;
+}
+
+bool XmppUnicastItemDecoder::DecodeNextHop(const xml_node &next_hop,
+    NextHop *nh) {
+    for (xml_node node = next_hop.first_child(); node;
+         node = node.next_sibling()) {
+        const char *name = node.name();
+        if (strcmp(name, "af") == 0) {
+            if (!autogen::ParseInteger(node, &nh->af))
+                return false;
+        } else if (strcmp(name, "address") == 0) {
+            nh->address = node.child_value();
+        } else if (strcmp(name, "label") == 0) {
+            if (!autogen::ParseInteger(node, &nh->label))
+                return false;
+        } else if (strcmp(name, "tunnel-encapsulation-list") == 0) {
+            for (xml_node encap = node.first_child(); encap;
+                 encap = encap.next_sibling()) {
+                if (strcmp(encap.name(), "tunnel-encapsulation") == 0)
+                    nh->tunnel_encapsulations.push_back(encap.child_value());
+            }
+        }
+    }
+    return true;
+}
+
+bool XmppUnicastItemDecoder::DecodeSecurityGroups(const xml_node &list) {
+    for (xml_node node = list.first_child(); node;
+         node = node.next_sibling()) {
+        if (strcmp(node.name(), "security-group") != 0)
+            continue;
+        int sg;
+        if (!autogen::ParseInteger(node, &sg))
+            return false;
+        security_groups_.push_back(sg);
+    }
+    return true;
+}
+
+void XmppUnicastItemDecoder::DecodeCommunityTags(const xml_node &list) {
+    for (xml_node node = list.first_child(); node;
+         node = node.next_sibling()) {
+        if (strcmp(node.name(), "community-tag") == 0)
+            community_tags_.push_back(node.child_value());
+    }
+}
+
+//
+// The load balance element is rare and small, so it's parsed with the
+// autogen code and converted to the extended community right away.
+//
+bool XmppUnicastItemDecoder::DecodeLoadBalance(const xml_node &node) {
+    autogen::LoadBalanceType lb_type;
+    lb_type.Clear();
+    if (!lb_type.XmlParse(node))
+        return false;
+    load_balance_ = LoadBalance(lb_type);
+    return true;
+}
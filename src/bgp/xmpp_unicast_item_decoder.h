@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef SRC_BGP_XMPP_UNICAST_ITEM_DECODER_H_
+#define SRC_BGP_XMPP_UNICAST_ITEM_DECODER_H_
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "base/util.h"
+#include "bgp/extended-community/load_balance.h"
+
+namespace pugi {
+class xml_node;
+}
+
+//
+// Decoder for the <item> in an inet or inet6 unicast route publish or
+// retract message from an agent.
+//
+// The item is decoded with a single pass over the children of each element
+// in the document built by XmppProto::Decode. String values are not copied;
+// the decoder keeps pointers to the text in the document and hence must not
+// be used after the document is gone. Integer values are validated the same
+// way as in the autogen ItemType::XmlParse, so an item is rejected by Decode
+// iff it would have been rejected by ItemType::XmlParse.
+//
+// The decoder is meant to be reused for all items received on a channel.
+// The storage for the next hop and list values is kept across calls, so a
+// steady stream of similar items does not need any memory allocation.
+//
+class XmppUnicastItemDecoder {
+public:
+    struct NextHop {
+        NextHop();
+        void Clear();
+
+        int af;
+        const char *address;
+        int label;
+        std::vector<const char *> tunnel_encapsulations;
+    };
+
+    XmppUnicastItemDecoder();
+
+    bool Decode(const pugi::xml_node &item);
+
+    int af() const { return af_; }
+    int safi() const { return safi_; }
+    const char *address() const { return address_; }
+    size_t next_hop_count() const { return next_hop_count_; }
+    const NextHop &next_hop(size_t idx) const { return next_hops_[idx]; }
+    int sequence_number() const { return sequence_number_; }
+    const std::vector<int> &security_groups() const {
+        return security_groups_;
+    }
+    const std::vector<const char *> &community_tags() const {
+        return community_tags_;
+    }
+    int local_preference() const { return local_preference_; }
+    int med() const { return med_; }
+    const LoadBalance &load_balance() const { return load_balance_; }
+
+private:
+    void Clear();
+    bool DecodeEntry(const pugi::xml_node &entry);
+    bool DecodeNlri(const pugi::xml_node &nlri);
+    bool DecodeNextHops(const pugi::xml_node &next_hops);
+    bool DecodeNextHop(const pugi::xml_node &node, NextHop *next_hop);
+    bool DecodeSecurityGroups(const pugi::xml_node &list);
+    void DecodeCommunityTags(const pugi::xml_node &list);
+    bool DecodeLoadBalance(const pugi::xml_node &node);
+
+    int af_;
+    int safi_;
+    const char *address_;
+    size_t next_hop_count_;
+    std::vector<NextHop> next_hops_;
+    int sequence_number_;
+    std::vector<int> security_groups_;
+    std::vector<const char *> community_tags_;
+    int local_preference_;
+    int med_;
+    LoadBalance load_balance_;
+
+    DISALLOW_COPY_AND_ASSIGN(XmppUnicastItemDecoder);
+};
+
+#endif  // SRC_BGP_XMPP_UNICAST_ITEM_DECODER_H_
@@ -30,6 +30,7 @@
 #include "bgp/bgp_xmpp_channel.h"
 #include "bgp/routing-instance/routing_instance.h"
 #include "bgp/routing-instance/rtarget_group_mgr.h"
+#include "bgp/scheduling_group.h"
 #include "control-node/buildinfo.h"
 #include "control-node/control_node.h"
 #include "control-node/options.h"
@@ -326,6 +327,10 @@ int main(int argc, char *argv[]) {
         options.task_track_run_time());
     ControlNode::SetDefaultSchedulingPolicy();
 
+    // Run the socket IO for TCP and SSL sessions on a pool of threads.
+    if (options.io_service_threads())
+        evm.CreateIoServicePool(options.io_service_threads());
+
     /* If Sandesh initialization is not being done via discovery we need to
      * initialize here. We need to do sandesh initialization here for cases
      * (i) When both Discovery and Collectors are configured.
@@ -386,12 +391,20 @@ int main(int argc, char *argv[]) {
     sandesh_context.set_test_mode(ControlNode::GetTestMode());
     sandesh_context.bgp_server = bgp_server.get();
     bgp_server->set_gr_helper_enable(options.gr_helper_bgp_enable());
+    bgp_server->set_extended_message_enable(
+        options.bgp_extended_message_enable());
+    bgp_server->set_peer_path_index_enable(
+        !options.bgp_peer_path_index_disable());
+    bgp_server->scheduling_group_manager()->set_send_shard_count(
+        options.bgp_send_shard_count());
     bgp_server->set_end_of_rib_timeout(options.xmpp_end_of_rib_timeout());
 
     DB config_db(TaskScheduler::GetInstance()->GetTaskId("db::IFMapTable"));
     DBGraph config_graph;
     IFMapServer ifmap_server(&config_db, &config_graph, evm.io_service());
     IFMap_Initialize(&ifmap_server);
+    ifmap_server.set_initial_sync_enabled(
+        options.ifmap_initial_sync_enable());
 
     BgpIfmapConfigManager *config_manager =
             static_cast<BgpIfmapConfigManager *>(bgp_server->config_manager());
@@ -76,9 +76,18 @@ void Options::Initialize(EventManager &evm,
              "BGP Configuration file")
         ("DEFAULT.bgp_end_of_rib_timeout", opt::value<uint32_t>()->default_value(30),
              "BGP end of rib timeout")
+        ("DEFAULT.bgp_extended_message_enable",
+            opt::bool_switch(&bgp_extended_message_enable_),
+            "Advertise the BGP Extended Message capability to BGP peers")
+        ("DEFAULT.bgp_peer_path_index_disable",
+            opt::bool_switch(&bgp_peer_path_index_disable_),
+            "Disable the per peer path index used for BGP peer walks")
         ("DEFAULT.bgp_port",
              opt::value<uint16_t>()->default_value(default_bgp_port),
              "BGP listener port")
+        ("DEFAULT.bgp_send_shard_count",
+             opt::value<uint32_t>()->default_value(1),
+             "Number of send shards per BGP scheduling group (1 to disable)")
         ("DEFAULT.collectors",
            opt::value<vector<string> >()->default_value(
                default_collector_server_list_, "127.0.0.1:8086"),
@@ -98,6 +107,12 @@ void Options::Initialize(EventManager &evm,
         ("DEFAULT.http_server_port",
              opt::value<uint16_t>()->default_value(default_http_server_port),
              "Sandesh HTTP listener port")
+        ("DEFAULT.ifmap_initial_sync_enable",
+            opt::bool_switch(&ifmap_initial_sync_enable_),
+            "Send the initial config of new agents as a snapshot")
+        ("DEFAULT.io_service_threads",
+             opt::value<uint32_t>()->default_value(0),
+             "Number of threads for TCP/SSL session IO (0 to use main thread)")
 
         ("DEFAULT.log_category",
              opt::value<string>()->default_value(log_category_),
@@ -253,6 +268,8 @@ bool Options::Process(int argc, char *argv[],
     // Retrieve the options.
     GetOptValue<string>(var_map, bgp_config_file_, "DEFAULT.bgp_config_file");
     GetOptValue<uint16_t>(var_map, bgp_port_, "DEFAULT.bgp_port");
+    GetOptValue<uint32_t>(var_map, bgp_send_shard_count_,
+                          "DEFAULT.bgp_send_shard_count");
     GetOptValue< vector<string> >(var_map, collector_server_list_,
                                   "DEFAULT.collectors");
     string error_msg;
@@ -277,6 +294,8 @@ bool Options::Process(int argc, char *argv[],
 
     GetOptValue<uint16_t>(var_map, http_server_port_,
                           "DEFAULT.http_server_port");
+    GetOptValue<uint32_t>(var_map, io_service_threads_,
+                          "DEFAULT.io_service_threads");
 
     GetOptValue<string>(var_map, log_category_, "DEFAULT.log_category");
     GetOptValue<string>(var_map, log_file_, "DEFAULT.log_file");
@@ -23,6 +23,7 @@ public:
     std::string hostname() const { return hostname_; }
     std::string host_ip() const { return host_ip_; }
     uint16_t http_server_port() const { return http_server_port_; }
+    uint32_t io_service_threads() const { return io_service_threads_; }
     std::string log_category() const { return log_category_; }
     bool log_disable() const { return log_disable_; }
     std::string log_file() const { return log_file_; }
@@ -67,6 +68,16 @@ public:
     bool optimize_snat() const { return optimize_snat_; }
     bool gr_helper_bgp_enable() const { return gr_helper_bgp_enable_; }
     bool gr_helper_xmpp_enable() const { return gr_helper_xmpp_enable_; }
+    bool bgp_extended_message_enable() const {
+        return bgp_extended_message_enable_;
+    }
+    bool bgp_peer_path_index_disable() const {
+        return bgp_peer_path_index_disable_;
+    }
+    uint32_t bgp_send_shard_count() const { return bgp_send_shard_count_; }
+    bool ifmap_initial_sync_enable() const {
+        return ifmap_initial_sync_enable_;
+    }
     uint32_t bgp_end_of_rib_timeout() const { return bgp_end_of_rib_timeout_; }
     uint32_t xmpp_end_of_rib_timeout() const {
         return xmpp_end_of_rib_timeout_;
@@ -100,6 +111,7 @@ private:
     std::string hostname_;
     std::string host_ip_;
     uint16_t http_server_port_;
+    uint32_t io_service_threads_;
     std::string log_category_;
     bool log_disable_;
     std::string log_file_;
@@ -124,6 +136,10 @@ private:
     uint32_t sandesh_ratelimit_;
     bool gr_helper_bgp_enable_;
     bool gr_helper_xmpp_enable_;
+    bool bgp_extended_message_enable_;
+    bool bgp_peer_path_index_disable_;
+    uint32_t bgp_send_shard_count_;
+    bool ifmap_initial_sync_enable_;
     uint32_t bgp_end_of_rib_timeout_;
     uint32_t xmpp_end_of_rib_timeout_;
     std::vector<std::string> default_collector_server_list_;
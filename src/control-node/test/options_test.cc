@@ -64,6 +64,7 @@ TEST_F(OptionsTest, NoArguments) {
     EXPECT_EQ(options_.hostname(), hostname_);
     EXPECT_EQ(options_.host_ip(), host_ip_);
     EXPECT_EQ(options_.http_server_port(), default_http_server_port);
+    EXPECT_EQ(options_.io_service_threads(), 0);
     EXPECT_EQ(options_.log_category(), "");
     EXPECT_EQ(options_.log_disable(), false);
     EXPECT_EQ(options_.log_file(), "<stdout>");
@@ -86,6 +87,10 @@ TEST_F(OptionsTest, NoArguments) {
               g_sandesh_constants.DEFAULT_SANDESH_SEND_RATELIMIT);
     EXPECT_EQ(options_.gr_helper_bgp_enable(), false);
     EXPECT_EQ(options_.gr_helper_xmpp_enable(), false);
+    EXPECT_EQ(options_.bgp_extended_message_enable(), false);
+    EXPECT_EQ(options_.bgp_peer_path_index_disable(), false);
+    EXPECT_EQ(options_.bgp_send_shard_count(), 1);
+    EXPECT_EQ(options_.ifmap_initial_sync_enable(), false);
 }
 
 TEST_F(OptionsTest, DefaultConfFile) {
@@ -238,6 +243,7 @@ TEST_F(OptionsTest, CustomConfigFile) {
         "optimize_snat=1\n"
         "gr_helper_bgp_enable=1\n"
         "gr_helper_xmpp_enable=1\n"
+        "ifmap_initial_sync_enable=1\n"
         "xmpp_auth_enable=true\n"
         "bgp_end_of_rib_timeout=200\n"
         "xmpp_end_of_rib_timeout=100\n"
@@ -310,6 +316,7 @@ TEST_F(OptionsTest, CustomConfigFile) {
     EXPECT_EQ(options_.optimize_snat(), true);
     EXPECT_EQ(options_.gr_helper_bgp_enable(), true);
     EXPECT_EQ(options_.gr_helper_xmpp_enable(), true);
+    EXPECT_EQ(options_.ifmap_initial_sync_enable(), true);
     EXPECT_EQ(options_.bgp_end_of_rib_timeout(), 200);
     EXPECT_EQ(options_.xmpp_end_of_rib_timeout(), 100);
     EXPECT_EQ(options_.xmpp_auth_enabled(), true);
@@ -622,8 +622,10 @@ int IFMapChannel::ReadPollResponse() {
         }
 
         // Manage timers.
+        bool search_result =
+            (reply_str.find("searchResult") != string::npos);
         if (start_stale_entries_cleanup()) {
-            if (reply_str.find("searchResult") != string::npos) {
+            if (search_result) {
                 // If this is a reconnection, keep re-arming the stale entries
                 // cleanup timer as long as we receive searchResults.
                 StartStaleEntriesCleanupTimer();
@@ -634,7 +636,7 @@ int IFMapChannel::ReadPollResponse() {
             }
         }
         if (!end_of_rib_computed()) {
-            if (reply_str.find("searchResult") != string::npos) {
+            if (search_result) {
                 // When the daemon is coming up, as long as we are receiving
                 // searchResults, we have not received the entire db. Keep
                 // re-arming the EOR timer as long as we receive searchResults.
@@ -646,13 +648,13 @@ int IFMapChannel::ReadPollResponse() {
             }
         }
 
-        // Send the message to the parser for further processing.
-        string poll_string = reply_str.substr(pos);
+        // Send the message to the parser for further processing. The parser
+        // works on the response in place, without another copy of it.
         increment_recv_msg_cnt();
         bool success = true;
         if (manager_->pollreadcb()) {
-            success = (manager_->pollreadcb())(poll_string.c_str(),
-                           poll_string.length(), sequence_number_);
+            success = (manager_->pollreadcb())(reply_str.c_str() + pos,
+                           reply_str.size() - pos, sequence_number_);
         }
         response_state_ = NONE;
         if (success) {
@@ -38,6 +38,10 @@ public:
     uint64_t delete_links_sent() const { return delete_links_sent_; }
     bool send_is_blocked() const { return send_is_blocked_; }
     uint64_t created_at() const { return created_at_; }
+    // Time taken to send the initial snapshot of the config to the client,
+    // 0 if the snapshot is not complete.
+    uint64_t config_sync_usecs() const { return config_sync_usecs_; }
+    uint64_t config_sync_objects() const { return config_sync_objects_; }
 
     void incr_msgs_sent() { ++msgs_sent_; }
     void incr_msgs_blocked() { ++msgs_blocked_; }
@@ -47,6 +51,10 @@ public:
     void incr_update_links_sent() { ++update_links_sent_; }
     void incr_delete_links_sent() { ++delete_links_sent_; }
     void set_send_is_blocked(bool is_blocked) { send_is_blocked_ = is_blocked; }
+    void set_config_sync(uint64_t usecs, uint64_t objects) {
+        config_sync_usecs_ = usecs;
+        config_sync_objects_ = objects;
+    }
 
     void Initialize(IFMapExporter *exporter, int index);
 
@@ -88,6 +96,8 @@ private:
     VmMap vm_map_;
     std::string name_;
     uint64_t created_at_;
+    uint64_t config_sync_usecs_;
+    uint64_t config_sync_objects_;
 };
 
 #endif
@@ -4,7 +4,9 @@
 
 #include "ifmap/ifmap_encoder.h"
 
+#include <stdio.h>
 #include <sstream>
+#include "base/time_util.h"
 #include "ifmap/ifmap_link.h"
 #include "ifmap/ifmap_object.h"
 #include "ifmap/ifmap_update.h"
@@ -12,90 +14,195 @@
 using namespace pugi;
 using namespace std;
 
-IFMapMessage::IFMapMessage() : op_type_(NONE), node_count_(0),
-    objects_per_message_(kObjectsPerMessage) {
-    // init empty document
-    Open();
+// Fragments are printed at the depth of the children of the op element:
+// iq/config/update|delete.
+static const unsigned int kFragmentDepth = 3;
+
+// Escape an attribute value the same way pugi does when saving a document.
+static void AppendEscapedAttribute(string *str, const string &value) {
+    for (string::const_iterator it = value.begin(); it != value.end(); ++it) {
+        switch (*it) {
+        case '&':
+            *str += "&amp;";
+            break;
+        case '<':
+            *str += "&lt;";
+            break;
+        case '>':
+            *str += "&gt;";
+            break;
+        case '"':
+            *str += "&quot;";
+            break;
+        default:
+            if (static_cast<unsigned char>(*it) < 32) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "&#%u;",
+                         static_cast<unsigned char>(*it));
+                *str += buf;
+            } else {
+                *str += *it;
+            }
+            break;
+        }
+    }
+}
+
+const char *IFMapMessage::OpStartTag(Op op) {
+    return (op == UPDATE) ? "\t\t<update>\n" : "\t\t<delete>\n";
+}
+
+const char *IFMapMessage::OpEndTag(Op op) {
+    return (op == UPDATE) ? "\t\t</update>\n" : "\t\t</delete>\n";
 }
 
-void IFMapMessage::Open() {
-    xml_node iq = doc_.append_child("iq");
-    // set iq (type, from, to) attributes
-    iq.append_attribute("type") = "set";
-    iq.append_attribute("from") = "network-control@contrailsystems.com"; 
-    iq.append_attribute("to") = "";
-    config_ = iq.append_child("config");
+IFMapMessage::IFMapMessage() : op_type_(NONE), node_count_(0),
+    fragment_count_(0), objects_per_message_(kObjectsPerMessage),
+    fragments_encoded_(0), fragments_reused_(0), encode_usecs_(0) {
 }
 
+// Build the message for the current receiver. The body is shared by all the
+// receivers, so this is a copy rather than a serialization of the document.
 void IFMapMessage::Close() {
-    ostringstream oss;
-    doc_.save(oss);
-    str_ = oss.str();
+    str_.clear();
+    str_.reserve(body_.size() + 256);
+    str_ += "<?xml version=\"1.0\"?>\n"
+            "<iq type=\"set\" from=\"network-control@contrailsystems.com\""
+            " to=\"";
+    AppendEscapedAttribute(&str_, receiver_);
+    str_ += "\">\n";
+    if (body_.empty()) {
+        str_ += "\t<config />\n";
+    } else {
+        str_ += "\t<config>\n";
+        str_ += body_;
+        str_ += OpEndTag(op_type_);
+        str_ += "\t</config>\n";
+    }
+    str_ += "</iq>\n";
 }
 
 void IFMapMessage::SetReceiverInMsg(const std::string &cli_identifier) {
-    xml_node iq = doc_.child("iq");
-    assert(iq);
-    xml_attribute iqattr = iq.attribute("to");
-    assert(iqattr);
-    std::string str(cli_identifier);
-    str += "/config";
-    iqattr.set_value(str.c_str());
+    receiver_ = cli_identifier;
+    receiver_ += "/config";
 }
 
 void IFMapMessage::SetObjectsPerMessage(int num) {
     objects_per_message_ = num;
 }
 
-void IFMapMessage::EncodeUpdate(const IFMapUpdate *update) {
-    // update is either of type UPDATE OR DELETE
-    if (update->IsUpdate()) {
-        if (op_type_ != UPDATE) {
-            op_node_ = config_.append_child("update");
-            op_type_ = UPDATE;
-        }
-        if (update->data().type == IFMapObjectPtr::NODE) {
-            EncodeNode(update);
-        } else if (update->data().type == IFMapObjectPtr::LINK) {
-            EncodeLink(update);
-        } else {
-            assert(0);
-        }
-    } else {
-        if (op_type_ != DEL) {
-            op_node_ = config_.append_child("delete");
-            op_type_ = DEL;
-        }
-        if (update->data().type == IFMapObjectPtr::NODE) {
-            EncodeNode(update);
-        } else if (update->data().type == IFMapObjectPtr::LINK) {
-            EncodeLink(update);
-        } else {
-            assert(0);
+void IFMapMessage::SetOpType(Op op_type) {
+    if (op_type_ != op_type) {
+        if (op_type_ != NONE) {
+            body_ += OpEndTag(op_type_);
         }
+        body_ += OpStartTag(op_type);
+        op_type_ = op_type;
+    }
+}
+
+void IFMapMessage::AppendFragment(const string &fragment, bool is_link) {
+    body_ += fragment;
+    fragment_count_++;
+
+    // Links count twice towards the size of the message.
+    if (is_link) {
+        node_count_++;
     }
     node_count_++;
 }
 
-void IFMapMessage::EncodeNode(const IFMapUpdate *update) {
+void IFMapMessage::EncodeUpdate(IFMapUpdate *update) {
+    // update is either of type UPDATE OR DELETE
+    SetOpType(update->IsUpdate() ? UPDATE : DEL);
+
+    if (update->fragment()) {
+        fragments_reused_++;
+    } else {
+        EncodeFragment(update);
+    }
+    AppendFragment(*update->fragment(), update->IsLink());
+}
+
+void IFMapMessage::EncodeNodeUpdate(IFMapNode *node, IFMapUpdate *update) {
+    if (update != NULL) {
+        assert(update->IsUpdate());
+        EncodeUpdate(update);
+        return;
+    }
+
+    uint64_t start = ClockMonotonicUsec();
+    SetOpType(UPDATE);
+
+    doc_.reset();
+    xml_node parent = doc_.append_child("fragment");
+    node->EncodeNodeDetail(&parent);
+    AppendFragment(PrintFragment(parent), false);
+
+    fragments_encoded_++;
+    encode_usecs_ += ClockMonotonicUsec() - start;
+}
+
+void IFMapMessage::EncodeLinkUpdate(IFMapLink *link, IFMapUpdate *update) {
+    if (update != NULL) {
+        assert(update->IsUpdate());
+        EncodeUpdate(update);
+        return;
+    }
+
+    uint64_t start = ClockMonotonicUsec();
+    SetOpType(UPDATE);
+
+    doc_.reset();
+    xml_node parent = doc_.append_child("fragment");
+    EncodeLink(link, &parent);
+    AppendFragment(PrintFragment(parent), true);
+
+    fragments_encoded_++;
+    encode_usecs_ += ClockMonotonicUsec() - start;
+}
+
+void IFMapMessage::EncodeFragment(IFMapUpdate *update) {
+    uint64_t start = ClockMonotonicUsec();
+
+    doc_.reset();
+    xml_node parent = doc_.append_child("fragment");
+    if (update->data().type == IFMapObjectPtr::NODE) {
+        EncodeNode(update, &parent);
+    } else if (update->data().type == IFMapObjectPtr::LINK) {
+        EncodeLink(update->data().u.link, &parent);
+    } else {
+        assert(0);
+    }
+    update->set_fragment(
+        IFMapUpdate::Fragment(new string(PrintFragment(parent))));
+
+    fragments_encoded_++;
+    encode_usecs_ += ClockMonotonicUsec() - start;
+}
+
+string IFMapMessage::PrintFragment(const xml_node &parent) {
+    ostringstream oss;
+    parent.first_child().print(oss, "\t", format_default, encoding_auto,
+                               kFragmentDepth);
+    return oss.str();
+}
+
+void IFMapMessage::EncodeNode(const IFMapUpdate *update, xml_node *parent) {
     IFMapNode *node = update->data().u.node;
     if (update->IsUpdate()) {
-        node->EncodeNodeDetail(&op_node_);
+        node->EncodeNodeDetail(parent);
     } else {
-        node->EncodeNode(&op_node_);
-    }    
+        node->EncodeNode(parent);
+    }
 }
 
-void IFMapMessage::EncodeLink(const IFMapUpdate *update) {
-    xml_node link_node = op_node_.append_child("link");
-
-    const IFMapLink *link = update->data().u.link;
+void IFMapMessage::EncodeLink(const IFMapLink *link, xml_node *parent) {
+    xml_node link_node = parent->append_child("link");
 
-    IFMapNode::EncodeNode(link->left_id(), &link_node);
-    IFMapNode::EncodeNode(link->right_id(), &link_node);
+    IFMapNode::EncodeNode(link->left_type(), link->left_name(), &link_node);
+    IFMapNode::EncodeNode(link->right_type(), link->right_name(), &link_node);
     link->EncodeLinkInfo(&link_node);
-
-    node_count_++;
 }
 
 bool IFMapMessage::IsFull() {
@@ -107,10 +214,11 @@ bool IFMapMessage::IsEmpty() {
 }
 
 void IFMapMessage::Reset() {
-    doc_.reset();
+    body_.clear();
+    receiver_.clear();
     node_count_ = 0;
+    fragment_count_ = 0;
     op_type_ = NONE;
-    Open();
 }
 
 const char * IFMapMessage::c_str() const {
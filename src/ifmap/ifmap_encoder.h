@@ -5,12 +5,23 @@
 #ifndef __ctrlplane__ifmap_encoder__
 #define __ctrlplane__ifmap_encoder__
 
+#include <stdint.h>
+#include <string>
 #include <pugixml/pugixml.hpp>
 
 class IFMapNode;
 class IFMapLink;
 class IFMapUpdate;
 
+//
+// Builds the config messages sent to the clients.
+//
+// Each update is encoded once into a fragment that is cached on the
+// IFMapUpdate, and the fragments are appended to a body that is common to
+// all the receivers of the message. Only the 'to' attribute differs between
+// clients, so Close() just wraps the body with the per client header. The
+// output is identical to saving the equivalent pugi document.
+//
 class IFMapMessage {
 public:
     static const int kObjectsPerMessage = 16;
@@ -20,30 +31,53 @@ public:
     // set the 'to' field in the message
     void SetReceiverInMsg(const std::string &cli_identifier);
     void SetObjectsPerMessage(int num);
-    void EncodeUpdate(const IFMapUpdate *update);
+    void EncodeUpdate(IFMapUpdate *update);
+    // Encode the current contents of an object outside of the update queue,
+    // e.g. as part of the initial snapshot of a client. If the object has an
+    // update in the queue, its fragment is shared with it.
+    void EncodeNodeUpdate(IFMapNode *node, IFMapUpdate *update);
+    void EncodeLinkUpdate(IFMapLink *link, IFMapUpdate *update);
     bool IsFull();
     bool IsEmpty();
     void Reset();
 
     const char *c_str() const;
 
+    // Number of fragments in the current message.
+    int fragment_count() const { return fragment_count_; }
+
+    uint64_t fragments_encoded() const { return fragments_encoded_; }
+    uint64_t fragments_reused() const { return fragments_reused_; }
+    uint64_t encode_usecs() const { return encode_usecs_; }
+
 private:
     enum Op {
         NONE,
         UPDATE,
         DEL
     };
-    void Open();
-    void EncodeNode(const IFMapUpdate *update);
-    void EncodeLink(const IFMapUpdate *update);
-
-    pugi::xml_document doc_;
-    pugi::xml_node config_;
-    Op op_type_;             // the current  type of op_node_
-    pugi::xml_node op_node_;
+    static const char *OpStartTag(Op op);
+    static const char *OpEndTag(Op op);
+
+    void SetOpType(Op op_type);
+    void AppendFragment(const std::string &fragment, bool is_link);
+    void EncodeNode(const IFMapUpdate *update, pugi::xml_node *parent);
+    void EncodeLink(const IFMapLink *link, pugi::xml_node *parent);
+    void EncodeFragment(IFMapUpdate *update);
+    std::string PrintFragment(const pugi::xml_node &parent);
+
+    pugi::xml_document doc_;    // scratch document used to encode fragments
+    Op op_type_;                // the current type of op in body_
+    std::string body_;
+    std::string receiver_;
     std::string str_;
     int node_count_;
+    int fragment_count_;
     int objects_per_message_;
+
+    uint64_t fragments_encoded_;
+    uint64_t fragments_reused_;
+    uint64_t encode_usecs_;
 };
 
 #endif /* defined(__ctrlplane__ifmap_encoder__) */
@@ -11,6 +11,7 @@
 #include "db/db_table_partition.h"
 #include "ifmap/ifmap_client.h"
 #include "ifmap/ifmap_graph_walker.h"
+#include "ifmap/ifmap_initial_sync.h"
 #include "ifmap/ifmap_link.h"
 #include "ifmap/ifmap_log.h"
 #include "ifmap/ifmap_server.h"
@@ -170,9 +171,24 @@ bool IFMapExporter::UpdateAddChange(ObjectType *obj, IFMapState *state,
     IFMapUpdate *update = state->GetUpdate(IFMapListEntry::UPDATE);
     if (update != NULL) {
         update->AdvertiseReset(rm_set);
+        // The encoding cached by the sender is stale if the object changed,
+        // even if the update stays where it is in the queue.
+        if (change) {
+            update->ClearFragment();
+        }
     }
 
-    if (state->interest().empty()) {
+    // Clients that are being sent their initial snapshot get the objects
+    // they haven't seen yet from the snapshot rather than from the queue.
+    BitSet syncing;
+    syncing.BuildComplement(server_->initial_sync()->sync_clients(),
+                            state->advertised());
+    BitSet interest;
+    interest.BuildComplement(state->interest(), syncing);
+    BitSet add;
+    add.BuildComplement(add_set, syncing);
+
+    if (interest.empty()) {
         if (update != NULL) {
             queue()->Dequeue(update);
             state->Remove(update);
@@ -181,18 +197,18 @@ bool IFMapExporter::UpdateAddChange(ObjectType *obj, IFMapState *state,
         return false;
     }
 
-    if (!change && add_set.empty()) {
+    if (!change && add.empty()) {
         return false;
     }
 
     bool is_move = false;
     if (update != NULL) {
         if (!change) {
-            if (update->advertise().Contains(add_set)) {
+            if (update->advertise().Contains(add)) {
                 return false;
             }
         } else {
-            if (state->interest() == update->advertise()) {
+            if (interest == update->advertise()) {
                 return false;
             }
         }
@@ -204,9 +220,9 @@ bool IFMapExporter::UpdateAddChange(ObjectType *obj, IFMapState *state,
     }
 
     if (!change) {
-        update->AdvertiseOr(add_set);
+        update->AdvertiseOr(add);
     } else {
-        update->SetAdvertise(state->interest());
+        update->SetAdvertise(interest);
     }
     queue()->Enqueue(update);
     sender()->QueueActive();
@@ -523,7 +539,7 @@ void IFMapExporter::LinkTableExport(DBTablePartBase *partition,
 
         IFMAP_DEBUG(LinkOper, "LinkRemove", left->ToString(), right->ToString(),
             s_left->interest().ToString(), s_right->interest().ToString());
-        walker_->LinkRemove(interest);
+        walker_->LinkRemove(left, right, interest);
 
         state->RemoveDependency();
         state->ClearValid();
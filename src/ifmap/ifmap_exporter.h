@@ -68,6 +68,7 @@ public:
 
     DBTable *link_table() { return link_table_; }
     IFMapServer *server() { return server_; }
+    IFMapGraphWalker *graph_walker() { return walker_.get(); }
 
     bool FilterNeighbor(IFMapNode *lnode, IFMapNode *rnode);
 
@@ -95,6 +96,7 @@ public:
 
 private:
     friend class XmppIfmapTest;
+    friend class IFMapInitialSync;
     class TableInfo;
     typedef std::map<DBTable *, TableInfo *> TableMap;
 
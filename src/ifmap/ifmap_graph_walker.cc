@@ -4,6 +4,8 @@
 
 #include "ifmap/ifmap_graph_walker.h"
 
+#include <string.h>
+
 #include <boost/bind.hpp>
 #include "base/logging.h"
 #include "base/task_trigger.h"
@@ -63,13 +65,75 @@ private:
     const BitSet &bset_;
 };
 
+// Accepts the nodes that have interest for any of the clients in the bitset
+// and that are not yet part of the region.
+class IFMapGraphWalker::RegionFilter : public DBGraph::VisitorFilter {
+public:
+    RegionFilter(IFMapExporter *exporter,
+                 const IFMapTypenameWhiteList *type_filter,
+                 const BitSet &bitset, const Region *region)
+            : exporter_(exporter),
+              type_filter_(type_filter),
+              bset_(bitset),
+              region_(region) {
+    }
+
+    bool VertexFilter(const DBGraphVertex *vertex) const {
+        return type_filter_->VertexFilter(vertex);
+    }
+
+    bool EdgeFilter(const DBGraphVertex *source, const DBGraphVertex *target,
+                    const DBGraphEdge *edge) const;
+
+private:
+    IFMapExporter *exporter_;
+    const IFMapTypenameWhiteList *type_filter_;
+    const BitSet &bset_;
+    const Region *region_;
+};
+
+//
+// The part of the graph affected by a batch of link deletes. The summary is
+// the set of clients, among the ones being recomputed, that have interest in
+// any node of the region.
+//
+struct IFMapGraphWalker::Region {
+    explicit Region(const BitSet &clients) : clients(clients) { }
+
+    BitSet clients;
+    std::vector<IFMapNode *> nodes;
+    std::set<const DBGraphVertex *> members;
+    BitSet summary;
+
+    bool Contains(const DBGraphVertex *vertex) const {
+        return members.find(vertex) != members.end();
+    }
+};
+
+bool IFMapGraphWalker::RegionFilter::EdgeFilter(const DBGraphVertex *source,
+        const DBGraphVertex *target, const DBGraphEdge *edge) const {
+    if (!type_filter_->EdgeFilter(source, target, edge)) {
+        return false;
+    }
+    if (region_->Contains(target)) {
+        return false;
+    }
+    const IFMapNode *tgt = static_cast<const IFMapNode *>(target);
+    const DBTable *table = tgt->table();
+    const IFMapNodeState *state = static_cast<const IFMapNodeState *>(
+        tgt->GetState(table, exporter_->TableListenerId(table)));
+    return (state != NULL && state->interest().intersects(bset_));
+}
+
 IFMapGraphWalker::IFMapGraphWalker(DBGraph *graph, IFMapExporter *exporter)
     : graph_(graph),
       exporter_(exporter),
       link_delete_walk_trigger_(new TaskTrigger(
           boost::bind(&IFMapGraphWalker::LinkDeleteWalk, this),
           TaskScheduler::GetInstance()->GetTaskId("db::IFMapTable"), 0)),
-      walk_client_index_(BitSet::npos) {
+      link_delete_walk_max_nodes_(kMaxLinkDeleteWalkNodes),
+      link_delete_walks_(0),
+      link_delete_walk_nodes_(0) {
     traversal_white_list_.reset(new IFMapTypenameWhiteList());
     AddNodesToWhitelist();
     AddLinksToWhitelist();
@@ -118,8 +182,33 @@ void IFMapGraphWalker::LinkAdd(IFMapNode *lnode, const BitSet &lhs,
     }
 }
 
-void IFMapGraphWalker::LinkRemove(const BitSet &bset) {
+void IFMapGraphWalker::SubgraphJoinVertex(DBGraphVertex *vertex,
+        const BitSet &bset, std::vector<IFMapNode *> *nodes) {
+    IFMapNode *node = static_cast<IFMapNode *>(vertex);
+    IFMapNodeState *state = exporter_->NodeStateLocate(node);
+    exporter_->StateInterestOr(state, bset);
+    nodes->push_back(node);
+}
+
+void IFMapGraphWalker::JoinSubgraph(IFMapNode *node, const BitSet &bset,
+                                    std::vector<IFMapNode *> *nodes) {
+    GraphPropagateFilter filter(exporter_, traversal_white_list_.get(), bset);
+    graph_->Visit(node,
+        boost::bind(&IFMapGraphWalker::SubgraphJoinVertex, this, _1, bset,
+                    nodes),
+        0, filter);
+}
+
+void IFMapGraphWalker::LinkRemove(IFMapNode *lnode, IFMapNode *rnode,
+                                  const BitSet &bset) {
+    if (bset.empty()) {
+        return;
+    }
     OrLinkDeleteClients(bset);          // link_delete_clients_ | bset
+    link_delete_nodes_.insert(
+        IFMapNode::Descriptor(lnode->table()->Typename(), lnode->name()));
+    link_delete_nodes_.insert(
+        IFMapNode::Descriptor(rnode->table()->Typename(), rnode->name()));
     link_delete_walk_trigger_->Set();
 }
 
@@ -133,66 +222,165 @@ bool IFMapGraphWalker::FilterNeighbor(IFMapNode *lnode, IFMapNode *rnode) {
     return false;
 }
 
-void IFMapGraphWalker::RecomputeInterest(DBGraphVertex *vertex, int bit) {
+void IFMapGraphWalker::AddToRegion(DBGraphVertex *vertex, Region *region) {
+    if (!region->members.insert(vertex).second) {
+        return;
+    }
     IFMapNode *node = static_cast<IFMapNode *>(vertex);
-    IFMapNodeState *state = exporter_->NodeStateLocate(node);
-    state->nmask_set(bit);
-    UpdateNewReachableNodesTracker(bit, state);
+    region->nodes.push_back(node);
+    IFMapNodeState *state = exporter_->NodeStateLookup(node);
+    region->summary |= (state->interest() & region->clients);
+    state->nmask_clear();
 }
 
-bool IFMapGraphWalker::LinkDeleteWalk() {
-    if (link_delete_clients_.empty()) {
-        walk_client_index_ = BitSet::npos;
-        return true;
+//
+// Collect the nodes that are reachable from the end of a deleted link and
+// that have interest for any of the clients being recomputed. A node outside
+// the region can't have reached a client via a deleted link, since the
+// region would then contain it, so its interest is still valid.
+//
+void IFMapGraphWalker::BuildRegion(const IFMapNode::Descriptor &descriptor,
+                                   Region *region) {
+    const BitSet &bset = region->clients;
+    IFMapServer *server = exporter_->server();
+    IFMapNode *node = IFMapNode::DescriptorLookup(server->database(),
+                                                  descriptor);
+    if (node == NULL || !node->IsVertexValid() || region->Contains(node) ||
+        !traversal_white_list_->VertexFilter(node)) {
+        return;
+    }
+    IFMapNodeState *state = exporter_->NodeStateLookup(node);
+    if (state == NULL || !state->interest().intersects(bset)) {
+        return;
     }
+    RegionFilter filter(exporter_, traversal_white_list_.get(), bset, region);
+    graph_->Visit(node,
+        boost::bind(&IFMapGraphWalker::AddToRegion, this, _1, region),
+        0, filter);
+}
 
+//
+// Seed the new interest of the region from its boundary: a client is still
+// interested in a node of the region if the node is the client's vrouter or
+// if it can be reached from a node outside the region that has interest for
+// the client.
+//
+void IFMapGraphWalker::RegionBoundaryInterest(const BitSet &bset,
+                                              Region *region) {
     IFMapServer *server = exporter_->server();
-    size_t i;
-
-    // Get the index of the client we want to start with.
-    if (walk_client_index_ == BitSet::npos) {
-        i = link_delete_clients_.find_first();
-    } else {
-        // walk_client_index_ was the last client that we finished processing.
-        i = link_delete_clients_.find_next(walk_client_index_);
-    }
-    int count = 0;
-    BitSet done_set;
-    while (i != BitSet::npos) {
-        IFMapClient *client = server->GetClient(i);
-        assert(client);
-        AddNewReachableNodesTracker(client->index());
-
-        IFMapTable *table = IFMapTable::FindTable(server->database(),
-                                                  "virtual-router");
-        IFMapNode *node = table->FindNode(client->identifier());
-        if ((node != NULL) && node->IsVertexValid()) {
-            graph_->Visit(node,
-                boost::bind(&IFMapGraphWalker::RecomputeInterest, this, _1, i),
-                0, *traversal_white_list_.get());
+    for (std::vector<IFMapNode *>::const_iterator iter =
+         region->nodes.begin(); iter != region->nodes.end(); ++iter) {
+        IFMapNode *node = *iter;
+        IFMapNodeState *state = exporter_->NodeStateLookup(node);
+        BitSet seed;
+        if (strcmp(node->table()->Typename(), "virtual-router") == 0) {
+            IFMapClient *client = server->FindClient(node->name());
+            if (client != NULL && bset.test(client->index())) {
+                seed.set(client->index());
+            }
+        }
+        for (DBGraphVertex::edge_iterator eiter =
+             node->edge_list_begin(graph_);
+             eiter != node->edge_list_end(graph_); ++eiter) {
+            DBGraphEdge *edge = eiter.operator->();
+            if (edge->IsDeleted()) {
+                continue;
+            }
+            DBGraphVertex *adj = eiter.target();
+            if (region->Contains(adj) ||
+                !traversal_white_list_->VertexFilter(adj) ||
+                !traversal_white_list_->EdgeFilter(adj, node, edge)) {
+                continue;
+            }
+            IFMapNodeState *adj_state =
+                exporter_->NodeStateLookup(static_cast<IFMapNode *>(adj));
+            if (adj_state != NULL) {
+                seed |= (adj_state->interest() & bset);
+            }
         }
-        done_set.set(i);
-        if (++count == kMaxLinkDeleteWalks) {
-            // client 'i' has been processed. If 'i' is the last bit set, we
-            // will return true below. Else we will return false and there
-            // is atleast one more bit left to process.
-            break;
+        if (!seed.empty()) {
+            state->nmask_or(seed);
         }
+    }
+}
 
-        i = link_delete_clients_.find_next(i);
+// Propagate the new interest within the region until nothing changes.
+void IFMapGraphWalker::RegionPropagateInterest(Region *region) {
+    std::vector<IFMapNode *> work_list;
+    for (std::vector<IFMapNode *>::const_iterator iter =
+         region->nodes.begin(); iter != region->nodes.end(); ++iter) {
+        if (!exporter_->NodeStateLookup(*iter)->nmask().empty()) {
+            work_list.push_back(*iter);
+        }
     }
-    // Remove the subset of clients that we have finished processing.
-    ResetLinkDeleteClients(done_set);
 
-    LinkDeleteWalkBatchEnd(done_set);
+    while (!work_list.empty()) {
+        IFMapNode *node = work_list.back();
+        work_list.pop_back();
+        BitSet nmask = exporter_->NodeStateLookup(node)->nmask();
+        for (DBGraphVertex::edge_iterator eiter =
+             node->edge_list_begin(graph_);
+             eiter != node->edge_list_end(graph_); ++eiter) {
+            DBGraphEdge *edge = eiter.operator->();
+            if (edge->IsDeleted()) {
+                continue;
+            }
+            DBGraphVertex *adj = eiter.target();
+            if (!region->Contains(adj) ||
+                !traversal_white_list_->EdgeFilter(node, adj, edge)) {
+                continue;
+            }
+            IFMapNode *adj_node = static_cast<IFMapNode *>(adj);
+            IFMapNodeState *adj_state = exporter_->NodeStateLookup(adj_node);
+            if (adj_state->nmask().Contains(nmask)) {
+                continue;
+            }
+            adj_state->nmask_or(nmask);
+            work_list.push_back(adj_node);
+        }
+    }
+}
 
+//
+// Recompute the interest of the clients affected by the link deletes since
+// the last walk, within the region of the graph reachable from the ends of
+// the deleted links.
+//
+// The region is built from the ends of the deleted links till it has at least
+// link_delete_walk_max_nodes_ nodes. The rest of them are left for the next
+// run, so return false to get rescheduled. The region is closed under the
+// nodes that have interest for the clients, so it can be recomputed on its
+// own and the interest of the nodes that are left is still consistent.
+//
+bool IFMapGraphWalker::LinkDeleteWalk() {
     if (link_delete_clients_.empty()) {
-        walk_client_index_ = BitSet::npos;
+        link_delete_nodes_.clear();
         return true;
-    } else {
-        walk_client_index_ = i;
+    }
+
+    Region region(link_delete_clients_);
+    while (!link_delete_nodes_.empty() &&
+           region.nodes.size() < link_delete_walk_max_nodes_) {
+        IFMapNode::Descriptor descriptor = *link_delete_nodes_.begin();
+        link_delete_nodes_.erase(link_delete_nodes_.begin());
+        BuildRegion(descriptor, &region);
+    }
+    RegionBoundaryInterest(region.summary, &region);
+    RegionPropagateInterest(&region);
+
+    for (std::vector<IFMapNode *>::const_iterator iter =
+         region.nodes.begin(); iter != region.nodes.end(); ++iter) {
+        IFMapNode *node = *iter;
+        CleanupInterest(region.summary, node, exporter_->NodeStateLookup(node));
+    }
+
+    link_delete_walks_++;
+    link_delete_walk_nodes_ += region.nodes.size();
+    if (!link_delete_nodes_.empty()) {
         return false;
     }
+    link_delete_clients_.clear();
+    return true;
 }
 
 void IFMapGraphWalker::OrLinkDeleteClients(const BitSet &bset) {
@@ -203,11 +391,8 @@ void IFMapGraphWalker::ResetLinkDeleteClients(const BitSet &bset) {
     link_delete_clients_.Reset(bset);
 }
 
-void IFMapGraphWalker::CleanupInterest(int client_index, IFMapNode *node,
+void IFMapGraphWalker::CleanupInterest(const BitSet &rm_mask, IFMapNode *node,
                                        IFMapNodeState *state) {
-    BitSet rm_mask;
-    rm_mask.set(client_index);
-
     // interest = interest - rm_mask + nmask
 
     if (!state->interest().empty() && !state->nmask().empty()) {
@@ -234,95 +419,6 @@ void IFMapGraphWalker::CleanupInterest(int client_index, IFMapNode *node,
     }
 }
 
-// Cleanup all the graph nodes that were reachable before this link delete.
-// After this link delete, these nodes may still be reachable. But, its
-// also possible that the link delete has made them unreachable.
-void IFMapGraphWalker::OldReachableNodesCleanupInterest(int client_index) {
-    IFMapState *state = NULL;
-    IFMapNode *node = NULL;
-    IFMapExporter::Cs_citer iter = exporter_->ClientConfigTrackerBegin(
-        IFMapExporter::INTEREST, client_index);
-    IFMapExporter::Cs_citer end_iter = exporter_->ClientConfigTrackerEnd(
-        IFMapExporter::INTEREST, client_index);
-
-    while (iter != end_iter) {
-        state = *iter;
-        // Get the iterator to the next element before calling
-        // CleanupInterest() since the state might be removed from the
-        // client's config-tracker, thereby invalidating the iterator of the
-        // container we are iterating over.
-        ++iter;
-        if (state->IsNode()) {
-            node = state->GetIFMapNode();
-            assert(node);
-            IFMapNodeState *nstate = exporter_->NodeStateLookup(node);
-            assert(state == nstate);
-            CleanupInterest(client_index, node, nstate);
-        }
-    }
-}
-
-// Cleanup all the graph nodes that were not reachable before the link delete
-// but are reachable now. Note, we store nodes in new_reachable_nodes_tracker_
-// only if we visited them during the graph-walk via RecomputeInterest() and if
-// their interest bit was not set i.e. they were not reachable before we
-// started the walk.
-void IFMapGraphWalker::NewReachableNodesCleanupInterest(int client_index) {
-    IFMapState *state = NULL;
-    IFMapNode *node = NULL;
-    ReachableNodesSet *rnset = new_reachable_nodes_tracker_.at(client_index);
-
-    for (Rns_citer iter = rnset->begin(); iter != rnset->end(); ++iter) {
-        state = *iter;
-        assert(state->IsNode());
-        node = state->GetIFMapNode();
-        assert(node);
-        IFMapNodeState *nstate = exporter_->NodeStateLookup(node);
-        assert(state == nstate);
-        CleanupInterest(client_index, node, nstate);
-    }
-    DeleteNewReachableNodesTracker(client_index);
-}
-
-void IFMapGraphWalker::LinkDeleteWalkBatchEnd(const BitSet &done_set) {
-    for (size_t i = done_set.find_first(); i != BitSet::npos;
-            i = done_set.find_next(i)) {
-        // Examine all the nodes that were reachable before the link delete.
-        OldReachableNodesCleanupInterest(i);
-        // Examine all the nodes that were not reachable before the link
-        // delete but are now reachable.
-        NewReachableNodesCleanupInterest(i);
-    }
-}
-
-void IFMapGraphWalker::AddNewReachableNodesTracker(int client_index) {
-    if (client_index >= (int)new_reachable_nodes_tracker_.size()) {
-        new_reachable_nodes_tracker_.resize(client_index + 1, NULL);
-    }
-    assert(new_reachable_nodes_tracker_[client_index] == NULL);
-    ReachableNodesSet *rnset = new ReachableNodesSet();
-    new_reachable_nodes_tracker_[client_index] = rnset;
-}
-
-void IFMapGraphWalker::DeleteNewReachableNodesTracker(int client_index) {
-    ReachableNodesSet *rnset = new_reachable_nodes_tracker_.at(client_index);
-    assert(rnset);
-    delete rnset;
-    new_reachable_nodes_tracker_[client_index] = NULL;
-}
-
-// Keep track of this node if it was unreachable earlier.
-void IFMapGraphWalker::UpdateNewReachableNodesTracker(int client_index,
-                                                      IFMapState *state) {
-    ReachableNodesSet *rnset = new_reachable_nodes_tracker_.at(client_index);
-    assert(rnset);
-    // If the interest is not set, the node was not reachable earlier but is
-    // reachable now.
-    if (!state->interest().test(client_index)) {
-        rnset->insert(state);
-    }
-}
-
 const IFMapTypenameWhiteList &IFMapGraphWalker::get_traversal_white_list()
         const {
     return *traversal_white_list_.get();
@@ -5,14 +5,17 @@
 #ifndef __ctrlplane__ifmap_graph_walker__
 #define __ctrlplane__ifmap_graph_walker__
 
+#include <set>
+#include <vector>
+
 #include "base/bitset.h"
 #include "base/queue_task.h"
+#include "ifmap/ifmap_node.h"
 
 class DBGraph;
 class DBGraphEdge;
 class DBGraphVertex;
 class IFMapExporter;
-class IFMapNode;
 class IFMapNodeState;
 class IFMapState;
 class TaskTrigger;
@@ -20,11 +23,21 @@ struct IFMapTypenameFilter;
 struct IFMapTypenameWhiteList;
 
 // Computes the interest graph for the ifmap clients (i.e. vnc agent).
+//
+// Link adds propagate the interest of each end of the link to the other end
+// and stop at nodes that already have it. Link deletes are processed in
+// batches: the region of the graph that is reachable from the ends of the
+// deleted links, and that has interest for any of the affected clients, is
+// the only part of the graph whose interest can change. The interest of the
+// region is recomputed from the nodes at its boundary, so the cost of a link
+// delete is proportional to the size of the region rather than to the size
+// of the interest graph of every client.
 class IFMapGraphWalker {
 public:
-    typedef std::set<IFMapState *> ReachableNodesSet;
-    typedef ReachableNodesSet::const_iterator Rns_citer;
-    typedef std::vector<ReachableNodesSet *> ReachableNodesTracker;
+    // A run of the link delete walk stops adding the ends of the deleted
+    // links to its region once it has this many nodes, and leaves the rest
+    // for the next run.
+    static const size_t kMaxLinkDeleteWalkNodes = 1024;
 
     IFMapGraphWalker(DBGraph *graph, IFMapExporter *exporter);
     ~IFMapGraphWalker();
@@ -34,38 +47,57 @@ public:
     // list.
     void LinkAdd(IFMapNode *lnode, const BitSet &lhs,
                  IFMapNode *rnode, const BitSet &rhs);
-    void LinkRemove(const BitSet &bset);
+    void LinkRemove(IFMapNode *lnode, IFMapNode *rnode, const BitSet &bset);
+
+    // Set the interest of a client in the subgraph that is reachable from
+    // its virtual-router node without notifying the exporter, as the client
+    // is sent the subgraph as a snapshot. The nodes are returned in the order
+    // in which they are visited.
+    void JoinSubgraph(IFMapNode *node, const BitSet &bset,
+                      std::vector<IFMapNode *> *nodes);
 
     bool FilterNeighbor(IFMapNode *lnode, IFMapNode *rnode);
     const IFMapTypenameWhiteList &get_traversal_white_list() const;
     void ResetLinkDeleteClients(const BitSet &bset);
 
+    // Used by tests to process the link deletes in smaller runs.
+    void set_link_delete_walk_max_nodes(size_t max_nodes) {
+        link_delete_walk_max_nodes_ = max_nodes;
+    }
+    uint64_t link_delete_walks() const { return link_delete_walks_; }
+    uint64_t link_delete_walk_nodes() const { return link_delete_walk_nodes_; }
+
 private:
-    static const int kMaxLinkDeleteWalks = 1;
+    class RegionFilter;
+    struct Region;
 
     void ProcessLinkAdd(IFMapNode *lnode, IFMapNode *rnode, const BitSet &bset);
     void JoinVertex(DBGraphVertex *vertex, const BitSet &bset);
-    void RecomputeInterest(DBGraphVertex *vertex, int bit);
-    void CleanupInterest(int client_index, IFMapNode *node,
+    void SubgraphJoinVertex(DBGraphVertex *vertex, const BitSet &bset,
+                            std::vector<IFMapNode *> *nodes);
+    void AddToRegion(DBGraphVertex *vertex, Region *region);
+    void BuildRegion(const IFMapNode::Descriptor &descriptor,
+                     Region *region);
+    void RegionBoundaryInterest(const BitSet &bset, Region *region);
+    void RegionPropagateInterest(Region *region);
+    void CleanupInterest(const BitSet &rm_mask, IFMapNode *node,
                          IFMapNodeState *state);
     void AddNodesToWhitelist();
     void AddLinksToWhitelist();
     bool LinkDeleteWalk();
-    void LinkDeleteWalkBatchEnd(const BitSet &done_set);
     void OrLinkDeleteClients(const BitSet &bset);
-    void AddNewReachableNodesTracker(int client_index);
-    void DeleteNewReachableNodesTracker(int client_index);
-    void UpdateNewReachableNodesTracker(int client_index, IFMapState *state);
-    void OldReachableNodesCleanupInterest(int client_index);
-    void NewReachableNodesCleanupInterest(int client_index);
 
     DBGraph *graph_;
     IFMapExporter *exporter_;
     boost::scoped_ptr<TaskTrigger> link_delete_walk_trigger_;
     std::auto_ptr<IFMapTypenameWhiteList> traversal_white_list_;
     BitSet link_delete_clients_;
-    size_t walk_client_index_;
-    ReachableNodesTracker new_reachable_nodes_tracker_;
+    // Ends of the links deleted since the last walk. Nodes are kept by name
+    // since they may go away before the walk.
+    std::set<IFMapNode::Descriptor> link_delete_nodes_;
+    size_t link_delete_walk_max_nodes_;
+    uint64_t link_delete_walks_;
+    uint64_t link_delete_walk_nodes_;
 };
 
 #endif /* defined(__ctrlplane__ifmap_graph_walker__) */
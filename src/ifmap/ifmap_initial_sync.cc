@@ -0,0 +1,330 @@
+/*
+ * Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "ifmap/ifmap_initial_sync.h"
+
+#include <boost/bind.hpp>
+
+#include "base/task_trigger.h"
+#include "base/time_util.h"
+#include "db/db.h"
+#include "ifmap/ifmap_client.h"
+#include "ifmap/ifmap_exporter.h"
+#include "ifmap/ifmap_graph_walker.h"
+#include "ifmap/ifmap_link.h"
+#include "ifmap/ifmap_link_table.h"
+#include "ifmap/ifmap_log.h"
+#include "ifmap/ifmap_log_types.h"
+#include "ifmap/ifmap_server.h"
+#include "ifmap/ifmap_table.h"
+#include "ifmap/ifmap_update.h"
+
+using std::string;
+using std::vector;
+
+//
+// Objects are kept by name since they may go away while the snapshot is
+// being sent.
+//
+struct IFMapInitialSync::ClientSync {
+    explicit ClientSync(IFMapClient *client)
+        : client(client), index(client->index()), bset(),
+          start_at(ClockMonotonicUsec()), next(0), objects_sent(0) {
+        bset.set(index);
+    }
+
+    size_t size() const { return nodes.size() + links.size(); }
+
+    IFMapClient *client;
+    int index;
+    BitSet bset;
+    uint64_t start_at;
+    vector<IFMapNode::Descriptor> nodes;
+    vector<string> links;
+    size_t next;                // position in nodes followed by links
+    uint64_t objects_sent;
+};
+
+IFMapInitialSync::IFMapInitialSync(IFMapServer *server)
+    : server_(server),
+      max_messages_per_run_(kMaxMessagesPerRun),
+      send_trigger_(new TaskTrigger(
+          boost::bind(&IFMapInitialSync::ProcessSendActive, this),
+          TaskScheduler::GetInstance()->GetTaskId("db::IFMapTable"), 0)) {
+    message_.SetObjectsPerMessage(kObjectsPerMessage);
+}
+
+IFMapInitialSync::~IFMapInitialSync() {
+    for (ClientSyncMap::iterator iter = sync_map_.begin();
+         iter != sync_map_.end(); ++iter) {
+        delete iter->second;
+    }
+}
+
+//
+// Set the interest of the client in its subgraph and make a list of the
+// objects to send. All of it happens in a single run of the task, so the
+// list is consistent with the interest sets that the exporter sees.
+//
+void IFMapInitialSync::ClientStart(IFMapClient *client) {
+    IFMapExporter *exporter = server_->exporter();
+    ClientSync *sync = new ClientSync(client);
+    sync_map_.insert(std::make_pair(sync->index, sync));
+    sync_clients_.set(sync->index);
+
+    IFMapTable *table = IFMapTable::FindTable(server_->database(),
+                                              "virtual-router");
+    assert(table);
+    IFMapNode *vrouter = table->FindNode(client->identifier());
+    if ((vrouter == NULL) || !vrouter->IsVertexValid()) {
+        Complete(sync);
+        return;
+    }
+
+    vector<IFMapNode *> nodes;
+    exporter->graph_walker()->JoinSubgraph(vrouter, sync->bset, &nodes);
+
+    sync->nodes.reserve(nodes.size());
+    for (vector<IFMapNode *>::const_iterator it = nodes.begin();
+         it != nodes.end(); ++it) {
+        IFMapNode *node = *it;
+        sync->nodes.push_back(
+            IFMapNode::Descriptor(node->table()->Typename(), node->name()));
+    }
+
+    // A link is part of the snapshot if both of its nodes are. Each link is
+    // a dependent of both of its nodes, so only look at it from the left.
+    for (vector<IFMapNode *>::const_iterator it = nodes.begin();
+         it != nodes.end(); ++it) {
+        IFMapNode *node = *it;
+        IFMapNodeState *state = exporter->NodeStateLookup(node);
+        for (IFMapNodeState::iterator iter = state->begin();
+             iter != state->end(); ++iter) {
+            IFMapLink *link = iter.operator->();
+            if (link->IsDeleted() || link->left() != node) {
+                continue;
+            }
+            IFMapLinkState *ls = exporter->LinkStateLookup(link);
+            if ((ls == NULL) || !ls->IsValid() ||
+                !ls->right()->interest().test(sync->index)) {
+                continue;
+            }
+            exporter->StateInterestOr(ls, sync->bset);
+            sync->links.push_back(link->link_name());
+        }
+    }
+
+    if (Send(sync)) {
+        Complete(sync);
+    }
+}
+
+void IFMapInitialSync::ClientCleanup(int index) {
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        send_scheduled_.reset(index);
+    }
+    ClientSyncMap::iterator loc = sync_map_.find(index);
+    if (loc == sync_map_.end()) {
+        return;
+    }
+    delete loc->second;
+    sync_map_.erase(loc);
+    sync_clients_.reset(index);
+}
+
+bool IFMapInitialSync::GetProgress(int index, uint64_t *start_at,
+                                   uint64_t *objects_sent,
+                                   uint64_t *objects_remaining) const {
+    ClientSyncMap::const_iterator loc = sync_map_.find(index);
+    if (loc == sync_map_.end()) {
+        return false;
+    }
+    const ClientSync *sync = loc->second;
+    *start_at = sync->start_at;
+    *objects_sent = sync->objects_sent;
+    *objects_remaining = sync->size() - sync->next;
+    return true;
+}
+
+void IFMapInitialSync::SendActive(int index) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    send_scheduled_.set(index);
+    send_trigger_->Set();
+}
+
+//
+// Clients that yield are scheduled again while this runs, so keep the trigger
+// going until there is nothing left to send.
+//
+bool IFMapInitialSync::ProcessSendActive() {
+    BitSet send_scheduled;
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        send_scheduled = send_scheduled_;
+        send_scheduled_.clear();
+    }
+    for (size_t i = send_scheduled.find_first(); i != BitSet::npos;
+         i = send_scheduled.find_next(i)) {
+        ClientSyncMap::iterator loc = sync_map_.find(i);
+        if (loc == sync_map_.end()) {
+            continue;
+        }
+        ClientSync *sync = loc->second;
+        if (Send(sync)) {
+            Complete(sync);
+        }
+    }
+    tbb::mutex::scoped_lock lock(mutex_);
+    return send_scheduled_.empty();
+}
+
+//
+// Send the remaining objects of the snapshot. Returns false if the client
+// blocked before all of them were sent, or if it used up its share of the
+// task, in which case it's scheduled to continue in a later run.
+//
+bool IFMapInitialSync::Send(ClientSync *sync) {
+    IFMapClient *client = sync->client;
+    int messages = 0;
+    while (sync->next < sync->size()) {
+        if (client->send_is_blocked()) {
+            return false;
+        }
+        if (messages == max_messages_per_run_) {
+            SendActive(sync->index);
+            return false;
+        }
+        while (!message_.IsFull() && sync->next < sync->size()) {
+            bool encoded;
+            if (sync->next < sync->nodes.size()) {
+                encoded = EncodeNode(sync, sync->nodes[sync->next]);
+            } else {
+                encoded = EncodeLink(sync,
+                    sync->links[sync->next - sync->nodes.size()]);
+            }
+            if (encoded) {
+                sync->objects_sent++;
+            }
+            sync->next++;
+        }
+        if (message_.IsEmpty()) {
+            continue;
+        }
+        message_.SetReceiverInMsg(client->identifier());
+        message_.Close();
+        bool sent = client->SendUpdate(message_.c_str());
+        message_.Reset();
+        messages++;
+        if (!sent) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//
+// Objects that went away, or that the client is no longer interested in,
+// are skipped. So are the ones that have already been sent to the client
+// through the queue.
+//
+bool IFMapInitialSync::EncodeNode(ClientSync *sync,
+                                  const IFMapNode::Descriptor &descriptor) {
+    IFMapNode *node =
+        IFMapNode::DescriptorLookup(server_->database(), descriptor);
+    if ((node == NULL) || node->IsDeleted()) {
+        return false;
+    }
+    IFMapExporter *exporter = server_->exporter();
+    IFMapNodeState *state = exporter->NodeStateLookup(node);
+    if ((state == NULL) || !state->interest().test(sync->index) ||
+        state->advertised().test(sync->index)) {
+        return false;
+    }
+    message_.EncodeNodeUpdate(node, state->GetUpdate(IFMapListEntry::UPDATE));
+    exporter->StateAdvertisedOr(state, sync->bset);
+    sync->client->incr_update_nodes_sent();
+    return true;
+}
+
+//
+// A link is only sent once both of its nodes have been sent to the client.
+//
+bool IFMapInitialSync::EncodeLink(ClientSync *sync, const string &link_name) {
+    IFMapLinkTable *table = static_cast<IFMapLinkTable *>(
+        server_->database()->FindTable("__ifmap_metadata__.0"));
+    IFMapLink *link = table->FindLink(link_name);
+    if ((link == NULL) || link->IsDeleted()) {
+        return false;
+    }
+    IFMapExporter *exporter = server_->exporter();
+    IFMapLinkState *state = exporter->LinkStateLookup(link);
+    if ((state == NULL) || !state->IsValid() ||
+        !state->interest().test(sync->index) ||
+        state->advertised().test(sync->index) ||
+        !state->left()->advertised().test(sync->index) ||
+        !state->right()->advertised().test(sync->index)) {
+        return false;
+    }
+    message_.EncodeLinkUpdate(link, state->GetUpdate(IFMapListEntry::UPDATE));
+    exporter->StateAdvertisedOr(state, sync->bset);
+    sync->client->incr_update_links_sent();
+    return true;
+}
+
+//
+// Switch the client to incremental updates. Anything the client is
+// interested in but hasn't been sent by now is exported through the queue.
+// The exporter is run on the objects directly rather than notifying all the
+// listeners of their tables. The export changes the interest tracker of the
+// client, so the objects are collected first. Nodes go before links, so
+// that the links find their nodes in the queue.
+//
+void IFMapInitialSync::Complete(ClientSync *sync) {
+    int index = sync->index;
+    sync_clients_.reset(index);
+
+    IFMapExporter *exporter = server_->exporter();
+    vector<IFMapNode *> nodes;
+    vector<IFMapLink *> links;
+    for (IFMapExporter::Cs_citer iter = exporter->ClientConfigTrackerBegin(
+             IFMapExporter::INTEREST, index);
+         iter != exporter->ClientConfigTrackerEnd(
+             IFMapExporter::INTEREST, index); ++iter) {
+        IFMapState *state = *iter;
+        if (state->advertised().test(index)) {
+            continue;
+        }
+        if (state->IsNode()) {
+            IFMapNode *node = state->GetIFMapNode();
+            if (!node->IsDeleted()) {
+                nodes.push_back(node);
+            }
+        } else {
+            IFMapLink *link = state->GetIFMapLink();
+            if (!link->IsDeleted()) {
+                links.push_back(link);
+            }
+        }
+    }
+    for (vector<IFMapNode *>::const_iterator it = nodes.begin();
+         it != nodes.end(); ++it) {
+        IFMapNode *node = *it;
+        exporter->NodeTableExport(node->get_table_partition(), node);
+    }
+    for (vector<IFMapLink *>::const_iterator it = links.begin();
+         it != links.end(); ++it) {
+        IFMapLink *link = *it;
+        exporter->LinkTableExport(link->get_table_partition(), link);
+    }
+
+    IFMapClient *client = sync->client;
+    client->set_config_sync(ClockMonotonicUsec() - sync->start_at,
+                            sync->objects_sent);
+    IFMAP_DEBUG(IFMapServerClientRegUnreg, "Initial config sent to client ",
+                client->identifier(), index);
+
+    sync_map_.erase(index);
+    delete sync;
+}
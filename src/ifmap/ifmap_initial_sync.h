@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef __ctrlplane__ifmap_initial_sync__
+#define __ctrlplane__ifmap_initial_sync__
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+#include <tbb/mutex.h>
+
+#include "base/bitset.h"
+#include "ifmap/ifmap_encoder.h"
+#include "ifmap/ifmap_node.h"
+
+class IFMapClient;
+class IFMapLink;
+class IFMapServer;
+class TaskTrigger;
+
+//
+// Sends the initial config of a newly registered client as a snapshot.
+//
+// The subgraph that is reachable from the virtual-router node of the client
+// is walked once. The interest of the client is set on all the nodes and
+// links of the subgraph, and the objects are then sent to the client in large
+// messages, nodes before links, without going through the update queue.
+//
+// Until the snapshot is complete, the exporter leaves the client out of the
+// updates for the objects that haven't been sent to it yet, so the queue only
+// carries changes and deletes of objects that the client already has. Objects
+// that the client becomes interested in while the snapshot is in progress are
+// picked up from its interest tracker when the snapshot completes, and are
+// then exported through the queue like any other update.
+//
+// Each run of the task sends at most kMaxMessagesPerRun messages to a client
+// before it yields, so that large snapshots don't hold up the other work of
+// the task.
+//
+// Everything but SendActive runs in the db::IFMapTable task.
+//
+class IFMapInitialSync {
+public:
+    static const int kObjectsPerMessage = 512;
+    static const int kMaxMessagesPerRun = 16;
+
+    explicit IFMapInitialSync(IFMapServer *server);
+    ~IFMapInitialSync();
+
+    // Walk the subgraph of a newly registered client and start sending it.
+    void ClientStart(IFMapClient *client);
+    void ClientCleanup(int index);
+
+    // Event posted when a client is ready to send after previously blocking.
+    void SendActive(int index);
+
+    // Clients whose snapshot is in progress.
+    const BitSet &sync_clients() const { return sync_clients_; }
+    bool IsSyncing(int index) const { return sync_clients_.test(index); }
+
+    // Progress of the snapshot of a client, for introspect. Returns false if
+    // the client doesn't have a snapshot in progress. The start time is the
+    // ClockMonotonicUsec when the snapshot started.
+    bool GetProgress(int index, uint64_t *start_at, uint64_t *objects_sent,
+                     uint64_t *objects_remaining) const;
+
+    void SetObjectsPerMessage(int num) {
+        message_.SetObjectsPerMessage(num);
+    }
+    void set_max_messages_per_run(int num) { max_messages_per_run_ = num; }
+
+private:
+    struct ClientSync;
+    typedef std::map<int, ClientSync *> ClientSyncMap;
+
+    bool ProcessSendActive();
+    bool Send(ClientSync *sync);
+    bool EncodeNode(ClientSync *sync, const IFMapNode::Descriptor &descriptor);
+    bool EncodeLink(ClientSync *sync, const std::string &link_name);
+    void Complete(ClientSync *sync);
+
+    IFMapServer *server_;
+    IFMapMessage message_;
+    ClientSyncMap sync_map_;
+    BitSet sync_clients_;
+    int max_messages_per_run_;
+
+    tbb::mutex mutex_;          // protects send_scheduled_
+    BitSet send_scheduled_;
+    boost::scoped_ptr<TaskTrigger> send_trigger_;
+};
+
+#endif /* defined(__ctrlplane__ifmap_initial_sync__) */
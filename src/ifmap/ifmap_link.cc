@@ -4,14 +4,23 @@
 
 #include "ifmap_link.h"
 
+#include <string.h>
+
+#include <algorithm>
 #include <sstream>
 #include <pugixml/pugixml.hpp>
 #include "ifmap/ifmap_table.h"
 
 using namespace std;
 
+IFMapLink::IFMapLink()
+    : DBGraphEdge(Edge()), left_first_(true), left_node_(NULL),
+      right_node_(NULL) {
+}
+
 IFMapLink::IFMapLink(const string &name)
-    : DBGraphEdge(Edge()), link_name_(name) {
+    : DBGraphEdge(Edge()), link_name_(name), left_first_(true),
+      left_node_(NULL), right_node_(NULL) {
 }
 
 void IFMapLink::SetProperties(Edge edge, IFMapNode *left, IFMapNode *right,
@@ -19,10 +28,13 @@ void IFMapLink::SetProperties(Edge edge, IFMapNode *left, IFMapNode *right,
                               const IFMapOrigin &origin) {
     SetEdge(edge);
     left_node_ = left;
-    left_id_ = make_pair(left->table()->Typename(), left->name());
+    left_type_ = IFMapSymbol(left->table()->Typename());
+    left_name_ = IFMapSymbol(left->name());
     right_node_ = right;
-    right_id_ = make_pair(right->table()->Typename(), right->name());
-    metadata_ = metadata;
+    right_type_ = IFMapSymbol(right->table()->Typename());
+    right_name_ = IFMapSymbol(right->name());
+    metadata_ = IFMapSymbol(metadata);
+    left_first_ = left->IsLess(*right);
     LinkOriginInfo origin_info(origin, sequence_number);
     origin_info_.push_back(origin_info);
 }
@@ -45,28 +57,28 @@ void IFMapLink::ClearNodes() {
 
 IFMapNode *IFMapLink::LeftNode(DB *db) {
     if (IsDeleted()) {
-        return IFMapNode::DescriptorLookup(db, left_id_);
+        return IFMapNode::DescriptorLookup(db, left_id());
     }
     return left_node_;
 }
 
 const IFMapNode *IFMapLink::LeftNode(DB *db) const {
     if (IsDeleted()) {
-        return IFMapNode::DescriptorLookup(db, left_id_);
+        return IFMapNode::DescriptorLookup(db, left_id());
     }
     return left_node_;
 }
 
 IFMapNode *IFMapLink::RightNode(DB *db) {
     if (IsDeleted()) {
-        return IFMapNode::DescriptorLookup(db, right_id_);
+        return IFMapNode::DescriptorLookup(db, right_id());
     }
     return right_node_;
 }
 
 const IFMapNode *IFMapLink::RightNode(DB *db) const {
     if (IsDeleted()) {
-        return IFMapNode::DescriptorLookup(db, right_id_);
+        return IFMapNode::DescriptorLookup(db, right_id());
     }
     return right_node_;
 }
@@ -81,14 +93,88 @@ void IFMapLink::SetKey(const DBRequestKey *genkey) {
 
 string IFMapLink::ToString() const {
     ostringstream repr;
-    repr << "link <" << left_id_.first << ':' << left_id_.second;
-    repr << "," << right_id_.first << ':' << right_id_.second << ">";
+    repr << "link <" << left_type_.str() << ':' << left_name_.str();
+    repr << "," << right_type_.str() << ':' << right_name_.str() << ">";
     return repr.str();
 }
 
+//
+// Split the name into the strings it's made of, without copying them.
+// Returns the number of pieces.
+//
+int IFMapLink::GetNamePieces(NamePiece *pieces) const {
+    if (metadata_.empty()) {
+        pieces[0] = NamePiece(link_name_.data(), link_name_.size());
+        return 1;
+    }
+    const string &first_type = left_first_ ? left_type_.str() :
+        right_type_.str();
+    const string &first_name = left_first_ ? left_name_.str() :
+        right_name_.str();
+    const string &second_type = left_first_ ? right_type_.str() :
+        left_type_.str();
+    const string &second_name = left_first_ ? right_name_.str() :
+        left_name_.str();
+    pieces[0] = NamePiece(metadata_.str().data(), metadata_.str().size());
+    pieces[1] = NamePiece(",", 1);
+    pieces[2] = NamePiece(first_type.data(), first_type.size());
+    pieces[3] = NamePiece(":", 1);
+    pieces[4] = NamePiece(first_name.data(), first_name.size());
+    pieces[5] = NamePiece(",", 1);
+    pieces[6] = NamePiece(second_type.data(), second_type.size());
+    pieces[7] = NamePiece(":", 1);
+    pieces[8] = NamePiece(second_name.data(), second_name.size());
+    return kNamePieces;
+}
+
+string IFMapLink::link_name() const {
+    NamePiece pieces[kNamePieces];
+    int count = GetNamePieces(pieces);
+    string name;
+    for (int i = 0; i < count; ++i) {
+        name.append(pieces[i].first, pieces[i].second);
+    }
+    return name;
+}
+
+//
+// Compare the names as if they were concatenated, so that links are sorted
+// by name without building the names.
+//
 bool IFMapLink::IsLess(const DBEntry &rgen) const {
     const IFMapLink &rhs = static_cast<const IFMapLink &>(rgen);
-    return link_name() < rhs.link_name();
+    NamePiece lpieces[kNamePieces], rpieces[kNamePieces];
+    int lcount = GetNamePieces(lpieces);
+    int rcount = rhs.GetNamePieces(rpieces);
+    int li = 0, ri = 0;
+    size_t loff = 0, roff = 0;
+    while (li < lcount && ri < rcount) {
+        const NamePiece &lp = lpieces[li];
+        const NamePiece &rp = rpieces[ri];
+        size_t size = std::min(lp.second - loff, rp.second - roff);
+        int cmp = memcmp(lp.first + loff, rp.first + roff, size);
+        if (cmp != 0) {
+            return cmp < 0;
+        }
+        loff += size;
+        roff += size;
+        if (loff == lp.second) {
+            li++;
+            loff = 0;
+        }
+        if (roff == rp.second) {
+            ri++;
+            roff = 0;
+        }
+    }
+    // Skip any empty pieces left over, then the shorter name is less.
+    while (li < lcount && lpieces[li].second == 0) {
+        li++;
+    }
+    while (ri < rcount && rpieces[ri].second == 0) {
+        ri++;
+    }
+    return (li == lcount) && (ri < rcount);
 }
 
 void IFMapLink::AddOriginInfo(const IFMapOrigin &in_origin, uint64_t seq_num) {
@@ -158,5 +244,5 @@ uint64_t IFMapLink::sequence_number(IFMapOrigin::Origin in_origin,
 
 void IFMapLink::EncodeLinkInfo(pugi::xml_node *parent) const {
     pugi::xml_node metadata_node = parent->append_child("metadata");
-    metadata_node.append_attribute("type") = metadata_.c_str();
+    metadata_node.append_attribute("type") = metadata_.str().c_str();
 }
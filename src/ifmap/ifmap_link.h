@@ -9,10 +9,16 @@
 #include "db/db_table.h"
 #include "ifmap/ifmap_node.h"
 #include "ifmap/ifmap_origin.h"
+#include "ifmap/ifmap_symbol.h"
 
 // An IFMapLink represents an edge in the ifmap configuration graph.
 // When links are deleted, the cached left and right node_ members are
 // cleared.
+// The metadata and the identifiers of the nodes are the same for many links,
+// so they are kept as interned symbols rather than as copies per link. The
+// name of the link is derived from them, in the format of
+// IFMapLinkTable::LinkKey, rather than kept as a string. Only the entries
+// that are allocated to look up a link by name hold the name itself.
 class IFMapLink : public DBGraphEdge {
 public:
     struct LinkOriginInfo {
@@ -26,8 +32,9 @@ public:
         uint64_t sequence_number;
     };
 
-    IFMapLink(const std::string &name);
-    const std::string &link_name() const { return link_name_; }
+    IFMapLink();
+    explicit IFMapLink(const std::string &name);
+    std::string link_name() const;
     
     // Initialize the link.
     void SetProperties(Edge edge, IFMapNode *left, IFMapNode *right,
@@ -61,10 +68,19 @@ public:
     IFMapNode *right() { return right_node_; }
     const IFMapNode *right() const { return right_node_; }
 
-    const IFMapNode::Descriptor &left_id() const { return left_id_; }
-    const IFMapNode::Descriptor &right_id() const { return right_id_; }
+    const std::string &left_type() const { return left_type_.str(); }
+    const std::string &left_name() const { return left_name_.str(); }
+    const std::string &right_type() const { return right_type_.str(); }
+    const std::string &right_name() const { return right_name_.str(); }
+
+    IFMapNode::Descriptor left_id() const {
+        return std::make_pair(left_type_.str(), left_name_.str());
+    }
+    IFMapNode::Descriptor right_id() const {
+        return std::make_pair(right_type_.str(), right_name_.str());
+    }
     
-    const std::string &metadata() const { return metadata_; }
+    const std::string &metadata() const { return metadata_.str(); }
 
     void AddOriginInfo(const IFMapOrigin &in_origin, uint64_t seq_num);
     void RemoveOriginInfo(IFMapOrigin::Origin in_origin);
@@ -80,11 +96,18 @@ public:
 
 private:
     friend class ShowIFMapLinkTable;
+    typedef std::pair<const char *, size_t> NamePiece;
+    static const int kNamePieces = 9;
+
+    int GetNamePieces(NamePiece *pieces) const;
 
-    std::string link_name_;
-    std::string metadata_;
-    IFMapNode::Descriptor left_id_;
-    IFMapNode::Descriptor right_id_;
+    std::string link_name_;     // only set in lookup entries
+    bool left_first_;           // the left node comes first in the name
+    IFMapSymbol metadata_;
+    IFMapSymbol left_type_;
+    IFMapSymbol left_name_;
+    IFMapSymbol right_type_;
+    IFMapSymbol right_name_;
     IFMapNode *left_node_;
     IFMapNode *right_node_;
     std::vector<LinkOriginInfo> origin_info_;
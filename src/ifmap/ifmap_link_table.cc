@@ -58,11 +58,16 @@ void IFMapLinkTable::AddLink(DBGraphBase::edge_descriptor edge,
         link->ClearDelete();
         link->set_last_change_at_to_now();
         partition->Change(link);
+        link->SetProperties(edge, left, right, metadata, sequence_number,
+                            origin);
     } else {
-        link = new IFMapLink(link_name);
+        // The name of the link is derived from its properties, so they
+        // must be set before it's added.
+        link = new IFMapLink();
+        link->SetProperties(edge, left, right, metadata, sequence_number,
+                            origin);
         partition->Add(link);
     }
-    link->SetProperties(edge, left, right, metadata, sequence_number, origin);
     graph_->SetEdgeProperty(link);
 }
 
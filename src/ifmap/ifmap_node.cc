@@ -110,10 +110,15 @@ void IFMapNode::EncodeNode(xml_node *parent) const {
     node.append_child("name").text().set(name_.c_str());
 }
 
-void IFMapNode::EncodeNode(const Descriptor &descriptor, xml_node *parent) {
+void IFMapNode::EncodeNode(const string &type, const string &name,
+                           xml_node *parent) {
     xml_node node = parent->append_child("node");
-    node.append_attribute("type") = descriptor.first.c_str();
-    node.append_child("name").text().set(descriptor.second.c_str());
+    node.append_attribute("type") = type.c_str();
+    node.append_child("name").text().set(name.c_str());
+}
+
+void IFMapNode::EncodeNode(const Descriptor &descriptor, xml_node *parent) {
+    EncodeNode(descriptor.first, descriptor.second, parent);
 }
 
 DBEntryBase::KeyPtr IFMapNode::GetDBRequestKey() const {
@@ -40,6 +40,8 @@ public:
     
     void EncodeNodeDetail(pugi::xml_node *parent) const;
     void EncodeNode(pugi::xml_node *parent) const;
+    static void EncodeNode(const std::string &type, const std::string &name,
+                           pugi::xml_node *parent);
     static void EncodeNode(const Descriptor &descriptor,
                            pugi::xml_node *parent);
     
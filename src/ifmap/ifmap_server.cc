@@ -19,6 +19,7 @@
 #include "ifmap/ifmap_client.h"
 #include "ifmap/ifmap_exporter.h"
 #include "ifmap/ifmap_graph_walker.h"
+#include "ifmap/ifmap_initial_sync.h"
 #include "ifmap/ifmap_link_table.h"
 #include "ifmap/ifmap_log.h"
 #include "ifmap/ifmap_node.h"
@@ -198,11 +199,12 @@ IFMapServer::IFMapServer(DB *db, DBGraph *graph,
           queue_(new IFMapUpdateQueue(this)),
           exporter_(new IFMapExporter(this)),
           sender_(new IFMapUpdateSender(this, queue())),
+          initial_sync_(new IFMapInitialSync(this)),
           vm_uuid_mapper_(new IFMapVmUuidMapper(db_, this)),
           work_queue_(TaskScheduler::GetInstance()->GetTaskId("db::IFMapTable"),
               0, boost::bind(&IFMapServer::ClientWorker, this, _1)),
           io_service_(io_service), ifmap_manager_(NULL),
-          ifmap_channel_manager_(NULL) {
+          ifmap_channel_manager_(NULL), initial_sync_enabled_(false) {
 }
 
 IFMapServer::~IFMapServer() {
@@ -254,6 +256,7 @@ void IFMapServer::ClientUnregister(IFMapClient *client) {
                 client->identifier(), client->index());
     size_t index = client->index();
     sender_->CleanupClient(index);
+    initial_sync_->ClientCleanup(index);
     queue_->Leave(index);
     ImSz_t iret = index_map_.erase(index);
     assert(iret == 1);
@@ -266,7 +269,11 @@ bool IFMapServer::ProcessClientWork(bool add, IFMapClient *client) {
     if (add) {
         ClientRegister(client);
         ClientExporterSetup(client);
-        ClientGraphDownload(client);
+        if (initial_sync_enabled_) {
+            initial_sync_->ClientStart(client);
+        } else {
+            ClientGraphDownload(client);
+        }
     } else {
         RemoveSelfAddedLinksAndObjects(client);
         CleanupUuidMapper(client);
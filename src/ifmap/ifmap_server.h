@@ -26,6 +26,7 @@ class DBGraphVertex;
 class IFMapChannelManager;
 class IFMapClient;
 class IFMapExporter;
+class IFMapInitialSync;
 class IFMapNode;
 class IFMapUpdateQueue;
 class IFMapUpdateSender;
@@ -84,6 +85,7 @@ public:
     IFMapUpdateQueue *queue() { return queue_.get(); }
     IFMapUpdateSender *sender() { return sender_.get(); }
     IFMapExporter *exporter() { return exporter_.get(); }
+    IFMapInitialSync *initial_sync() { return initial_sync_.get(); }
     IFMapVmUuidMapper *vm_uuid_mapper() { return vm_uuid_mapper_.get(); }
     boost::asio::io_service *io_service() { return io_service_; }
     void set_ifmap_manager(IFMapManager *manager) {
@@ -101,6 +103,13 @@ public:
         return ifmap_channel_manager_;
     }
 
+    // Send the initial config of new clients as a snapshot rather than
+    // through the update queue.
+    void set_initial_sync_enabled(bool enabled) {
+        initial_sync_enabled_ = enabled;
+    }
+    bool initial_sync_enabled() const { return initial_sync_enabled_; }
+
     void ProcessVmSubscribe(std::string vr_name, std::string vm_uuid,
                             bool subscribe, bool has_vms);
     void ProcessVmSubscribe(std::string vr_name, std::string vm_uuid,
@@ -156,6 +165,7 @@ private:
     boost::scoped_ptr<IFMapUpdateQueue> queue_;
     boost::scoped_ptr<IFMapExporter> exporter_;
     boost::scoped_ptr<IFMapUpdateSender> sender_;
+    boost::scoped_ptr<IFMapInitialSync> initial_sync_;
     boost::scoped_ptr<IFMapVmUuidMapper> vm_uuid_mapper_;
     BitSet client_indexes_;
     ClientMap client_map_;
@@ -165,6 +175,7 @@ private:
     IFMapManager *ifmap_manager_;
     IFMapChannelManager *ifmap_channel_manager_;
     ClientHistory client_history_;
+    bool initial_sync_enabled_;
 };
 
 #endif /* defined(__ctrlplane__ifmap_server__) */
@@ -5,16 +5,20 @@
 #include <stdint.h>
 #include "ifmap/ifmap_server_parser.h"
 
+#include <algorithm>
+
 #include <pugixml/pugixml.hpp>
 #include "db/db.h"
 #include "ifmap/ifmap_server_table.h"
 #include "ifmap/ifmap_log.h"
 #include "ifmap/ifmap_log_types.h"
+#include "ifmap/ifmap_stream_parser.h"
 
 using namespace std;
 using namespace pugi;
 
 IFMapServerParser::ModuleMap IFMapServerParser::module_map_;
+const size_t IFMapServerParser::kReceiveChunkSize;
 
 static const char *NodeName(const xml_node &node) {
     const char *name = node.name();
@@ -213,22 +217,11 @@ void IFMapServerParser::ParseResults(
     }
 }
 
-// Called in the context of the ifmap client thread.
-bool IFMapServerParser::Receive(DB *db, const char *data, size_t length,
-                                uint64_t sequence_number) {
-    xml_document xdoc;
-    pugi::xml_parse_result result = xdoc.load_buffer(data, length);
-    if (!result) {
-        IFMAP_WARN(IFMapXmlLoadError, "Unable to load XML document", length);
-        return false;
-    }
-
-    IFMapServerParser::RequestList requests;
-    ParseResults(xdoc, &requests);
-
-    while (!requests.empty()) {
-        auto_ptr<DBRequest> req(requests.front());
-        requests.pop_front();
+void IFMapServerParser::EnqueueRequests(DB *db, RequestList *list,
+                                        uint64_t sequence_number) const {
+    while (!list->empty()) {
+        auto_ptr<DBRequest> req(list->front());
+        list->pop_front();
 
         IFMapTable::RequestKey *key =
                 static_cast<IFMapTable::RequestKey *>(req->key.get());
@@ -241,5 +234,33 @@ bool IFMapServerParser::Receive(DB *db, const char *data, size_t length,
             IFMAP_TRACE(IFMapTblNotFoundTrace, "Cant find table", key->id_type);
         }
     }
+}
+
+//
+// Called in the context of the ifmap client thread.
+//
+// The response is parsed in chunks, and the requests for each chunk are
+// enqueued before the next one is parsed, so neither a document for the whole
+// response nor the requests for all of it are ever held in memory. Items that
+// precede a parse error have already been applied when the error is detected.
+//
+bool IFMapServerParser::Receive(DB *db, const char *data, size_t length,
+                                uint64_t sequence_number) {
+    IFMapStreamParser parser(this);
+    RequestList requests;
+    for (size_t offset = 0; offset < length; offset += kReceiveChunkSize) {
+        size_t size = std::min(kReceiveChunkSize, length - offset);
+        bool success = parser.Parse(data + offset, size, &requests);
+        EnqueueRequests(db, &requests, sequence_number);
+        if (!success) {
+            IFMAP_WARN(IFMapXmlLoadError, "Unable to load XML document",
+                       length);
+            return false;
+        }
+    }
+    if (!parser.Complete()) {
+        IFMAP_WARN(IFMapXmlLoadError, "Incomplete XML document", length);
+        return false;
+    }
     return true;
 }
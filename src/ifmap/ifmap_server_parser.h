@@ -26,6 +26,9 @@ public:
     typedef std::map<std::string, MetadataParseFn> MetadataParseMap;
     typedef std::list<struct DBRequest *> RequestList;
 
+    // Size of the chunks in which Receive parses a response.
+    static const size_t kReceiveChunkSize = 64 * 1024;
+
     // Called for each resultItem element in the IF-MAP notification.
     bool ParseResultItem(const pugi::xml_node &parent, bool add_change,
                          RequestList *list) const;
@@ -45,6 +48,8 @@ private:
     typedef std::map<std::string, IFMapServerParser *> ModuleMap;
     static ModuleMap module_map_;
 
+    void EnqueueRequests(DB *db, RequestList *list,
+                         uint64_t sequence_number) const;
     bool ParseMetadata(const pugi::xml_node &node,
                        struct DBRequest *result) const;
 
@@ -30,6 +30,7 @@
 #include "ifmap/ifmap_log_types.h"
 #include "ifmap/ifmap_table.h"
 #include "ifmap/ifmap_update.h"
+#include "ifmap/ifmap_update_sender.h"
 #include "ifmap/ifmap_uuid_mapper.h"
 
 #include <pugixml/pugixml.hpp>
@@ -1905,6 +1906,42 @@ void IFMapServerClientShowReq::HandleRequest() const {
     RequestPipeline rp(ps);
 }
 
+static bool IFMapUpdateSenderShowReqHandleRequest(const Sandesh *sr,
+                const RequestPipeline::PipeSpec ps, int stage, int instNum,
+                RequestPipeline::InstData *data) {
+    const IFMapUpdateSenderShowReq *request =
+        static_cast<const IFMapUpdateSenderShowReq *>(ps.snhRequest_.get());
+    IFMapSandeshContext *sctx =
+        static_cast<IFMapSandeshContext *>(request->module_context("IFMap"));
+
+    IFMapUpdateSenderShowResp *response = new IFMapUpdateSenderShowResp();
+    IFMapUpdateSenderStats stats;
+    sctx->ifmap_server()->sender()->GetStats(&stats);
+
+    response->set_sender_stats(stats);
+    response->set_context(request->context());
+    response->set_more(false);
+    response->Response();
+
+    // Return 'true' so that we are not called again
+    return true;
+}
+
+// The sender runs in the db::IFMapTable task, so read its stats from there.
+void IFMapUpdateSenderShowReq::HandleRequest() const {
+
+    RequestPipeline::StageSpec s0;
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+
+    s0.taskId_ = scheduler->GetTaskId("db::IFMapTable");
+    s0.cbFn_ = IFMapUpdateSenderShowReqHandleRequest;
+    s0.instances_.push_back(0);
+
+    RequestPipeline::PipeSpec ps(this);
+    ps.stages_= boost::assign::list_of(s0);
+    RequestPipeline rp(ps);
+}
+
 static bool IFMapNodeTableListShowReqHandleRequest(const Sandesh *sr,
                 const RequestPipeline::PipeSpec ps, int stage, int instNum,
                 RequestPipeline::InstData *data) {
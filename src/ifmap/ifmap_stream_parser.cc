@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "ifmap/ifmap_stream_parser.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+using pugi::xml_parse_result;
+
+IFMapStreamParser::IFMapStreamParser(const IFMapServerParser *parser)
+    : parser_(parser) {
+    Reset();
+}
+
+void IFMapStreamParser::Reset() {
+    doc_.reset();
+    buffer_.clear();
+    state_ = Text;
+    offset_ = 0;
+    tag_start_ = 0;
+    name_start_ = 0;
+    depth_ = 0;
+    quote_ = 0;
+    markup_end_ = NULL;
+    prev_ = 0;
+    end_tag_ = false;
+    add_change_ = false;
+    result_depth_ = 0;
+    item_depth_ = 0;
+    item_start_ = 0;
+    items_ = 0;
+}
+
+bool IFMapStreamParser::Complete() const {
+    return (state_ == Text && depth_ == 0);
+}
+
+//
+// Return the terminator of the markup that starts with "<!" followed by the
+// given data, or NULL if more data is needed to tell. The prefix is set to
+// the size of the "--" or "[CDATA[" that opens the markup, so that it isn't
+// taken as part of the terminator.
+//
+const char *IFMapStreamParser::MarkupEnd(const char *data, size_t size,
+                                         size_t *prefix) {
+    static const char kComment[] = "--";
+    static const char kCData[] = "[CDATA[";
+    const size_t kCommentSize = sizeof(kComment) - 1;
+    const size_t kCDataSize = sizeof(kCData) - 1;
+
+    if (memcmp(data, kComment, std::min(size, kCommentSize)) == 0) {
+        *prefix = kCommentSize;
+        return (size < kCommentSize) ? NULL : "-->";
+    }
+    if (memcmp(data, kCData, std::min(size, kCDataSize)) == 0) {
+        *prefix = kCDataSize;
+        return (size < kCDataSize) ? NULL : "]]>";
+    }
+    *prefix = 0;
+    return ">";
+}
+
+//
+// Match the local name of an element against the result elements.
+//
+bool IFMapStreamParser::IsResultName(const char *name, size_t size,
+                                     bool *add_change) const {
+    const char *colon = static_cast<const char *>(memchr(name, ':', size));
+    if (colon) {
+        size -= colon + 1 - name;
+        name = colon + 1;
+    }
+    if (size != 12)
+        return false;
+    if (memcmp(name, "updateResult", 12) == 0 ||
+        memcmp(name, "searchResult", 12) == 0) {
+        *add_change = true;
+        return true;
+    }
+    if (memcmp(name, "deleteResult", 12) == 0) {
+        *add_change = false;
+        return true;
+    }
+    return false;
+}
+
+//
+// Load the result item that ends at the given position and convert it to
+// requests. The item is parsed in place, since it's dropped from the buffer
+// right after.
+//
+bool IFMapStreamParser::ParseItem(size_t end, RequestList *list) {
+    xml_parse_result result =
+        doc_.load_buffer_inplace(&buffer_[item_start_], end - item_start_);
+    if (!result) {
+        doc_.reset();
+        return false;
+    }
+    parser_->ParseResultItem(doc_.first_child(), add_change_, list);
+    doc_.reset();
+    items_++;
+    return true;
+}
+
+//
+// Handle the '>' that closes the current tag, which ends at the given
+// position. Return false if the response is not well formed.
+//
+bool IFMapStreamParser::TagClose(size_t end, RequestList *list) {
+    if (end_tag_) {
+        if (depth_ == 0)
+            return false;
+        bool success = true;
+        if (depth_ == item_depth_) {
+            success = ParseItem(end, list);
+            item_depth_ = 0;
+        } else if (depth_ == result_depth_) {
+            result_depth_ = 0;
+        }
+        depth_--;
+        return success;
+    }
+
+    // Empty element tags don't change the depth. An empty result item has
+    // no identity, so there's nothing to parse.
+    if (prev_ == '/')
+        return true;
+
+    if (item_depth_ == 0 && result_depth_ != 0 && depth_ == result_depth_) {
+        item_start_ = tag_start_;
+        item_depth_ = depth_ + 1;
+    }
+    depth_++;
+    return true;
+}
+
+//
+// Drop the data that is no longer needed: everything before the current
+// result item or, outside of result items, before the current tag.
+//
+void IFMapStreamParser::Compact() {
+    size_t keep;
+    if (item_depth_ != 0) {
+        keep = item_start_;
+    } else if (state_ == Text || state_ == Markup) {
+        keep = offset_;
+    } else {
+        keep = tag_start_;
+    }
+    if (keep == 0)
+        return;
+    buffer_.erase(0, keep);
+    offset_ -= keep;
+    tag_start_ = (tag_start_ >= keep) ? tag_start_ - keep : 0;
+    name_start_ = (name_start_ >= keep) ? name_start_ - keep : 0;
+    item_start_ = (item_start_ >= keep) ? item_start_ - keep : 0;
+}
+
+bool IFMapStreamParser::Parse(const char *data, size_t size,
+                              RequestList *list) {
+    buffer_.append(data, size);
+    const char *buf = buffer_.data();
+    size_t len = buffer_.size();
+    size_t pos = offset_;
+    bool wait = false;
+    while (pos < len && !wait) {
+        switch (state_) {
+        case Text: {
+            const char *lt = static_cast<const char *>(
+                memchr(buf + pos, '<', len - pos));
+            if (!lt) {
+                pos = len;
+                break;
+            }
+            tag_start_ = lt - buf;
+            pos = tag_start_ + 1;
+            state_ = TagOpen;
+            break;
+        }
+        case TagOpen: {
+            char c = buf[pos];
+            prev_ = 0;
+            end_tag_ = false;
+            if (c == '/') {
+                end_tag_ = true;
+                state_ = Tag;
+                pos++;
+            } else if (c == '?') {
+                markup_end_ = "?>";
+                state_ = Markup;
+                pos++;
+            } else if (c == '!') {
+                state_ = MarkupOpen;
+                pos++;
+            } else {
+                name_start_ = pos;
+                state_ = TagName;
+            }
+            break;
+        }
+        case TagName: {
+            for (; pos < len; ++pos) {
+                char c = buf[pos];
+                if (c == '>' || c == '/' ||
+                    c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+                    break;
+                }
+            }
+            if (pos == len)
+                break;
+            if (item_depth_ == 0 && result_depth_ == 0 &&
+                IsResultName(buf + name_start_, pos - name_start_,
+                             &add_change_)) {
+                result_depth_ = depth_ + 1;
+            }
+            state_ = Tag;
+            break;
+        }
+        case Tag: {
+            char c = 0;
+            for (; pos < len; ++pos) {
+                c = buf[pos];
+                if (c == '>' || c == '\'' || c == '"')
+                    break;
+                prev_ = c;
+            }
+            if (pos == len)
+                break;
+            pos++;
+            if (c == '>') {
+                state_ = Text;
+                if (!TagClose(pos, list)) {
+                    offset_ = pos;
+                    return false;
+                }
+                // An empty result element doesn't have any items.
+                if (!end_tag_ && prev_ == '/' &&
+                    result_depth_ == depth_ + 1) {
+                    result_depth_ = 0;
+                }
+            } else {
+                quote_ = c;
+                state_ = Quote;
+            }
+            break;
+        }
+        case Quote: {
+            const char *end = static_cast<const char *>(
+                memchr(buf + pos, quote_, len - pos));
+            if (!end) {
+                pos = len;
+                break;
+            }
+            pos = end - buf + 1;
+            prev_ = quote_;
+            state_ = Tag;
+            break;
+        }
+        case MarkupOpen: {
+            size_t prefix;
+            markup_end_ = MarkupEnd(buf + pos, len - pos, &prefix);
+            if (!markup_end_) {
+                wait = true;
+                break;
+            }
+            pos += prefix;
+            state_ = Markup;
+            break;
+        }
+        case Markup: {
+            size_t end_size = strlen(markup_end_);
+            const char *end = std::search(buf + pos, buf + len,
+                                          markup_end_, markup_end_ + end_size);
+            if (end == buf + len) {
+                // The terminator may be split across chunks.
+                pos = std::max(pos, len - std::min(len, end_size - 1));
+                wait = true;
+                break;
+            }
+            pos = end - buf + end_size;
+            state_ = Text;
+            break;
+        }
+        }
+    }
+
+    offset_ = pos;
+    Compact();
+    return true;
+}
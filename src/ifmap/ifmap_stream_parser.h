@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef __ctrlplane__ifmap_stream_parser__
+#define __ctrlplane__ifmap_stream_parser__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+#include <pugixml/pugixml.hpp>
+
+#include "base/util.h"
+#include "ifmap/ifmap_server_parser.h"
+
+//
+// Incremental parser for IF-MAP poll and search responses.
+//
+// The response is fed in chunks of any size. A scanner that keeps its state
+// across chunks follows the element structure of the response and looks for
+// the children of updateResult, searchResult and deleteResult elements. Each
+// of those result items is loaded into a small document once its end tag
+// has been seen, and converted to DB requests with the metadata parsers of
+// the IFMapServerParser. Nothing outside the result items is kept, so the
+// memory used is bounded by the size of the largest result item plus the
+// size of a chunk, rather than by the size of the response.
+//
+// Processing instructions end at "?>", comments at "-->" and CDATA sections
+// at "]]>". Other declarations are skipped up to the next '>'; the IF-MAP
+// server doesn't put '>' in any of them.
+//
+class IFMapStreamParser {
+public:
+    typedef IFMapServerParser::RequestList RequestList;
+
+    explicit IFMapStreamParser(const IFMapServerParser *parser);
+
+    // Parse the next chunk of the response. The requests for the result
+    // items completed by the chunk are appended to the list. Returns false
+    // if the response is not well formed.
+    bool Parse(const char *data, size_t size, RequestList *list);
+
+    // Returns true if the response parsed so far is complete.
+    bool Complete() const;
+
+    void Reset();
+
+    // Bytes carried over to the next chunk.
+    size_t buffered() const { return buffer_.size(); }
+    uint64_t items() const { return items_; }
+
+private:
+    enum State {
+        Text,
+        TagOpen,
+        TagName,
+        Tag,
+        Quote,
+        MarkupOpen,
+        Markup
+    };
+
+    static const char *MarkupEnd(const char *data, size_t size,
+                                 size_t *prefix);
+    bool IsResultName(const char *name, size_t size, bool *add_change) const;
+    bool TagClose(size_t end, RequestList *list);
+    bool ParseItem(size_t end, RequestList *list);
+    void Compact();
+
+    const IFMapServerParser *parser_;
+    pugi::xml_document doc_;
+    std::string buffer_;
+    State state_;
+    size_t offset_;             // scan position in buffer_
+    size_t tag_start_;          // position of the '<' of the current tag
+    size_t name_start_;
+    int depth_;
+    char quote_;
+    const char *markup_end_;    // terminator of the current markup
+    char prev_;
+    bool end_tag_;
+    bool add_change_;
+    int result_depth_;          // depth of the result element, 0 if none
+    int item_depth_;            // depth of the result item, 0 if none
+    size_t item_start_;
+    uint64_t items_;
+
+    DISALLOW_COPY_AND_ASSIGN(IFMapStreamParser);
+};
+
+#endif /* defined(__ctrlplane__ifmap_stream_parser__) */
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "ifmap/ifmap_symbol.h"
+
+#include <boost/unordered_map.hpp>
+#include <tbb/mutex.h>
+
+using std::string;
+
+namespace {
+
+//
+// The entries are the nodes of the map, so their addresses don't change as
+// the map grows. The table is never destroyed, since symbols may outlive any
+// static destructor.
+//
+struct SymbolTable {
+    typedef boost::unordered_map<string, tbb::atomic<int> > Map;
+
+    SymbolTable() : bytes(0) {
+    }
+
+    tbb::mutex mutex;
+    Map map;
+    size_t bytes;
+};
+
+SymbolTable *symbol_table = new SymbolTable();
+
+const string empty_string;
+
+}  // namespace
+
+IFMapSymbol::IFMapSymbol(const string &str) : entry_(NULL) {
+    if (str.empty()) {
+        return;
+    }
+    tbb::mutex::scoped_lock lock(symbol_table->mutex);
+    SymbolTable::Map::iterator loc = symbol_table->map.find(str);
+    if (loc == symbol_table->map.end()) {
+        tbb::atomic<int> refcount;
+        refcount = 0;
+        loc = symbol_table->map.insert(std::make_pair(str, refcount)).first;
+        symbol_table->bytes += str.size();
+    }
+    loc->second++;
+    entry_ = &*loc;
+}
+
+IFMapSymbol::IFMapSymbol(const IFMapSymbol &rhs) : entry_(rhs.entry_) {
+    if (entry_) {
+        entry_->second++;
+    }
+}
+
+IFMapSymbol::~IFMapSymbol() {
+    Release();
+}
+
+IFMapSymbol &IFMapSymbol::operator=(const IFMapSymbol &rhs) {
+    Entry *entry = rhs.entry_;
+    if (entry) {
+        entry->second++;
+    }
+    Release();
+    entry_ = entry;
+    return *this;
+}
+
+const string &IFMapSymbol::str() const {
+    return entry_ ? entry_->first : empty_string;
+}
+
+//
+// References other than the last one are dropped without the lock. The last
+// one is dropped with the lock held, so that a concurrent lookup of the same
+// string can't pick up an entry that is being removed. The lookup may add a
+// reference before the lock is taken here, so the count is only known to
+// reach 0 under the lock. References are only added without the lock by
+// copying a live symbol, which can't race with the last one going away.
+//
+void IFMapSymbol::Release() {
+    if (entry_ == NULL) {
+        return;
+    }
+    Entry *entry = entry_;
+    entry_ = NULL;
+    while (true) {
+        int count = entry->second;
+        if (count <= 1) {
+            break;
+        }
+        if (entry->second.compare_and_swap(count - 1, count) == count) {
+            return;
+        }
+    }
+    tbb::mutex::scoped_lock lock(symbol_table->mutex);
+    if (--entry->second == 0) {
+        symbol_table->bytes -= entry->first.size();
+        symbol_table->map.erase(symbol_table->map.find(entry->first));
+    }
+}
+
+size_t IFMapSymbol::TableSize() {
+    tbb::mutex::scoped_lock lock(symbol_table->mutex);
+    return symbol_table->map.size();
+}
+
+size_t IFMapSymbol::TableBytes() {
+    tbb::mutex::scoped_lock lock(symbol_table->mutex);
+    return symbol_table->bytes;
+}
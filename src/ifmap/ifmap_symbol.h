@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef __ctrlplane__ifmap_symbol__
+#define __ctrlplane__ifmap_symbol__
+
+#include <stddef.h>
+#include <string>
+#include <utility>
+
+#include <tbb/atomic.h>
+
+//
+// An immutable string that is interned in a process wide table.
+//
+// Equal strings share a single refcounted copy, which is removed from the
+// table when the last symbol that refers to it goes away. This is meant for
+// the strings that the configuration graph repeats for every object, such
+// as type and metadata names, and the node names kept by each link.
+//
+// Symbols can be created and destroyed from any task. Copying a symbol and
+// destroying it while other references remain only update the refcount;
+// creating one from a string and destroying the last reference take the
+// table lock.
+//
+class IFMapSymbol {
+public:
+    IFMapSymbol() : entry_(NULL) {
+    }
+    explicit IFMapSymbol(const std::string &str);
+    IFMapSymbol(const IFMapSymbol &rhs);
+    ~IFMapSymbol();
+
+    IFMapSymbol &operator=(const IFMapSymbol &rhs);
+
+    const std::string &str() const;
+    bool empty() const { return entry_ == NULL; }
+
+    // Equal strings are the same entry.
+    bool operator==(const IFMapSymbol &rhs) const {
+        return entry_ == rhs.entry_;
+    }
+    bool operator!=(const IFMapSymbol &rhs) const {
+        return entry_ != rhs.entry_;
+    }
+
+    // Number of distinct strings in the table and the bytes they hold.
+    static size_t TableSize();
+    static size_t TableBytes();
+
+private:
+    typedef std::pair<const std::string, tbb::atomic<int> > Entry;
+
+    void Release();
+
+    Entry *entry_;
+};
+
+#endif /* defined(__ctrlplane__ifmap_symbol__) */
@@ -8,6 +8,7 @@
 #include <boost/crc.hpp>      // for boost::crc_32_type
 #include <boost/intrusive/list.hpp>
 #include <boost/intrusive/slist.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include "base/bitset.h"
 #include "base/dependency.h"
@@ -84,6 +85,10 @@ struct IFMapListEntry {
 
 class IFMapUpdate : public IFMapListEntry {
 public:
+    // The XML encoding of the node or link, shared by all the messages that
+    // carry this update.
+    typedef boost::shared_ptr<const std::string> Fragment;
+
     IFMapUpdate(IFMapNode *node, bool positive);
     IFMapUpdate(IFMapLink *link, bool positive);
     virtual ~IFMapUpdate() { }
@@ -99,11 +104,18 @@ public:
     bool IsNode() const { return data_.IsNode(); }
     bool IsLink() const { return data_.IsLink(); }
 
+    const Fragment &fragment() const { return fragment_; }
+    void set_fragment(const Fragment &fragment) { fragment_ = fragment; }
+    // Called when the contents of the node change. Messages that already
+    // hold a reference keep the previous encoding.
+    void ClearFragment() { fragment_.reset(); }
+
 private:
     friend class IFMapState;
     boost::intrusive::slist_member_hook<> node_;
     IFMapObjectPtr data_;
     BitSet advertise_;
+    Fragment fragment_;
 };
 
 struct IFMapMarker : public IFMapListEntry {
@@ -193,6 +205,7 @@ public:
     const BitSet &nmask() const { return nmask_; }
     void nmask_clear() { nmask_.clear(); }
     void nmask_set(int bit) { nmask_.set(bit); }
+    void nmask_or(const BitSet &bset) { nmask_ |= bset; }
     virtual bool CanDelete() {
         return (update_list().empty() && IsInvalid() && !HasDependents());
     }
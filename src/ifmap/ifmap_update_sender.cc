@@ -10,6 +10,7 @@
 #include "ifmap/ifmap_exporter.h"
 #include "ifmap/ifmap_log.h"
 #include "ifmap/ifmap_log_types.h"
+#include "ifmap/ifmap_server_show_types.h"
 #include "ifmap/ifmap_update.h"
 #include "ifmap/ifmap_update_queue.h"
 
@@ -18,7 +19,8 @@ using namespace std;
 IFMapUpdateSender::IFMapUpdateSender(IFMapServer *server,
                                      IFMapUpdateQueue *queue)
     : server_(server), queue_(queue), message_(new IFMapMessage()),
-      task_scheduled_(false), queue_active_(false) {
+      task_scheduled_(false), queue_active_(false), messages_(0),
+      client_messages_(0), fragments_sent_(0) {
 }
 
 IFMapUpdateSender::~IFMapUpdateSender() {
@@ -263,6 +265,8 @@ void IFMapUpdateSender::SendUpdate(BitSet send_set, BitSet *blocked_set) {
 
         // Send the string version of the message to the client.
         send_result = client->SendUpdate(message_->c_str());
+        client_messages_++;
+        fragments_sent_ += message_->fragment_count();
 
         // Keep track of all the clients whose buffers are full. 
         if (!send_result) {
@@ -270,10 +274,33 @@ void IFMapUpdateSender::SendUpdate(BitSet send_set, BitSet *blocked_set) {
             send_blocked_.set(i);
         }
     }
+    messages_++;
     // Reset the message to init things for the next message
     message_->Reset();
 }
 
+//
+// Every fragment is encoded once and then copied into the message of each
+// receiver. The time saved is estimated from the average encode time of a
+// fragment and the number of fragments that would otherwise have been
+// encoded again for each additional receiver.
+//
+void IFMapUpdateSender::GetStats(IFMapUpdateSenderStats *stats) const {
+    uint64_t encoded = message_->fragments_encoded();
+    uint64_t encode_usecs = message_->encode_usecs();
+    stats->set_messages(messages_);
+    stats->set_client_messages(client_messages_);
+    stats->set_fragments_encoded(encoded);
+    stats->set_fragments_reused(message_->fragments_reused());
+    stats->set_fragments_sent(fragments_sent_);
+    stats->set_encode_usecs(encode_usecs);
+    uint64_t saved = 0;
+    if (encoded && fragments_sent_ > encoded) {
+        saved = encode_usecs * (fragments_sent_ - encoded) / encoded;
+    }
+    stats->set_encode_usecs_saved(saved);
+}
+
 // marker is before next_marker in the Q. next_marker could be the tail_marker.
 // 'done' is set to true only if all the clients in the union of the
 // client-sets of the 2 markers are blocked.
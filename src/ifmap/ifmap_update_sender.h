@@ -15,6 +15,7 @@ class IFMapServer;
 class IFMapState;
 class IFMapUpdate;
 class IFMapUpdateQueue;
+class IFMapUpdateSenderStats;
 
 class IFMapUpdateSender {
 public:
@@ -42,6 +43,8 @@ public:
         return send_blocked_.test(client_index);
     }
 
+    void GetStats(IFMapUpdateSenderStats *stats) const;
+
 private:
     class SendTask;
     friend class IFMapUpdateSenderTest;
@@ -70,6 +73,10 @@ private:
     BitSet send_scheduled_;     // client-set for which send active was called
     BitSet send_blocked_;       // client-set for clients that are blocked
 
+    uint64_t messages_;         // messages built
+    uint64_t client_messages_;  // messages sent, one per receiver
+    uint64_t fragments_sent_;   // fragments sent, once per receiver
+
     void SetSendBlocked(int client_index) {
         send_blocked_.set(client_index);
     }
@@ -17,6 +17,7 @@
 #include "ifmap/ifmap_factory.h"
 #include "ifmap/ifmap_log.h"
 #include "ifmap/ifmap_sandesh_context.h"
+#include "ifmap/ifmap_initial_sync.h"
 #include "ifmap/ifmap_server.h"
 #include "ifmap/ifmap_server_show_types.h"
 #include "ifmap/ifmap_log_types.h"
@@ -128,6 +129,7 @@ bool IFMapXmppChannel::IFMapSender::SendUpdate(const std::string &msg) {
 
 void IFMapXmppChannel::WriteReadyCb(const boost::system::error_code &ec) {
     ifmap_client_->set_send_is_blocked(false);
+    ifmap_server_->initial_sync()->SendActive(ifmap_client_->index());
     ifmap_server_->sender()->SendActive(ifmap_client_->index());
 }
 
@@ -9,8 +9,10 @@
 #include <boost/bind.hpp>
 #include <boost/assign/list_of.hpp>
 #include "base/logging.h"
+#include "base/time_util.h"
 
 #include "ifmap/ifmap_client.h"
+#include "ifmap/ifmap_initial_sync.h"
 #include "ifmap/ifmap_sandesh_context.h"
 #include "ifmap/ifmap_server.h"
 #include "ifmap/ifmap_xmpp.h"
@@ -46,14 +48,15 @@ public:
     static bool BufferStage(const Sandesh *sr,
                             const RequestPipeline::PipeSpec ps, int stage,
                             int instNum, RequestPipeline::InstData *data);
-    static void CopyNode(IFMapXmppClientInfo *dest, IFMapClient *src);
+    static void CopyNode(IFMapXmppClientInfo *dest, IFMapClient *src,
+                         const IFMapInitialSync *initial_sync);
     static bool SendStage(const Sandesh *sr, const RequestPipeline::PipeSpec ps,
                           int stage, int instNum,
                           RequestPipeline::InstData *data);
 };
 
 void ShowIFMapXmppClientInfo::CopyNode(IFMapXmppClientInfo *dest,
-                                       IFMapClient *src) {
+        IFMapClient *src, const IFMapInitialSync *initial_sync) {
     dest->set_client_name(src->identifier());
     dest->set_client_index(src->index());
     dest->set_msgs_sent(src->msgs_sent());
@@ -64,6 +67,19 @@ void ShowIFMapXmppClientInfo::CopyNode(IFMapXmppClientInfo *dest,
     dest->set_delete_links_sent(src->delete_links_sent());
     dest->set_bytes_sent(src->bytes_sent());
     dest->set_is_blocked(src->send_is_blocked());
+    dest->set_config_sync_usecs(src->config_sync_usecs());
+    dest->set_config_sync_objects(src->config_sync_objects());
+
+    // A snapshot that is in progress, e.g. while the client is blocked.
+    uint64_t start_at, objects_sent, objects_remaining;
+    if (initial_sync->GetProgress(src->index(), &start_at, &objects_sent,
+                                  &objects_remaining)) {
+        dest->set_config_sync_in_progress(true);
+        dest->set_config_sync_objects_sent(objects_sent);
+        dest->set_config_sync_objects_remaining(objects_remaining);
+        dest->set_config_sync_start_time_ago(
+            duration_usecs_to_string(ClockMonotonicUsec() - start_at));
+    }
 
     VmRegInfo vm_reg_info;
     vm_reg_info.vm_list = src->vm_list();
@@ -90,7 +106,7 @@ bool ShowIFMapXmppClientInfo::BufferStage(const Sandesh *sr,
          iter != client_map.end(); ++iter) {
 	IFMapXmppClientInfo dest;
         IFMapClient *src = iter->second;
-	CopyNode(&dest, src);
+	CopyNode(&dest, src, server->initial_sync());
         show_data->send_buffer.push_back(dest);
     }
 
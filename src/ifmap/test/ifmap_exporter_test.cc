@@ -11,6 +11,8 @@
 #include "db/db_graph.h"
 #include "io/event_manager.h"
 #include "ifmap/ifmap_client.h"
+#include "ifmap/ifmap_graph_walker.h"
+#include "ifmap/ifmap_initial_sync.h"
 #include "ifmap/ifmap_link.h"
 #include "ifmap/ifmap_link_table.h"
 #include "ifmap/ifmap_server.h"
@@ -33,7 +35,7 @@ using namespace std;
 class TestClient : public IFMapClient {
 public:
     TestClient(const string &addr)
-        : identifier_(addr) {
+        : identifier_(addr), count_(0), blocked_(false) {
     }
 
     virtual const string &identifier() const {
@@ -41,11 +43,18 @@ public:
     }
 
     virtual bool SendUpdate(const std::string &msg) {
-        return true;
+        count_++;
+        set_send_is_blocked(blocked_);
+        return !blocked_;
     }
 
+    int count() const { return count_; }
+    void set_blocked(bool blocked) { blocked_ = blocked; }
+
 private:
     string identifier_;
+    int count_;
+    bool blocked_;
 };
 
 class IFMapUpdateSenderMock : public IFMapUpdateSender {
@@ -1245,6 +1254,281 @@ TEST_F(IFMapExporterTest, ConfigTracker) {
     TASK_UTIL_EXPECT_EQ(LinkTableSize(), 10);
 }
 
+// A link delete doesn't remove the interest in a node that is still
+// reachable via another path.
+TEST_F(IFMapExporterTest, LinkDeleteAlternatePath) {
+    server_.SetSender(new IFMapUpdateSenderMock(&server_));
+    TestClient c1("192.168.1.1");
+    ClientSetup(&c1);
+
+    IFMapMsgLink("project", "virtual-network", "vnc", "blue");
+    IFMapMsgLink("virtual-machine", "virtual-machine-interface",
+                 "vm_x", "vm_x:veth0");
+    IFMapMsgLink("virtual-machine", "virtual-machine-interface",
+                 "vm_x", "vm_x:veth1");
+    IFMapMsgLink("virtual-machine-interface", "virtual-network",
+                 "vm_x:veth0", "blue");
+    IFMapMsgLink("virtual-machine-interface", "virtual-network",
+                 "vm_x:veth1", "blue");
+    IFMapMsgLink("virtual-router", "virtual-machine", "192.168.1.1", "vm_x");
+    task_util::WaitForIdle();
+
+    IFMapNode *blue = TableLookup("virtual-network", "blue");
+    ASSERT_TRUE(blue != NULL);
+    IFMapNode *veth0 = TableLookup("virtual-machine-interface", "vm_x:veth0");
+    ASSERT_TRUE(veth0 != NULL);
+    EXPECT_TRUE(exporter_->NodeStateLookup(blue)->interest().test(
+        c1.index()));
+
+    IFMapMsgUnlink("virtual-machine-interface", "virtual-network",
+                   "vm_x:veth0", "blue");
+    task_util::WaitForIdle();
+    EXPECT_TRUE(exporter_->NodeStateLookup(blue)->interest().test(
+        c1.index()));
+    EXPECT_TRUE(exporter_->NodeStateLookup(veth0)->interest().test(
+        c1.index()));
+
+    IFMapMsgUnlink("virtual-machine-interface", "virtual-network",
+                   "vm_x:veth1", "blue");
+    task_util::WaitForIdle();
+    EXPECT_FALSE(exporter_->NodeStateLookup(blue)->interest().test(
+        c1.index()));
+    EXPECT_TRUE(exporter_->NodeStateLookup(veth0)->interest().test(
+        c1.index()));
+}
+
+// A link delete only revisits the part of the graph reachable from the link.
+TEST_F(IFMapExporterTest, LinkDeleteRegion) {
+    server_.SetSender(new IFMapUpdateSenderMock(&server_));
+    TestClient c1("192.168.1.1");
+    ClientSetup(&c1);
+    TestClient c2("192.168.1.2");
+    ClientSetup(&c2);
+
+    IFMapMsgLink("project", "virtual-network", "vnc", "blue");
+    IFMapMsgLink("project", "virtual-network", "vnc", "red");
+    IFMapMsgLink("virtual-machine", "virtual-machine-interface",
+                 "vm_x", "vm_x:veth0");
+    IFMapMsgLink("virtual-machine-interface", "virtual-network",
+                 "vm_x:veth0", "blue");
+    IFMapMsgLink("virtual-machine", "virtual-machine-interface",
+                 "vm_y", "vm_y:veth0");
+    IFMapMsgLink("virtual-machine-interface", "virtual-network",
+                 "vm_y:veth0", "red");
+    IFMapMsgLink("virtual-router", "virtual-machine", "192.168.1.1", "vm_x");
+    IFMapMsgLink("virtual-router", "virtual-machine", "192.168.1.2", "vm_y");
+    task_util::WaitForIdle();
+
+    IFMapNode *blue = TableLookup("virtual-network", "blue");
+    ASSERT_TRUE(blue != NULL);
+    IFMapNode *red = TableLookup("virtual-network", "red");
+    ASSERT_TRUE(red != NULL);
+    IFMapNode *vm_y = TableLookup("virtual-machine", "vm_y");
+    ASSERT_TRUE(vm_y != NULL);
+    EXPECT_TRUE(exporter_->NodeStateLookup(red)->interest().test(
+        c2.index()));
+
+    IFMapGraphWalker *walker = exporter_->graph_walker();
+    uint64_t walks = walker->link_delete_walks();
+    uint64_t walk_nodes = walker->link_delete_walk_nodes();
+
+    IFMapMsgUnlink("virtual-machine-interface", "virtual-network",
+                   "vm_y:veth0", "red");
+    task_util::WaitForIdle();
+    EXPECT_FALSE(exporter_->NodeStateLookup(red)->interest().test(
+        c2.index()));
+    EXPECT_TRUE(exporter_->NodeStateLookup(vm_y)->interest().test(
+        c2.index()));
+    EXPECT_TRUE(exporter_->NodeStateLookup(blue)->interest().test(
+        c1.index()));
+
+    // The region is red, vm_y:veth0 and vm_y.
+    EXPECT_EQ(walks + 1, walker->link_delete_walks());
+    EXPECT_EQ(walk_nodes + 3, walker->link_delete_walk_nodes());
+}
+
+// Link deletes in separate regions are recomputed in separate runs of the
+// walk when a run is limited to fewer nodes than the regions have.
+TEST_F(IFMapExporterTest, LinkDeleteBounded) {
+    server_.SetSender(new IFMapUpdateSenderMock(&server_));
+    TestClient c1("192.168.1.1");
+    ClientSetup(&c1);
+    TestClient c2("192.168.1.2");
+    ClientSetup(&c2);
+
+    IFMapMsgLink("project", "virtual-network", "vnc", "blue");
+    IFMapMsgLink("project", "virtual-network", "vnc", "red");
+    IFMapMsgLink("virtual-machine", "virtual-machine-interface",
+                 "vm_x", "vm_x:veth0");
+    IFMapMsgLink("virtual-machine-interface", "virtual-network",
+                 "vm_x:veth0", "blue");
+    IFMapMsgLink("virtual-machine", "virtual-machine-interface",
+                 "vm_y", "vm_y:veth0");
+    IFMapMsgLink("virtual-machine-interface", "virtual-network",
+                 "vm_y:veth0", "red");
+    IFMapMsgLink("virtual-router", "virtual-machine", "192.168.1.1", "vm_x");
+    IFMapMsgLink("virtual-router", "virtual-machine", "192.168.1.2", "vm_y");
+    task_util::WaitForIdle();
+
+    IFMapNode *blue = TableLookup("virtual-network", "blue");
+    ASSERT_TRUE(blue != NULL);
+    IFMapNode *red = TableLookup("virtual-network", "red");
+    ASSERT_TRUE(red != NULL);
+    EXPECT_TRUE(exporter_->NodeStateLookup(blue)->interest().test(
+        c1.index()));
+    EXPECT_TRUE(exporter_->NodeStateLookup(red)->interest().test(
+        c2.index()));
+
+    IFMapGraphWalker *walker = exporter_->graph_walker();
+    walker->set_link_delete_walk_max_nodes(1);
+    uint64_t walks = walker->link_delete_walks();
+    uint64_t walk_nodes = walker->link_delete_walk_nodes();
+
+    // Delete both links in the same batch.
+    task_util::TaskSchedulerStop();
+    IFMapMsgUnlink("virtual-machine-interface", "virtual-network",
+                   "vm_x:veth0", "blue");
+    IFMapMsgUnlink("virtual-machine-interface", "virtual-network",
+                   "vm_y:veth0", "red");
+    task_util::TaskSchedulerStart();
+    task_util::WaitForIdle();
+
+    EXPECT_FALSE(exporter_->NodeStateLookup(blue)->interest().test(
+        c1.index()));
+    EXPECT_FALSE(exporter_->NodeStateLookup(red)->interest().test(
+        c2.index()));
+
+    // Each region has 3 nodes and is recomputed in its own run.
+    EXPECT_EQ(walks + 2, walker->link_delete_walks());
+    EXPECT_EQ(walk_nodes + 6, walker->link_delete_walk_nodes());
+}
+
+//
+// The initial config of a new client is sent as a snapshot, without going
+// through the update queue, and later changes are sent incrementally.
+//
+TEST_F(IFMapExporterTest, InitialSync) {
+    server_.SetSender(new IFMapUpdateSenderMock(&server_));
+    server_.set_initial_sync_enabled(true);
+
+    IFMapMsgLink("virtual-machine", "virtual-machine-interface",
+                 "vm_x", "vm_x:veth0");
+    IFMapMsgLink("virtual-machine-interface", "virtual-network",
+                 "vm_x:veth0", "blue");
+    IFMapMsgLink("virtual-router", "virtual-machine", "192.168.1.1", "vm_x");
+    task_util::WaitForIdle();
+
+    TestClient c1("192.168.1.1");
+    server_.ProcessClientWork(true, &c1);
+    task_util::WaitForIdle();
+
+    EXPECT_FALSE(server_.initial_sync()->IsSyncing(c1.index()));
+    EXPECT_EQ(1, c1.count());
+    EXPECT_LE(4U, c1.update_nodes_sent());
+    EXPECT_LE(3U, c1.update_links_sent());
+    EXPECT_EQ(c1.update_nodes_sent() + c1.update_links_sent(),
+              c1.config_sync_objects());
+
+    IFMapNode *blue = TableLookup("virtual-network", "blue");
+    ASSERT_TRUE(blue != NULL);
+    IFMapNodeState *state = exporter_->NodeStateLookup(blue);
+    EXPECT_TRUE(state->interest().test(c1.index()));
+    EXPECT_TRUE(state->advertised().test(c1.index()));
+    EXPECT_TRUE(state->GetUpdate(IFMapListEntry::UPDATE) == NULL);
+
+    IFMapMsgLink("virtual-machine-interface", "virtual-network",
+                 "vm_x:veth0", "red");
+    task_util::WaitForIdle();
+    IFMapNode *red = TableLookup("virtual-network", "red");
+    ASSERT_TRUE(red != NULL);
+    IFMapUpdate *update =
+        exporter_->NodeStateLookup(red)->GetUpdate(IFMapListEntry::UPDATE);
+    ASSERT_TRUE(update != NULL);
+    EXPECT_TRUE(update->advertise().test(c1.index()));
+}
+
+//
+// Objects that the client becomes interested in while its snapshot is
+// blocked go through the queue once the snapshot completes.
+//
+TEST_F(IFMapExporterTest, InitialSyncBlocked) {
+    server_.SetSender(new IFMapUpdateSenderMock(&server_));
+    server_.set_initial_sync_enabled(true);
+    server_.initial_sync()->SetObjectsPerMessage(2);
+
+    IFMapMsgLink("virtual-machine", "virtual-machine-interface",
+                 "vm_x", "vm_x:veth0");
+    IFMapMsgLink("virtual-machine-interface", "virtual-network",
+                 "vm_x:veth0", "blue");
+    IFMapMsgLink("virtual-router", "virtual-machine", "192.168.1.1", "vm_x");
+    task_util::WaitForIdle();
+
+    TestClient c1("192.168.1.1");
+    c1.set_blocked(true);
+    server_.ProcessClientWork(true, &c1);
+    task_util::WaitForIdle();
+    EXPECT_TRUE(server_.initial_sync()->IsSyncing(c1.index()));
+    EXPECT_EQ(1, c1.count());
+
+    uint64_t start_at, objects_sent, objects_remaining;
+    EXPECT_TRUE(server_.initial_sync()->GetProgress(c1.index(), &start_at,
+        &objects_sent, &objects_remaining));
+    EXPECT_NE(0U, start_at);
+    EXPECT_LT(0U, objects_sent);
+    EXPECT_LT(0U, objects_remaining);
+
+    IFMapMsgLink("virtual-machine-interface", "virtual-network",
+                 "vm_x:veth0", "red");
+    task_util::WaitForIdle();
+    IFMapNode *red = TableLookup("virtual-network", "red");
+    ASSERT_TRUE(red != NULL);
+    IFMapNodeState *state = exporter_->NodeStateLookup(red);
+    EXPECT_TRUE(state->interest().test(c1.index()));
+    IFMapUpdate *update = state->GetUpdate(IFMapListEntry::UPDATE);
+    EXPECT_TRUE(update == NULL || !update->advertise().test(c1.index()));
+
+    c1.set_blocked(false);
+    c1.set_send_is_blocked(false);
+    server_.initial_sync()->SendActive(c1.index());
+    task_util::WaitForIdle();
+    EXPECT_FALSE(server_.initial_sync()->IsSyncing(c1.index()));
+    EXPECT_LT(1, c1.count());
+    EXPECT_NE(0U, c1.config_sync_usecs());
+    EXPECT_FALSE(server_.initial_sync()->GetProgress(c1.index(), &start_at,
+        &objects_sent, &objects_remaining));
+
+    update = state->GetUpdate(IFMapListEntry::UPDATE);
+    ASSERT_TRUE(update != NULL);
+    EXPECT_TRUE(update->advertise().test(c1.index()));
+}
+
+//
+// A snapshot that needs more messages than a run allows is sent over several
+// runs of the task.
+//
+TEST_F(IFMapExporterTest, InitialSyncYield) {
+    server_.SetSender(new IFMapUpdateSenderMock(&server_));
+    server_.set_initial_sync_enabled(true);
+    server_.initial_sync()->SetObjectsPerMessage(1);
+    server_.initial_sync()->set_max_messages_per_run(1);
+
+    IFMapMsgLink("virtual-machine", "virtual-machine-interface",
+                 "vm_x", "vm_x:veth0");
+    IFMapMsgLink("virtual-machine-interface", "virtual-network",
+                 "vm_x:veth0", "blue");
+    IFMapMsgLink("virtual-router", "virtual-machine", "192.168.1.1", "vm_x");
+    task_util::WaitForIdle();
+
+    TestClient c1("192.168.1.1");
+    server_.ProcessClientWork(true, &c1);
+    task_util::WaitForIdle();
+
+    EXPECT_FALSE(server_.initial_sync()->IsSyncing(c1.index()));
+    EXPECT_LE(7, c1.count());
+    EXPECT_EQ(c1.update_nodes_sent() + c1.update_links_sent(),
+              c1.config_sync_objects());
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     LoggingInit();
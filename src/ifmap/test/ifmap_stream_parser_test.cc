@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "ifmap/ifmap_stream_parser.h"
+
+#include <stdlib.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <pugixml/pugixml.hpp>
+
+#include "base/logging.h"
+#include "base/time_util.h"
+#include "db/db_table.h"
+#include "ifmap/ifmap_server_parser.h"
+#include "ifmap/ifmap_server_table.h"
+#include "ifmap/ifmap_table.h"
+#include "schema/vnc_cfg_types.h"
+#include "testing/gunit.h"
+
+using std::cout;
+using std::endl;
+using std::ifstream;
+using std::istreambuf_iterator;
+using std::ostringstream;
+using std::string;
+using std::vector;
+
+class IFMapStreamParserTest : public ::testing::Test {
+protected:
+    typedef IFMapServerParser::RequestList RequestList;
+
+    IFMapStreamParserTest() : parser_(NULL), seed_(0) {
+    }
+
+    virtual void SetUp() {
+        parser_ = IFMapServerParser::GetInstance("vnc_cfg");
+        vnc_cfg_ParserInit(parser_);
+    }
+
+    virtual void TearDown() {
+        parser_->MetadataClear("vnc_cfg");
+    }
+
+    string FileRead(const string &filename) {
+        ifstream file(filename.c_str());
+        string content((istreambuf_iterator<char>(file)),
+                       istreambuf_iterator<char>());
+        return content;
+    }
+
+    // Describe the requests in a list and delete them.
+    static vector<string> Describe(RequestList *list) {
+        vector<string> result;
+        while (!list->empty()) {
+            DBRequest *request = list->front();
+            list->pop_front();
+            IFMapTable::RequestKey *key =
+                static_cast<IFMapTable::RequestKey *>(request->key.get());
+            ostringstream out;
+            out << request->oper << " " << key->id_type << ":"
+                << key->id_name;
+            IFMapServerTable::RequestData *data =
+                static_cast<IFMapServerTable::RequestData *>(
+                    request->data.get());
+            if (data != NULL) {
+                out << " " << data->id_type << ":" << data->id_name << " "
+                    << data->metadata;
+                if (data->content.get() != NULL) {
+                    out << " content";
+                }
+            }
+            result.push_back(out.str());
+            delete request;
+        }
+        return result;
+    }
+
+    vector<string> DocumentParse(const string &response) {
+        pugi::xml_document xdoc;
+        pugi::xml_parse_result result =
+            xdoc.load_buffer(response.data(), response.size());
+        EXPECT_EQ(pugi::status_ok, result.status);
+        RequestList list;
+        parser_->ParseResults(xdoc, &list);
+        return Describe(&list);
+    }
+
+    // Parse the response in chunks of random size, up to max_chunk bytes.
+    vector<string> StreamParse(const string &response, size_t max_chunk) {
+        IFMapStreamParser stream(parser_);
+        RequestList list;
+        for (size_t pos = 0; pos < response.size(); ) {
+            size_t size = 1 + rand_r(&seed_) % max_chunk;
+            size = std::min(size, response.size() - pos);
+            EXPECT_TRUE(stream.Parse(response.data() + pos, size, &list));
+            pos += size;
+        }
+        EXPECT_TRUE(stream.Complete());
+        return Describe(&list);
+    }
+
+    static string ResultItem(int index) {
+        ostringstream out;
+        out << "<resultItem><identity name=\"contrail:virtual-network:vn"
+            << index << "\" type=\"other\" other-type-definition=\"extended\"/>"
+            "<metadata><contrail:id-perms xmlns:contrail="
+            "\"http://www.contrailsystems.com/vnc_cfg.xsd\" "
+            "ifmap-cardinality=\"singleValue\"><uuid><uuid-mslong>"
+            "7154778764020240001</uuid-mslong><uuid-lslong>"
+            "13082342935312119001</uuid-lslong></uuid></contrail:id-perms>"
+            "</metadata></resultItem>\n";
+        return out.str();
+    }
+
+    static string ResponseHeader() {
+        return "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            "<ns3:Envelope "
+            "xmlns:ns2=\"http://www.trustedcomputinggroup.org/2010/IFMAP/2\" "
+            "xmlns:ns3=\"http://www.w3.org/2003/05/soap-envelope\">"
+            "<ns3:Body><ns2:response><pollResult>"
+            "<searchResult name=\"root\">\n";
+    }
+
+    static string ResponseTrailer() {
+        return "</searchResult></pollResult></ns2:response></ns3:Body>"
+            "</ns3:Envelope>\n";
+    }
+
+    static size_t MaxRssKbytes() {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+
+    IFMapServerParser *parser_;
+    unsigned int seed_;
+};
+
+//
+// The stream parser produces the same requests as the document parser,
+// however the response is split into chunks.
+//
+TEST_F(IFMapStreamParserTest, SameAsDocument) {
+    const char *files[] = {
+        "server_parser_test.xml",
+        "server_parser_test1.xml",
+        "server_parser_test2.xml",
+        "server_parser_test3.xml",
+        "server_parser_test4.xml",
+        "server_parser_test5.xml",
+        "server_parser_test6.xml",
+    };
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); ++i) {
+        string response =
+            FileRead(string("controller/src/ifmap/testdata/") + files[i]);
+        ASSERT_NE(0U, response.size());
+        vector<string> expected = DocumentParse(response);
+        EXPECT_NE(0U, expected.size());
+        EXPECT_EQ(expected, StreamParse(response, 1));
+        EXPECT_EQ(expected, StreamParse(response, 64));
+        EXPECT_EQ(expected, StreamParse(response, 4096));
+        EXPECT_EQ(expected, StreamParse(response, response.size()));
+    }
+}
+
+//
+// Quoted '>' and '/' in attributes, comments and empty results. Comments and
+// CDATA sections that contain tags end at their own terminators.
+//
+TEST_F(IFMapStreamParserTest, Markup) {
+    string response = "<?xml version=\"1.0\"?>\n<!-- comment -->"
+        "<response><pollResult><updateResult name=\"a/>\"/>"
+        "<ns2:deleteResult name='>'>" + ResultItem(1) + "<resultItem/>" +
+        "</ns2:deleteResult><searchResult>" + ResultItem(2) +
+        "<!-- <resultItem> -> - > --><![CDATA[</searchResult> ]> ]]>" +
+        "<!---->" + ResultItem(3) +
+        "</searchResult></pollResult></response>";
+    vector<string> expected = DocumentParse(response);
+    ASSERT_EQ(3U, expected.size());
+    EXPECT_EQ(expected, StreamParse(response, 1));
+    EXPECT_EQ(expected, StreamParse(response, 2));
+    EXPECT_EQ(expected, StreamParse(response, 16));
+}
+
+TEST_F(IFMapStreamParserTest, Malformed) {
+    RequestList list;
+    IFMapStreamParser stream(parser_);
+
+    string response = ResponseHeader() + ResultItem(1) + ResultItem(2);
+    EXPECT_TRUE(stream.Parse(response.data(), response.size(), &list));
+    EXPECT_FALSE(stream.Complete());
+    EXPECT_EQ(2U, stream.items());
+    EXPECT_EQ(2U, Describe(&list).size());
+
+    // An item that pugixml can't load.
+    string item = "<resultItem><identity></metadata></resultItem>";
+    EXPECT_FALSE(stream.Parse(item.data(), item.size(), &list));
+    EXPECT_TRUE(list.empty());
+
+    // The items before a malformed one in the same chunk are still
+    // converted to requests.
+    stream.Reset();
+    response = ResponseHeader() + ResultItem(1) + item + ResultItem(2);
+    EXPECT_FALSE(stream.Parse(response.data(), response.size(), &list));
+    EXPECT_EQ(1U, stream.items());
+    vector<string> requests = Describe(&list);
+    ASSERT_EQ(1U, requests.size());
+    EXPECT_NE(string::npos, requests[0].find("vn1"));
+
+    // More end tags than start tags.
+    stream.Reset();
+    response = ResponseHeader() + ResponseTrailer() + "</extra>";
+    EXPECT_FALSE(stream.Parse(response.data(), response.size(), &list));
+    EXPECT_TRUE(list.empty());
+}
+
+//
+// The data that is carried over between chunks doesn't grow with the size
+// of the response.
+//
+TEST_F(IFMapStreamParserTest, Bounded) {
+    const size_t kChunkSize = 1024;
+    IFMapStreamParser stream(parser_);
+    RequestList list;
+    string data = ResponseHeader();
+    size_t max_item = 0;
+    for (int i = 0; i < 10000; ++i) {
+        string item = ResultItem(i);
+        max_item = std::max(max_item, item.size());
+        data += item;
+    }
+    data += ResponseTrailer();
+
+    size_t max_buffered = 0;
+    for (size_t pos = 0; pos < data.size(); pos += kChunkSize) {
+        size_t size = std::min(kChunkSize, data.size() - pos);
+        EXPECT_TRUE(stream.Parse(data.data() + pos, size, &list));
+        max_buffered = std::max(max_buffered, stream.buffered());
+        Describe(&list);
+    }
+    EXPECT_TRUE(stream.Complete());
+    EXPECT_EQ(10000U, stream.items());
+    EXPECT_LE(max_buffered, max_item + kChunkSize);
+}
+
+//
+// Compare the time and memory used to parse a large searchResult with those
+// of loading it as a document. The size of the response can be changed with
+// the environment variable IFMAP_STREAM_PARSER_TEST_MBYTES. The stream parser
+// runs first and is fed a chunk at a time, so that the peak RSS reported for
+// it doesn't include the response or the document.
+//
+TEST_F(IFMapStreamParserTest, Throughput) {
+    char *str = getenv("IFMAP_STREAM_PARSER_TEST_MBYTES");
+    size_t mbytes = str ? strtoul(str, NULL, 0) : 4;
+    const size_t kChunkSize = IFMapServerParser::kReceiveChunkSize;
+
+    IFMapStreamParser stream(parser_);
+    RequestList list;
+    size_t size = 0, requests = 0, max_buffered = 0;
+    int index = 0;
+    uint64_t start = ClockMonotonicUsec();
+    string chunk = ResponseHeader();
+    while (true) {
+        bool last = (size + chunk.size() >= mbytes << 20);
+        while (!last && chunk.size() < kChunkSize) {
+            chunk += ResultItem(index++);
+        }
+        if (last) {
+            chunk += ResponseTrailer();
+        }
+        EXPECT_TRUE(stream.Parse(chunk.data(), chunk.size(), &list));
+        size += chunk.size();
+        requests += list.size();
+        max_buffered = std::max(max_buffered, stream.buffered());
+        Describe(&list);
+        chunk.clear();
+        if (last) {
+            break;
+        }
+    }
+    uint64_t stream_usecs = ClockMonotonicUsec() - start;
+    size_t stream_rss = MaxRssKbytes();
+    EXPECT_TRUE(stream.Complete());
+    EXPECT_EQ(static_cast<size_t>(index), requests);
+
+    string response = ResponseHeader();
+    for (int i = 0; i < index; ++i) {
+        response += ResultItem(i);
+    }
+    response += ResponseTrailer();
+    EXPECT_EQ(size, response.size());
+
+    start = ClockMonotonicUsec();
+    {
+        pugi::xml_document xdoc;
+        pugi::xml_parse_result result =
+            xdoc.load_buffer(response.data(), response.size());
+        EXPECT_EQ(pugi::status_ok, result.status);
+        parser_->ParseResults(xdoc, &list);
+        EXPECT_EQ(requests, list.size());
+        Describe(&list);
+    }
+    uint64_t document_usecs = ClockMonotonicUsec() - start;
+    size_t document_rss = MaxRssKbytes();
+
+    cout << "Parsed " << index << " items, " << size << " bytes" << endl;
+    cout << "Stream: " << stream_usecs << " usecs, "
+         << (stream_usecs ? size / stream_usecs : 0) << " MB/s, "
+         << max_buffered << " bytes buffered, max RSS " << stream_rss
+         << " KB" << endl;
+    cout << "Document: " << document_usecs << " usecs, "
+         << (document_usecs ? size / document_usecs : 0) << " MB/s, "
+         << "max RSS " << document_rss << " KB" << endl;
+}
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "ifmap/ifmap_symbol.h"
+
+#include <stdlib.h>
+#include <sys/resource.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/test/task_test_util.h"
+#include "control-node/control_node.h"
+#include "db/db.h"
+#include "db/db_graph.h"
+#include "db/db_table_partition.h"
+#include "ifmap/ifmap_link.h"
+#include "ifmap/ifmap_link_table.h"
+#include "ifmap/ifmap_server_parser.h"
+#include "ifmap/ifmap_table.h"
+#include "ifmap/test/ifmap_test_util.h"
+#include "schema/vnc_cfg_types.h"
+#include "testing/gunit.h"
+
+using std::cout;
+using std::endl;
+using std::ostringstream;
+using std::string;
+using std::vector;
+
+class IFMapSymbolTest : public ::testing::Test {
+protected:
+    IFMapSymbolTest()
+            : db_(TaskScheduler::GetInstance()->GetTaskId("db::IFMapTable")),
+              parser_(NULL) {
+    }
+
+    virtual void SetUp() {
+        IFMapLinkTable_Init(&db_, &graph_);
+        parser_ = IFMapServerParser::GetInstance("vnc_cfg");
+        vnc_cfg_ParserInit(parser_);
+        vnc_cfg_Server_ModuleInit(&db_, &graph_);
+    }
+
+    virtual void TearDown() {
+        IFMapLinkTable_Clear(&db_);
+        IFMapTable::ClearTables(&db_);
+        task_util::WaitForIdle();
+        db_.Clear();
+        parser_->MetadataClear("vnc_cfg");
+    }
+
+    static string Name(const string &prefix, int index) {
+        ostringstream out;
+        out << "default-domain:demo:" << prefix << index;
+        return out.str();
+    }
+
+    static void Intern(const vector<string> *strings, int iterations) {
+        for (int i = 0; i < iterations; ++i) {
+            vector<IFMapSymbol> symbols;
+            for (size_t idx = 0; idx < strings->size(); ++idx) {
+                symbols.push_back(IFMapSymbol(strings->at(idx)));
+            }
+            vector<IFMapSymbol> copies(symbols);
+        }
+    }
+
+    static size_t MaxRssKbytes() {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+
+    DB db_;
+    DBGraph graph_;
+    IFMapServerParser *parser_;
+};
+
+TEST_F(IFMapSymbolTest, Intern) {
+    size_t size = IFMapSymbol::TableSize();
+    size_t bytes = IFMapSymbol::TableBytes();
+    {
+        IFMapSymbol s1("virtual-network");
+        IFMapSymbol s2(string("virtual-") + "network");
+        IFMapSymbol s3("project");
+        EXPECT_TRUE(s1 == s2);
+        EXPECT_TRUE(s1 != s3);
+        EXPECT_EQ(&s1.str(), &s2.str());
+        EXPECT_EQ("virtual-network", s2.str());
+        EXPECT_EQ(size + 2, IFMapSymbol::TableSize());
+        EXPECT_EQ(bytes + 22, IFMapSymbol::TableBytes());
+    }
+    EXPECT_EQ(size, IFMapSymbol::TableSize());
+    EXPECT_EQ(bytes, IFMapSymbol::TableBytes());
+}
+
+//
+// The string is removed from the table when the last copy goes away.
+//
+TEST_F(IFMapSymbolTest, Refcount) {
+    size_t size = IFMapSymbol::TableSize();
+    IFMapSymbol *s1 = new IFMapSymbol("virtual-network");
+    IFMapSymbol s2(*s1);
+    IFMapSymbol s3;
+    s3 = s2;
+    s3 = s3;
+    delete s1;
+    EXPECT_EQ(size + 1, IFMapSymbol::TableSize());
+    s2 = IFMapSymbol();
+    EXPECT_EQ(size + 1, IFMapSymbol::TableSize());
+    EXPECT_EQ("virtual-network", s3.str());
+    s3 = IFMapSymbol("project");
+    EXPECT_EQ(size + 1, IFMapSymbol::TableSize());
+    s3 = IFMapSymbol();
+    EXPECT_EQ(size, IFMapSymbol::TableSize());
+}
+
+TEST_F(IFMapSymbolTest, Empty) {
+    size_t size = IFMapSymbol::TableSize();
+    IFMapSymbol s1;
+    IFMapSymbol s2("");
+    EXPECT_TRUE(s1.empty());
+    EXPECT_TRUE(s2.empty());
+    EXPECT_TRUE(s1 == s2);
+    EXPECT_EQ("", s1.str());
+    EXPECT_EQ(size, IFMapSymbol::TableSize());
+}
+
+TEST_F(IFMapSymbolTest, Concurrent) {
+    size_t size = IFMapSymbol::TableSize();
+    vector<string> strings;
+    for (int i = 0; i < 64; ++i) {
+        strings.push_back(Name("vn", i % 16));
+    }
+    boost::thread_group threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.create_thread(
+            boost::bind(&IFMapSymbolTest::Intern, &strings, 1000));
+    }
+    threads.join_all();
+    EXPECT_EQ(size, IFMapSymbol::TableSize());
+}
+
+//
+// Links share the strings for the metadata and the identifiers of the nodes,
+// and derive their names from them. The size of the config can be changed
+// with the environment variable IFMAP_SYMBOL_TEST_INTERFACES, to measure the
+// memory used by a large one.
+//
+TEST_F(IFMapSymbolTest, Links) {
+    char *str = getenv("IFMAP_SYMBOL_TEST_INTERFACES");
+    int interfaces = str ? strtoul(str, NULL, 0) : 10000;
+    const int kNetworks = 100;
+    size_t size = IFMapSymbol::TableSize();
+    size_t start_rss = MaxRssKbytes();
+
+    for (int i = 0; i < interfaces; ++i) {
+        string vmi = Name("vmi", i);
+        ifmap_test_util::IFMapMsgLink(&db_,
+            "virtual-machine-interface", vmi,
+            "virtual-network", Name("vn", i % kNetworks),
+            "virtual-machine-interface-virtual-network");
+        ifmap_test_util::IFMapMsgLink(&db_,
+            "virtual-machine-interface", vmi,
+            "virtual-machine", Name("vm", i),
+            "virtual-machine-interface-virtual-machine");
+    }
+    task_util::WaitForIdle();
+
+    IFMapLinkTable *table = static_cast<IFMapLinkTable *>(
+        db_.FindTable("__ifmap_metadata__.0"));
+    EXPECT_EQ(static_cast<size_t>(interfaces) * 2, table->Size());
+
+    // 3 types and 2 metadata names, and the names of all the nodes.
+    size_t nodes = interfaces * 2 + std::min(interfaces, kNetworks);
+    EXPECT_EQ(size + 5 + nodes, IFMapSymbol::TableSize());
+
+    // Bytes the links would hold with a copy of each string. The names of
+    // the links are kept aside, to measure the memory they would take if
+    // the links held them. The links are sorted by name, and can be looked
+    // up by it.
+    size_t copy_bytes = 0;
+    string prev_name;
+    vector<string> names;
+    names.reserve(table->Size());
+    size_t names_rss = MaxRssKbytes();
+    DBTablePartition *partition =
+        static_cast<DBTablePartition *>(table->GetTablePartition(0));
+    for (IFMapLink *link = static_cast<IFMapLink *>(partition->GetFirst());
+         link != NULL;
+         link = static_cast<IFMapLink *>(partition->GetNext(link))) {
+        IFMapNode::Descriptor left = link->left_id();
+        IFMapNode::Descriptor right = link->right_id();
+        copy_bytes += link->metadata().size() + left.first.size() +
+            left.second.size() + right.first.size() + right.second.size() +
+            5 * (sizeof(string) - sizeof(IFMapSymbol));
+        string name = link->link_name();
+        EXPECT_EQ(table->LinkKey(link->metadata(), link->left(),
+                                 link->right()), name);
+        EXPECT_LT(prev_name, name);
+        EXPECT_EQ(link, table->FindLink(name));
+        prev_name = name;
+        names.push_back(name);
+    }
+    names_rss = MaxRssKbytes() - names_rss;
+
+    cout << "Links: " << table->Size() << ", nodes: " << nodes << endl;
+    cout << "Interned strings: " << IFMapSymbol::TableSize() - size
+         << ", " << IFMapSymbol::TableBytes() << " bytes" << endl;
+    cout << "Per link copies: " << copy_bytes << " bytes" << endl;
+    cout << "Max RSS: " << MaxRssKbytes() << " KB, "
+         << MaxRssKbytes() - start_rss - names_rss << " KB for the config"
+         << endl;
+    cout << "Link names: " << names_rss << " KB not held by the links"
+         << endl;
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    LoggingInit();
+    ControlNode::SetDefaultSchedulingPolicy();
+    bool success = RUN_ALL_TESTS();
+    TaskScheduler::GetInstance()->Terminate();
+    return success;
+}
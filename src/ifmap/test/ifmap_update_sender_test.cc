@@ -4,6 +4,8 @@
 
 #include "ifmap/ifmap_update_sender.h"
 
+#include <pugixml/pugixml.hpp>
+
 #include "base/logging.h"
 #include "base/task.h"
 #include "base/test/task_test_util.h"
@@ -16,6 +18,7 @@
 #include "ifmap/ifmap_link_table.h"
 #include "ifmap/ifmap_node.h"
 #include "ifmap/ifmap_server.h"
+#include "ifmap/ifmap_server_show_types.h"
 #include "ifmap/ifmap_table.h"
 #include "ifmap/ifmap_update.h"
 #include "ifmap/ifmap_update_queue.h"
@@ -37,10 +40,12 @@ public:
     virtual bool SendUpdate(const std::string &msg) {
         cout << "Sending " << endl << msg << endl;
         send_update_cnt_++;
+        last_msg_ = msg;
         return send_success_;
     }
 
     int get_send_update_cnt() { return send_update_cnt_; }
+    const string &last_msg() const { return last_msg_; }
 
     // Control if you want to block or continue sending
     void set_send_success(bool succ) { send_success_ = succ; }
@@ -49,6 +54,7 @@ private:
     string identifier_;
     bool send_success_;
     int send_update_cnt_;
+    string last_msg_;
 };
 
 struct IFMapUpdateDeleter {
@@ -1231,6 +1237,110 @@ TEST_F(IFMapUpdateSenderTest, Bug228) {
     queue_->PrintQueue();
 }
 
+// Each update is encoded once and the same body goes to all the receivers.
+TEST_F(IFMapUpdateSenderTest, SharedEncoding) {
+    TestClient c0("c0");
+    TestClient c1("c1");
+    server_.ClientRegister(&c0);
+    server_.ClientExporterSetup(&c0);
+    server_.ClientRegister(&c1);
+    server_.ClientExporterSetup(&c1);
+
+    IFMapUpdate *u1 = CreateUpdate("u1", true);
+    IFMapUpdate *u2 = CreateUpdate("u2", false);
+
+    BitSet cli_bs;
+    cli_bs.set(c0.index());
+    cli_bs.set(c1.index());
+    u1->AdvertiseOr(cli_bs);
+    u2->AdvertiseOr(cli_bs);
+
+    queue_->Join(c0.index());
+    queue_->Join(c1.index());
+    queue_->Enqueue(u1);
+    queue_->Enqueue(u2);
+
+    sender_->QueueActive();
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(1, c0.get_send_update_cnt());
+    TASK_UTIL_EXPECT_EQ(1, c1.get_send_update_cnt());
+    TASK_UTIL_EXPECT_EQ(1, queue_->size());
+
+    IFMapUpdateSenderStats stats;
+    sender_->GetStats(&stats);
+    EXPECT_EQ(1U, stats.messages);
+    EXPECT_EQ(2U, stats.client_messages);
+    EXPECT_EQ(2U, stats.fragments_encoded);
+    EXPECT_EQ(0U, stats.fragments_reused);
+    EXPECT_EQ(4U, stats.fragments_sent);
+
+    // The messages only differ in the receiver.
+    const TestClient *clients[] = { &c0, &c1 };
+    for (int idx = 0; idx < 2; ++idx) {
+        const string &msg = clients[idx]->last_msg();
+        pugi::xml_document doc;
+        ASSERT_TRUE(doc.load_buffer(msg.data(), msg.size()));
+        pugi::xml_node iq = doc.child("iq");
+        EXPECT_EQ(clients[idx]->identifier() + "/config",
+                  string(iq.attribute("to").value()));
+        pugi::xml_node config = iq.child("config");
+        EXPECT_STREQ("u1", config.child("update").child("node").
+                     child_value("name"));
+        EXPECT_STREQ("u2", config.child("delete").child("node").
+                     child_value("name"));
+    }
+    string body0 = c0.last_msg().substr(c0.last_msg().find("<config>"));
+    string body1 = c1.last_msg().substr(c1.last_msg().find("<config>"));
+    EXPECT_EQ(body0, body1);
+
+    queue_->Leave(c0.index());
+    queue_->Leave(c1.index());
+}
+
+// An update that is sent to a blocked client later is not encoded again.
+TEST_F(IFMapUpdateSenderTest, FragmentReuse) {
+    TestClient c0("c0");
+    TestClient c1("c1");
+    server_.ClientRegister(&c0);
+    server_.ClientExporterSetup(&c0);
+    server_.ClientRegister(&c1);
+    server_.ClientExporterSetup(&c1);
+
+    IFMapUpdate *u1 = CreateUpdate("u1", true);
+    BitSet cli_bs;
+    cli_bs.set(c0.index());
+    cli_bs.set(c1.index());
+    u1->AdvertiseOr(cli_bs);
+
+    queue_->Join(c0.index());
+    queue_->Join(c1.index());
+    queue_->Enqueue(u1);
+
+    SetSendBlocked(c0.index());
+    sender_->SendActive(c1.index());
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(0, c0.get_send_update_cnt());
+    TASK_UTIL_EXPECT_EQ(1, c1.get_send_update_cnt());
+    EXPECT_TRUE(u1->fragment() != NULL);
+
+    sender_->SendActive(c0.index());
+    task_util::WaitForIdle();
+    TASK_UTIL_EXPECT_EQ(1, c0.get_send_update_cnt());
+    TASK_UTIL_EXPECT_EQ(1, queue_->size());
+
+    IFMapUpdateSenderStats stats;
+    sender_->GetStats(&stats);
+    EXPECT_EQ(2U, stats.messages);
+    EXPECT_EQ(1U, stats.fragments_encoded);
+    EXPECT_EQ(1U, stats.fragments_reused);
+    EXPECT_EQ(2U, stats.fragments_sent);
+    EXPECT_EQ(c0.last_msg().substr(c0.last_msg().find("<config>")),
+              c1.last_msg().substr(c1.last_msg().find("<config>")));
+
+    queue_->Leave(c0.index());
+    queue_->Leave(c1.index());
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     bool success = RUN_ALL_TESTS();
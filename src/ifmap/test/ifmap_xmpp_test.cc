@@ -10,6 +10,7 @@
 #include "db/db_graph.h"
 #include "ifmap/ifmap_client.h"
 #include "ifmap/ifmap_exporter.h"
+#include "ifmap/ifmap_initial_sync.h"
 #include "ifmap/ifmap_link.h"
 #include "ifmap/ifmap_link_table.h"
 #include "ifmap/ifmap_node.h"
@@ -1496,6 +1497,72 @@ TEST_F(XmppIfmapTest, Cli1Vn1Vm3Add) {
     EXPECT_TRUE(xmpp_server_->FindConnection(client_name) == NULL);
 }
 
+//
+// Same config as Cli1Vn1Vm3Add, with the initial config of the client sent as
+// a snapshot. The snapshot sends one object per message and yields after each
+// one, and the virtual-machines that are subscribed while it's in progress go
+// through the update queue.
+//
+TEST_F(XmppIfmapTest, InitialSyncCli1Vn1Vm3Add) {
+    ifmap_server_.set_initial_sync_enabled(true);
+    ifmap_server_.initial_sync()->SetObjectsPerMessage(1);
+    ifmap_server_.initial_sync()->set_max_messages_per_run(1);
+    SetObjectsPerMessage(1);
+
+    string content =
+        FileRead("controller/src/ifmap/testdata/cli1_vn1_vm3_add.xml");
+    assert(content.size() != 0);
+    parser_->Receive(&db_, content.data(), content.size(), 0);
+    task_util::WaitForIdle();
+
+    string client_name =
+        string("default-global-system-config:a1s27.contrail.juniper.net");
+    string filename("/tmp/" + GetUserName() + "_initial_sync_cli1.output");
+    IFMapXmppClientMock *vnsw_client =
+        new IFMapXmppClientMock(&evm_, xmpp_server_->GetPort(), client_name,
+                                filename);
+    TASK_UTIL_EXPECT_EQ(true, vnsw_client->IsEstablished());
+    vnsw_client->RegisterWithXmpp();
+    TASK_UTIL_EXPECT_TRUE(ServerIsEstablished(xmpp_server_, client_name)
+                          == true);
+
+    vnsw_client->SendConfigSubscribe();
+    TASK_UTIL_EXPECT_TRUE(ifmap_server_.FindClient(client_name) != NULL);
+    vnsw_client->SendVmConfigSubscribe("2d308482-c7b3-4e05-af14-e732b7b50117");
+    vnsw_client->SendVmConfigSubscribe("93e76278-1990-4905-a472-8e9188f41b2c");
+    vnsw_client->SendVmConfigSubscribe("43d086ab-52c4-4a1f-8c3d-63b321e36e8a");
+    IFMapClient *client = ifmap_server_.FindClient(client_name);
+    ASSERT_TRUE(client != NULL);
+    size_t cli_index = static_cast<size_t>(client->index());
+
+    // Every object is sent exactly once, whichever way it goes.
+    TASK_UTIL_EXPECT_FALSE(ifmap_server_.initial_sync()->IsSyncing(cli_index));
+    TASK_UTIL_EXPECT_EQ(32, vnsw_client->Count());
+    TASK_UTIL_EXPECT_EQ(client->msgs_sent(), vnsw_client->Count());
+    EXPECT_EQ(32U, client->update_nodes_sent() + client->update_links_sent());
+    EXPECT_LT(0U, client->config_sync_objects());
+    int walk_count = ClientGraphWalkVerify(client_name, cli_index, true, true);
+    EXPECT_EQ(InterestConfigTrackerSize(client->index()), walk_count);
+    EXPECT_EQ(InterestConfigTrackerSize(client->index()), 32);
+
+    ConfigUpdate(vnsw_client, new XmppConfigData());
+    TASK_UTIL_EXPECT_EQ(ifmap_server_.GetClientMapSize(), 0);
+    CheckClientBits(vnsw_client->name(), cli_index, false, false);
+
+    vnsw_client->UnRegisterWithXmpp();
+    vnsw_client->Shutdown();
+    task_util::WaitForIdle();
+    TcpServerManager::DeleteServer(vnsw_client);
+    vnsw_client = NULL;
+
+    XmppConnection *sconnection = xmpp_server_->FindConnection(client_name);
+    if (sconnection) {
+        sconnection->Shutdown();
+    }
+    TASK_UTIL_EXPECT_EQ(xmpp_server_->ConnectionCount(), 0);
+    EXPECT_TRUE(xmpp_server_->FindConnection(client_name) == NULL);
+}
+
 TEST_F(XmppIfmapTest, Cli1Vn2Np1Add) {
 
     SetObjectsPerMessage(1);
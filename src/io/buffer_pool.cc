@@ -0,0 +1,113 @@
+//
+// Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
+//
+
+#include "io/buffer_pool.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "io/io_types.h"
+
+namespace io {
+
+BufferPool::SizeClass::SizeClass() : buffer_size(0), max_free_count(0) {
+    free_count = 0;
+}
+
+BufferPool::BufferPool(size_t max_free_bytes) {
+    for (size_t idx = 0; idx < kSizeClassCount; ++idx) {
+        SizeClass *size_class = &size_classes_[idx];
+        size_class->buffer_size = kMinBufferSize << idx;
+        size_class->max_free_count =
+            std::max(max_free_bytes / size_class->buffer_size, size_t(1));
+    }
+    assert(size_classes_[kSizeClassCount - 1].buffer_size == kMaxBufferSize);
+    hits_ = 0;
+    misses_ = 0;
+    drops_ = 0;
+    oversize_ = 0;
+}
+
+BufferPool::~BufferPool() {
+    for (size_t idx = 0; idx < kSizeClassCount; ++idx) {
+        uint8_t *data;
+        while (size_classes_[idx].free_list.try_pop(data)) {
+            delete [] data;
+        }
+    }
+}
+
+//
+// Return the index of the smallest size class that fits the size, or -1 if
+// the size is larger than the largest size class.
+//
+int BufferPool::SizeToIndex(size_t size) {
+    int index = 0;
+    for (size_t bufsize = kMinBufferSize; bufsize < size; bufsize <<= 1) {
+        if (++index == static_cast<int>(kSizeClassCount))
+            return -1;
+    }
+    return index;
+}
+
+uint8_t *BufferPool::Allocate(size_t size) {
+    int index = SizeToIndex(size);
+    if (index < 0) {
+        oversize_++;
+        return new uint8_t[size];
+    }
+
+    SizeClass *size_class = &size_classes_[index];
+    uint8_t *data;
+    if (size_class->free_list.try_pop(data)) {
+        size_class->free_count--;
+        hits_++;
+        return data;
+    }
+    misses_++;
+    return new uint8_t[size_class->buffer_size];
+}
+
+void BufferPool::Release(uint8_t *data, size_t size) {
+    int index = SizeToIndex(size);
+    if (index < 0) {
+        delete [] data;
+        return;
+    }
+
+    SizeClass *size_class = &size_classes_[index];
+    if (size_class->free_count.fetch_and_increment() >=
+        size_class->max_free_count) {
+        size_class->free_count--;
+        drops_++;
+        delete [] data;
+        return;
+    }
+    size_class->free_list.push(data);
+}
+
+uint64_t BufferPool::free_buffers() const {
+    uint64_t count = 0;
+    for (size_t idx = 0; idx < kSizeClassCount; ++idx) {
+        count += size_classes_[idx].free_count;
+    }
+    return count;
+}
+
+void BufferPool::GetStats(BufferPoolStats &stats) const {
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.drops = drops_;
+    stats.oversize = oversize_;
+    uint64_t free_buffers = 0, free_bytes = 0;
+    for (size_t idx = 0; idx < kSizeClassCount; ++idx) {
+        const SizeClass *size_class = &size_classes_[idx];
+        free_buffers += size_class->free_count;
+        free_bytes += size_class->free_count * size_class->buffer_size;
+    }
+    stats.free_buffers = free_buffers;
+    stats.free_bytes = free_bytes;
+}
+
+}  // namespace io
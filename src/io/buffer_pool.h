@@ -0,0 +1,76 @@
+//
+// Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
+//
+
+#ifndef IO_BUFFER_POOL_H_
+#define IO_BUFFER_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <tbb/atomic.h>
+#include <tbb/concurrent_queue.h>
+
+#include "base/util.h"
+
+class BufferPoolStats;
+
+namespace io {
+
+//
+// Pool of read buffers that is shared by all sessions of a TcpServer.
+//
+// Buffers are grouped in power of two size classes between kMinBufferSize
+// and kMaxBufferSize. Each size class keeps released buffers on a lock-free
+// queue, so that the io thread that allocates a buffer for the next read and
+// the reader task that releases a consumed buffer don't serialize on a lock.
+// The number of free bytes kept per size class is bounded; buffers released
+// beyond that are returned to the heap.
+//
+// Requests larger than kMaxBufferSize bypass the pool. Release needs to be
+// called with the same size that was passed to Allocate.
+//
+class BufferPool {
+public:
+    static const size_t kMinBufferSize = 256;
+    static const size_t kMaxBufferSize = 64 * 1024;
+    static const size_t kDefaultMaxFreeBytes = 1024 * 1024;
+
+    explicit BufferPool(size_t max_free_bytes = kDefaultMaxFreeBytes);
+    ~BufferPool();
+
+    uint8_t *Allocate(size_t size);
+    void Release(uint8_t *data, size_t size);
+
+    void GetStats(BufferPoolStats &stats) const;
+
+    uint64_t hits() const { return hits_; }
+    uint64_t misses() const { return misses_; }
+    uint64_t drops() const { return drops_; }
+    uint64_t free_buffers() const;
+
+private:
+    static const size_t kSizeClassCount = 9;
+
+    struct SizeClass {
+        SizeClass();
+
+        size_t buffer_size;
+        size_t max_free_count;
+        tbb::concurrent_queue<uint8_t *> free_list;
+        tbb::atomic<size_t> free_count;
+    };
+
+    static int SizeToIndex(size_t size);
+
+    SizeClass size_classes_[kSizeClassCount];
+    tbb::atomic<uint64_t> hits_;
+    tbb::atomic<uint64_t> misses_;
+    tbb::atomic<uint64_t> drops_;
+    tbb::atomic<uint64_t> oversize_;
+
+    DISALLOW_COPY_AND_ASSIGN(BufferPool);
+};
+
+}  // namespace io
+
+#endif  // IO_BUFFER_POOL_H_
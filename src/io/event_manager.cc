@@ -5,6 +5,10 @@
 #include "Thrift.h"
 
 #include "io/event_manager.h"
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
 #include "base/logging.h"
 #include "io/io_log.h"
 
@@ -14,6 +18,11 @@ SandeshTraceBufferPtr IOTraceBuf(SandeshTraceBufferCreate(IO_TRACE_BUF, 1000));
 
 EventManager::EventManager() {
     shutdown_ = false;
+    io_service_next_ = 0;
+}
+
+EventManager::~EventManager() {
+    DeleteIoServicePool();
 }
 
 void EventManager::Shutdown() {
@@ -21,18 +30,70 @@ void EventManager::Shutdown() {
 
     // TODO: make sure that are no users of this event manager.
     io_service_.stop();
+    for (IoServicePool::iterator it = io_service_pool_.begin();
+         it != io_service_pool_.end(); ++it) {
+        (*it)->stop();
+    }
 }
 
-void EventManager::Run() {
-    using namespace apache::thrift;
+void EventManager::CreateIoServicePool(size_t thread_count) {
+    assert(io_service_pool_.empty());
+    for (size_t idx = 0; idx < thread_count; ++idx) {
+        boost::asio::io_service *service = new boost::asio::io_service;
+        io_service_pool_.push_back(service);
+        io_service_work_.push_back(
+            new boost::asio::io_service::work(*service));
+    }
+    for (size_t idx = 0; idx < thread_count; ++idx) {
+        io_service_threads_.push_back(new boost::thread(boost::bind(
+            &EventManager::RunIoService, this, io_service_pool_[idx])));
+    }
+}
+
+//
+// Stop the pool threads and delete the pool. Sessions that were placed on
+// the pool must have been deleted by now.
+//
+// Called from the destructor, so it's fine to set shutdown_ even if the
+// EventManager was not Shutdown. The pool threads need it to exit.
+//
+void EventManager::DeleteIoServicePool() {
+    shutdown_ = true;
+    STLDeleteValues(&io_service_work_);
+    for (IoServicePool::iterator it = io_service_pool_.begin();
+         it != io_service_pool_.end(); ++it) {
+        (*it)->stop();
+    }
+    for (ThreadList::iterator it = io_service_threads_.begin();
+         it != io_service_threads_.end(); ++it) {
+        (*it)->join();
+    }
+    STLDeleteValues(&io_service_threads_);
+    STLDeleteValues(&io_service_pool_);
+}
 
+io_service *EventManager::session_io_service() {
+    if (io_service_pool_.empty())
+        return &io_service_;
+    size_t idx = io_service_next_.fetch_and_increment();
+    return io_service_pool_[idx % io_service_pool_.size()];
+}
+
+void EventManager::Run() {
     assert(mutex_.try_lock());
     io_service::work work(io_service_);
+    RunIoService(&io_service_);
+    mutex_.unlock();
+}
+
+void EventManager::RunIoService(boost::asio::io_service *service) {
+    using namespace apache::thrift;
+
     do {
         if (shutdown_) break;
         boost::system::error_code ec;
         try {
-            io_service_.run(ec);
+            service->run(ec);
             if (ec) {
                 EVENT_MANAGER_LOG_ERROR("io_service run failed: " <<
                                         ec.message());
@@ -54,7 +115,6 @@ void EventManager::Run() {
             assert(false);
         }
     } while (true);
-    mutex_.unlock();
 }
 
 size_t EventManager::RunOnce() {
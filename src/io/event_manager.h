@@ -4,11 +4,18 @@
 
 #pragma once
 
+#include <vector>
+
 #include <boost/asio/io_service.hpp>
+#include <tbb/atomic.h>
 #include <tbb/spin_mutex.h>
 
 #include "base/util.h"
 
+namespace boost {
+class thread;
+}
+
 //
 // Wrapper around boost::io_service.
 //
@@ -18,9 +25,18 @@
 // Poll directly or indirectly after having started a ServerThread (which
 // calls Run).
 //
+// An EventManager can optionally own a pool of additional io_services, each
+// run by its own thread. TcpServer places the sockets of the sessions that
+// it creates on these io_services in round-robin order, so that socket reads
+// and SSL processing for a large number of sessions is spread over several
+// threads. The main io_service is still used for accept, timers and all the
+// other users of io_service(). Session callbacks continue to be handed off
+// to the TaskScheduler, so the pool does not change which tasks run them.
+//
 class EventManager {
 public:
     EventManager();
+    ~EventManager();
 
     // Run until shutdown.
     void Run();
@@ -33,12 +49,31 @@ public:
 
     void Shutdown();
 
+    // Create the session io_service pool and start its threads.
+    void CreateIoServicePool(size_t thread_count);
+
     boost::asio::io_service *io_service() { return &io_service_; }
 
+    // Return the io_service to be used for the socket of a new session.
+    boost::asio::io_service *session_io_service();
+
+    size_t io_service_pool_size() const { return io_service_pool_.size(); }
+
 private:
+    typedef std::vector<boost::asio::io_service *> IoServicePool;
+    typedef std::vector<boost::asio::io_service::work *> IoServiceWorkList;
+    typedef std::vector<boost::thread *> ThreadList;
+
+    void RunIoService(boost::asio::io_service *io_service);
+    void DeleteIoServicePool();
+
     boost::asio::io_service io_service_;
     bool shutdown_;
     tbb::spin_mutex mutex_;
+    IoServicePool io_service_pool_;
+    IoServiceWorkList io_service_work_;
+    ThreadList io_service_threads_;
+    tbb::atomic<size_t> io_service_next_;
 
     DISALLOW_COPY_AND_ASSIGN(EventManager);
 };
@@ -41,8 +41,8 @@ TcpSession *SslServer::AllocSession(bool server_session) {
             so_ssl_accept_.release();
         }
     } else {
-        SslSocket *socket = new SslSocket(*event_manager()->io_service(),
-                                          context_);
+        SslSocket *socket =
+            new SslSocket(*event_manager()->session_io_service(), context_);
         session = AllocSession(socket);
     }
 
@@ -132,7 +132,7 @@ TcpServer::Socket *SslServer::accept_socket() const {
 }
 
 void SslServer::set_accept_socket() {
-    so_ssl_accept_.reset(new SslSocket(*event_manager()->io_service(),
-                                       context_));
+    so_ssl_accept_.reset(
+        new SslSocket(*event_manager()->session_io_service(), context_));
 }
 
@@ -50,6 +50,7 @@ SslSession::SslSession(SslServer *server, SslSocket *ssl_socket,
     if (server) {
         ssl_enabled_ = server->ssl_enabled_;
         ssl_handshake_delayed_ = server->ssl_handshake_delayed_;
+        SetIoService(&ssl_socket_->next_layer().get_io_service());
     }
 }
 
@@ -115,6 +116,17 @@ std::size_t SslSession::WriteSome(const uint8_t *data, std::size_t len,
     }
 }
 
+std::size_t SslSession::WriteSomeBuffers(
+    const std::vector<boost::asio::const_buffer> &buffers,
+    boost::system::error_code &error) {
+
+    if (IsSslHandShakeSuccessLocked()) {
+        return ssl_socket_->write_some(buffers, error);
+    } else {
+        return (TcpSession::WriteSomeBuffers(buffers, error));
+    }
+}
+
 void SslSession::AsyncWrite(const uint8_t *data, std::size_t size) {
     if (IsSslHandShakeSuccessLocked()) {
         boost::asio::async_write(
@@ -158,6 +170,6 @@ void SslSession::TriggerSslHandShakeInternal(SslSessionPtr session, SslHandShake
 }
 
 void SslSession::TriggerSslHandShake(SslHandShakeCallbackHandler cb) {
-    server()->event_manager()->io_service()->post(
+    socket()->get_io_service().post(
         boost::bind(&TriggerSslHandShakeInternal, SslSessionPtr(this), cb));
 }
@@ -71,6 +71,9 @@ private:
     void AsyncReadSome(boost::asio::mutable_buffer buffer);
     std::size_t WriteSome(const uint8_t *data, std::size_t len,
                           boost::system::error_code &error);
+    std::size_t WriteSomeBuffers(
+        const std::vector<boost::asio::const_buffer> &buffers,
+        boost::system::error_code &error);
     void AsyncWrite(const uint8_t *data, std::size_t size);
 
     static void TriggerSslHandShakeInternal(SslSessionPtr, SslHandShakeCallbackHandler);
@@ -4,6 +4,8 @@
 
 #include "io/tcp_message_write.h"
 
+#include <vector>
+
 #include "base/util.h"
 #include "base/logging.h"
 #include "io/tcp_session.h"
@@ -18,10 +20,6 @@ TcpMessageWriter::TcpMessageWriter(TcpSession *session) :
 }
 
 TcpMessageWriter::~TcpMessageWriter() {
-    for (BufferQueue::iterator iter = buffer_queue_.begin();
-         iter != buffer_queue_.end(); ++iter) {
-        DeleteBuffer(*iter);
-    }
     buffer_queue_.clear();
 }
 
@@ -55,40 +53,109 @@ int TcpMessageWriter::Send(const uint8_t *data, size_t len, error_code &ec) {
     return wrote;
 }
 
-// Socket is ready for write. Flush any pending data
-void TcpMessageWriter::HandleWriteReady(error_code &error) {
+//
+// Send the list of SharedBuffers with gather writes if there's no pending
+// data. Buffers that are not written completely are queued without copying
+// the data.
+//
+int TcpMessageWriter::Send(const TcpSession::SharedBufferList &buffers,
+                           error_code &ec) {
+    size_t len = 0;
+    for (TcpSession::SharedBufferList::const_iterator it = buffers.begin();
+         it != buffers.end(); ++it) {
+        len += it->size();
+    }
+
+    // Update socket write call statistics.
+    session_->stats_.write_calls++;
+    session_->stats_.write_bytes += len;
+
+    session_->server_->stats_.write_calls++;
+    session_->server_->stats_.write_bytes += len;
+
+    if (!buffer_queue_.empty()) {
+        TCP_SESSION_LOG_UT_DEBUG(session_, TCP_DIR_OUT,
+            "Write not ready. Enqueue " << buffers.size() << " buffers "
+            "(len = " << len << ") and return");
+        buffer_queue_.insert(buffer_queue_.end(),
+                             buffers.begin(), buffers.end());
+        return 0;
+    }
+
+    buffer_queue_.insert(buffer_queue_.end(), buffers.begin(), buffers.end());
+    size_t wrote = BufferFlush(ec);
+    if (TcpSession::IsSocketErrorHard(ec)) {
+        buffer_queue_.clear();
+        offset_ = 0;
+        return -1;
+    }
+
+    if (wrote != len) {
+        TCP_SESSION_LOG_UT_DEBUG(session_, TCP_DIR_OUT,
+            "Encountered partial send of " << wrote << " bytes when "
+            "sending " << len << " bytes, Error: " << ec);
+        session_->DeferWriter();
+    }
+    return wrote;
+}
+
+//
+// Write the queued buffers until the queue is empty or the socket blocks.
+// Return the number of bytes written.
+//
+// The queued buffers are coalesced into gather writes of up to
+// kMaxWriteBuffers. A write that doesn't consume all the buffers is not
+// treated as blocking, since an SslSession writes at most one record per
+// call. The socket is blocked only if nothing at all can be written.
+//
+size_t TcpMessageWriter::BufferFlush(error_code &error) {
+    size_t total = 0;
     while (!buffer_queue_.empty()) {
-        boost::asio::mutable_buffer head = buffer_queue_.front();
-        const uint8_t *data = buffer_cast<const uint8_t *>(head) + offset_;
-        int remaining = buffer_size(head) - offset_;
-        int wrote = session_->WriteSome(data, remaining, error);
-        if (TcpSession::IsSocketErrorHard(error)) {
-            return;
-        }
-        assert(wrote >= 0);
-        if (wrote != remaining) {
-            offset_ += wrote;
-            session_->DeferWriter();
-            return;
-        } else {
-            offset_ = 0;
-            DeleteBuffer(head);
-            buffer_queue_.pop_front();
+        std::vector<const_buffer> iov;
+        size_t offset = offset_;
+        for (BufferQueue::const_iterator iter = buffer_queue_.begin();
+             iter != buffer_queue_.end() && iov.size() < kMaxWriteBuffers;
+             ++iter) {
+            iov.push_back(buffer(iter->data() + offset,
+                                 iter->size() - offset));
+            offset = 0;
         }
+        size_t wrote = session_->WriteSomeBuffers(iov, error);
+        if (TcpSession::IsSocketErrorHard(error))
+            break;
+        BufferConsume(wrote);
+        total += wrote;
+        if (wrote == 0)
+            break;
     }
-    buffer_queue_.clear();
+    return total;
 }
 
-void TcpMessageWriter::BufferAppend(const uint8_t *src, int bytes) {
-    uint8_t *data = new uint8_t[bytes];
-    memcpy(data, src, bytes);
-    mutable_buffer buffer = mutable_buffer(data, bytes);
-    buffer_queue_.push_back(buffer);
+// Socket is ready for write. Flush any pending data
+void TcpMessageWriter::HandleWriteReady(error_code &error) {
+    BufferFlush(error);
+    if (TcpSession::IsSocketErrorHard(error))
+        return;
+    if (!buffer_queue_.empty())
+        session_->DeferWriter();
 }
 
-void TcpMessageWriter::DeleteBuffer(mutable_buffer buffer) {
-    const uint8_t *data = buffer_cast<const uint8_t *>(buffer);
-    delete[] data;
-    return;
+void TcpMessageWriter::BufferAppend(const uint8_t *src, int bytes) {
+    boost::shared_array<uint8_t> data(new uint8_t[bytes]);
+    memcpy(data.get(), src, bytes);
+    buffer_queue_.push_back(TcpSession::SharedBuffer(data, bytes));
 }
 
+//
+// Release buffers at the head of the queue that have been written and
+// update the offset into the first buffer that's still pending.
+//
+void TcpMessageWriter::BufferConsume(size_t bytes) {
+    bytes += offset_;
+    while (!buffer_queue_.empty() && bytes >= buffer_queue_.front().size()) {
+        bytes -= buffer_queue_.front().size();
+        buffer_queue_.pop_front();
+    }
+    assert(!buffer_queue_.empty() || bytes == 0);
+    offset_ = bytes;
+}
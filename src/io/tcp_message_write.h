@@ -13,30 +13,38 @@
 #include <boost/system/error_code.hpp>
 #include <tbb/mutex.h>
 #include "base/util.h"
+#include "io/tcp_session.h"
 
 using namespace boost::system;
 
-class TcpSession;
-
+//
+// Pending data is kept in a queue of reference counted buffers. Data that's
+// sent via the copying Send is copied into a new buffer, while SharedBuffers
+// are queued by reference. When the socket becomes writable, the queued
+// buffers are coalesced into gather writes of up to kMaxWriteBuffers.
+//
 class TcpMessageWriter {
 public:
     static const int kDefaultBufferSize = 4 * 1024;
+    static const size_t kMaxWriteBuffers = 64;
     explicit TcpMessageWriter(TcpSession *session);
     ~TcpMessageWriter();
 
     // return false for send  
     int Send(const uint8_t *msg, size_t len, error_code &ec);
+    int Send(const TcpSession::SharedBufferList &buffers, error_code &ec);
 
 private:
     friend class TcpSession;
     typedef boost::intrusive_ptr<TcpSession> TcpSessionPtr;
-    typedef std::list<boost::asio::mutable_buffer> BufferQueue;
+    typedef std::list<TcpSession::SharedBuffer> BufferQueue;
     void BufferAppend(const uint8_t *data, int len);
-    void DeleteBuffer(boost::asio::mutable_buffer buffer); 
+    void BufferConsume(size_t bytes);
+    size_t BufferFlush(boost::system::error_code &error);
     void HandleWriteReady(boost::system::error_code &ec);
 
     BufferQueue buffer_queue_;
-    int offset_;
+    size_t offset_;
     TcpSession *session_;
 };
 
@@ -277,7 +277,7 @@ TcpSession *TcpServer::AllocSession(bool server_session) {
             so_accept_.release();
         }
     } else {
-        Socket *socket = new Socket(*evm_->io_service());
+        Socket *socket = new Socket(*evm_->session_io_service());
         session = AllocSession(socket);
     }
 
@@ -289,7 +289,7 @@ TcpServer::Socket *TcpServer::accept_socket() const {
 }
 
 void TcpServer::set_accept_socket() {
-    so_accept_.reset(new Socket(*evm_->io_service()));
+    so_accept_.reset(new Socket(*evm_->session_io_service()));
 }
 
 bool TcpServer::AcceptSession(TcpSession *session) {
@@ -483,6 +483,10 @@ void TcpServer::GetTxSocketStats(SocketIOStats &socket_stats) const {
     stats_.GetTxStats(socket_stats);
 }
 
+void TcpServer::GetBufferPoolStats(BufferPoolStats &stats) const {
+    buffer_pool_.GetStats(stats);
+}
+
 //
 // TcpServerManager class routines
 //
@@ -14,11 +14,13 @@
 #include <tbb/compat/condition_variable>
 
 #include "base/util.h"
+#include "io/buffer_pool.h"
 #include "io/server_manager.h"
 #include "io/io_utils.h"
 
 class EventManager;
 class TcpSession;
+class BufferPoolStats;
 class SocketIOStats;
 
 class TcpServer {
@@ -78,6 +80,8 @@ public:
 
     void GetRxSocketStats(SocketIOStats &socket_stats) const;
     void GetTxSocketStats(SocketIOStats &socket_stats) const;
+    void GetBufferPoolStats(BufferPoolStats &stats) const;
+    io::BufferPool *buffer_pool() { return &buffer_pool_; }
 
     int SetMd5SocketOption(int fd, uint32_t peer_ip,
                            const std::string &md5_password);
@@ -150,6 +154,7 @@ private:
     void SetName(Endpoint local_endpoint);
 
     io::SocketStats stats_;
+    io::BufferPool buffer_pool_;
     EventManager *evm_;
     // mutex protects the session maps
     mutable tbb::mutex mutex_;
@@ -57,6 +57,8 @@ TcpSession::TcpSession(
       socket_(socket),
       read_on_connect_(async_read_ready),
       buffer_size_(kDefaultBufferSize),
+      read_size_(kDefaultBufferSize),
+      small_reads_(0),
       established_(false),
       closed_(false),
       direction_(ACTIVE),
@@ -68,7 +70,11 @@ TcpSession::TcpSession(
         reader_task_id_ = scheduler->GetTaskId("io::ReaderTask");
     }
     if (server_) {
-        io_strand_.reset(new Strand(*server->event_manager()->io_service()));
+        if (socket) {
+            SetIoService(&socket->get_io_service());
+        } else {
+            SetIoService(server->event_manager()->io_service());
+        }
     }
     defer_reader_ = false;
 }
@@ -82,9 +88,28 @@ TcpSession::~TcpSession() {
     buffer_queue_.clear();
 }
 
+//
+// Sessions that are created without a server (e.g. in unit tests) use the
+// heap directly.
+//
+uint8_t *TcpSession::AllocateBufferData(size_t size) {
+    if (!server_)
+        return new uint8_t[size];
+    return server_->buffer_pool()->Allocate(size);
+}
+
+void TcpSession::DeleteBufferData(uint8_t *data, size_t size) {
+    if (!server_) {
+        delete[] data;
+        return;
+    }
+    server_->buffer_pool()->Release(data, size);
+}
+
 mutable_buffer TcpSession::AllocateBuffer() {
-    uint8_t *data = new uint8_t[buffer_size_];
-    mutable_buffer buffer = mutable_buffer(data, buffer_size_);
+    int size = read_size_;
+    uint8_t *data = AllocateBufferData(size);
+    mutable_buffer buffer = mutable_buffer(data, size);
     {
         tbb::mutex::scoped_lock lock(mutex_);
         buffer_queue_.push_back(buffer);
@@ -94,7 +119,40 @@ mutable_buffer TcpSession::AllocateBuffer() {
 
 void TcpSession::DeleteBuffer(mutable_buffer buffer) {
     uint8_t *data = buffer_cast<uint8_t *>(buffer);
-    delete[] data;
+    DeleteBufferData(data, buffer_size(buffer));
+}
+
+//
+// Adapt the read size to the rate at which data arrives on the socket.
+//
+// A read that fills the buffer means that more data is waiting in the socket,
+// as is the case during an XMPP full sync or a sandesh stream, so the next
+// read uses a buffer that is twice as large, up to kMaxReadSize. The read
+// size goes back down by half, but not below buffer_size_, after a number of
+// consecutive reads that use less than a quarter of the buffer.
+//
+// There is at most one read in progress on a session, so this does not race
+// with AllocateBuffer.
+//
+void TcpSession::UpdateReadSize(size_t bytes_transferred, size_t buffer_size) {
+    static const int kSmallReadsMax = 8;
+
+    if (bytes_transferred == buffer_size) {
+        small_reads_ = 0;
+        read_size_ *= 2;
+        if (read_size_ > kMaxReadSize)
+            read_size_ = max(buffer_size_, int(kMaxReadSize));
+        return;
+    }
+    if (read_size_ <= buffer_size_ ||
+        bytes_transferred > static_cast<size_t>(read_size_ / 4)) {
+        small_reads_ = 0;
+        return;
+    }
+    if (++small_reads_ < kSmallReadsMax)
+        return;
+    small_reads_ = 0;
+    read_size_ = max(read_size_ / 2, buffer_size_);
 }
 
 static int BufferCmp(const mutable_buffer &lhs, const const_buffer &rhs) {
@@ -150,6 +208,14 @@ void TcpSession::AsyncReadStartInternal(TcpSessionPtr session) {
     AsyncReadSome(buffer);
 }
 
+//
+// Read start requests are posted to the io_service of the socket, which is
+// one of the EventManager's session io_services.
+//
+void TcpSession::SetIoService(io_service *service) {
+    io_strand_.reset(new Strand(*service));
+}
+
 void TcpSession::AsyncReadStart() {
     if (io_strand_) {
         io_strand_->post(boost::bind(
@@ -187,6 +253,12 @@ std::size_t TcpSession::WriteSome(const uint8_t *data, std::size_t len,
     return socket()->write_some(boost::asio::buffer(data, len), error);
 }
 
+std::size_t TcpSession::WriteSomeBuffers(
+    const std::vector<boost::asio::const_buffer> &buffers,
+    boost::system::error_code &error) {
+    return socket()->write_some(buffers, error);
+}
+
 void TcpSession::AsyncWrite(const uint8_t *data, std::size_t size) {
     boost::asio::async_write(
         *socket(), buffer(data, size),
@@ -407,6 +479,45 @@ bool TcpSession::Send(const uint8_t *data, size_t size, size_t *sent) {
     return ret;
 }
 
+//
+// Send a list of SharedBuffers with a single gather write.
+//
+// The SharedBuffers are always sent via the TcpMessageWriter, even if the
+// socket is blocking, so that any buffers that are not written right away
+// are retained until they have been written.
+//
+bool TcpSession::Send(const SharedBufferList &buffers, size_t *sent) {
+    tbb::mutex::scoped_lock lock(mutex_);
+
+    // Reset sent, if provided.
+    if (sent) *sent = 0;
+
+    //
+    // If the session closed in the mean while, bail out
+    //
+    if (!established_) return false;
+
+    size_t size = 0;
+    for (SharedBufferList::const_iterator it = buffers.begin();
+         it != buffers.end(); ++it) {
+        size += it->size();
+    }
+
+    boost::system::error_code error;
+    int len = writer_->Send(buffers, error);
+    lock.release();
+    if (len < 0) {
+        TCP_SESSION_LOG_ERROR(this, TCP_DIR_OUT,
+                              "Write failed due to error: "
+                              << error.category().name() << " "
+                              << error.message());
+        CloseInternal(error, true);
+        return false;
+    }
+    if (sent) *sent = len;
+    return ((size_t)len == size);
+}
+
 Task* TcpSession::CreateReaderTask(boost::asio::mutable_buffer buffer,
                                   size_t bytes_transferred) {
 
@@ -461,6 +572,7 @@ void TcpSession::AsyncReadHandler(
     session->stats_.read_bytes += bytes_transferred;
     session->server_->stats_.read_calls++;
     session->server_->stats_.read_bytes += bytes_transferred;
+    session->UpdateReadSize(bytes_transferred, buffer_size(buffer));
 
     Task *task = session->CreateReaderTask(buffer, bytes_transferred);
     // Starting a new task for the session
@@ -630,12 +742,13 @@ void TcpMessageReader::OnRead(Buffer buffer) {
         }
 
         // concat the buffers into a contiguous message.
-        boost::scoped_array<uint8_t>
-            data(new uint8_t[AllocBufferSize(msglength)]);
-        BufferConcat(data.get(), buffer, msglength);
+        int bufsize = AllocBufferSize(msglength);
+        uint8_t *data = session_->AllocateBufferData(bufsize);
+        BufferConcat(data, buffer, msglength);
         assert(remain_ == -1);
         // Receive the message
-        bool success = callback_(data.get(), msglength);
+        bool success = callback_(data, msglength);
+        session_->DeleteBufferData(data, bufsize);
         if (!success)
             return;
     }
@@ -815,4 +928,5 @@ void TcpSession::GetTxSocketStats(SocketIOStats &socket_stats) const {
 
 void TcpSession::SetBufferSize(int buffer_size) {
     buffer_size_ = buffer_size;
+    read_size_ = buffer_size;
 }
@@ -7,6 +7,7 @@
 
 #include <list>
 #include <deque>
+#include <vector>
 
 #include <boost/asio/buffer.hpp>
 #include <boost/asio/io_service.hpp>
@@ -15,6 +16,7 @@
 #include <boost/intrusive_ptr.hpp>
 #include <boost/function.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_array.hpp>
 
 #include <tbb/mutex.h>
 #include <tbb/task.h>
@@ -38,6 +40,7 @@ class TcpMessageWriter;
 class TcpSession {
 public:
     static const int kDefaultBufferSize = 4 * 1024;
+    static const int kMaxReadSize = 64 * 1024;
 
     enum Event {
         EVENT_NONE,
@@ -55,11 +58,37 @@ public:
     typedef boost::function<void(TcpSession *, Event)> EventObserver;
     typedef boost::asio::const_buffer Buffer;
 
+    // A reference counted buffer that can be sent without being copied.
+    // The same SharedBuffer can be sent on multiple sessions. It can refer
+    // to part of the underlying array, starting at the given offset.
+    class SharedBuffer {
+    public:
+        SharedBuffer() : offset_(0), size_(0) { }
+        SharedBuffer(const boost::shared_array<uint8_t> &data, size_t size)
+            : data_(data), offset_(0), size_(size) {
+        }
+        SharedBuffer(const boost::shared_array<uint8_t> &data, size_t offset,
+                     size_t size)
+            : data_(data), offset_(offset), size_(size) {
+        }
+        const uint8_t *data() const { return data_.get() + offset_; }
+        size_t size() const { return size_; }
+
+    private:
+        boost::shared_array<uint8_t> data_;
+        size_t offset_;
+        size_t size_;
+    };
+    typedef std::vector<SharedBuffer> SharedBufferList;
+
     // TcpSession constructor takes ownership of socket.
     TcpSession(TcpServer *server, Socket *socket,
                bool async_read_ready = true);
     // Performs a non-blocking send operation.
     virtual bool Send(const uint8_t *data, size_t size, size_t *sent);
+    // Performs a non-blocking gather send operation. Any part of buffers
+    // that can't be written right away is queued by reference.
+    virtual bool Send(const SharedBufferList &buffers, size_t *sent);
 
     // Called by TcpServer to trigger async read.
     virtual bool Connected(Endpoint remote);
@@ -91,6 +120,11 @@ public:
     // Buffers must be freed in arrival order.
     virtual void ReleaseBuffer(Buffer buffer);
 
+    // Allocate and free memory from the buffer pool of the server. Used for
+    // read buffers and for messages that span multiple read buffers.
+    uint8_t *AllocateBufferData(size_t size);
+    void DeleteBufferData(uint8_t *data, size_t size);
+
     // This function returns the instance to run SessionTask.
     // Returning Task::kTaskInstanceAny would allow multiple session tasks to 
     // run in parallel.
@@ -172,6 +206,10 @@ protected:
     void AsyncReadStartInternal(TcpSessionPtr session);
     virtual Task* CreateReaderTask(boost::asio::mutable_buffer, size_t);
 
+    // Set the io_service that runs the socket, for derived classes that
+    // don't pass the socket to the TcpSession constructor.
+    void SetIoService(boost::asio::io_service *service);
+
     virtual ~TcpSession();
 
     // Read handler. Called from a TBB task.
@@ -182,6 +220,9 @@ protected:
     virtual void AsyncReadSome(boost::asio::mutable_buffer buffer);
     virtual std::size_t WriteSome(const uint8_t *data, std::size_t len,
                                   boost::system::error_code &error);
+    virtual std::size_t WriteSomeBuffers(
+        const std::vector<boost::asio::const_buffer> &buffers,
+        boost::system::error_code &error);
     virtual void AsyncWrite(const uint8_t *data, std::size_t size);
 
     virtual int reader_task_id() const {
@@ -223,6 +264,7 @@ private:
 
     boost::asio::mutable_buffer AllocateBuffer();
     void DeleteBuffer(boost::asio::mutable_buffer buffer);
+    void UpdateReadSize(size_t bytes_transferred, size_t buffer_size);
 
     static int reader_task_id_;
 
@@ -231,6 +273,8 @@ private:
     boost::scoped_ptr<Strand> io_strand_;
     bool read_on_connect_;
     int buffer_size_;
+    int read_size_;             // Size of the next read buffer.
+    int small_reads_;           // Consecutive reads much below read_size_.
 
     /**************** protected by mutex_ ****************/
     bool established_;          // In TCP ESTABLISHED state.
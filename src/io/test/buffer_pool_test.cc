@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "io/buffer_pool.h"
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include <vector>
+
+#include "io/io_types.h"
+#include "testing/gunit.h"
+
+using io::BufferPool;
+using std::vector;
+
+class BufferPoolTest : public ::testing::Test {
+protected:
+    // Allocate and release buffers of random sizes, some of which are
+    // larger than the largest size class.
+    static void AllocateRelease(BufferPool *pool, unsigned int seed) {
+        vector<uint8_t *> buffers;
+        vector<size_t> sizes;
+        for (int iter = 0; iter < 1000; ++iter) {
+            size_t size = 1 + rand_r(&seed) % (BufferPool::kMaxBufferSize * 2);
+            uint8_t *data = pool->Allocate(size);
+            data[0] = data[size - 1] = 0xAA;
+            buffers.push_back(data);
+            sizes.push_back(size);
+            if (buffers.size() < 8)
+                continue;
+            for (size_t idx = 0; idx < buffers.size(); ++idx) {
+                pool->Release(buffers[idx], sizes[idx]);
+            }
+            buffers.clear();
+            sizes.clear();
+        }
+        for (size_t idx = 0; idx < buffers.size(); ++idx) {
+            pool->Release(buffers[idx], sizes[idx]);
+        }
+    }
+};
+
+TEST_F(BufferPoolTest, Recycle) {
+    BufferPool pool;
+    uint8_t *data = pool.Allocate(4096);
+    EXPECT_EQ(0U, pool.hits());
+    EXPECT_EQ(1U, pool.misses());
+    pool.Release(data, 4096);
+    EXPECT_EQ(1U, pool.free_buffers());
+
+    EXPECT_EQ(data, pool.Allocate(4096));
+    EXPECT_EQ(1U, pool.hits());
+    EXPECT_EQ(0U, pool.free_buffers());
+    pool.Release(data, 4096);
+}
+
+//
+// Sizes are rounded up to the size class, so buffers of different sizes in
+// the same class are interchangeable.
+//
+TEST_F(BufferPoolTest, SizeClass) {
+    BufferPool pool;
+    uint8_t *data = pool.Allocate(300);
+    pool.Release(data, 300);
+    EXPECT_EQ(data, pool.Allocate(512));
+    pool.Release(data, 512);
+
+    data = pool.Allocate(1);
+    pool.Release(data, 1);
+    uint8_t *other = pool.Allocate(257);
+    EXPECT_NE(data, other);
+    pool.Release(other, 257);
+    EXPECT_EQ(data, pool.Allocate(BufferPool::kMinBufferSize));
+    pool.Release(data, BufferPool::kMinBufferSize);
+}
+
+TEST_F(BufferPoolTest, Oversize) {
+    BufferPool pool;
+    size_t size = BufferPool::kMaxBufferSize + 1;
+    uint8_t *data = pool.Allocate(size);
+    pool.Release(data, size);
+    EXPECT_EQ(0U, pool.free_buffers());
+
+    BufferPoolStats stats;
+    pool.GetStats(stats);
+    EXPECT_EQ(1U, stats.oversize);
+    EXPECT_EQ(0U, stats.hits);
+    EXPECT_EQ(0U, stats.misses);
+}
+
+//
+// Buffers released beyond the limit of the size class go back to the heap.
+//
+TEST_F(BufferPoolTest, MaxFree) {
+    BufferPool pool(4 * 4096);
+    vector<uint8_t *> buffers;
+    for (int idx = 0; idx < 6; ++idx) {
+        buffers.push_back(pool.Allocate(4096));
+    }
+    for (int idx = 0; idx < 6; ++idx) {
+        pool.Release(buffers[idx], 4096);
+    }
+    EXPECT_EQ(4U, pool.free_buffers());
+    EXPECT_EQ(2U, pool.drops());
+
+    BufferPoolStats stats;
+    pool.GetStats(stats);
+    EXPECT_EQ(4U, stats.free_buffers);
+    EXPECT_EQ(4U * 4096, stats.free_bytes);
+    EXPECT_EQ(6U, stats.misses);
+    EXPECT_EQ(2U, stats.drops);
+}
+
+TEST_F(BufferPoolTest, Concurrent) {
+    BufferPool pool(64 * 1024);
+    boost::thread_group threads;
+    for (unsigned int idx = 0; idx < 4; ++idx) {
+        threads.create_thread(
+            boost::bind(&BufferPoolTest::AllocateRelease, &pool, idx));
+    }
+    threads.join_all();
+
+    BufferPoolStats stats;
+    pool.GetStats(stats);
+    EXPECT_EQ(4000U, stats.hits + stats.misses + stats.oversize);
+    EXPECT_LE(stats.free_bytes, 9U * 64 * 1024);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -2,6 +2,8 @@
  * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
  */
 
+#include <set>
+
 #include "base/test/task_test_util.h"
 #include "io/test/event_manager_test.h"
 #include "testing/gunit.h"
@@ -25,6 +27,27 @@ protected:
     ServerThread thread_;
 };
 
+//
+// Session io_services are handed out round-robin from the pool, and the main
+// io_service is used when there is no pool.
+//
+TEST_F(EventManagerTest, IoServicePool) {
+    EXPECT_EQ(evm_.io_service(), evm_.session_io_service());
+    evm_.CreateIoServicePool(3);
+    EXPECT_EQ(3U, evm_.io_service_pool_size());
+
+    set<boost::asio::io_service *> services;
+    for (int i = 0; i < 3; ++i) {
+        boost::asio::io_service *service = evm_.session_io_service();
+        EXPECT_NE(evm_.io_service(), service);
+        services.insert(service);
+    }
+    EXPECT_EQ(3U, services.size());
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(1U, services.count(evm_.session_io_service()));
+    }
+}
+
 typedef EventManagerTest EventManagerDeathTest;
 
 TEST_F(EventManagerDeathTest, Poll) {
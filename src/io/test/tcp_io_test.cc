@@ -2,7 +2,10 @@
  * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
  */
 
+#include <algorithm>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include <pthread.h>
 #include <sys/types.h>
@@ -21,6 +24,7 @@
 #include "base/test/task_test_util.h"
 
 #include "io/event_manager.h"
+#include "io/tcp_message_write.h"
 #include "io/tcp_server.h"
 #include "io/tcp_session.h"
 #include "io/test/event_manager_test.h"
@@ -42,14 +46,59 @@ class EchoSession : public TcpSession {
     }
     bool called;
 
+    // Keep the data that's read, to verify it.
+    void set_record(bool record) { record_ = record; }
+    const std::string &data() const { return data_; }
+
+    // Limit the number of bytes written by each gather write, like an SSL
+    // stream that writes one record at a time.
+    void set_write_limit(size_t write_limit) { write_limit_ = write_limit; }
+
+    // Make count gather writes fail as if the socket was blocked, after the
+    // given number of writes.
+    void BlockWrites(int after, int count) {
+        write_block_after_ = after;
+        write_blocks_ = count;
+    }
+    const std::vector<size_t> &write_buffer_counts() const {
+        return write_buffer_counts_;
+    }
+
+    virtual std::size_t WriteSomeBuffers(
+        const std::vector<boost::asio::const_buffer> &buffers,
+        boost::system::error_code &error) {
+        write_buffer_counts_.push_back(buffers.size());
+        if (write_block_after_ > 0) {
+            write_block_after_--;
+        } else if (write_blocks_ > 0) {
+            write_blocks_--;
+            error = boost::asio::error::would_block;
+            return 0;
+        }
+        if (write_limit_ == 0)
+            return TcpSession::WriteSomeBuffers(buffers, error);
+        std::vector<boost::asio::const_buffer> limited;
+        size_t size = 0;
+        for (size_t idx = 0; idx < buffers.size() && size < write_limit_;
+             ++idx) {
+            size_t len = std::min(boost::asio::buffer_size(buffers[idx]),
+                                  write_limit_ - size);
+            limited.push_back(boost::asio::buffer(buffers[idx], len));
+            size += len;
+        }
+        return TcpSession::WriteSomeBuffers(limited, error);
+    }
+
   protected:
     virtual ~EchoSession() {
     }
 
     virtual void OnRead(Buffer buffer) {
-        // const u_int8_t *data = BufferData(buffer);
+        const u_int8_t *data = BufferData(buffer);
         const size_t len = BufferSize(buffer);
         TCP_UT_LOG_DEBUG("Received " << len << " bytes");
+        if (record_)
+            data_.append(reinterpret_cast<const char *>(data), len);
         total_ += len;
     }
   private:
@@ -71,6 +120,12 @@ class EchoSession : public TcpSession {
         }
     }
     int total_;
+    bool record_;
+    std::string data_;
+    size_t write_limit_;
+    int write_block_after_;
+    int write_blocks_;
+    std::vector<size_t> write_buffer_counts_;
 };
 
 class EchoServer : public TcpServer {
@@ -104,6 +159,10 @@ class EchoServer : public TcpServer {
         return session_->Send(data, size, actual);
     }
 
+    bool Send(const TcpSession::SharedBufferList &buffers, size_t *actual) {
+        return session_->Send(buffers, actual);
+    }
+
     EchoSession *GetSession() const { return session_; }
     void SetSocketOptions() { session_->SetSocketOptions(); }
 
@@ -112,7 +171,8 @@ private:
 };
 
 EchoSession::EchoSession(EchoServer *server, Socket *socket)
-    : TcpSession(server, socket), called(false), total_(0) {
+    : TcpSession(server, socket), called(false), total_(0), record_(false),
+      write_limit_(0), write_block_after_(0), write_blocks_(0) {
     set_observer(boost::bind(&EchoSession::OnEvent, this, _1, _2));
 }
 
@@ -154,6 +214,39 @@ protected:
         task_util::WaitForIdle();
     }
 
+    // Connect the client to the server and record what the server reads.
+    void Connect() {
+        server_->Initialize(0);
+        task_util::WaitForIdle();
+        thread_->Start();
+        int port = server_->GetPort();
+        ASSERT_LT(0, port);
+
+        client_->CreateSession();
+        client_->EchoServer::ConnectTest(port);
+        client_->SetSocketOptions();
+        task_util::WaitForIdle();
+        TASK_UTIL_EXPECT_TRUE(client_->GetSession()->IsEstablished());
+        TASK_UTIL_ASSERT_TRUE((server_->GetSession() != NULL));
+        server_->GetSession()->set_record(true);
+    }
+
+    // Build SharedBuffers of the given sizes, filled with consecutive bytes
+    // so that the order in which they are read can be verified.
+    static TcpSession::SharedBufferList BuildBuffers(
+        const std::vector<size_t> &sizes, std::string *expected) {
+        TcpSession::SharedBufferList buffers;
+        for (size_t idx = 0; idx < sizes.size(); ++idx) {
+            boost::shared_array<uint8_t> data(new uint8_t[sizes[idx]]);
+            for (size_t pos = 0; pos < sizes[idx]; ++pos) {
+                data[pos] = static_cast<uint8_t>(expected->size());
+                expected->push_back(static_cast<char>(data[pos]));
+            }
+            buffers.push_back(TcpSession::SharedBuffer(data, sizes[idx]));
+        }
+        return buffers;
+    }
+
     auto_ptr<ServerThread> thread_;
     EchoServer *server_;
     EchoServer *client_;
@@ -362,8 +455,125 @@ TEST_F(EchoServerTest, DeferRead) {
     EXPECT_NE("00:00:00", rx_stats1.blocked_duration);
 }
 
+//
+// Gather writes that only write part of the buffers, like an SslSession,
+// don't cause the writer to wait for the socket to become writable.
+//
+TEST_F(EchoServerTest, SharedBufferPartialWrite) {
+    Connect();
+    EchoSession *session = client_->GetSession();
+    session->set_write_limit(100);
+
+    std::vector<size_t> sizes(3, 150);
+    std::string expected;
+    TcpSession::SharedBufferList buffers = BuildBuffers(sizes, &expected);
+    size_t sent = 0;
+    EXPECT_TRUE(client_->Send(buffers, &sent));
+    EXPECT_EQ(expected.size(), sent);
+    EXPECT_EQ(5U, session->write_buffer_counts().size());
+
+    TASK_UTIL_EXPECT_EQ(expected.size(), server_->GetSession()->data().size());
+    EXPECT_EQ(expected, server_->GetSession()->data());
+    SocketIOStats tx_stats;
+    session->GetTxSocketStats(tx_stats);
+    EXPECT_EQ(0, tx_stats.blocked_count);
+}
+
+//
+// The part of the buffers that can't be written when the socket blocks is
+// queued, starting in the middle of a buffer, and written when the socket
+// becomes writable again.
+//
+TEST_F(EchoServerTest, SharedBufferBlocked) {
+    Connect();
+    EchoSession *session = client_->GetSession();
+    session->set_write_limit(150);
+    session->BlockWrites(1, 1);
+
+    std::vector<size_t> sizes;
+    sizes.push_back(100);
+    sizes.push_back(200);
+    sizes.push_back(300);
+    std::string expected;
+    TcpSession::SharedBufferList buffers = BuildBuffers(sizes, &expected);
+
+    // The first write crosses into the second buffer and the next one
+    // blocks, so the second buffer is queued with an offset of 50 bytes.
+    size_t sent = 0;
+    EXPECT_FALSE(client_->Send(buffers, &sent));
+    EXPECT_EQ(150U, sent);
+
+    // The rest is written when the socket is writable. The first of these
+    // writes ends exactly at the end of the second buffer.
+    TASK_UTIL_EXPECT_EQ(expected.size(), server_->GetSession()->data().size());
+    EXPECT_EQ(expected, server_->GetSession()->data());
+    std::vector<size_t> counts;
+    counts.push_back(3);
+    counts.push_back(2);
+    counts.push_back(2);
+    counts.push_back(1);
+    counts.push_back(1);
+    EXPECT_EQ(counts, session->write_buffer_counts());
+    SocketIOStats tx_stats;
+    session->GetTxSocketStats(tx_stats);
+    EXPECT_EQ(1, tx_stats.blocked_count);
+}
+
+//
+// Queued buffers are written with gather writes of at most kMaxWriteBuffers.
+//
+TEST_F(EchoServerTest, SharedBufferMaxWriteBuffers) {
+    const size_t max_buffers = TcpMessageWriter::kMaxWriteBuffers;
+    Connect();
+    EchoSession *session = client_->GetSession();
+    session->BlockWrites(0, 1);
+
+    std::vector<size_t> sizes(max_buffers + 36, 10);
+    std::string expected;
+    TcpSession::SharedBufferList buffers = BuildBuffers(sizes, &expected);
+    size_t sent = 0;
+    EXPECT_FALSE(client_->Send(buffers, &sent));
+    EXPECT_EQ(0U, sent);
+
+    TASK_UTIL_EXPECT_EQ(expected.size(), server_->GetSession()->data().size());
+    EXPECT_EQ(expected, server_->GetSession()->data());
+    std::vector<size_t> counts;
+    counts.push_back(max_buffers + 36);
+    counts.push_back(max_buffers);
+    counts.push_back(36);
+    EXPECT_EQ(counts, session->write_buffer_counts());
+}
+
 }  // namespace
 
+//
+// Sessions run on the EventManager's io_service pool, if there is one.
+//
+TEST_F(EchoServerTest, IoServicePool) {
+    evm_->CreateIoServicePool(2);
+    server_->Initialize(0);
+    task_util::WaitForIdle();
+    thread_->Start();		// Must be called after initialization
+    int port = server_->GetPort();
+    ASSERT_LT(0, port);
+
+    client_->CreateSession();
+    client_->EchoServer::ConnectTest(port);
+    client_->SetSocketOptions();
+    TASK_UTIL_EXPECT_TRUE(client_->GetSession()->IsEstablished());
+    TASK_UTIL_ASSERT_TRUE((server_->GetSession() != NULL));
+    EXPECT_NE(evm_->io_service(),
+              &client_->GetSession()->socket()->get_io_service());
+    EXPECT_NE(evm_->io_service(),
+              &server_->GetSession()->socket()->get_io_service());
+
+    const char msg[] = "Test Message";
+    for (int i = 0; i < 16; i++) {
+        client_->Send((const u_int8_t *) msg, sizeof(msg), NULL);
+    }
+    TASK_UTIL_ASSERT_EQ(16 * sizeof(msg), server_->GetSession()->GetTotal());
+}
+
 int main(int argc, char **argv) {
     LoggingInit();
     Sandesh::SetLoggingParams(true, "", SandeshLevel::UT_DEBUG);
@@ -7,9 +7,14 @@
 #include <boost/ptr_container/ptr_vector.hpp>
 #include <boost/lexical_cast.hpp>
 #include <pthread.h>
+#include <stdlib.h>
+#include <tbb/atomic.h>
+
+#include <iostream>
 
 #include "testing/gunit.h"
 #include "base/task.h"
+#include "base/time_util.h"
 #include "base/test/task_test_util.h"
 #include "io/event_manager.h"
 #include "io/udp_server.h"
@@ -355,6 +360,213 @@ TEST_F(UdpRecvTest, Basic) {
     task_util::WaitForIdle();
 }
 
+//
+// Server that counts the datagrams received in batch and non batch mode.
+//
+class UdpBatchRecvServerTest: public UdpServer {
+ public:
+    explicit UdpBatchRecvServerTest(EventManager *evm) : UdpServer(evm) {
+        recv_msg_ = 0;
+        recv_batch_ = 0;
+        recv_bytes_ = 0;
+    }
+
+    void OnRead(boost::asio::const_buffer &recv_buffer,
+                const udp::endpoint &remote_endpoint) {
+        recv_msg_++;
+        recv_bytes_ += boost::asio::buffer_size(recv_buffer);
+        DeallocateBuffer(recv_buffer);
+    }
+
+    void OnReadBatch(const DatagramList &datagrams) {
+        recv_batch_++;
+        for (DatagramList::const_iterator it = datagrams.begin();
+             it != datagrams.end(); ++it) {
+            recv_msg_++;
+            recv_bytes_ += boost::asio::buffer_size(it->buffer);
+        }
+    }
+
+    int GetNumRecvMsg() const { return recv_msg_; }
+    int GetNumRecvBatch() const { return recv_batch_; }
+    int GetNumRecvBytes() const { return recv_bytes_; }
+
+ private:
+    tbb::atomic<int> recv_msg_;
+    tbb::atomic<int> recv_batch_;
+    tbb::atomic<int> recv_bytes_;
+};
+
+class UdpBatchTest : public ::testing::Test {
+ protected:
+    UdpBatchTest() : evm_(new EventManager()) {
+    }
+    virtual void SetUp() {
+        server_ = new UdpBatchRecvServerTest(evm_.get());
+        client_ = new UdpBatchRecvServerTest(evm_.get());
+        thread_.reset(new ServerThread(evm_.get()));
+    }
+    virtual void TearDown() {
+        task_util::WaitForIdle();
+        evm_->Shutdown();
+        task_util::WaitForIdle();
+        client_->Shutdown();
+        server_->Shutdown();
+        task_util::WaitForIdle();
+        UdpServerManager::DeleteServer(client_);
+        UdpServerManager::DeleteServer(server_);
+        if (thread_.get() != NULL) {
+            thread_->Join();
+        }
+        task_util::WaitForIdle();
+    }
+
+    udp::endpoint ServerEndpoint() {
+        boost::system::error_code ec;
+        udp::endpoint ep = server_->GetLocalEndpoint(&ec);
+        return udp::endpoint(
+            boost::asio::ip::address::from_string("127.0.0.1"), ep.port());
+    }
+
+    std::auto_ptr<ServerThread> thread_;
+    std::auto_ptr<EventManager> evm_;
+    UdpBatchRecvServerTest *server_;
+    UdpBatchRecvServerTest *client_;
+};
+
+//
+// Datagrams sent with SendBatch are received in batches.
+//
+TEST_F(UdpBatchTest, Basic) {
+    server_->Initialize("127.0.0.1", 0);
+    server_->StartBatchReceive(8);
+    client_->Initialize("127.0.0.1", 0);
+    task_util::WaitForIdle();
+    thread_->Start();
+
+    const char msg[] = "Test Message";
+    UdpServer::DatagramList datagrams;
+    for (int i = 0; i < 32; ++i) {
+        datagrams.push_back(UdpServer::Datagram(
+            boost::asio::buffer(msg, sizeof(msg)), ServerEndpoint()));
+    }
+    EXPECT_EQ(32U, client_->SendBatch(datagrams));
+    TASK_UTIL_EXPECT_EQ(32, server_->GetNumRecvMsg());
+    TASK_UTIL_EXPECT_EQ(32 * (int) sizeof(msg), server_->GetNumRecvBytes());
+    EXPECT_LE(4, server_->GetNumRecvBatch());
+    EXPECT_GE(32, server_->GetNumRecvBatch());
+
+    SocketIOStats tx_stats;
+    client_->GetTxSocketStats(tx_stats);
+    EXPECT_EQ(32, tx_stats.calls);
+    EXPECT_EQ(32 * sizeof(msg), tx_stats.bytes);
+    SocketIOStats rx_stats;
+    server_->GetRxSocketStats(rx_stats);
+    EXPECT_EQ(32, rx_stats.calls);
+    EXPECT_EQ(32 * sizeof(msg), rx_stats.bytes);
+}
+
+//
+// The default OnReadBatch hands each datagram to OnRead.
+//
+TEST_F(UdpBatchTest, DefaultOnReadBatch) {
+    UdpRecvServerTest *server = new UdpRecvServerTest(evm_.get());
+    server->Initialize("127.0.0.1", 0);
+    server->StartBatchReceive();
+    task_util::WaitForIdle();
+    thread_->Start();
+
+    boost::system::error_code ec;
+    UdpLocalClient client(server->GetLocalEndpoint(&ec).port());
+    EXPECT_TRUE(client.Connect());
+    const char msg[] = "Test Message";
+    for (int i = 0; i < 4; ++i) {
+        client.Send((const u_int8_t *) msg, sizeof(msg));
+        TASK_UTIL_EXPECT_EQ(i + 1, server->GetNumRecvMsg());
+    }
+    client.Close();
+
+    task_util::WaitForIdle();
+    server->Shutdown();
+    task_util::WaitForIdle();
+    UdpServerManager::DeleteServer(server);
+}
+
+//
+// Compare the rate at which datagrams go over the loopback with one system
+// call and one asio operation per datagram and in batch mode. The sender
+// sends bursts that fit in the socket buffer of the receiver and waits for
+// each burst to be received, so that nothing gets dropped. The number of
+// datagrams can be changed with the environment variable
+// UDP_IO_TEST_DATAGRAMS.
+//
+TEST_F(UdpBatchTest, Throughput) {
+    char *str = getenv("UDP_IO_TEST_DATAGRAMS");
+    int total = str ? strtoul(str, NULL, 0) : 20000;
+    const int kBurstSize = 64;
+    const int kDatagramSize = 256;
+
+    UdpBatchRecvServerTest *single_server =
+        new UdpBatchRecvServerTest(evm_.get());
+    single_server->Initialize("127.0.0.1", 0);
+    single_server->StartReceive();
+    server_->Initialize("127.0.0.1", 0);
+    server_->StartBatchReceive();
+    client_->Initialize("127.0.0.1", 0);
+    task_util::WaitForIdle();
+    thread_->Start();
+
+    boost::system::error_code ec;
+    UdpLocalClient client(single_server->GetLocalEndpoint(&ec).port());
+    EXPECT_TRUE(client.Connect());
+    std::vector<uint8_t> data(kDatagramSize, 0xAA);
+    uint64_t start = ClockMonotonicUsec();
+    for (int sent = 0; sent < total; sent += kBurstSize) {
+        for (int i = 0; i < kBurstSize; ++i) {
+            client.Send(&data[0], data.size());
+        }
+        while (single_server->GetNumRecvMsg() < sent + kBurstSize &&
+               ClockMonotonicUsec() - start < 60 * 1000 * 1000) {
+            sched_yield();
+        }
+        ASSERT_EQ(sent + kBurstSize, single_server->GetNumRecvMsg());
+    }
+    uint64_t single_usecs = ClockMonotonicUsec() - start;
+
+    UdpServer::DatagramList datagrams;
+    for (int i = 0; i < kBurstSize; ++i) {
+        datagrams.push_back(UdpServer::Datagram(
+            boost::asio::buffer(&data[0], data.size()), ServerEndpoint()));
+    }
+    start = ClockMonotonicUsec();
+    for (int sent = 0; sent < total; sent += kBurstSize) {
+        EXPECT_EQ(datagrams.size(), client_->SendBatch(datagrams));
+        while (server_->GetNumRecvMsg() < sent + kBurstSize &&
+               ClockMonotonicUsec() - start < 60 * 1000 * 1000) {
+            sched_yield();
+        }
+        ASSERT_EQ(sent + kBurstSize, server_->GetNumRecvMsg());
+    }
+    uint64_t batch_usecs = ClockMonotonicUsec() - start;
+    int batches = server_->GetNumRecvBatch();
+
+    uint64_t received = server_->GetNumRecvMsg();
+    std::cout << "Received " << received << " datagrams of " << kDatagramSize
+              << " bytes" << std::endl;
+    std::cout << "Single: " << single_usecs << " usecs, "
+              << (single_usecs ? received * 1000000 / single_usecs : 0)
+              << " pps" << std::endl;
+    std::cout << "Batch: " << batch_usecs << " usecs, "
+              << (batch_usecs ? received * 1000000 / batch_usecs : 0)
+              << " pps, " << batches << " batches" << std::endl;
+
+    client.Close();
+    task_util::WaitForIdle();
+    single_server->Shutdown();
+    task_util::WaitForIdle();
+    UdpServerManager::DeleteServer(single_server);
+}
+
 }  // namespace
 
 int main(int argc, char **argv) {
@@ -2,8 +2,13 @@
  * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
  */
 
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
 #include <boost/bind.hpp>
+#include <boost/scoped_array.hpp>
 #include <base/logging.h>
+#include <base/util.h>
 #include <io/udp_server.h>
 #include <io/io_log.h>
 #include <io/io_utils.h>
@@ -16,6 +21,41 @@ using boost::asio::ip::udp;
 
 int UdpServer::reader_task_id_ = -1;
 
+#ifndef __linux__
+//
+// Emulate recvmmsg and sendmmsg with one system call per datagram on
+// platforms that don't have them.
+//
+struct mmsghdr {
+    struct msghdr msg_hdr;
+    unsigned int msg_len;
+};
+
+static int recvmmsg(int fd, struct mmsghdr *msgs, unsigned int vlen,
+                    int flags, struct timespec *timeout) {
+    unsigned int count = 0;
+    for (; count < vlen; ++count) {
+        ssize_t len = recvmsg(fd, &msgs[count].msg_hdr, flags);
+        if (len < 0)
+            break;
+        msgs[count].msg_len = len;
+    }
+    return (count == 0 && vlen != 0) ? -1 : count;
+}
+
+static int sendmmsg(int fd, struct mmsghdr *msgs, unsigned int vlen,
+                    int flags) {
+    unsigned int count = 0;
+    for (; count < vlen; ++count) {
+        ssize_t len = sendmsg(fd, &msgs[count].msg_hdr, flags);
+        if (len < 0)
+            break;
+        msgs[count].msg_len = len;
+    }
+    return (count == 0 && vlen != 0) ? -1 : count;
+}
+#endif
+
 class UdpServer::Reader : public Task {
 public:
     Reader(UdpServerPtr server, const udp::endpoint &remote_endpoint,
@@ -41,11 +81,95 @@ private:
     const_buffer buffer_;
 };
 
+//
+// A set of receive buffers along with the message headers that are needed
+// to fill all of them with a single recvmmsg call. Batches are allocated on
+// demand, up to kMaxBatchCount per server, and recycled after the datagrams
+// have been processed by OnReadBatch.
+//
+class UdpServer::Batch {
+public:
+    Batch(int count, int buffer_size)
+        : buffer_size_(buffer_size),
+          data_(new uint8_t[count * buffer_size]),
+          msgs_(count),
+          iovs_(count),
+          endpoints_(count) {
+        datagrams_.reserve(count);
+    }
+
+    int Receive(int fd);
+    const DatagramList &datagrams() const { return datagrams_; }
+
+private:
+    int buffer_size_;
+    boost::scoped_array<uint8_t> data_;
+    std::vector<struct mmsghdr> msgs_;
+    std::vector<struct iovec> iovs_;
+    std::vector<udp::endpoint> endpoints_;
+    DatagramList datagrams_;
+
+    DISALLOW_COPY_AND_ASSIGN(Batch);
+};
+
+//
+// Receive as many datagrams as are available, up to the size of the batch,
+// without blocking. Returns the number of datagrams or -1 on error.
+//
+int UdpServer::Batch::Receive(int fd) {
+    for (size_t idx = 0; idx < msgs_.size(); ++idx) {
+        iovs_[idx].iov_base = data_.get() + idx * buffer_size_;
+        iovs_[idx].iov_len = buffer_size_;
+        struct msghdr *hdr = &msgs_[idx].msg_hdr;
+        memset(hdr, 0, sizeof(*hdr));
+        hdr->msg_name = endpoints_[idx].data();
+        hdr->msg_namelen = endpoints_[idx].capacity();
+        hdr->msg_iov = &iovs_[idx];
+        hdr->msg_iovlen = 1;
+    }
+
+    datagrams_.clear();
+    int count = recvmmsg(fd, &msgs_[0], msgs_.size(), MSG_DONTWAIT, NULL);
+    for (int idx = 0; idx < count; ++idx) {
+        endpoints_[idx].resize(msgs_[idx].msg_hdr.msg_namelen);
+        datagrams_.push_back(Datagram(
+            const_buffer(iovs_[idx].iov_base, msgs_[idx].msg_len),
+            endpoints_[idx]));
+    }
+    return count;
+}
+
+class UdpServer::BatchReader : public Task {
+public:
+    BatchReader(UdpServerPtr server, Batch *batch)
+        : Task(server->reader_task_id(),
+               server->batch_reader_task_instance()),
+        server_(server),
+        batch_(batch) {
+    }
+
+    virtual bool Run() {
+        if (server_->GetServerState() == OK) {
+            server_->OnReadBatch(batch_->datagrams());
+        }
+        server_->ReleaseBatch(batch_);
+        return true;
+    }
+    std::string Description() const { return "UdpServer::BatchReader"; }
+
+private:
+    UdpServerPtr server_;
+    Batch *batch_;
+};
+
 UdpServer::UdpServer(boost::asio::io_service *io_service, int buffer_size):
     socket_(*io_service),
     buffer_size_(buffer_size),
     state_(Uninitialized),
-    evm_(NULL) {
+    evm_(NULL),
+    batch_size_(kDefaultBatchSize),
+    batch_count_(0),
+    batch_stalled_(false) {
     if (reader_task_id_ == -1) {
         TaskScheduler *scheduler = TaskScheduler::GetInstance();
         reader_task_id_ = scheduler->GetTaskId("io::udp::ReaderTask");
@@ -58,7 +182,10 @@ UdpServer::UdpServer(EventManager *evm, int buffer_size):
     socket_(*(evm->io_service())),
     buffer_size_(buffer_size),
     state_(Uninitialized),
-    evm_(evm) {
+    evm_(evm),
+    batch_size_(kDefaultBatchSize),
+    batch_count_(0),
+    batch_stalled_(false) {
     if (reader_task_id_ == -1) {
         TaskScheduler *scheduler = TaskScheduler::GetInstance();
         reader_task_id_ = scheduler->GetTaskId("io::udp::ReaderTask");
@@ -71,6 +198,10 @@ int UdpServer::reader_task_instance(const udp::endpoint &rep) const {
     return Task::kTaskInstanceAny;
 }
 
+int UdpServer::batch_reader_task_instance() const {
+    return Task::kTaskInstanceAny;
+}
+
 void UdpServer::SetName(udp::endpoint ep) {
     std::ostringstream s;
     boost::system::error_code ec;
@@ -82,6 +213,7 @@ UdpServer::~UdpServer() {
     assert(state_ == Uninitialized || state_ == SocketOpenFailed ||
            state_ == SocketBindFailed);
     assert(pbuf_.empty());
+    STLDeleteValues(&batch_free_list_);
 }
 
 void UdpServer::Shutdown() {
@@ -91,6 +223,9 @@ void UdpServer::Shutdown() {
             delete[] pbuf_.back();
             pbuf_.pop_back();
         }
+        batch_count_ -= batch_free_list_.size();
+        STLDeleteValues(&batch_free_list_);
+        batch_stalled_ = false;
     }
     if (socket_.is_open()) {
         boost::system::error_code ec;
@@ -257,6 +392,169 @@ void UdpServer::HandleReceiveInternal(const_buffer recv_buffer,
     StartReceive();
 }
 
+void UdpServer::StartBatchReceive(int batch_size) {
+    if (state_ != OK) {
+        stats_.read_errors++;
+        UDP_SERVER_LOG_ERROR(this, UDP_DIR_NA,
+            "StartBatchReceive UDP server in WRONG state: " << state_);
+        return;
+    }
+    batch_size_ = batch_size;
+    AsyncBatchReceive();
+}
+
+//
+// Wait for the socket to become readable. The datagrams are read by
+// HandleBatchReceive.
+//
+void UdpServer::AsyncBatchReceive() {
+    socket_.async_receive(boost::asio::null_buffers(),
+        boost::bind(&UdpServer::HandleBatchReceive, UdpServerPtr(this),
+            boost::asio::placeholders::error));
+}
+
+//
+// Get a batch for the next receive. If all batches are in use by reader
+// tasks, the receive is stalled until one of them gets released. Datagrams
+// that arrive in the meantime are queued, or dropped, by the kernel.
+//
+UdpServer::Batch *UdpServer::AllocateBatch() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    if (!batch_free_list_.empty()) {
+        Batch *batch = batch_free_list_.back();
+        batch_free_list_.pop_back();
+        return batch;
+    }
+    if (batch_count_ < kMaxBatchCount) {
+        batch_count_++;
+        return new Batch(batch_size_, buffer_size_);
+    }
+    batch_stalled_ = true;
+    return NULL;
+}
+
+void UdpServer::ReleaseBatch(Batch *batch) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    if (state_ != OK) {
+        batch_count_--;
+        delete batch;
+        return;
+    }
+    batch_free_list_.push_back(batch);
+    if (!batch_stalled_)
+        return;
+    batch_stalled_ = false;
+    lock.release();
+    AsyncBatchReceive();
+}
+
+void UdpServer::HandleBatchReceive(const boost::system::error_code& error) {
+    if (state_ != OK) {
+        stats_.read_errors++;
+        UDP_SERVER_LOG_ERROR(this, UDP_DIR_IN,
+            "Receive UDP server in WRONG state: " << state_);
+        return;
+    }
+    if (error) {
+        stats_.read_errors++;
+        UDP_SERVER_LOG_ERROR(this, UDP_DIR_IN,
+            "Read FAILED due to error: " << error.value() << " : " <<
+            error.message());
+        AsyncBatchReceive();
+        return;
+    }
+
+    Batch *batch = AllocateBatch();
+    if (!batch)
+        return;
+    int count = batch->Receive(socket_.native_handle());
+    if (count <= 0) {
+        if (count < 0 && errno != EAGAIN && errno != EWOULDBLOCK &&
+            errno != EINTR) {
+            stats_.read_errors++;
+            UDP_SERVER_LOG_ERROR(this, UDP_DIR_IN,
+                "Read FAILED due to error: " << errno << " : " <<
+                strerror(errno));
+        }
+        ReleaseBatch(batch);
+        AsyncBatchReceive();
+        return;
+    }
+
+    // Update read statistics, counting each datagram as a read call as in
+    // the non batch mode.
+    for (DatagramList::const_iterator it = batch->datagrams().begin();
+         it != batch->datagrams().end(); ++it) {
+        stats_.read_calls++;
+        stats_.read_bytes += buffer_size(it->buffer);
+    }
+
+    BatchReader *task = new BatchReader(UdpServerPtr(this), batch);
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    scheduler->Enqueue(task);
+    AsyncBatchReceive();
+}
+
+void UdpServer::OnReadBatch(const DatagramList &datagrams) {
+    for (DatagramList::const_iterator it = datagrams.begin();
+         it != datagrams.end(); ++it) {
+        size_t size = buffer_size(it->buffer);
+        mutable_buffer b(AllocateBuffer(size));
+        memcpy(buffer_cast<uint8_t *>(b),
+               buffer_cast<const uint8_t *>(it->buffer), size);
+        const_buffer buffer(buffer_cast<const uint8_t *>(b), size);
+        OnRead(buffer, it->endpoint);
+    }
+}
+
+size_t UdpServer::SendBatch(const DatagramList &datagrams) {
+    if (state_ != OK) {
+        stats_.write_errors++;
+        UDP_SERVER_LOG_ERROR(this, UDP_DIR_NA,
+            "SendBatch UDP server in WRONG state: " << state_);
+        return 0;
+    }
+
+    size_t count = datagrams.size();
+    std::vector<struct mmsghdr> msgs(count);
+    std::vector<struct iovec> iovs(count);
+    for (size_t idx = 0; idx < count; ++idx) {
+        const Datagram &datagram = datagrams[idx];
+        iovs[idx].iov_base = const_cast<uint8_t *>(
+            buffer_cast<const uint8_t *>(datagram.buffer));
+        iovs[idx].iov_len = buffer_size(datagram.buffer);
+        struct msghdr *hdr = &msgs[idx].msg_hdr;
+        memset(hdr, 0, sizeof(*hdr));
+        hdr->msg_name = const_cast<struct sockaddr *>(
+            reinterpret_cast<const struct sockaddr *>(
+                datagram.endpoint.data()));
+        hdr->msg_namelen = datagram.endpoint.size();
+        hdr->msg_iov = &iovs[idx];
+        hdr->msg_iovlen = 1;
+    }
+
+    size_t sent = 0;
+    while (sent < count) {
+        int res = sendmmsg(socket_.native_handle(), &msgs[sent],
+                           count - sent, MSG_DONTWAIT);
+        if (res < 0) {
+            if (errno == EINTR)
+                continue;
+            stats_.write_errors++;
+            UDP_SERVER_LOG_ERROR(this, UDP_DIR_OUT,
+                "Send to " << datagrams[sent].endpoint <<
+                " FAILED due to error: " << errno << " : " << strerror(errno));
+            break;
+        }
+        for (int idx = 0; idx < res; ++idx) {
+            stats_.write_calls++;
+            stats_.write_bytes += msgs[sent + idx].msg_len;
+        }
+        sent += res;
+    }
+    return sent;
+}
+
 void UdpServer::HandleReceive(const_buffer &recv_buffer,
     udp::endpoint remote_endpoint, std::size_t bytes_transferred,
     const boost::system::error_code& error) {
@@ -24,6 +24,18 @@ class UdpServer {
         SocketBindFailed,
     };
     static const int kDefaultBufferSize = 4 * 1024;
+    static const int kDefaultBatchSize = 64;
+
+    // A datagram that is received or sent in a batch.
+    struct Datagram {
+        Datagram() { }
+        Datagram(boost::asio::const_buffer buffer,
+                 const boost::asio::ip::udp::endpoint &endpoint)
+            : buffer(buffer), endpoint(endpoint) { }
+        boost::asio::const_buffer buffer;
+        boost::asio::ip::udp::endpoint endpoint;
+    };
+    typedef std::vector<Datagram> DatagramList;
 
     explicit UdpServer(EventManager *evm, int buffer_size = kDefaultBufferSize);
     explicit UdpServer(boost::asio::io_service *io_service,
@@ -39,6 +51,14 @@ class UdpServer {
     void StartSend(boost::asio::ip::udp::endpoint ep, std::size_t bytes_to_send,
             boost::asio::const_buffer buffer);
     void StartReceive();
+    // Batch mode, used instead of StartReceive. Each time the socket becomes
+    // readable, up to batch_size datagrams are received with a single system
+    // call and delivered to OnReadBatch.
+    void StartBatchReceive(int batch_size = kDefaultBatchSize);
+    // Send the datagrams with as few system calls as possible. Returns the
+    // number of datagrams that were sent. Unlike StartSend, the buffers are
+    // owned by the caller and can be reused as soon as SendBatch returns.
+    size_t SendBatch(const DatagramList &datagrams);
     // state
     ServerState GetServerState() { return state_; }
     boost::asio::ip::udp::endpoint GetLocalEndpoint(
@@ -79,6 +99,13 @@ class UdpServer {
     //      there is one ReaderTask per remote endpoint
     virtual int reader_task_instance(
         const boost::asio::ip::udp::endpoint &remote_endpoint) const;
+    // Called with the datagrams received in batch mode. The buffers are
+    // recycled after the call returns and must not be deallocated. The
+    // default implementation hands a copy of each datagram to OnRead.
+    virtual void OnReadBatch(const DatagramList &datagrams);
+    // The instance to run the ReaderTask for a batch, which may contain
+    // datagrams from multiple remote endpoints.
+    virtual int batch_reader_task_instance() const;
     virtual void HandleSend(boost::asio::const_buffer send_buffer,
             boost::asio::ip::udp::endpoint remote_endpoint,
             std::size_t bytes_transferred,
@@ -86,6 +113,8 @@ class UdpServer {
 
  private:
     class Reader;
+    class Batch;
+    class BatchReader;
     friend void intrusive_ptr_add_ref(UdpServer *server);
     friend void intrusive_ptr_release(UdpServer *server);
     virtual void SetName(boost::asio::ip::udp::endpoint ep);
@@ -97,7 +126,12 @@ class UdpServer {
             boost::asio::ip::udp::endpoint remote_endpoint,
             std::size_t bytes_transferred,
             const boost::system::error_code& error);
+    void AsyncBatchReceive();
+    void HandleBatchReceive(const boost::system::error_code& error);
+    Batch *AllocateBatch();
+    void ReleaseBatch(Batch *batch);
 
+    static const int kMaxBatchCount = 4;
     static int reader_task_id_;
     boost::asio::ip::udp::socket socket_;
     int buffer_size_;
@@ -107,6 +141,10 @@ class UdpServer {
     boost::asio::ip::udp::endpoint remote_endpoint_;
     tbb::mutex mutex_;
     std::vector<uint8_t *> pbuf_;
+    int batch_size_;
+    int batch_count_;                       // Batches allocated.
+    std::vector<Batch *> batch_free_list_;  // Protected by mutex_.
+    bool batch_stalled_;                    // No batch for next receive.
     tbb::atomic<int> refcount_;
     io::SocketStats stats_;
 
@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "xmpp/xmpp_stanza_framer.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <boost/regex.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/time_util.h"
+#include "testing/gunit.h"
+#include "xmpp/xmpp_str.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+class XmppStanzaFramerTest : public ::testing::Test {
+protected:
+    XmppStanzaFramerTest() : seed_(0) {
+    }
+
+    virtual void SetUp() {
+        char *str = getenv("XMPP_STANZA_FRAMER_TEST_SEED");
+        seed_ = str ? strtoul(str, NULL, 0) : time(NULL);
+        srand(seed_);
+    }
+
+    // Feed the data to the framer in chunks of the given size and return the
+    // framed messages. The data that has not been framed yet is kept in the
+    // buffer and scanned again along with the next chunk.
+    vector<string> Frame(const string &data, size_t chunk_size) {
+        vector<string> result;
+        string buf;
+        for (size_t pos = 0; pos < data.size(); pos += chunk_size) {
+            buf.append(data, pos, chunk_size);
+            size_t start = 0;
+            while (size_t size =
+                   framer_.Scan(buf.data() + start, buf.size() - start)) {
+                EXPECT_LE(size, buf.size() - start);
+                result.push_back(buf.substr(start, size));
+                start += size;
+                framer_.Reset();
+            }
+            EXPECT_EQ(buf.size() - start, framer_.offset());
+            buf.erase(0, start);
+        }
+        return result;
+    }
+
+    int Random(int max) {
+        return rand() % max;
+    }
+
+    string RandomText(const char *chars) {
+        string text;
+        int len = Random(8);
+        size_t nchars = strlen(chars);
+        for (int i = 0; i < len; ++i)
+            text += chars[Random(nchars)];
+        return text;
+    }
+
+    string RandomAttributes() {
+        string attrs;
+        int count = Random(3);
+        for (int i = 0; i < count; ++i) {
+            attrs += Random(2) ? " " : "\n\t";
+            attrs += "a" + RandomText("0123456789") + "=";
+            if (Random(2)) {
+                attrs += "'" + RandomText("ab<>/\"= ") + "'";
+            } else {
+                attrs += "\"" + RandomText("ab<>/'= ") + "\"";
+            }
+        }
+        return attrs;
+    }
+
+    string RandomElement(const string &name, int depth) {
+        static const char *names[] = {
+            "iq", "message", "pubsub", "items", "item", "entry", "x", "body"
+        };
+        string element = "<" + name + RandomAttributes();
+        if (Random(4) == 0)
+            return element + (Random(2) ? "/>" : " />");
+
+        element += ">";
+        int children = depth < 4 ? Random(4) : 0;
+        for (int i = 0; i < children; ++i) {
+            element += RandomText("abc &;>/'\"\n");
+            element += RandomElement(names[Random(8)], depth + 1);
+        }
+        element += RandomText("abc &;>/'\"\n");
+        element += "</" + name + (Random(2) ? ">" : " >");
+        return element;
+    }
+
+    // Build a stanza, optionally preceded by data that is not a stanza and
+    // that the framer needs to skip.
+    string RandomStanza() {
+        string stanza;
+        switch (Random(6)) {
+        case 0:
+            stanza += "<?xml version='1.0'?>";
+            break;
+        case 1:
+            stanza += "<stream:features><x a='<iq>'/></stream:features>";
+            break;
+        case 2:
+            stanza += " \r\n\t";
+            break;
+        default:
+            break;
+        }
+        return stanza + RandomElement(Random(2) ? "iq" : "message", 0);
+    }
+
+    unsigned int seed_;
+    XmppStanzaFramer framer_;
+};
+
+TEST_F(XmppStanzaFramerTest, Basic) {
+    string stanza("<iq type='set' from='agent'><pubsub><item/></pubsub></iq>");
+    EXPECT_EQ(stanza.size(), framer_.Scan(stanza.data(), stanza.size()));
+    EXPECT_EQ(0, framer_.depth());
+}
+
+TEST_F(XmppStanzaFramerTest, EmptyStanza) {
+    string stanza("<message to='agent' />");
+    EXPECT_EQ(stanza.size(), framer_.Scan(stanza.data(), stanza.size()));
+}
+
+TEST_F(XmppStanzaFramerTest, Partial) {
+    string stanza("<iq type='set'><pubsub><item/></pubsub></iq>");
+    for (size_t size = 1; size < stanza.size(); ++size) {
+        EXPECT_EQ(0U, framer_.Scan(stanza.data(), size));
+        EXPECT_EQ(size, framer_.offset());
+    }
+    EXPECT_EQ(stanza.size(), framer_.Scan(stanza.data(), stanza.size()));
+}
+
+//
+// Tag delimiters inside quoted attribute values are ignored.
+//
+TEST_F(XmppStanzaFramerTest, QuotedAttributes) {
+    string stanza("<iq a='</iq>' b=\"/>\" c='\"'><x y=\"'>\"/></iq>");
+    EXPECT_EQ(stanza.size(), framer_.Scan(stanza.data(), stanza.size()));
+}
+
+//
+// The stanza ends at the end tag that matches its start tag, not the first
+// end tag with the same name.
+//
+TEST_F(XmppStanzaFramerTest, NestedSameName) {
+    string stanza("<iq><iq>text</iq><iq/></iq>");
+    EXPECT_EQ(stanza.size(), framer_.Scan(stanza.data(), stanza.size()));
+}
+
+//
+// Top level elements that are not stanzas, stray end tags and declarations
+// are returned as part of the prefix of the next stanza.
+//
+TEST_F(XmppStanzaFramerTest, SkipNonStanza) {
+    string data("<?xml version='1.0'?><stream:features><iq/>"
+        "</stream:features></stream:stream><iqx/><message/>");
+    EXPECT_EQ(data.find("<iq/>") + 5, framer_.Scan(data.data(), data.size()));
+    framer_.Reset();
+    string rest("</stream:features></stream:stream><iqx/><message/>");
+    EXPECT_EQ(rest.size(), framer_.Scan(rest.data(), rest.size()));
+}
+
+TEST_F(XmppStanzaFramerTest, MultipleStanzas) {
+    string first("<iq type='set'><pubsub/></iq>");
+    string second("<message><body>hello</body></message>");
+    vector<string> result = Frame(first + second + "<iq>", 7);
+    ASSERT_EQ(2U, result.size());
+    EXPECT_EQ(first, result[0]);
+    EXPECT_EQ(second, result[1]);
+}
+
+//
+// Frame random stanzas split at random boundaries and verify that each one
+// is returned intact.
+//
+TEST_F(XmppStanzaFramerTest, Fuzz) {
+    cout << "Random seed " << seed_ << endl;
+    for (int iteration = 0; iteration < 100; ++iteration) {
+        vector<string> stanzas;
+        string data;
+        int count = 1 + Random(32);
+        for (int i = 0; i < count; ++i) {
+            stanzas.push_back(RandomStanza());
+            data += stanzas.back();
+        }
+
+        framer_.Reset();
+        vector<string> result = Frame(data, 1 + Random(64));
+        ASSERT_EQ(stanzas.size(), result.size());
+        for (size_t i = 0; i < stanzas.size(); ++i) {
+            EXPECT_EQ(stanzas[i], result[i]);
+        }
+    }
+}
+
+//
+// Random bytes must never make the framer return more than it was given or
+// read past the end of the buffer.
+//
+TEST_F(XmppStanzaFramerTest, FuzzGarbage) {
+    cout << "Random seed " << seed_ << endl;
+    const char chars[] = "<>/?!'\" =aiqmessage\n\x80\xff";
+    for (int iteration = 0; iteration < 100; ++iteration) {
+        string data;
+        int len = Random(1024);
+        for (int i = 0; i < len; ++i)
+            data += chars[Random(sizeof(chars) - 1)];
+
+        framer_.Reset();
+        Frame(data, 1 + Random(64));
+    }
+}
+
+//
+// Compare the framing throughput with that of the regex based matching that
+// was used earlier. The amount of data can be changed with the environment
+// variable XMPP_STANZA_FRAMER_TEST_MBYTES.
+//
+TEST_F(XmppStanzaFramerTest, Throughput) {
+    char *str = getenv("XMPP_STANZA_FRAMER_TEST_MBYTES");
+    size_t mbytes = str ? strtoul(str, NULL, 0) : 4;
+    const size_t kChunkSize = 4096;
+
+    string stanza("<iq type=\"set\" from=\"agent\" to=\"network-control\">"
+        "<pubsub xmlns=\"http://jabber.org/protocol/pubsub\">"
+        "<publish node=\"blue/1/10.1.1.1/32\"><item><entry>");
+    for (int i = 0; i < 16; ++i)
+        stanza += "<next-hop><address>192.168.1.1</address></next-hop>";
+    stanza += "</entry></item></publish></pubsub></iq>";
+    string data;
+    while (data.size() < mbytes << 20)
+        data += stanza;
+    size_t stanzas = data.size() / stanza.size();
+
+    uint64_t start = ClockMonotonicUsec();
+    size_t count = Frame(data, kChunkSize).size();
+    uint64_t framer_usecs = ClockMonotonicUsec() - start;
+    EXPECT_EQ(stanzas, count);
+
+    boost::regex begin_patt(rXMPP_MESSAGE);
+    boost::regex end_patt("</iq[\\s\\t\\r\\n]*>");
+    boost::match_results<string::const_iterator> begin_res, end_res;
+    count = 0;
+    start = ClockMonotonicUsec();
+    string buf;
+    for (size_t pos = 0; pos < data.size(); pos += kChunkSize) {
+        buf += data.substr(pos, kChunkSize);
+        string::const_iterator first = buf.begin(), last = buf.end();
+        while (regex_search(first, last, begin_res, begin_patt) &&
+               regex_search(begin_res[0].second, last, end_res, end_patt)) {
+            first = end_res[0].second;
+            count++;
+        }
+        buf.erase(0, first - static_cast<const string &>(buf).begin());
+    }
+    uint64_t regex_usecs = ClockMonotonicUsec() - start;
+    EXPECT_EQ(stanzas, count);
+
+    cout << "Framed " << stanzas << " stanzas, " << data.size() << " bytes"
+         << endl;
+    cout << "Framer: " << framer_usecs << " usecs, "
+         << (framer_usecs ? data.size() / framer_usecs : 0) << " MB/s"
+         << endl;
+    cout << "Regex: " << regex_usecs << " usecs, "
+         << (regex_usecs ? data.size() / regex_usecs : 0) << " MB/s" << endl;
+}
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -551,8 +551,16 @@ void XmppConnection::ReceiveMsg(XmppSession *session, const string &msg) {
         IncProtoStats((unsigned int)minfo->type);
         state_machine_->OnMessage(session, minfo);
     } else if ((minfo = last_msg_.get()) != NULL) {
+        // A publish that is held till the collection that completes it is
+        // received. The rx trace callback still sees the raw message, since
+        // it is part of what was received on the wire.
         session->IncStats((unsigned int)minfo->type, msg.size());
         IncProtoStats((unsigned int)minfo->type);
+        if (mux_) {
+            mux_->RxMessageTrace(
+                session->remote_endpoint().address().to_string(),
+                session->remote_endpoint().port(), msg.size(), msg, minfo);
+        }
     } else {
         session->IncStats(XmppStanza::INVALID, msg.size());
         XMPP_MESSAGE_TRACE(XmppRxStreamInvalid,
@@ -582,18 +590,9 @@ XmppStanza::XmppMessage *XmppConnection::XmppDecode(const string &msg) {
 
         if (iq->action.compare("collection") == 0) {
             if (last_msg_.get() != NULL) {
-                XmppStanza::XmppMessageIq *last_iq = 
+                XmppStanza::XmppMessageIq *last_iq =
                     static_cast<XmppStanza::XmppMessageIq *>(last_msg_.get());
-
-                if (last_iq->node.compare(iq->as_node) == 0) {
-                    XmlBase *impl = last_iq->dom.get();
-                    impl->ReadNode("publish");
-                    impl->ModifyAttribute("node", iq->node);
-                    last_iq->node = impl->ReadAttrib("node");
-                    last_iq->is_as_node = iq->is_as_node;
-                    //Save the complete ass/dissociate node
-                    last_iq->as_node = iq->as_node;
-                } else {
+                if (!MergeCollection(last_iq, iq)) {
                     XMPP_WARNING(XmppIqMessageInvalid);
                     goto error;
                 }
@@ -612,6 +611,24 @@ error:
     return NULL;
 }
 
+//
+// Merge the node in a collection iq into the publish iq that precedes it.
+// Return false if the collection is for a different node.
+//
+bool XmppConnection::MergeCollection(XmppStanza::XmppMessageIq *publish,
+        const XmppStanza::XmppMessageIq *collection) {
+    if (publish->node.compare(collection->as_node) != 0)
+        return false;
+    XmlBase *impl = publish->dom.get();
+    impl->ReadNode("publish");
+    impl->ModifyAttribute("node", collection->node);
+    publish->node = impl->ReadAttrib("node");
+    publish->is_as_node = collection->is_as_node;
+    //Save the complete ass/dissociate node
+    publish->as_node = collection->as_node;
+    return true;
+}
+
 int XmppConnection::ProcessXmppChatMessage(
         const XmppStanza::XmppChatMessage *msg) {
     mux_->ProcessXmppMessage(msg);
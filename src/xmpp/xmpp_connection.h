@@ -66,6 +66,10 @@ public:
     virtual bool AcceptSession(XmppSession *session);
     virtual void ReceiveMsg(XmppSession *session, const std::string &); 
 
+    // Merge a collection iq into the publish iq that precedes it on the wire.
+    static bool MergeCollection(XmppStanza::XmppMessageIq *publish,
+                                const XmppStanza::XmppMessageIq *collection);
+
     virtual boost::asio::ip::tcp::endpoint endpoint() const;
     virtual boost::asio::ip::tcp::endpoint local_endpoint() const;
     std::string endpoint_string() const;
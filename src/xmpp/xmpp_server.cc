@@ -616,6 +616,9 @@ void XmppServer::FillShowServer(ShowXmppServerResp *resp) const {
     resp->set_rx_socket_stats(peer_socket_stats);
     GetTxSocketStats(peer_socket_stats);
     resp->set_tx_socket_stats(peer_socket_stats);
+    BufferPoolStats buffer_pool_stats;
+    GetBufferPoolStats(buffer_pool_stats);
+    resp->set_buffer_pool_stats(buffer_pool_stats);
     resp->set_current_connections(connection_map_.size());
     resp->set_max_connections(max_connections_);
 }
@@ -19,7 +19,6 @@ using namespace std;
 
 using boost::asio::mutable_buffer;
 
-const boost::regex XmppSession::patt_(rXMPP_MESSAGE);
 const boost::regex XmppSession::stream_patt_(rXMPP_STREAM_START);
 const boost::regex XmppSession::stream_res_end_(rXMPP_STREAM_END);
 const boost::regex XmppSession::whitespace_(sXMPP_WHITESPACE);
@@ -149,6 +148,7 @@ void XmppSession::ReplaceBuf(const std::string &str) {
     buf_ = str;
     buf_.reserve(kMaxMessageSize+8);
     offset_ = buf_.begin();
+    framer_.Reset();
 }
 
 bool XmppSession::LeftOver() const {
@@ -178,6 +178,20 @@ int XmppSession::MatchRegex(const boost::regex &patt) {
     }
 }
 
+//
+// Find the end of the next stanza in the buffer using the incremental framer.
+// Data that was scanned for a partial stanza is not looked at again when more
+// data is appended to the buffer.
+//
+bool XmppSession::MatchStanza(int *result) {
+    size_t size = framer_.Scan(buf_.data(), buf_.size());
+    if (!size)
+        return true; // partial. read more
+    offset_ = buf_.begin() + size;
+    *result = 0;
+    return false;
+}
+
 bool XmppSession::Match(Buffer buffer, int *result, bool NewBuf) {
     const XmppConnection *connection = this->Connection();
 
@@ -248,7 +262,7 @@ bool XmppSession::Match(Buffer buffer, int *result, bool NewBuf) {
                 }
             }
         } else if (state == xmsm::OPENCONFIRM || state == xmsm::ESTABLISHED) {
-            m = MatchRegex(tag_known_ ? tag_to_pattern(begin_tag_.c_str()):patt_);
+            return MatchStanza(result);
         }
 
         if (m == 0) { // full match
@@ -9,6 +9,7 @@
 #include <boost/regex.hpp>
 #include "io/ssl_server.h"
 #include "io/ssl_session.h"
+#include "xmpp/xmpp_stanza_framer.h"
 
 class XmppServer;
 class XmppConnection;
@@ -55,6 +56,7 @@ private:
     boost::regex tag_to_pattern(const char *); 
     int MatchRegex(const boost::regex &patt);
     bool Match(Buffer buffer, int *result, bool NewBuf);
+    bool MatchStanza(int *result);
     void SetBuf(const std::string &);
     void ReplaceBuf(const std::string &);
     bool LeftOver() const;
@@ -68,6 +70,7 @@ private:
     int tag_known_;
     int task_instance_;
     boost::match_results<std::string::const_iterator> res_;
+    XmppStanzaFramer framer_;
     std::vector<StatsPair> stats_; // packet count
     int keepalive_idle_time_;
     int keepalive_interval_;
@@ -75,7 +78,6 @@ private:
     int tcp_user_timeout_;
     bool stream_open_matched_;
 
-    static const boost::regex patt_;
     static const boost::regex stream_patt_;
     static const boost::regex stream_res_end_;
     static const boost::regex whitespace_;
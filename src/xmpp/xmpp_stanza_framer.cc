@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "xmpp/xmpp_stanza_framer.h"
+
+#include <string.h>
+
+XmppStanzaFramer::XmppStanzaFramer() {
+    Reset();
+}
+
+void XmppStanzaFramer::Reset() {
+    state_ = Text;
+    offset_ = 0;
+    name_start_ = 0;
+    depth_ = 0;
+    quote_ = 0;
+    prev_ = 0;
+    end_tag_ = false;
+    skip_tag_ = false;
+}
+
+bool XmppStanzaFramer::IsStanzaName(const char *name, size_t size) const {
+    if (size == 2 && memcmp(name, "iq", 2) == 0)
+        return true;
+    if (size == 7 && memcmp(name, "message", 7) == 0)
+        return true;
+    return false;
+}
+
+//
+// Handle the '>' that closes the current tag.
+// Return true if the tag completes a top level stanza.
+//
+bool XmppStanzaFramer::TagClose() {
+    if (skip_tag_)
+        return false;
+
+    // Ignore end tags for top level elements that are not stanzas.
+    if (end_tag_) {
+        if (depth_ == 0)
+            return false;
+        return (--depth_ == 0);
+    }
+
+    // Empty element tag.
+    if (prev_ == '/')
+        return (depth_ == 0);
+
+    depth_++;
+    return false;
+}
+
+//
+// Scan the buffer starting at the offset where the previous call stopped.
+// The data before the offset must be the same as in the previous call.
+//
+size_t XmppStanzaFramer::Scan(const char *data, size_t size) {
+    size_t pos = offset_;
+    while (pos < size) {
+        switch (state_) {
+        case Text: {
+            const char *lt = static_cast<const char *>(
+                memchr(data + pos, '<', size - pos));
+            if (!lt) {
+                pos = size;
+                break;
+            }
+            pos = lt - data + 1;
+            state_ = TagOpen;
+            break;
+        }
+        case TagOpen: {
+            char c = data[pos];
+            prev_ = 0;
+            end_tag_ = false;
+            skip_tag_ = false;
+            if (c == '/') {
+                end_tag_ = true;
+                state_ = Tag;
+                pos++;
+            } else if (c == '?' || c == '!') {
+                state_ = Markup;
+                pos++;
+            } else {
+                name_start_ = pos;
+                state_ = TagName;
+            }
+            break;
+        }
+        case TagName: {
+            for (; pos < size; ++pos) {
+                char c = data[pos];
+                if (c == '>' || c == '/' ||
+                    c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+                    break;
+                }
+            }
+            if (pos == size)
+                break;
+            if (depth_ == 0) {
+                skip_tag_ =
+                    !IsStanzaName(data + name_start_, pos - name_start_);
+            }
+            state_ = Tag;
+            break;
+        }
+        case Tag: {
+            char c = 0;
+            for (; pos < size; ++pos) {
+                c = data[pos];
+                if (c == '>' || c == '\'' || c == '"')
+                    break;
+                prev_ = c;
+            }
+            if (pos == size)
+                break;
+            pos++;
+            if (c == '>') {
+                state_ = Text;
+                if (TagClose()) {
+                    offset_ = pos;
+                    return pos;
+                }
+            } else {
+                quote_ = c;
+                state_ = Quote;
+            }
+            break;
+        }
+        case Quote: {
+            const char *end = static_cast<const char *>(
+                memchr(data + pos, quote_, size - pos));
+            if (!end) {
+                pos = size;
+                break;
+            }
+            pos = end - data + 1;
+            prev_ = quote_;
+            state_ = Tag;
+            break;
+        }
+        case Markup: {
+            const char *gt = static_cast<const char *>(
+                memchr(data + pos, '>', size - pos));
+            if (!gt) {
+                pos = size;
+                break;
+            }
+            pos = gt - data + 1;
+            state_ = Text;
+            break;
+        }
+        }
+    }
+
+    offset_ = pos;
+    return 0;
+}
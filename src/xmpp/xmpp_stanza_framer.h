@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2016 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef __XMPP_STANZA_FRAMER_H__
+#define __XMPP_STANZA_FRAMER_H__
+
+#include <stddef.h>
+
+#include "base/util.h"
+
+//
+// Incremental scanner that finds the end of the next <iq> or <message>
+// stanza in the inbound XMPP stream.
+//
+// The caller keeps appending received data to a buffer and invokes Scan with
+// the whole buffer every time. The framer remembers how far it has scanned,
+// the element depth and whether it is inside a tag or a quoted attribute
+// value, so each byte is looked at only once even if a stanza is split over
+// many TCP segments. Text between tags is skipped with memchr.
+//
+// Scan returns the length of the buffer prefix that ends with a complete
+// stanza. Anything before the start of the stanza is part of the prefix.
+// Top level elements other than <iq> and <message> are skipped. Processing
+// instructions and declarations are skipped up to the next '>'; comments
+// are not allowed in XMPP streams and are not handled specially. Once a
+// stanza has been returned, the caller must Reset the framer before scanning
+// the remainder of the data from the start of a new buffer.
+//
+class XmppStanzaFramer {
+public:
+    XmppStanzaFramer();
+
+    void Reset();
+    size_t Scan(const char *data, size_t size);
+
+    size_t offset() const { return offset_; }
+    int depth() const { return depth_; }
+
+private:
+    enum State {
+        Text,
+        TagOpen,
+        TagName,
+        Tag,
+        Quote,
+        Markup
+    };
+
+    bool IsStanzaName(const char *name, size_t size) const;
+    bool TagClose();
+
+    State state_;
+    size_t offset_;
+    size_t name_start_;
+    int depth_;
+    char quote_;
+    char prev_;
+    bool end_tag_;
+    bool skip_tag_;
+
+    DISALLOW_COPY_AND_ASSIGN(XmppStanzaFramer);
+};
+
+#endif // __XMPP_STANZA_FRAMER_H__